@@ -0,0 +1,196 @@
+/* Copyright 2015 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <vector>
+#include "legion.h"
+using namespace LegionRuntime::HighLevel;
+using LegionRuntime::TimeStamp;
+
+/*
+ * Microbenchmarks for the event graph operations that dominate
+ * the runtime overhead of short tasks: long chains of dependent
+ * events, wide fan-in merges, small merges and trigger queries.
+ * Every result is printed as one line of the form
+ *
+ *   event_bench,<test>,<parameter>,<metric>,<value>
+ *
+ * so that runs can be collected and compared by scripts.
+ *
+ * Options:
+ *   -chain <n>  length of the dependent event chains (default 256)
+ *   -fanin <n>  number of inputs of the wide merges (default 1024)
+ *   -pairs <n>  number of two-input merges (default 100000)
+ *   -reps <n>   repetitions of the chain and fan-in tests (default 10)
+ */
+
+enum TaskIDs {
+  TOP_LEVEL_TASK_ID,
+};
+
+static inline double elapsed_ns(unsigned long long start,
+                                unsigned long long stop)
+{
+  return (double)(stop - start);
+}
+
+static void report(const char *test, int param,
+                   const char *metric, double value)
+{
+  printf("event_bench,%s,%d,%s,%.1f\n", test, param, metric, value);
+}
+
+// Each event in the chain triggers once its predecessor has
+static void bench_chain(int length, int reps)
+{
+  double build_ns = 0.0, trigger_ns = 0.0;
+  for (int r = 0; r < reps; r++)
+  {
+    unsigned long long t0 = TimeStamp::get_current_time_in_nanos();
+    UserEvent start = UserEvent::create_user_event();
+    Event prev = start;
+    for (int i = 0; i < length; i++)
+    {
+      UserEvent next = UserEvent::create_user_event();
+      next.trigger(prev);
+      prev = next;
+    }
+    unsigned long long t1 = TimeStamp::get_current_time_in_nanos();
+    start.trigger();
+    prev.wait();
+    unsigned long long t2 = TimeStamp::get_current_time_in_nanos();
+    assert(prev.has_triggered());
+    build_ns += elapsed_ns(t0, t1);
+    trigger_ns += elapsed_ns(t1, t2);
+  }
+  report("chain", length, "build_ns_per_event", build_ns / (reps * length));
+  report("chain", length, "trigger_ns_per_event",
+         trigger_ns / (reps * length));
+}
+
+// One merged event waiting on many independent inputs
+static void bench_fanin(int width, int reps)
+{
+  double merge_ns = 0.0, trigger_ns = 0.0;
+  std::vector<UserEvent> inputs(width);
+  for (int r = 0; r < reps; r++)
+  {
+    std::set<Event> wait_for;
+    for (int i = 0; i < width; i++)
+    {
+      inputs[i] = UserEvent::create_user_event();
+      wait_for.insert(inputs[i]);
+    }
+    unsigned long long t0 = TimeStamp::get_current_time_in_nanos();
+    Event merged = Event::merge_events(wait_for);
+    unsigned long long t1 = TimeStamp::get_current_time_in_nanos();
+    for (int i = 0; i < width; i++)
+      inputs[i].trigger();
+    merged.wait();
+    unsigned long long t2 = TimeStamp::get_current_time_in_nanos();
+    assert(merged.has_triggered());
+    merge_ns += elapsed_ns(t0, t1);
+    trigger_ns += elapsed_ns(t1, t2);
+  }
+  report("fanin", width, "merge_ns_per_input", merge_ns / (reps * width));
+  report("fanin", width, "trigger_ns_per_input",
+         trigger_ns / (reps * width));
+}
+
+// Lots of small merges, the common case for task preconditions
+static void bench_pairs(int pairs)
+{
+  std::vector<UserEvent> lhs(pairs), rhs(pairs);
+  std::vector<Event> merged(pairs);
+  for (int i = 0; i < pairs; i++)
+  {
+    lhs[i] = UserEvent::create_user_event();
+    rhs[i] = UserEvent::create_user_event();
+  }
+  unsigned long long t0 = TimeStamp::get_current_time_in_nanos();
+  for (int i = 0; i < pairs; i++)
+    merged[i] = Event::merge_events(lhs[i], rhs[i]);
+  unsigned long long t1 = TimeStamp::get_current_time_in_nanos();
+  for (int i = 0; i < pairs; i++)
+  {
+    lhs[i].trigger();
+    rhs[i].trigger();
+  }
+  unsigned long long t2 = TimeStamp::get_current_time_in_nanos();
+  for (int i = 0; i < pairs; i++)
+    merged[i].wait();
+  report("pairs", pairs, "merge_ns_per_pair", elapsed_ns(t0, t1) / pairs);
+  report("pairs", pairs, "trigger_ns_per_pair", elapsed_ns(t1, t2) / pairs);
+}
+
+// The has_triggered fast path on both sides of the trigger
+static void bench_query(int queries)
+{
+  UserEvent pending = UserEvent::create_user_event();
+  UserEvent done = UserEvent::create_user_event();
+  done.trigger();
+  int count = 0;
+  unsigned long long t0 = TimeStamp::get_current_time_in_nanos();
+  for (int i = 0; i < queries; i++)
+    if (pending.has_triggered())
+      count++;
+  unsigned long long t1 = TimeStamp::get_current_time_in_nanos();
+  for (int i = 0; i < queries; i++)
+    if (done.has_triggered())
+      count++;
+  unsigned long long t2 = TimeStamp::get_current_time_in_nanos();
+  assert(count == queries);
+  report("query", queries, "untriggered_ns", elapsed_ns(t0, t1) / queries);
+  report("query", queries, "triggered_ns", elapsed_ns(t1, t2) / queries);
+  pending.trigger();
+}
+
+void top_level_task(const Task *task,
+                    const std::vector<PhysicalRegion> &regions,
+                    Context ctx, HighLevelRuntime *runtime)
+{
+  int chain = 256, fanin = 1024, pairs = 100000, reps = 10;
+  const InputArgs &command_args = HighLevelRuntime::get_input_args();
+  for (int i = 1; i < command_args.argc; i++)
+  {
+    if (!strcmp(command_args.argv[i],"-chain"))
+      chain = atoi(command_args.argv[++i]);
+    if (!strcmp(command_args.argv[i],"-fanin"))
+      fanin = atoi(command_args.argv[++i]);
+    if (!strcmp(command_args.argv[i],"-pairs"))
+      pairs = atoi(command_args.argv[++i]);
+    if (!strcmp(command_args.argv[i],"-reps"))
+      reps = atoi(command_args.argv[++i]);
+  }
+  assert((chain > 0) && (fanin > 0) && (pairs > 0) && (reps > 0));
+
+  bench_chain(chain, reps);
+  bench_fanin(fanin, reps);
+  bench_pairs(pairs);
+  bench_query(pairs);
+}
+
+int main(int argc, char **argv)
+{
+  HighLevelRuntime::set_top_level_task_id(TOP_LEVEL_TASK_ID);
+  HighLevelRuntime::register_legion_task<top_level_task>(TOP_LEVEL_TASK_ID,
+      Processor::LOC_PROC, true/*single*/, false/*index*/);
+
+  return HighLevelRuntime::start(argc, argv);
+}
@@ -0,0 +1,221 @@
+/* Copyright 2015 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <set>
+#include <map>
+#include <vector>
+#include "legion.h"
+#include "default_mapper.h"
+using namespace LegionRuntime::HighLevel;
+using namespace LegionRuntime::Accessor;
+using namespace LegionRuntime::Arrays;
+
+/*
+ * Regression test for batched reference counting on idle nodes.
+ *
+ * The top-level task fills a region and has one task on every other
+ * address space read it, so those nodes make remote copies of the
+ * collectables that node 0 owns.  Once the readers are done the
+ * other nodes have nothing left to run and go idle.  Node 0 then
+ * destroys the region, which releases the remote copies, and the
+ * idle nodes answer with reference removals that go through their
+ * ReferenceBatch.  Node 0 stays busy for a while after every round
+ * so that the removals have plenty of time to arrive before the
+ * next round and before shutdown.
+ *
+ * Run it on two or more nodes with -hl:message_stats.  Every
+ * "Reference changes from node N" line for N other than 0 must
+ * report 0 changes left for shutdown, anything else means an idle
+ * node held on to its removals until the runtime shut down.  On a
+ * single address space there is nothing to test and it says so.
+ *
+ * Options:
+ *   -rounds <n>   number of create/read/destroy rounds (default 4)
+ *   -n <n>        number of elements in each region (default 1024)
+ *   -wait <us>    time node 0 stays busy after each round
+ *                 (default 100000)
+ */
+
+enum TaskIDs {
+  TOP_LEVEL_TASK_ID,
+  READ_TASK_ID,
+};
+
+enum FieldIDs {
+  FID_VALUE,
+};
+
+// Sends every read task to the processor named in its arguments
+class IdleReleaseMapper : public DefaultMapper {
+public:
+  IdleReleaseMapper(Machine machine, HighLevelRuntime *rt, Processor local)
+    : DefaultMapper(machine, rt, local) { }
+public:
+  virtual void select_task_options(Task *task)
+  {
+    DefaultMapper::select_task_options(task);
+    if (task->task_id == READ_TASK_ID)
+    {
+      assert(task->arglen == sizeof(Processor));
+      task->target_proc = *((const Processor*)task->args);
+    }
+  }
+};
+
+void mapper_registration(Machine machine, HighLevelRuntime *rt,
+                         const std::set<Processor> &local_procs)
+{
+  for (std::set<Processor>::const_iterator it = local_procs.begin();
+        it != local_procs.end(); it++)
+  {
+    rt->replace_default_mapper(new IdleReleaseMapper(machine, rt, *it), *it);
+  }
+}
+
+int read_task(const Task *task,
+              const std::vector<PhysicalRegion> &regions,
+              Context ctx, HighLevelRuntime *runtime)
+{
+  RegionAccessor<AccessorType::Generic, int> acc =
+    regions[0].get_field_accessor(FID_VALUE).typeify<int>();
+  Domain dom = runtime->get_index_space_domain(ctx,
+      task->regions[0].region.get_index_space());
+  int sum = 0;
+  for (GenericPointInRectIterator<1> pir(dom.get_rect<1>()); pir; pir++)
+    sum += acc.read(DomainPoint::from_point<1>(pir.p));
+  return sum;
+}
+
+void top_level_task(const Task *task,
+                    const std::vector<PhysicalRegion> &regions,
+                    Context ctx, HighLevelRuntime *runtime)
+{
+  int rounds = 4, num_elmts = 1024, wait_us = 100000;
+  const InputArgs &command_args = HighLevelRuntime::get_input_args();
+  for (int i = 1; i < command_args.argc; i++)
+  {
+    if (!strcmp(command_args.argv[i],"-rounds"))
+      rounds = atoi(command_args.argv[++i]);
+    if (!strcmp(command_args.argv[i],"-n"))
+      num_elmts = atoi(command_args.argv[++i]);
+    if (!strcmp(command_args.argv[i],"-wait"))
+      wait_us = atoi(command_args.argv[++i]);
+  }
+  assert((rounds > 0) && (num_elmts > 0) && (wait_us >= 0));
+
+  // One reader on every other address space
+  std::vector<Processor> readers;
+  {
+    Machine machine = Machine::get_machine();
+    std::set<Processor> all_procs;
+    machine.get_all_processors(all_procs);
+    const Processor local = task->target_proc;
+    std::set<AddressSpaceID> seen;
+    seen.insert(local.address_space());
+    for (std::set<Processor>::const_iterator it = all_procs.begin();
+          it != all_procs.end(); it++)
+    {
+      if (it->kind() != Processor::LOC_PROC)
+        continue;
+      if (seen.find(it->address_space()) != seen.end())
+        continue;
+      seen.insert(it->address_space());
+      readers.push_back(*it);
+    }
+  }
+  if (readers.empty())
+  {
+    printf("gc_idle_release: only one address space, nothing to test\n");
+    return;
+  }
+
+  const int expected = num_elmts * (num_elmts - 1) / 2;
+  for (int round = 0; round < rounds; round++)
+  {
+    Rect<1> elem_rect(Point<1>(0), Point<1>(num_elmts-1));
+    IndexSpace is = runtime->create_index_space(ctx,
+                            Domain::from_rect<1>(elem_rect));
+    FieldSpace fs = runtime->create_field_space(ctx);
+    {
+      FieldAllocator allocator = runtime->create_field_allocator(ctx, fs);
+      allocator.allocate_field(sizeof(int), FID_VALUE);
+    }
+    LogicalRegion lr = runtime->create_logical_region(ctx, is, fs);
+
+    {
+      RegionRequirement req(lr, WRITE_DISCARD, EXCLUSIVE, lr);
+      req.add_field(FID_VALUE);
+      InlineLauncher launcher(req);
+      PhysicalRegion pr = runtime->map_region(ctx, launcher);
+      pr.wait_until_valid();
+      RegionAccessor<AccessorType::Generic, int> acc =
+        pr.get_field_accessor(FID_VALUE).typeify<int>();
+      int value = 0;
+      for (GenericPointInRectIterator<1> pir(elem_rect); pir; pir++)
+        acc.write(DomainPoint::from_point<1>(pir.p), value++);
+      runtime->unmap_region(ctx, pr);
+    }
+
+    std::vector<Future> futures;
+    for (unsigned idx = 0; idx < readers.size(); idx++)
+    {
+      TaskLauncher launcher(READ_TASK_ID,
+                            TaskArgument(&readers[idx], sizeof(Processor)));
+      launcher.add_region_requirement(
+          RegionRequirement(lr, READ_ONLY, EXCLUSIVE, lr));
+      launcher.add_field(0, FID_VALUE);
+      futures.push_back(runtime->execute_task(ctx, launcher));
+    }
+    for (unsigned idx = 0; idx < futures.size(); idx++)
+    {
+      int sum = futures[idx].get_result<int>();
+      if (sum != expected)
+      {
+        printf("gc_idle_release: FAILED, reader %d saw %d instead of %d\n",
+               idx, sum, expected);
+        exit(1);
+      }
+    }
+    futures.clear();
+
+    // The readers are done, so every other node is idle from here on
+    // while it releases its copies of what we destroy
+    runtime->destroy_logical_region(ctx, lr);
+    runtime->destroy_field_space(ctx, fs);
+    runtime->destroy_index_space(ctx, is);
+    usleep(wait_us);
+  }
+  printf("gc_idle_release: %d rounds on %ld other address spaces done, "
+         "check -hl:message_stats for changes left for shutdown\n",
+         rounds, (long)readers.size());
+}
+
+int main(int argc, char **argv)
+{
+  HighLevelRuntime::set_top_level_task_id(TOP_LEVEL_TASK_ID);
+  HighLevelRuntime::register_legion_task<top_level_task>(TOP_LEVEL_TASK_ID,
+      Processor::LOC_PROC, true/*single*/, false/*index*/);
+  HighLevelRuntime::register_legion_task<int, read_task>(READ_TASK_ID,
+      Processor::LOC_PROC, true/*single*/, false/*index*/,
+      AUTO_GENERATE_ID, TaskConfigOptions(true/*leaf*/), "read_task");
+  HighLevelRuntime::set_registration_callback(mapper_registration);
+
+  return HighLevelRuntime::start(argc, argv);
+}
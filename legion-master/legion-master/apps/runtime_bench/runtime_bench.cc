@@ -0,0 +1,468 @@
+/* Copyright 2015 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <map>
+#include <string>
+#include <vector>
+#include "legion.h"
+using namespace LegionRuntime::HighLevel;
+using namespace LegionRuntime::Arrays;
+using LegionRuntime::TimeStamp;
+
+/*
+ * Microbenchmarks for the overheads of the runtime itself, measured
+ * in isolation from any application work.  It builds against either
+ * the shared low-level runtime or the GASNet low-level runtime
+ * (set SHARED_LOWLEVEL in the Makefile).  Every result is printed
+ * as one line of the form
+ *
+ *   runtime_bench,<test>,<parameter>,<metric>,<value>
+ *
+ * so that runs can be collected and compared by scripts.  The
+ * tests are:
+ *
+ *   launch       individual and index space launches of empty tasks
+ *   event        trigger latency and two-input merge cost
+ *   reservation  uncontended and queued acquire/release pairs
+ *   barrier      arrivals and phase completion of a barrier
+ *   instance     create and destroy of instances in every memory
+ *   dma          copy bandwidth for every pair of memories with affinity
+ *   region_tree  launch cost as a function of region tree depth
+ *                and number of fields
+ *
+ * The parameter for the memory tests is the name of the memory
+ * (or memory pair) and for the region tree test it is written
+ * as <depth>x<fields>.
+ *
+ * Options:
+ *   -test <name>   only run the named test, can be given more
+ *                  than once (default all)
+ *   -n <n>         number of launches and operations (default 1000)
+ *   -reps <n>      repetitions of the memory tests (default 10)
+ *   -bytes <n>     size of the instances in bytes (default 16MB)
+ *   -depth <n>     maximum region tree depth (default 8)
+ *   -fields <n>    maximum number of fields (default 32)
+ */
+
+enum TaskIDs {
+  TOP_LEVEL_TASK_ID,
+  EMPTY_TASK_ID,
+  REGION_TASK_ID,
+};
+
+static inline double elapsed_ns(unsigned long long start,
+                                unsigned long long stop)
+{
+  return (double)(stop - start);
+}
+
+static void report(const char *test, const char *param,
+                   const char *metric, double value)
+{
+  printf("runtime_bench,%s,%s,%s,%.1f\n", test, param, metric, value);
+}
+
+static void report(const char *test, int param,
+                   const char *metric, double value)
+{
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%d", param);
+  report(test, buffer, metric, value);
+}
+
+static const char* memory_kind_name(Memory::Kind kind)
+{
+  switch (kind)
+  {
+    case Memory::GLOBAL_MEM:   return "global";
+    case Memory::SYSTEM_MEM:   return "system";
+    case Memory::REGDMA_MEM:   return "regdma";
+    case Memory::SOCKET_MEM:   return "socket";
+    case Memory::Z_COPY_MEM:   return "zcopy";
+    case Memory::GPU_FB_MEM:   return "framebuffer";
+    case Memory::DISK_MEM:     return "disk";
+    case Memory::LEVEL3_CACHE: return "l3cache";
+    case Memory::LEVEL2_CACHE: return "l2cache";
+    case Memory::LEVEL1_CACHE: return "l1cache";
+  }
+  return "unknown";
+}
+
+static void memory_name(Memory m, char *buffer, size_t size)
+{
+  snprintf(buffer, size, "%s:" IDFMT, memory_kind_name(m.kind()), m.id);
+}
+
+void empty_task(const Task *task,
+                const std::vector<PhysicalRegion> &regions,
+                Context ctx, HighLevelRuntime *runtime)
+{
+}
+
+// Individual launches and index space launches of tasks that do nothing
+static void bench_launch(Context ctx, HighLevelRuntime *runtime, int count)
+{
+  {
+    std::vector<Future> futures(count);
+    unsigned long long t0 = TimeStamp::get_current_time_in_nanos();
+    for (int i = 0; i < count; i++)
+    {
+      TaskLauncher launcher(EMPTY_TASK_ID, TaskArgument(NULL, 0));
+      futures[i] = runtime->execute_task(ctx, launcher);
+    }
+    unsigned long long t1 = TimeStamp::get_current_time_in_nanos();
+    for (int i = 0; i < count; i++)
+      futures[i].get_void_result();
+    unsigned long long t2 = TimeStamp::get_current_time_in_nanos();
+    report("launch", count, "individual_launch_ns", elapsed_ns(t0, t1) / count);
+    report("launch", count, "individual_task_ns", elapsed_ns(t0, t2) / count);
+  }
+  {
+    Rect<1> launch_rect(Point<1>(0), Point<1>(count-1));
+    ArgumentMap arg_map;
+    IndexLauncher launcher(EMPTY_TASK_ID, Domain::from_rect<1>(launch_rect),
+                           TaskArgument(NULL, 0), arg_map);
+    unsigned long long t0 = TimeStamp::get_current_time_in_nanos();
+    FutureMap fm = runtime->execute_index_space(ctx, launcher);
+    unsigned long long t1 = TimeStamp::get_current_time_in_nanos();
+    fm.wait_all_results();
+    unsigned long long t2 = TimeStamp::get_current_time_in_nanos();
+    report("launch", count, "index_launch_ns", elapsed_ns(t0, t1));
+    report("launch", count, "index_point_ns", elapsed_ns(t0, t2) / count);
+  }
+}
+
+// Round trip for triggering an event that somebody waits on and the
+// cost of small merges, see event_bench for the detailed event tests
+static void bench_event(int count)
+{
+  double trigger_ns = 0.0;
+  for (int i = 0; i < count; i++)
+  {
+    UserEvent event = UserEvent::create_user_event();
+    unsigned long long t0 = TimeStamp::get_current_time_in_nanos();
+    event.trigger();
+    event.wait();
+    unsigned long long t1 = TimeStamp::get_current_time_in_nanos();
+    trigger_ns += elapsed_ns(t0, t1);
+  }
+  std::vector<UserEvent> inputs(2*count);
+  for (int i = 0; i < (2*count); i++)
+    inputs[i] = UserEvent::create_user_event();
+  std::vector<Event> merged(count);
+  unsigned long long t0 = TimeStamp::get_current_time_in_nanos();
+  for (int i = 0; i < count; i++)
+    merged[i] = Event::merge_events(inputs[2*i], inputs[2*i+1]);
+  unsigned long long t1 = TimeStamp::get_current_time_in_nanos();
+  for (int i = 0; i < (2*count); i++)
+    inputs[i].trigger();
+  for (int i = 0; i < count; i++)
+    merged[i].wait();
+  report("event", count, "trigger_wait_ns", trigger_ns / count);
+  report("event", count, "merge_ns", elapsed_ns(t0, t1) / count);
+}
+
+// Acquire/release pairs both waiting for each grant and queued up
+// behind each other so that only the runtime is on the critical path
+static void bench_reservation(int count)
+{
+  Reservation reservation = Reservation::create_reservation();
+  unsigned long long t0 = TimeStamp::get_current_time_in_nanos();
+  for (int i = 0; i < count; i++)
+  {
+    Event grant = reservation.acquire(0, true/*exclusive*/);
+    grant.wait();
+    reservation.release();
+  }
+  unsigned long long t1 = TimeStamp::get_current_time_in_nanos();
+  Event last = Event::NO_EVENT;
+  for (int i = 0; i < count; i++)
+  {
+    last = reservation.acquire(0, true/*exclusive*/);
+    reservation.release(last);
+  }
+  last.wait();
+  unsigned long long t2 = TimeStamp::get_current_time_in_nanos();
+  report("reservation", count, "blocking_pair_ns", elapsed_ns(t0, t1) / count);
+  report("reservation", count, "queued_pair_ns", elapsed_ns(t1, t2) / count);
+  reservation.destroy_reservation();
+}
+
+// Arrivals on a barrier and the latency for each phase to complete
+static void bench_barrier(int arrivals, int phases)
+{
+  Barrier barrier = Barrier::create_barrier(arrivals);
+  Barrier first = barrier;
+  double arrive_ns = 0.0, phase_ns = 0.0;
+  for (int p = 0; p < phases; p++)
+  {
+    unsigned long long t0 = TimeStamp::get_current_time_in_nanos();
+    for (int i = 0; i < arrivals; i++)
+      barrier.arrive(1);
+    unsigned long long t1 = TimeStamp::get_current_time_in_nanos();
+    barrier.wait();
+    unsigned long long t2 = TimeStamp::get_current_time_in_nanos();
+    arrive_ns += elapsed_ns(t0, t1);
+    phase_ns += elapsed_ns(t0, t2);
+    barrier = barrier.advance_barrier();
+  }
+  report("barrier", arrivals, "arrive_ns", arrive_ns / (phases * arrivals));
+  report("barrier", arrivals, "phase_ns", phase_ns / phases);
+  first.destroy_barrier();
+}
+
+// Creating and destroying instances in each of the memories
+static void bench_instance(const std::set<Memory> &memories,
+                           size_t bytes, int count)
+{
+  const size_t elements = bytes / sizeof(double);
+  Rect<1> rect(Point<1>(0), Point<1>(elements-1));
+  Domain dom = Domain::from_rect<1>(rect);
+  std::vector<PhysicalInstance> instances(count);
+  for (std::set<Memory>::const_iterator it = memories.begin();
+        it != memories.end(); it++)
+  {
+    if (it->capacity() < bytes)
+      continue;
+    char name[64];
+    memory_name(*it, name, sizeof(name));
+    unsigned long long t0 = TimeStamp::get_current_time_in_nanos();
+    int created = 0;
+    for (int i = 0; i < count; i++)
+    {
+      instances[i] = dom.create_instance(*it, sizeof(double));
+      if (!instances[i].exists())
+        break;
+      created++;
+      // Destroy each one right away so we never run out of space
+      instances[i].destroy();
+    }
+    unsigned long long t1 = TimeStamp::get_current_time_in_nanos();
+    if (created == 0)
+      continue;
+    report("instance", name, "create_destroy_ns", elapsed_ns(t0, t1) / created);
+  }
+}
+
+// Copy bandwidth between each pair of memories with affinity and
+// within each memory
+static void bench_dma(const std::set<Memory> &memories,
+                      size_t bytes, int reps)
+{
+  Machine machine = Machine::get_machine();
+  std::set<std::pair<Memory,Memory> > pairs;
+  for (std::set<Memory>::const_iterator it = memories.begin();
+        it != memories.end(); it++)
+    pairs.insert(std::pair<Memory,Memory>(*it, *it));
+  std::vector<MemoryMemoryAffinity> affinities;
+  machine.get_mem_mem_affinity(affinities);
+  for (std::vector<MemoryMemoryAffinity>::const_iterator it =
+        affinities.begin(); it != affinities.end(); it++)
+  {
+    pairs.insert(std::pair<Memory,Memory>(it->m1, it->m2));
+    pairs.insert(std::pair<Memory,Memory>(it->m2, it->m1));
+  }
+  const size_t elements = bytes / sizeof(double);
+  Rect<1> rect(Point<1>(0), Point<1>(elements-1));
+  Domain dom = Domain::from_rect<1>(rect);
+  for (std::set<std::pair<Memory,Memory> >::const_iterator it =
+        pairs.begin(); it != pairs.end(); it++)
+  {
+    PhysicalInstance src = dom.create_instance(it->first, sizeof(double));
+    if (!src.exists())
+      continue;
+    PhysicalInstance dst = dom.create_instance(it->second, sizeof(double));
+    if (!dst.exists())
+    {
+      src.destroy();
+      continue;
+    }
+    // Warm up the copy path once before timing it
+    dom.copy(src, dst, sizeof(double)).wait();
+    unsigned long long t0 = TimeStamp::get_current_time_in_nanos();
+    Event done = Event::NO_EVENT;
+    for (int r = 0; r < reps; r++)
+      done = dom.copy(src, dst, sizeof(double), done);
+    done.wait();
+    unsigned long long t1 = TimeStamp::get_current_time_in_nanos();
+    char src_name[64], dst_name[64], name[160];
+    memory_name(it->first, src_name, sizeof(src_name));
+    memory_name(it->second, dst_name, sizeof(dst_name));
+    snprintf(name, sizeof(name), "%s->%s", src_name, dst_name);
+    // bytes per nanosecond is the same as GB/s
+    report("dma", name, "GB_per_s",
+           (double(bytes) * reps) / elapsed_ns(t0, t1));
+    report("dma", name, "copy_us", elapsed_ns(t0, t1) / (reps * 1e3));
+    src.destroy();
+    dst.destroy();
+  }
+}
+
+void region_task(const Task *task,
+                 const std::vector<PhysicalRegion> &regions,
+                 Context ctx, HighLevelRuntime *runtime)
+{
+}
+
+// Launches that each use a leaf of a region tree with the given depth
+// and number of fields, alternating between the two leaves at the
+// bottom of the tree so the analysis has to walk the whole path
+static void bench_region_tree(Context ctx, HighLevelRuntime *runtime,
+                              int depth, int num_fields, int count)
+{
+  const int num_elements = 1 << depth;
+  Rect<1> elem_rect(Point<1>(0), Point<1>(num_elements-1));
+  IndexSpace is = runtime->create_index_space(ctx,
+                          Domain::from_rect<1>(elem_rect));
+  FieldSpace fs = runtime->create_field_space(ctx);
+  std::vector<FieldID> fields(num_fields);
+  {
+    FieldAllocator allocator = runtime->create_field_allocator(ctx, fs);
+    for (int i = 0; i < num_fields; i++)
+      fields[i] = allocator.allocate_field(sizeof(double));
+  }
+  LogicalRegion lr = runtime->create_logical_region(ctx, is, fs);
+  // Split the first half at each level to build a tree of the given depth
+  LogicalRegion leaves[2] = { lr, lr };
+  LogicalRegion current = lr;
+  IndexSpace current_is = is;
+  int size = num_elements;
+  Rect<1> color_rect(Point<1>(0), Point<1>(1));
+  for (int d = 0; d < depth; d++)
+  {
+    DomainColoring coloring;
+    size /= 2;
+    coloring[0] = Domain::from_rect<1>(
+        Rect<1>(Point<1>(0), Point<1>(size-1)));
+    coloring[1] = Domain::from_rect<1>(
+        Rect<1>(Point<1>(size), Point<1>(2*size-1)));
+    IndexPartition ip = runtime->create_index_partition(ctx, current_is,
+                          Domain::from_rect<1>(color_rect), coloring,
+                          true/*disjoint*/);
+    LogicalPartition lp = runtime->get_logical_partition(ctx, current, ip);
+    leaves[0] = runtime->get_logical_subregion_by_color(ctx, lp, 0);
+    leaves[1] = runtime->get_logical_subregion_by_color(ctx, lp, 1);
+    current = leaves[0];
+    current_is = runtime->get_index_subspace(ctx, ip, 0);
+  }
+  std::vector<Future> futures(count);
+  unsigned long long t0 = TimeStamp::get_current_time_in_nanos();
+  for (int i = 0; i < count; i++)
+  {
+    TaskLauncher launcher(REGION_TASK_ID, TaskArgument(NULL, 0));
+    launcher.add_region_requirement(
+        RegionRequirement(leaves[i%2], READ_WRITE, EXCLUSIVE, lr));
+    for (int f = 0; f < num_fields; f++)
+      launcher.add_field(0/*idx*/, fields[f]);
+    futures[i] = runtime->execute_task(ctx, launcher);
+  }
+  unsigned long long t1 = TimeStamp::get_current_time_in_nanos();
+  for (int i = 0; i < count; i++)
+    futures[i].get_void_result();
+  unsigned long long t2 = TimeStamp::get_current_time_in_nanos();
+  char name[32];
+  snprintf(name, sizeof(name), "%dx%d", depth, num_fields);
+  report("region_tree", name, "launch_ns", elapsed_ns(t0, t1) / count);
+  report("region_tree", name, "task_ns", elapsed_ns(t0, t2) / count);
+  runtime->destroy_logical_region(ctx, lr);
+  runtime->destroy_field_space(ctx, fs);
+  runtime->destroy_index_space(ctx, is);
+}
+
+static bool run_test(const std::set<std::string> &only, const char *test)
+{
+  return (only.empty() || (only.find(test) != only.end()));
+}
+
+void top_level_task(const Task *task,
+                    const std::vector<PhysicalRegion> &regions,
+                    Context ctx, HighLevelRuntime *runtime)
+{
+  int count = 1000, reps = 10, max_depth = 8, max_fields = 32;
+  size_t bytes = 16 << 20;
+  std::set<std::string> only;
+  const InputArgs &command_args = HighLevelRuntime::get_input_args();
+  for (int i = 1; i < command_args.argc; i++)
+  {
+    if (!strcmp(command_args.argv[i],"-test"))
+      only.insert(command_args.argv[++i]);
+    if (!strcmp(command_args.argv[i],"-n"))
+      count = atoi(command_args.argv[++i]);
+    if (!strcmp(command_args.argv[i],"-reps"))
+      reps = atoi(command_args.argv[++i]);
+    if (!strcmp(command_args.argv[i],"-bytes"))
+      bytes = atol(command_args.argv[++i]);
+    if (!strcmp(command_args.argv[i],"-depth"))
+      max_depth = atoi(command_args.argv[++i]);
+    if (!strcmp(command_args.argv[i],"-fields"))
+      max_fields = atoi(command_args.argv[++i]);
+  }
+  assert((count > 0) && (reps > 0) && (max_depth > 0) && (max_fields > 0));
+  assert((max_depth < 30) && (bytes >= sizeof(double)));
+
+  // Only use the memories in our address space for the memory tests
+  std::set<Memory> memories;
+  {
+    Machine machine = Machine::get_machine();
+    std::set<Memory> all_memories;
+    machine.get_all_memories(all_memories);
+    const Processor local = runtime->get_executing_processor(ctx);
+    for (std::set<Memory>::const_iterator it = all_memories.begin();
+          it != all_memories.end(); it++)
+    {
+      if (it->address_space() == local.address_space())
+        memories.insert(*it);
+    }
+  }
+
+  if (run_test(only, "launch"))
+    bench_launch(ctx, runtime, count);
+  if (run_test(only, "event"))
+    bench_event(count);
+  if (run_test(only, "reservation"))
+    bench_reservation(count);
+  if (run_test(only, "barrier"))
+    bench_barrier(count, reps);
+  if (run_test(only, "instance"))
+    bench_instance(memories, bytes, reps);
+  if (run_test(only, "dma"))
+    bench_dma(memories, bytes, reps);
+  if (run_test(only, "region_tree"))
+  {
+    for (int depth = 1; depth <= max_depth; depth *= 2)
+      for (int fields = 1; fields <= max_fields; fields *= 4)
+        bench_region_tree(ctx, runtime, depth, fields, count);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  HighLevelRuntime::set_top_level_task_id(TOP_LEVEL_TASK_ID);
+  HighLevelRuntime::register_legion_task<top_level_task>(TOP_LEVEL_TASK_ID,
+      Processor::LOC_PROC, true/*single*/, false/*index*/);
+  HighLevelRuntime::register_legion_task<empty_task>(EMPTY_TASK_ID,
+      Processor::LOC_PROC, true/*single*/, true/*index*/,
+      AUTO_GENERATE_ID, TaskConfigOptions(true/*leaf*/), "empty_task");
+  HighLevelRuntime::register_legion_task<region_task>(REGION_TASK_ID,
+      Processor::LOC_PROC, true/*single*/, false/*index*/,
+      AUTO_GENERATE_ID, TaskConfigOptions(true/*leaf*/), "region_task");
+
+  return HighLevelRuntime::start(argc, argv);
+}
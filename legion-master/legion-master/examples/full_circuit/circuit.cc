@@ -24,6 +24,7 @@
 
 #include "circuit.h"
 #include "circuit_mapper.h"
+#include "adaptive_mapper.h"
 #include "legion.h"
 
 using namespace LegionRuntime::HighLevel;
@@ -35,7 +36,8 @@ LegionRuntime::Logger::Category log_circuit("circuit");
 void parse_input_args(char **argv, int argc, int &num_loops, int &num_pieces,
                       int &nodes_per_piece, int &wires_per_piece,
                       int &pct_wire_in_piece, int &random_seed,
-                      int &steps, int &sync, bool &perform_checks, bool &dump_values);
+                      int &steps, int &sync, bool &perform_checks, bool &dump_values,
+                      bool &use_trace);
 
 Partitions load_circuit(Circuit &ckt, std::vector<CircuitPiece> &pieces, Context ctx,
                         HighLevelRuntime *runtime, int num_pieces, int nodes_per_piece,
@@ -60,6 +62,7 @@ void top_level_task(const Task *task,
   int sync = 0;
   bool perform_checks = false;
   bool dump_values = false;
+  bool use_trace = false;
   {
     const InputArgs &command_args = HighLevelRuntime::get_input_args();
     char **argv = command_args.argv;
@@ -67,7 +70,7 @@ void top_level_task(const Task *task,
 
     parse_input_args(argv, argc, num_loops, num_pieces, nodes_per_piece, 
 		     wires_per_piece, pct_wire_in_piece, random_seed,
-		     steps, sync, perform_checks, dump_values);
+		     steps, sync, perform_checks, dump_values, use_trace);
 
     log_circuit(LEVEL_PRINT,"circuit settings: loops=%d pieces=%d nodes/piece=%d "
                             "wires/piece=%d pct_in_piece=%d seed=%d",
@@ -136,8 +139,13 @@ void top_level_task(const Task *task,
   ts_start = LegionRuntime::TimeStamp::get_current_time_in_micros();
   // Run the main loop
   bool simulation_success = true;
+  // The checks launch a different set of tasks once they fail,
+  // so only trace the loop when it is the same every time
+  const bool trace_loop = use_trace && !perform_checks;
   for (int i = 0; i < num_loops; i++)
   {
+    if (trace_loop)
+      runtime->begin_trace(ctx, MAIN_LOOP_TRACE_ID);
     TaskHelper::dispatch_task<CalcNewCurrentsTask>(cnc_launcher, ctx, runtime, 
                                                    perform_checks, simulation_success);
     TaskHelper::dispatch_task<DistributeChargeTask>(dsc_launcher, ctx, runtime, 
@@ -145,6 +153,8 @@ void top_level_task(const Task *task,
     TaskHelper::dispatch_task<UpdateVoltagesTask>(upv_launcher, ctx, runtime, 
                                                   perform_checks, simulation_success,
                                                   ((i+1)==num_loops));
+    if (trace_loop)
+      runtime->end_trace(ctx, MAIN_LOOP_TRACE_ID);
   }
   ts_end = LegionRuntime::TimeStamp::get_current_time_in_micros();
   if (simulation_success)
@@ -217,10 +227,28 @@ void top_level_task(const Task *task,
 static void update_mappers(Machine machine, HighLevelRuntime *rt,
                            const std::set<Processor> &local_procs)
 {
+  // Pick the mapper with -mapper circuit|default|adaptive so
+  // that they can be compared on the same problem
+  const char *mapper_name = "circuit";
+  {
+    const InputArgs &command_args = HighLevelRuntime::get_input_args();
+    for (int i = 1; i < (command_args.argc - 1); i++)
+    {
+      if (!strcmp(command_args.argv[i], "-mapper"))
+        mapper_name = command_args.argv[i+1];
+    }
+  }
   for (std::set<Processor>::const_iterator it = local_procs.begin();
         it != local_procs.end(); it++)
   {
-    rt->replace_default_mapper(new CircuitMapper(machine, rt, *it), *it);
+    Mapper *mapper;
+    if (!strcmp(mapper_name, "adaptive"))
+      mapper = new AdaptiveMapper(machine, rt, *it);
+    else if (!strcmp(mapper_name, "default"))
+      mapper = new DefaultMapper(machine, rt, *it);
+    else
+      mapper = new CircuitMapper(machine, rt, *it);
+    rt->replace_default_mapper(mapper, *it);
   }
 }
 
@@ -251,7 +279,7 @@ void parse_input_args(char **argv, int argc, int &num_loops, int &num_pieces,
                       int &nodes_per_piece, int &wires_per_piece,
                       int &pct_wire_in_piece, int &random_seed,
                       int &steps, int &sync, bool &perform_checks,
-                      bool &dump_values)
+                      bool &dump_values, bool &use_trace)
 {
   for (int i = 1; i < argc; i++) 
   {
@@ -314,6 +342,12 @@ void parse_input_args(char **argv, int argc, int &num_loops, int &num_pieces,
       dump_values = true;
       continue;
     }
+
+    if(!strcmp(argv[i], "-trace"))
+    {
+      use_trace = true;
+      continue;
+    }
   }
 }
 
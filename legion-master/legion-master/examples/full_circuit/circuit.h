@@ -53,6 +53,10 @@ enum {
   REDUCE_ID = 1,
 };
 
+enum {
+  MAIN_LOOP_TRACE_ID = 1,
+};
+
 enum NodeFields {
   FID_NODE_CAP,
   FID_LEAKAGE,
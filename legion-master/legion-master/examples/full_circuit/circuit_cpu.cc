@@ -677,6 +677,115 @@ static inline void update_voltages(LogicalRegion lr,
   }
 }
 
+// Updates a run of nodes at a time through SOA spans, which lets
+// the compiler vectorize the loop instead of going through the
+// accessors one node at a time
+struct DenseUpdateVoltages {
+public:
+  DenseUpdateVoltages(const RegionAccessor<AccessorType::SOA<sizeof(float)>,float> &voltage,
+                      const RegionAccessor<AccessorType::SOA<sizeof(float)>,float> &charge,
+                      const RegionAccessor<AccessorType::SOA<sizeof(float)>,float> &cap,
+                      const RegionAccessor<AccessorType::SOA<sizeof(float)>,float> &leakage)
+    : fa_voltage(voltage), fa_charge(charge), fa_cap(cap), fa_leakage(leakage) { }
+public:
+  inline void operator()(ptr_t first, size_t count)
+  {
+    AccessorType::Span<float,sizeof(float)> voltage = fa_voltage.span(first, count);
+    AccessorType::Span<float,sizeof(float)> charge = fa_charge.span(first, count);
+    AccessorType::Span<float,sizeof(float)> cap = fa_cap.span(first, count);
+    AccessorType::Span<float,sizeof(float)> leakage = fa_leakage.span(first, count);
+    for (size_t i = 0; i < count; i++)
+    {
+      float v = voltage[i] + charge[i] / cap[i];
+      voltage[i] = v * (1.f - leakage[i]);
+      // Reset the charge for the next iteration
+      charge[i] = 0.f;
+    }
+  }
+public:
+  const RegionAccessor<AccessorType::SOA<sizeof(float)>,float> &fa_voltage;
+  const RegionAccessor<AccessorType::SOA<sizeof(float)>,float> &fa_charge;
+  const RegionAccessor<AccessorType::SOA<sizeof(float)>,float> &fa_cap;
+  const RegionAccessor<AccessorType::SOA<sizeof(float)>,float> &fa_leakage;
+};
+
+// Same update for instances whose elements are strided but not packed
+// (e.g. AOS), through the run-time strided spans of the generic
+// accessors.  A generic span can come back shorter than requested,
+// so keep going until the whole run is covered.
+struct StridedUpdateVoltages {
+public:
+  StridedUpdateVoltages(const RegionAccessor<AccessorType::Generic,float> &voltage,
+                        const RegionAccessor<AccessorType::Generic,float> &charge,
+                        const RegionAccessor<AccessorType::Generic,float> &cap,
+                        const RegionAccessor<AccessorType::Generic,float> &leakage)
+    : fa_voltage(voltage), fa_charge(charge), fa_cap(cap), fa_leakage(leakage) { }
+public:
+  inline void operator()(ptr_t first, size_t count)
+  {
+    while (count > 0)
+    {
+      AccessorType::Span<float,0> voltage = fa_voltage.span(first, count);
+      AccessorType::Span<float,0> charge = fa_charge.span(first, count);
+      AccessorType::Span<float,0> cap = fa_cap.span(first, count);
+      AccessorType::Span<float,0> leakage = fa_leakage.span(first, count);
+      size_t act_count = std::min(std::min(voltage.size(), charge.size()),
+                                  std::min(cap.size(), leakage.size()));
+      assert(act_count > 0);
+      for (size_t i = 0; i < act_count; i++)
+      {
+        float v = voltage[i] + charge[i] / cap[i];
+        voltage[i] = v * (1.f - leakage[i]);
+        // Reset the charge for the next iteration
+        charge[i] = 0.f;
+      }
+      first.value += act_count;
+      count -= act_count;
+    }
+  }
+public:
+  RegionAccessor<AccessorType::Generic,float> fa_voltage;
+  RegionAccessor<AccessorType::Generic,float> fa_charge;
+  RegionAccessor<AccessorType::Generic,float> fa_cap;
+  RegionAccessor<AccessorType::Generic,float> fa_leakage;
+};
+
+static inline bool dense_update_voltages(LogicalRegion lr,
+                            const RegionAccessor<AccessorType::Generic,float> &fa_voltage,
+                            const RegionAccessor<AccessorType::Generic,float> &fa_charge,
+                            const RegionAccessor<AccessorType::Generic,float> &fa_cap,
+                            const RegionAccessor<AccessorType::Generic,float> &fa_leakage)
+{
+  // No direct pointer to the instances, go point by point
+  if (!fa_voltage.can_convert<AccessorType::SOA<0> >() ||
+      !fa_charge.can_convert<AccessorType::SOA<0> >() ||
+      !fa_cap.can_convert<AccessorType::SOA<0> >() ||
+      !fa_leakage.can_convert<AccessorType::SOA<0> >())
+    return false;
+  // Check for the exact type we convert to, anything else with a
+  // different stride takes the run-time strided path
+  if (!fa_voltage.can_convert<AccessorType::SOA<sizeof(float)> >() ||
+      !fa_charge.can_convert<AccessorType::SOA<sizeof(float)> >() ||
+      !fa_cap.can_convert<AccessorType::SOA<sizeof(float)> >() ||
+      !fa_leakage.can_convert<AccessorType::SOA<sizeof(float)> >())
+  {
+    StridedUpdateVoltages functor(fa_voltage, fa_charge, fa_cap, fa_leakage);
+    for_each_span(lr, functor);
+    return true;
+  }
+  RegionAccessor<AccessorType::SOA<sizeof(float)>,float> soa_voltage = 
+    fa_voltage.convert<AccessorType::SOA<sizeof(float)> >();
+  RegionAccessor<AccessorType::SOA<sizeof(float)>,float> soa_charge = 
+    fa_charge.convert<AccessorType::SOA<sizeof(float)> >();
+  RegionAccessor<AccessorType::SOA<sizeof(float)>,float> soa_cap = 
+    fa_cap.convert<AccessorType::SOA<sizeof(float)> >();
+  RegionAccessor<AccessorType::SOA<sizeof(float)>,float> soa_leakage = 
+    fa_leakage.convert<AccessorType::SOA<sizeof(float)> >();
+  DenseUpdateVoltages functor(soa_voltage, soa_charge, soa_cap, soa_leakage);
+  for_each_span(lr, functor);
+  return true;
+}
+
 /*static*/
 void UpdateVoltagesTask::cpu_base_impl(const CircuitPiece &p,
                                        const std::vector<PhysicalRegion> &regions)
@@ -702,10 +811,14 @@ void UpdateVoltagesTask::cpu_base_impl(const CircuitPiece &p,
   //RegionAccessor<AccessorType::Generic, PointerLocation> fa_location = 
   //  regions[4].get_field_accessor(FID_LOCATOR).typeify<PointerLocation>();
 
-  update_voltages(p.pvt_nodes, fa_pvt_voltage, fa_pvt_charge, 
-                  fa_pvt_cap, fa_pvt_leakage);
-  update_voltages(p.shr_nodes, fa_shr_voltage, fa_shr_charge, 
-                  fa_shr_cap, fa_shr_leakage);
+  if (!dense_update_voltages(p.pvt_nodes, fa_pvt_voltage, fa_pvt_charge,
+                             fa_pvt_cap, fa_pvt_leakage))
+    update_voltages(p.pvt_nodes, fa_pvt_voltage, fa_pvt_charge, 
+                    fa_pvt_cap, fa_pvt_leakage);
+  if (!dense_update_voltages(p.shr_nodes, fa_shr_voltage, fa_shr_charge,
+                             fa_shr_cap, fa_shr_leakage))
+    update_voltages(p.shr_nodes, fa_shr_voltage, fa_shr_charge, 
+                    fa_shr_cap, fa_shr_leakage);
 #endif
 }
 
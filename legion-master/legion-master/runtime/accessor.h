@@ -132,6 +132,8 @@ namespace LegionRuntime {
 	/*const*/ T value;
       };
 
+      template <typename T, size_t STRIDE> struct Span;
+
       template <size_t STRIDE> struct AOS;
       template <size_t STRIDE> struct SOA;
       template <size_t STRIDE, size_t BLOCK_SIZE, size_t BLOCK_STRIDE> struct HybridSOA;
@@ -297,6 +299,20 @@ namespace LegionRuntime {
 	  T *raw_span_ptr(ptr_t ptr, size_t req_count, size_t& act_count, ByteOffset& offset)
 	  { return (T*)(Untyped::raw_span_ptr(ptr, req_count, act_count, offset)); }
 
+	  // The stride of a generic accessor is only known at run time.
+	  // The span may be shorter than 'count' (e.g. it stops at the end
+	  // of a block), so callers must loop until they have covered the
+	  // range they asked for.
+	  Span<T, 0> span(ptr_t first, size_t count)
+	  {
+	    size_t act_count = 0;
+	    ByteOffset stride;
+	    void *base = Untyped::raw_span_ptr(first, count, act_count, stride);
+	    if (act_count > count)
+	      act_count = count;
+	    return Span<T, 0>(base, stride.offset, act_count);
+	  }
+
 	  template <int DIM>
 	  T *raw_rect_ptr(const Rect<DIM>& r, Rect<DIM> &subrect, ByteOffset *offsets)
 	  { return (T*)(Untyped::raw_rect_ptr<DIM>(r, subrect, offsets)); }
@@ -502,6 +518,36 @@ namespace LegionRuntime {
         BlockStride(size_t _value) : Const<size_t, BLOCK_STRIDE>(_value) {}
       };
 
+      // A span is a run of consecutive elements of one field given by
+      // the address of the first element, the byte stride between
+      // elements and the number of elements.  Spans made by the AOS,
+      // SOA and HybridSOA accessors carry the accessor's compile-time
+      // stride, so a counted loop over a span is a unit- or constant-
+      // stride loop that the compiler can vectorize.
+      template <typename T, size_t STRIDE>
+      struct Span : public Stride<STRIDE> {
+        CUDAPREFIX
+        Span(void) : Stride<STRIDE>(), base(0), length(0) {}
+        CUDAPREFIX
+        Span(void *_base, size_t _stride, size_t _length)
+          : Stride<STRIDE>(_stride), base((char *)_base), length(_length) {}
+
+        CUDAPREFIX
+        inline T& operator[](size_t idx) const
+        { return *(T *)(base + (idx * Stride<STRIDE>::value)); }
+        CUDAPREFIX
+        inline size_t size(void) const { return length; }
+        // Elements are packed and the span can be used as a plain array
+        CUDAPREFIX
+        inline bool is_dense(void) const
+        { return (Stride<STRIDE>::value == sizeof(T)); }
+        CUDAPREFIX
+        inline T *ptr(void) const { return (T *)base; }
+
+        char *base;
+        size_t length;
+      };
+
       template <size_t STRIDE> 
       struct AOS {
 	struct Untyped : public Stride<STRIDE> {
@@ -597,6 +643,22 @@ namespace LegionRuntime {
             return *((T*)Untyped::elem_ptr(ptr)); 
           }
 
+          CUDAPREFIX
+          inline Span<T, STRIDE> span(ptr_t first, size_t count) const
+          {
+#ifdef PRIVILEGE_CHECKS
+            // Don't check privileges on spans
+            //check_privileges<ACCESSOR_WRITE>(this->template priv, this->region);
+#endif
+#ifdef BOUNDS_CHECKS 
+            check_bounds(this->region, first);
+            if (count > 0)
+              check_bounds(this->region, ptr_t(first.value + count - 1));
+#endif
+            return Span<T, STRIDE>(Untyped::elem_ptr(first), 
+                                   Stride<STRIDE>::value, count);
+          }
+
 	  template<typename REDOP> CUDAPREFIX
 	  inline void reduce(ptr_t ptr, typename REDOP::RHS newval) const
 	  {
@@ -713,6 +775,22 @@ namespace LegionRuntime {
             return *((T*)Untyped::elem_ptr(ptr)); 
           }
 
+          CUDAPREFIX
+          inline Span<T, STRIDE> span(ptr_t first, size_t count) const
+          {
+#ifdef PRIVILEGE_CHECKS
+            // Don't check privileges on spans
+            //check_privileges<ACCESSOR_WRITE>(this->template priv, this->region);
+#endif
+#ifdef BOUNDS_CHECKS 
+            check_bounds(this->region, first);
+            if (count > 0)
+              check_bounds(this->region, ptr_t(first.value + count - 1));
+#endif
+            return Span<T, STRIDE>(Untyped::elem_ptr(first), 
+                                   Stride<STRIDE>::value, count);
+          }
+
 	  template<typename REDOP> CUDAPREFIX
 	  inline void reduce(ptr_t ptr, typename REDOP::RHS newval) const
 	  {
@@ -824,6 +902,22 @@ namespace LegionRuntime {
             return *((T*)Untyped::elem_ptr(ptr)); 
           }
 
+          CUDAPREFIX
+          inline Span<T, STRIDE> span(ptr_t first, size_t count) const
+          {
+#ifdef PRIVILEGE_CHECKS
+            // Don't check privileges on spans
+            //check_privileges<ACCESSOR_WRITE>(this->template priv, this->region);
+#endif
+#ifdef BOUNDS_CHECKS 
+            check_bounds(this->region, first);
+            if (count > 0)
+              check_bounds(this->region, ptr_t(first.value + count - 1));
+#endif
+            return Span<T, STRIDE>(Untyped::elem_ptr(first), 
+                                   Stride<STRIDE>::value, count);
+          }
+
 	  template<typename REDOP> CUDAPREFIX
 	  inline void reduce(ptr_t ptr, typename REDOP::RHS newval) const
 	  {
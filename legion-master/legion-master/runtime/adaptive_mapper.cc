@@ -0,0 +1,351 @@
+/* Copyright 2015 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "legion.h"
+#include "adaptive_mapper.h"
+
+#include <cstdlib>
+#include <cassert>
+#include <algorithm>
+
+#define STATIC_STABLE_ITERATIONS      4
+#define STATIC_REPROFILE_INTERVAL     64
+#define STATIC_MIN_SLICE_TIME         100 /*us*/
+#define STATIC_TOLERANCE              25 /*percent*/
+#define STATIC_ADAPTIVE_SAMPLES       4
+#define STATIC_MAX_LATENCY_SAMPLES    32
+
+namespace LegionRuntime {
+  namespace HighLevel {
+
+    Logger::Category log_adaptive("adaptive_mapper");
+
+    //--------------------------------------------------------------------------
+    AdaptiveMapper::AdaptiveMapper(Machine m, HighLevelRuntime *rt,
+                                   Processor local)
+      : DefaultMapper(m, rt, local),
+        stable_iterations(STATIC_STABLE_ITERATIONS),
+        reprofile_interval(STATIC_REPROFILE_INTERVAL),
+        min_slice_time(STATIC_MIN_SLICE_TIME),
+        tolerance(STATIC_TOLERANCE)
+    //--------------------------------------------------------------------------
+    {
+      log_adaptive(LEVEL_SPEW,"Initializing the adaptive mapper for "
+                              "processor " IDFMT "", local_proc.id);
+      {
+        int argc = HighLevelRuntime::get_input_args().argc;
+        char **argv = HighLevelRuntime::get_input_args().argv;
+        unsigned num_profiling_samples = STATIC_ADAPTIVE_SAMPLES;
+        for (int i=1; i < argc; i++)
+        {
+#define INT_ARG(argname, varname) do {      \
+          if (!strcmp(argv[i], argname)) {  \
+            varname = atoi(argv[++i]);      \
+            continue;                       \
+          } } while(0);
+          INT_ARG("-am:samples", num_profiling_samples);
+          INT_ARG("-am:stable", stable_iterations);
+          INT_ARG("-am:reprofile", reprofile_interval);
+          INT_ARG("-am:grain", min_slice_time);
+          INT_ARG("-am:tolerance", tolerance);
+#undef INT_ARG
+        }
+        profiler.set_needed_profiling_samples(num_profiling_samples);
+      }
+      // Don't try to profile variants for processors we don't have
+      const Processor::Kind all_kinds[] = { Processor::TOC_PROC,
+        Processor::LOC_PROC, Processor::UTIL_PROC, Processor::PROC_GROUP };
+      for (unsigned idx = 0; idx < (sizeof(all_kinds)/sizeof(all_kinds[0]));
+            idx++)
+      {
+        if (machine_interface.filter_processors(all_kinds[idx]).empty())
+          profiler.ignore_processor_kind(all_kinds[idx]);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    AdaptiveMapper::AdaptiveMapper(const AdaptiveMapper &rhs)
+      : DefaultMapper(rhs)
+    //--------------------------------------------------------------------------
+    {
+      // should never be called
+      assert(false);
+    }
+
+    //--------------------------------------------------------------------------
+    AdaptiveMapper::~AdaptiveMapper(void)
+    //--------------------------------------------------------------------------
+    {
+      log_adaptive(LEVEL_SPEW,"Deleting adaptive mapper for processor "
+                              IDFMT "", local_proc.id);
+    }
+
+    //--------------------------------------------------------------------------
+    AdaptiveMapper& AdaptiveMapper::operator=(const AdaptiveMapper &rhs)
+    //--------------------------------------------------------------------------
+    {
+      // should never be called
+      assert(false);
+      return *this;
+    }
+
+    //--------------------------------------------------------------------------
+    void AdaptiveMapper::select_task_options(Task *task)
+    //--------------------------------------------------------------------------
+    {
+      log_adaptive(LEVEL_SPEW,"Select task options in adaptive mapper "
+                              "for processor " IDFMT "", local_proc.id);
+      task->inline_task = false;
+      task->spawn_task = stealing_enabled;
+      task->map_locally = false;
+      task->task_priority = 0; // No prioritization
+      // This also decides whether the task needs to be profiled
+      Processor::Kind kind = select_processor_kind(task);
+      if (kind == local_kind)
+        task->target_proc = local_proc;
+      else
+        task->target_proc = select_kind_processor(kind);
+    }
+
+    //--------------------------------------------------------------------------
+    void AdaptiveMapper::slice_domain(const Task *task, const Domain &domain,
+                                      std::vector<DomainSplit> &slices)
+    //--------------------------------------------------------------------------
+    {
+      log_adaptive(LEVEL_SPEW,"Slice index space in adaptive mapper for task "
+                              "%s (ID %lld) for processor " IDFMT "",
+                              task->variants->name,
+                              task->get_unique_task_id(), local_proc.id);
+      Processor::Kind kind = task->target_proc.kind();
+      const std::set<Processor> &kind_procs =
+        machine_interface.filter_processors(kind);
+      std::vector<Processor> procs(kind_procs.begin(), kind_procs.end());
+      if (procs.empty())
+        procs.push_back(local_proc);
+      // Start from the default number of slices and then coarsen
+      // them if the points are too cheap to be worth distributing
+      size_t num_slices = procs.size() * splitting_factor;
+      long long point_time = profiler.average_execution_time(task, kind);
+      if ((point_time >= 0) && (min_slice_time > 0))
+      {
+        size_t total_time = point_time * domain.get_volume();
+        size_t useful_slices = total_time / min_slice_time;
+        if (useful_slices < 1)
+          useful_slices = 1;
+        if (useful_slices < num_slices)
+          num_slices = useful_slices;
+      }
+      unsigned factor = 1;
+      if (num_slices < procs.size())
+        procs.resize(num_slices);
+      else
+        factor = num_slices / procs.size();
+      log_adaptive(LEVEL_DEBUG,"Slicing task %s (ID %lld) into %zd slices "
+                               "over %zd processors",
+                               task->variants->name,
+                               task->get_unique_task_id(),
+                               num_slices, procs.size());
+      DefaultMapper::decompose_index_space(domain, procs, factor, slices);
+    }
+
+    //--------------------------------------------------------------------------
+    void AdaptiveMapper::notify_mapping_result(const Mappable *mappable)
+    //--------------------------------------------------------------------------
+    {
+      DefaultMapper::notify_mapping_result(mappable);
+      if (mappable->get_mappable_kind() == Mappable::TASK_MAPPABLE)
+      {
+        const Task *task = mappable->as_mappable_task();
+        // Remember when profiled tasks finished mapping so we
+        // can measure how long it takes for their data to arrive
+        if (task->profile_task)
+          mapped_times[task->get_unique_task_id()] =
+            TimeStamp::get_current_time_in_micros();
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    void AdaptiveMapper::notify_profiling_info(const Task *task)
+    //--------------------------------------------------------------------------
+    {
+      log_adaptive(LEVEL_SPEW,"Notify profiling info for task %s (ID %lld) in "
+                              "adaptive mapper for processor " IDFMT "",
+                              task->variants->name,
+                              task->get_unique_task_id(),
+                              task->target_proc.id);
+      Processor::Kind kind = task->target_proc.kind();
+      std::map<UniqueID,unsigned long long>::iterator mapped_finder =
+        mapped_times.find(task->get_unique_task_id());
+      if (mapped_finder != mapped_times.end())
+      {
+        // Profiling times are relative to the start of the runtime so
+        // recover the offset from the current time, which is only a
+        // few microseconds after the stop time of the task
+        unsigned long long now = TimeStamp::get_current_time_in_micros();
+        unsigned long long start = task->start_time + (now - task->stop_time);
+        if (start > mapped_finder->second)
+        {
+          LatencyProfile &profile = latency_profiles[
+            std::pair<Processor::TaskFuncID,Processor::Kind>(task->task_id,
+                                                             kind)];
+          if (profile.latencies.size() == STATIC_MAX_LATENCY_SAMPLES)
+          {
+            profile.total_time -= profile.latencies.front();
+            profile.latencies.pop_front();
+          }
+          long long latency = start - mapped_finder->second;
+          profile.total_time += latency;
+          profile.latencies.push_back(latency);
+        }
+        mapped_times.erase(mapped_finder);
+      }
+      // Check whether this run agrees with what we've seen before
+      TaskDecision &decision = decisions[task->task_id];
+      long long exec_time = task->stop_time - task->start_time;
+      long long average = profiler.average_execution_time(task, kind);
+      long long deviation = (exec_time > average) ? (exec_time - average) :
+                                                    (average - exec_time);
+      bool stable = (average >= 0) && ((deviation * 100) <=
+                                       (average * (long long)tolerance));
+      if (decision.memoized)
+      {
+        if (!stable)
+        {
+          log_adaptive(LEVEL_DEBUG,"Performance of task %s changed, "
+                                   "re-evaluating its mapping",
+                                   task->variants->name);
+          decision.memoized = false;
+          decision.stable_count = 0;
+        }
+      }
+      else if (stable && decision.kind_valid && (decision.kind == kind) &&
+               (decision.stable_count >= stable_iterations))
+      {
+        log_adaptive(LEVEL_DEBUG,"Memoizing mapping of task %s on processor "
+                                 "kind %d", task->variants->name, kind);
+        decision.memoized = true;
+        memoizer.commit_mapping(task->target_proc, task);
+      }
+      Mapper::ExecutionProfile profiling;
+      profiling.start_time = task->start_time;
+      profiling.stop_time = task->stop_time;
+      profiler.update_profiling_info(task, task->target_proc, kind, profiling);
+    }
+
+    //--------------------------------------------------------------------------
+    Processor::Kind AdaptiveMapper::select_processor_kind(Task *task)
+    //--------------------------------------------------------------------------
+    {
+      TaskDecision &decision = decisions[task->task_id];
+      decision.launches++;
+      if (decision.memoized)
+      {
+        task->profile_task = (reprofile_interval > 0) &&
+                             ((decision.launches % reprofile_interval) == 0);
+        return decision.kind;
+      }
+      task->profile_task = true;
+      if (!profiler.profiling_complete(task))
+        return profiler.next_processor_kind(task);
+      // Pick the kind with the lowest execution plus data movement cost
+      bool best_set = false;
+      long long best_cost = 0;
+      Processor::Kind best_kind = local_kind;
+      const std::map<VariantID,TaskVariantCollection::Variant> &variants =
+        task->variants->get_all_variants();
+      for (std::map<VariantID,TaskVariantCollection::Variant>::const_iterator
+            it = variants.begin(); it != variants.end(); it++)
+      {
+        Processor::Kind kind = it->second.proc_kind;
+        if (!task->variants->has_variant(kind, !(task->is_index_space),
+                                         task->is_index_space))
+          continue;
+        long long cost = estimate_cost(task, kind);
+        if (cost < 0)
+          continue;
+        if (!best_set || (cost < best_cost))
+        {
+          best_cost = cost;
+          best_kind = kind;
+          best_set = true;
+        }
+      }
+      if (!best_set)
+        return profiler.best_processor_kind(task);
+      if (decision.kind_valid && (decision.kind == best_kind))
+        decision.stable_count++;
+      else
+      {
+        decision.kind = best_kind;
+        decision.kind_valid = true;
+        decision.stable_count = 1;
+      }
+      return best_kind;
+    }
+
+    //--------------------------------------------------------------------------
+    Processor AdaptiveMapper::select_kind_processor(Processor::Kind kind)
+    //--------------------------------------------------------------------------
+    {
+      const std::set<Processor> &kind_procs =
+        machine_interface.filter_processors(kind);
+      if (kind_procs.empty())
+        return local_proc;
+      // Round-robin over the processors of the kind
+      unsigned &next = next_kind_proc[kind];
+      if (next >= kind_procs.size())
+        next = 0;
+      std::set<Processor>::const_iterator it = kind_procs.begin();
+      std::advance(it, next++);
+      return *it;
+    }
+
+    //--------------------------------------------------------------------------
+    long long AdaptiveMapper::estimate_cost(const Task *task,
+                                            Processor::Kind kind) const
+    //--------------------------------------------------------------------------
+    {
+      long long cost = profiler.average_execution_time(task, kind);
+      if (cost < 0)
+        return cost;
+      std::map<std::pair<Processor::TaskFuncID,Processor::Kind>,
+               LatencyProfile>::const_iterator finder = latency_profiles.find(
+          std::pair<Processor::TaskFuncID,Processor::Kind>(task->task_id,kind));
+      if ((finder != latency_profiles.end()) &&
+          !finder->second.latencies.empty())
+        cost += (finder->second.total_time /
+                 (long long)finder->second.latencies.size());
+      return cost;
+    }
+
+    //--------------------------------------------------------------------------
+    AdaptiveMapper::TaskDecision::TaskDecision(void)
+      : kind(Processor::LOC_PROC), kind_valid(false), memoized(false),
+        stable_count(0), launches(0)
+    //--------------------------------------------------------------------------
+    {
+    }
+
+    //--------------------------------------------------------------------------
+    AdaptiveMapper::LatencyProfile::LatencyProfile(void)
+      : total_time(0)
+    //--------------------------------------------------------------------------
+    {
+    }
+
+  };
+};
+
+// EOF
@@ -0,0 +1,107 @@
+/* Copyright 2015 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __ADAPTIVE_MAPPER_H__
+#define __ADAPTIVE_MAPPER_H__
+
+#include "legion.h"
+#include "default_mapper.h"
+
+namespace LegionRuntime {
+  namespace HighLevel {
+
+    /**
+     * \class AdaptiveMapper
+     * The adaptive mapper is an extension of the default mapper
+     * whose decisions are driven by profiling information that
+     * is gathered online.  For each task ID it learns the execution
+     * time of each variant as well as the latency between when a
+     * task is mapped and when it begins running, which is dominated
+     * by the copies required to move its data into place.  These
+     * costs are used to pick the processor kind (and therefore the
+     * variant) for a task and the granularity at which index space
+     * launches are sliced.  Once the choice for a task ID has been
+     * stable for several iterations the decision and the region
+     * mappings are memoized, and profiling is only re-enabled
+     * periodically to detect changes in the behavior of the task.
+     */
+    class AdaptiveMapper : public DefaultMapper {
+    public:
+      AdaptiveMapper(Machine machine, HighLevelRuntime *rt, Processor local);
+      AdaptiveMapper(const AdaptiveMapper &rhs);
+      virtual ~AdaptiveMapper(void);
+    public:
+      AdaptiveMapper& operator=(const AdaptiveMapper &rhs);
+    public:
+      virtual void select_task_options(Task *task);
+      virtual void slice_domain(const Task *task, const Domain &domain,
+                                std::vector<DomainSplit> &slices);
+      virtual void notify_mapping_result(const Mappable *mappable);
+      virtual void notify_profiling_info(const Task *task);
+    protected:
+      Processor::Kind select_processor_kind(Task *task);
+      Processor select_kind_processor(Processor::Kind kind);
+      long long estimate_cost(const Task *task, Processor::Kind kind) const;
+    protected:
+      struct TaskDecision {
+      public:
+        TaskDecision(void);
+      public:
+        Processor::Kind kind;
+        bool kind_valid;
+        bool memoized;
+        unsigned stable_count;
+        unsigned long long launches;
+      };
+      struct LatencyProfile {
+      public:
+        LatencyProfile(void);
+      public:
+        long long total_time;
+        std::list<long long> latencies;
+      };
+    protected:
+      // The number of consecutive iterations that a decision must be
+      // the same before it is memoized
+      // Controlled by -am:stable
+      unsigned stable_iterations;
+      // How often memoized tasks are profiled again (0 means never)
+      // Controlled by -am:reprofile
+      unsigned reprofile_interval;
+      // The minimum amount of work in microseconds that each
+      // slice of an index space launch should contain
+      // Controlled by -am:grain
+      unsigned min_slice_time;
+      // The percentage deviation from the average execution time
+      // that is still considered stable
+      // Controlled by -am:tolerance
+      unsigned tolerance;
+      std::map<Processor::TaskFuncID,TaskDecision> decisions;
+      // Mapping-to-execution latencies for each task ID and processor kind
+      std::map<std::pair<Processor::TaskFuncID,Processor::Kind>,
+               LatencyProfile> latency_profiles;
+      // Times at which profiled tasks finished mapping
+      std::map<UniqueID,unsigned long long> mapped_times;
+      // Next processor for each kind when spreading tasks
+      std::map<Processor::Kind,unsigned> next_kind_proc;
+    };
+
+  };
+};
+
+#endif // __ADAPTIVE_MAPPER_H__
+
+// EOF
@@ -23,6 +23,7 @@
 #define STATIC_MAX_PERMITTED_STEALS   4
 #define STATIC_MAX_STEAL_COUNT        2
 #define STATIC_SPLIT_FACTOR           2
+#define STATIC_SLICE_RADIX            0
 #define STATIC_BREADTH_FIRST          false
 #define STATIC_WAR_ENABLED            false 
 #define STATIC_STEALING_ENABLED       false
@@ -46,6 +47,7 @@ namespace LegionRuntime {
         max_steals_per_theft(STATIC_MAX_PERMITTED_STEALS),
         max_steal_count(STATIC_MAX_STEAL_COUNT),
         splitting_factor(STATIC_SPLIT_FACTOR),
+        slice_radix(STATIC_SLICE_RADIX),
         breadth_first_traversal(STATIC_BREADTH_FIRST),
         war_enabled(STATIC_WAR_ENABLED),
         stealing_enabled(STATIC_STEALING_ENABLED),
@@ -78,6 +80,7 @@ namespace LegionRuntime {
           INT_ARG("-dm:thefts", max_steals_per_theft);
           INT_ARG("-dm:count", max_steal_count);
           INT_ARG("-dm:split", splitting_factor);
+          INT_ARG("-dm:radix", slice_radix);
           BOOL_ARG("-dm:war", war_enabled);
           BOOL_ARG("-dm:steal", stealing_enabled);
           BOOL_ARG("-dm:bft", breadth_first_traversal);
@@ -361,8 +364,10 @@ namespace LegionRuntime {
       machine_interface.filter_processors(machine, best_kind, all_procs);
       std::vector<Processor> procs(all_procs.begin(),all_procs.end());
 
-      DefaultMapper::decompose_index_space(domain, procs, 
-                                           splitting_factor, slices);
+      DefaultMapper::decompose_index_space_tree(domain, procs, 
+                                                splitting_factor, slice_radix,
+                                                task->orig_proc, local_proc,
+                                                slices);
     }
 
     //--------------------------------------------------------------------------
@@ -870,6 +875,43 @@ namespace LegionRuntime {
       }
     }
 
+    template <unsigned DIM>
+    static void weighted_rect_split(const Domain &domain,
+                                    const std::vector<unsigned> &weights,
+                                    std::vector<Domain> &pieces)
+    {
+      Arrays::Rect<DIM> r = domain.get_rect<DIM>();
+      // Cut along the dimension with the largest extent
+      unsigned cut = 0;
+      for (unsigned d = 1; d < DIM; d++)
+      {
+        if ((r.hi[d] - r.lo[d]) > (r.hi[cut] - r.lo[cut]))
+          cut = d;
+      }
+      const long long extent = r.hi[cut] - r.lo[cut] + 1;
+      long long total = 0;
+      for (unsigned idx = 0; idx < weights.size(); idx++)
+        total += weights[idx];
+      long long prefix = 0;
+      int lo = r.lo[cut];
+      for (unsigned idx = 0; idx < weights.size(); idx++)
+      {
+        prefix += weights[idx];
+        int hi = r.lo[cut] + int((extent * prefix) / total) - 1;
+        if (hi < lo)
+        {
+          // Too small a share to get any points
+          pieces.push_back(Domain::NO_DOMAIN);
+          continue;
+        }
+        Arrays::Rect<DIM> sub = r;
+        sub.lo.x[cut] = lo;
+        sub.hi.x[cut] = hi;
+        pieces.push_back(Domain::from_rect<DIM>(sub));
+        lo = hi + 1;
+      }
+    }
+
     //--------------------------------------------------------------------------
     /*static*/ void DefaultMapper::decompose_index_space(const Domain &domain, 
                                           const std::vector<Processor> &targets,
@@ -988,5 +1030,102 @@ namespace LegionRuntime {
       }
     }
 
+    //--------------------------------------------------------------------------
+    /*static*/ void DefaultMapper::decompose_index_space_tree(
+                                          const Domain &domain,
+                                          const std::vector<Processor> &targets,
+                                          unsigned splitting_factor,
+                                          unsigned radix, Processor origin,
+                                          Processor local,
+                                      std::vector<Mapper::DomainSplit> &slices)
+    //--------------------------------------------------------------------------
+    {
+      // Group the target processors by the node that they are on
+      std::map<AddressSpace,std::vector<Processor> > node_procs;
+      for (std::vector<Processor>::const_iterator it = targets.begin();
+            it != targets.end(); it++)
+        node_procs[it->address_space()].push_back(*it);
+      // The origin is the root of the tree even if it has no targets
+      node_procs[origin.address_space()];
+      const unsigned num_nodes = node_procs.size();
+      // Only use a tree when the origin would otherwise have to send
+      // slices to more than radix other nodes and we know how to cut
+      // the domain, otherwise just slice it flat
+      if ((radix == 0) || (num_nodes <= (radix+1)) || 
+          (domain.get_dim() == 0) || 
+          (node_procs.find(local.address_space()) == node_procs.end()))
+      {
+        decompose_index_space(domain, targets, splitting_factor, slices);
+        return;
+      }
+      // Rank all the nodes relative to the origin so that every node
+      // can compute the same implicit radix-k tree and find its subtree
+      std::vector<AddressSpace> nodes;
+      nodes.reserve(num_nodes);
+      unsigned root = 0, local_pos = 0;
+      for (std::map<AddressSpace,std::vector<Processor> >::const_iterator it =
+            node_procs.begin(); it != node_procs.end(); it++)
+      {
+        if (it->first == origin.address_space())
+          root = nodes.size();
+        if (it->first == local.address_space())
+          local_pos = nodes.size();
+        nodes.push_back(it->first);
+      }
+      const unsigned local_rank = (local_pos + num_nodes - root) % num_nodes;
+      // Weight our part and each child subtree by their processor counts
+      std::vector<unsigned> weights;
+      std::vector<AddressSpace> owners;
+      weights.push_back(node_procs[local.address_space()].size());
+      owners.push_back(local.address_space());
+      for (unsigned child = local_rank*radix + 1; 
+            (child <= (local_rank*radix + radix)) && (child < num_nodes); 
+            child++)
+      {
+        unsigned subtree_procs = 0;
+        // Walk the subtree one level at a time
+        for (unsigned lo = child, hi = child; lo < num_nodes; 
+              lo = lo*radix + 1, hi = hi*radix + radix)
+        {
+          for (unsigned rank = lo; (rank <= hi) && (rank < num_nodes); rank++)
+            subtree_procs += node_procs[nodes[(rank + root) % num_nodes]].size();
+        }
+        weights.push_back(subtree_procs);
+        owners.push_back(nodes[(child + root) % num_nodes]);
+      }
+      std::vector<Domain> pieces;
+      switch (domain.get_dim())
+      {
+        case 1:
+          weighted_rect_split<1>(domain, weights, pieces);
+          break;
+        case 2:
+          weighted_rect_split<2>(domain, weights, pieces);
+          break;
+        case 3:
+          weighted_rect_split<3>(domain, weights, pieces);
+          break;
+        default:
+          assert(false);
+      }
+      for (unsigned idx = 0; idx < pieces.size(); idx++)
+      {
+        if (!pieces[idx].exists())
+          continue;
+        const std::vector<Processor> &procs = node_procs[owners[idx]];
+        if (idx == 0)
+        {
+          // Our own part gets sliced across our local processors
+          decompose_index_space(pieces[idx], procs, splitting_factor, slices);
+        }
+        else
+        {
+          // Each child subtree is sliced again on its root node
+          slices.push_back(DomainSplit(pieces[idx], procs[0], 
+                                       true/*recurse*/, false/*stealable*/));
+        }
+      }
+    }
+
   };
 };
@@ -104,6 +104,13 @@ namespace LegionRuntime {
                               const std::vector<Processor> &targets,
                               unsigned splitting_factor, 
                               std::vector<Mapper::DomainSplit> &slice);
+      // Break an IndexSpace of tasks into a radix-k tree of slices
+      // over the address spaces of the target processors
+      static void decompose_index_space_tree(const Domain &domain,
+                              const std::vector<Processor> &targets,
+                              unsigned splitting_factor, unsigned radix,
+                              Processor origin, Processor local,
+                              std::vector<Mapper::DomainSplit> &slice);
     protected:
       const Processor local_proc;
       const Processor::Kind local_kind;
@@ -119,6 +126,16 @@ namespace LegionRuntime {
       // difference pieces
       // Controlled by -dm:split
       unsigned splitting_factor;
+      // The fan-out of the tree used to distribute index space slices
+      // across nodes, each node slices its own part of the domain
+      // and forwards the rest to at most slice_radix other nodes
+      // (0 distributes all the slices from the launching node)
+      // Off by default until it has been run on multiple nodes: the
+      // tree decomposition has only been checked offline against fake
+      // multi-node processor lists, and the SLICE_AGGREGATE messages
+      // have never been exchanged between real address spaces
+      // Controlled by -dm:radix
+      unsigned slice_radix;
       // Do a breadth-first traversal of the task tree, by default we do
       // a depth-first traversal to improve locality
       bool breadth_first_traversal;
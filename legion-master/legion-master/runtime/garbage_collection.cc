@@ -24,6 +24,9 @@
 namespace LegionRuntime {
   namespace HighLevel {
 
+    // Extern declarations for loggers
+    extern Logger::Category log_run;
+
     /////////////////////////////////////////////////////////////
     // CollectableState 
     /////////////////////////////////////////////////////////////
@@ -317,19 +320,17 @@ namespace LegionRuntime {
       // Remove references on any remote nodes
       if (owner)
       {
+        std::vector<AddressSpaceID> targets;
         for (std::set<AddressSpaceID>::const_iterator it = 
               remote_spaces.begin(); it != remote_spaces.end(); it++)
         {
           // We can skip ourselves
           if (owner_space == (*it))
             continue;
-          Serializer rez;
-          {
-            RezCheck z(rez);
-            rez.serialize(did);
-          }
-          runtime->send_remove_distributed_resource(*it, rez);
+          targets.push_back(*it);
         }
+        if (!targets.empty())
+          send_remove_resource_references(runtime, did, targets);
         remote_spaces.clear();
         // We can only recycle the distributed ID on the owner
         // node since the ID is the same across all the nodes.
@@ -659,7 +660,7 @@ namespace LegionRuntime {
       assert(!owner);
 #endif
       AutoLock gc(gc_lock);
-      held_remote_references++;
+      held_remote_references += cnt;
     }
 
     //--------------------------------------------------------------------------
@@ -675,16 +676,10 @@ namespace LegionRuntime {
         add_remote_reference(sid, cnt);
       else
       {
-        Serializer rez;
-        {
-          RezCheck z(rez);
-          rez.serialize(did);
-          // Need to send the sid since it might not be
-          // the same as the sender noder
-          rez.serialize(sid);
-          rez.serialize(cnt);
-        }
-        runtime->send_add_distributed_remote(owner_space, rez);
+        // Need to send the sid since it might not be
+        // the same as the sender node
+        runtime->find_reference_batch(owner_space)->add_distributed_remote(
+                                                            did, sid, cnt);
       }
       // Mark that we know there is an instance at sid
       update_remote_spaces(sid);
@@ -710,31 +705,61 @@ namespace LegionRuntime {
 #ifdef DEBUG_HIGH_LEVEL
       assert(!owner);
 #endif
-      Serializer rez;
-      {
-        RezCheck z(rez);
-        rez.serialize(did);
-        // Always send back the destruction event
-        rez.serialize(destruction_event);
-        rez.serialize(held_remote_references);
-      }
-      runtime->send_remove_distributed_remote(owner_space, rez);
+      // Always send back the destruction event
+      runtime->find_reference_batch(owner_space)->remove_distributed_remote(
+                          did, destruction_event, held_remote_references);
       // Set the references back to zero since we sent them back
       held_remote_references = 0;
     }
  
+    //--------------------------------------------------------------------------
+    /*static*/ void DistributedCollectable::send_remove_resource_references(
+                                    Runtime *rt, DistributedID did,
+                                    const std::vector<AddressSpaceID> &targets)
+    //--------------------------------------------------------------------------
+    {
+      // Split the targets into at most radix subtrees, the first
+      // node of each subtree is responsible for forwarding the
+      // release on to the rest of the nodes in its subtree
+      const size_t radix = (Runtime::gc_release_radix > 0) ?
+                            Runtime::gc_release_radix : targets.size();
+      const size_t chunk = (targets.size() + radix - 1) / radix;
+      for (size_t start = 0; start < targets.size(); start += chunk)
+      {
+        const size_t stop = ((start + chunk) < targets.size()) ?
+                              (start + chunk) : targets.size();
+        std::vector<AddressSpaceID> forward(targets.begin() + start + 1,
+                                            targets.begin() + stop);
+        rt->find_reference_batch(targets[start])->
+                                  remove_distributed_resource(did, forward);
+      }
+    }
+ 
     //--------------------------------------------------------------------------
     /*static*/ void DistributedCollectable::process_remove_resource_reference(
                                     Runtime *rt, Deserializer &derez)
     //--------------------------------------------------------------------------
     {
       DerezCheck z(derez);
-      DistributedID did;
-      derez.deserialize(did);
-      
-      DistributedCollectable *target = rt->find_distributed_collectable(did);
-      if (target->remove_resource_reference())
-        delete target;
+      size_t num_releases;
+      derez.deserialize(num_releases);
+      for (unsigned idx = 0; idx < num_releases; idx++)
+      {
+        DistributedID did;
+        derez.deserialize(did);
+        size_t num_forward;
+        derez.deserialize(num_forward);
+        if (num_forward > 0)
+        {
+          std::vector<AddressSpaceID> forward(num_forward);
+          for (unsigned fidx = 0; fidx < num_forward; fidx++)
+            derez.deserialize(forward[fidx]);
+          send_remove_resource_references(rt, did, forward);
+        }
+        DistributedCollectable *target = rt->find_distributed_collectable(did);
+        if (target->remove_resource_reference())
+          delete target;
+      }
     }
 
     //--------------------------------------------------------------------------
@@ -743,16 +768,21 @@ namespace LegionRuntime {
     //--------------------------------------------------------------------------
     {
       DerezCheck z(derez);
-      DistributedID did;
-      derez.deserialize(did);
-      Event destruction_event;
-      derez.deserialize(destruction_event);
-      unsigned cnt;
-      derez.deserialize(cnt);
-
-      DistributedCollectable *target = rt->find_distributed_collectable(did);
-      if (target->remove_remote_reference(source, destruction_event, cnt))
-        delete target;
+      size_t num_removes;
+      derez.deserialize(num_removes);
+      for (unsigned idx = 0; idx < num_removes; idx++)
+      {
+        DistributedID did;
+        derez.deserialize(did);
+        Event destruction_event;
+        derez.deserialize(destruction_event);
+        unsigned cnt;
+        derez.deserialize(cnt);
+
+        DistributedCollectable *target = rt->find_distributed_collectable(did);
+        if (target->remove_remote_reference(source, destruction_event, cnt))
+          delete target;
+      }
     }
 
     //--------------------------------------------------------------------------
@@ -761,16 +791,21 @@ namespace LegionRuntime {
     //--------------------------------------------------------------------------
     {
       DerezCheck z(derez);
-      DistributedID did;
-      derez.deserialize(did);
-      AddressSpaceID source;
-      derez.deserialize(source);
-      unsigned cnt;
-      derez.deserialize(cnt);
-
-      DistributedCollectable *target = rt->find_distributed_collectable(did);
-      if (target->add_remote_reference(source, cnt))
-        delete target;
+      size_t num_adds;
+      derez.deserialize(num_adds);
+      for (unsigned idx = 0; idx < num_adds; idx++)
+      {
+        DistributedID did;
+        derez.deserialize(did);
+        AddressSpaceID source;
+        derez.deserialize(source);
+        unsigned cnt;
+        derez.deserialize(cnt);
+
+        DistributedCollectable *target = rt->find_distributed_collectable(did);
+        if (target->add_remote_reference(source, cnt))
+          delete target;
+      }
     }
 
     /////////////////////////////////////////////////////////////
@@ -816,16 +851,9 @@ namespace LegionRuntime {
       // Remove our references from any remote collectables
       if (!subscribers.empty())
       {
-        for (std::map<AddressSpaceID,DistributedID>::const_iterator it = 
-              subscribers.begin(); it != subscribers.end(); it++)
-        {
-          Serializer rez;
-          {
-            RezCheck z(rez);
-            rez.serialize(it->second);
-          }
-          runtime->send_remove_hierarchical_resource(it->first, rez);
-        }
+        std::vector<std::pair<AddressSpaceID,DistributedID> > 
+          targets(subscribers.begin(), subscribers.end());
+        send_remove_resource_references(runtime, targets);
       }
       // Free up our distributed id
       runtime->unregister_hierarchical_collectable(did);
@@ -1134,7 +1162,7 @@ namespace LegionRuntime {
     //--------------------------------------------------------------------------
     {
       AutoLock gc(gc_lock);
-      held_remote_references++;
+      held_remote_references += cnt;
     }
 
     //--------------------------------------------------------------------------
@@ -1165,28 +1193,64 @@ namespace LegionRuntime {
 #ifdef DEBUG_HIGH_LEVEL
       assert(did != owner_did);
 #endif
-      Serializer rez;
-      {
-        RezCheck z(rez);
-        rez.serialize(owner_did);
-        rez.serialize(held_remote_references);
-      }
-      runtime->send_remove_hierarchical_remote(owner_addr, rez);
+      runtime->find_reference_batch(owner_addr)->remove_hierarchical_remote(
+                                          owner_did, held_remote_references);
       // Set the references back to zero since we sent them back
       held_remote_references = 0;
     }
 
+    //--------------------------------------------------------------------------
+    /*static*/ void HierarchicalCollectable::send_remove_resource_references(
+                                                                 Runtime *rt,
+           const std::vector<std::pair<AddressSpaceID,DistributedID> > &targets)
+    //--------------------------------------------------------------------------
+    {
+      // Same tree as for distributed collectables, except that
+      // each subscriber has its own distributed ID
+      const size_t radix = (Runtime::gc_release_radix > 0) ?
+                            Runtime::gc_release_radix : targets.size();
+      const size_t chunk = (targets.size() + radix - 1) / radix;
+      for (size_t start = 0; start < targets.size(); start += chunk)
+      {
+        const size_t stop = ((start + chunk) < targets.size()) ?
+                              (start + chunk) : targets.size();
+        std::vector<std::pair<AddressSpaceID,DistributedID> > 
+          forward(targets.begin() + start + 1, targets.begin() + stop);
+        rt->find_reference_batch(targets[start].first)->
+                remove_hierarchical_resource(targets[start].second, forward);
+      }
+    }
+
     //--------------------------------------------------------------------------
     /*static*/ void HierarchicalCollectable::process_remove_resource_reference(
                                     Runtime *rt, Deserializer &derez)
     //--------------------------------------------------------------------------
     {
       DerezCheck z(derez);
-      DistributedID did;
-      derez.deserialize(did);
-      HierarchicalCollectable *target = rt->find_hierarchical_collectable(did);
-      if (target->remove_resource_reference())
-        delete target;
+      size_t num_releases;
+      derez.deserialize(num_releases);
+      for (unsigned idx = 0; idx < num_releases; idx++)
+      {
+        DistributedID did;
+        derez.deserialize(did);
+        size_t num_forward;
+        derez.deserialize(num_forward);
+        if (num_forward > 0)
+        {
+          std::vector<std::pair<AddressSpaceID,DistributedID> > 
+                                                        forward(num_forward);
+          for (unsigned fidx = 0; fidx < num_forward; fidx++)
+          {
+            derez.deserialize(forward[fidx].first);
+            derez.deserialize(forward[fidx].second);
+          }
+          send_remove_resource_references(rt, forward);
+        }
+        HierarchicalCollectable *target = 
+          rt->find_hierarchical_collectable(did);
+        if (target->remove_resource_reference())
+          delete target;
+      }
     }
 
     //--------------------------------------------------------------------------
@@ -1195,13 +1259,332 @@ namespace LegionRuntime {
     //--------------------------------------------------------------------------
     {
       DerezCheck z(derez);
-      DistributedID did;
-      derez.deserialize(did);
-      unsigned num_remote_references;
-      derez.deserialize(num_remote_references);
-      HierarchicalCollectable *target = rt->find_hierarchical_collectable(did);
-      if (target->remove_remote_reference(num_remote_references))
-        delete target;
+      size_t num_removes;
+      derez.deserialize(num_removes);
+      for (unsigned idx = 0; idx < num_removes; idx++)
+      {
+        DistributedID did;
+        derez.deserialize(did);
+        unsigned num_remote_references;
+        derez.deserialize(num_remote_references);
+        HierarchicalCollectable *target = 
+          rt->find_hierarchical_collectable(did);
+        if (target->remove_remote_reference(num_remote_references))
+          delete target;
+      }
+    }
+
+    /////////////////////////////////////////////////////////////
+    // ReferenceBatch 
+    /////////////////////////////////////////////////////////////
+
+    //--------------------------------------------------------------------------
+    ReferenceBatch::ReferenceBatch(Runtime *rt, AddressSpaceID t)
+      : runtime(rt), target(t), 
+        batch_lock(Reservation::create_reservation()),
+        pending_changes(0), pending_since(0), total_changes(0),
+        merged_changes(0), sent_batches(0), shutdown_changes(0)
+    //--------------------------------------------------------------------------
+    {
+    }
+
+    //--------------------------------------------------------------------------
+    ReferenceBatch::ReferenceBatch(const ReferenceBatch &rhs)
+      : runtime(NULL), target(0)
+    //--------------------------------------------------------------------------
+    {
+      // should never be called
+      assert(false);
+    }
+
+    //--------------------------------------------------------------------------
+    ReferenceBatch::~ReferenceBatch(void)
+    //--------------------------------------------------------------------------
+    {
+      if (Runtime::message_statistics)
+        log_run(LEVEL_PRINT,"Reference changes from node %d to node %d: "
+                            "%lld changes (%lld merged) in %lld batches, "
+                            "%lld changes left for shutdown",
+                            runtime->address_space, target, total_changes,
+                            merged_changes, sent_batches, shutdown_changes);
+      batch_lock.destroy_reservation();
+      batch_lock = Reservation::NO_RESERVATION;
+    }
+
+    //--------------------------------------------------------------------------
+    ReferenceBatch& ReferenceBatch::operator=(const ReferenceBatch &rhs)
+    //--------------------------------------------------------------------------
+    {
+      // should never be called
+      assert(false);
+      return *this;
+    }
+
+    //--------------------------------------------------------------------------
+    void ReferenceBatch::remove_distributed_resource(DistributedID did,
+                                     const std::vector<AddressSpaceID> &forward)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock b_lock(batch_lock);
+#ifdef DEBUG_HIGH_LEVEL
+      assert(distributed_resources.find(did) == distributed_resources.end());
+#endif
+      distributed_resources[did] = forward;
+      record_change(false/*merged*/);
+    }
+
+    //--------------------------------------------------------------------------
+    void ReferenceBatch::remove_distributed_remote(DistributedID did,
+                                                   Event dest_event,
+                                                   unsigned cnt)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock b_lock(batch_lock);
+      std::map<DistributedID,std::pair<Event,unsigned> >::iterator finder = 
+        distributed_removes.find(did);
+      if (finder != distributed_removes.end())
+      {
+#ifdef DEBUG_HIGH_LEVEL
+        // There is only ever one copy of a collectable on each node
+        assert(finder->second.first == dest_event);
+#endif
+        finder->second.second += cnt;
+        record_change(true/*merged*/);
+      }
+      else
+      {
+        distributed_removes[did] = std::pair<Event,unsigned>(dest_event, cnt);
+        record_change(false/*merged*/);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    void ReferenceBatch::add_distributed_remote(DistributedID did,
+                                                AddressSpaceID sid, 
+                                                unsigned cnt)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock b_lock(batch_lock);
+      const std::pair<DistributedID,AddressSpaceID> key(did, sid);
+      std::map<std::pair<DistributedID,AddressSpaceID>,unsigned>::iterator
+        finder = distributed_adds.find(key);
+      if (finder != distributed_adds.end())
+      {
+        finder->second += cnt;
+        record_change(true/*merged*/);
+      }
+      else
+      {
+        distributed_adds[key] = cnt;
+        record_change(false/*merged*/);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    void ReferenceBatch::remove_hierarchical_resource(DistributedID did,
+         const std::vector<std::pair<AddressSpaceID,DistributedID> > &forward)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock b_lock(batch_lock);
+#ifdef DEBUG_HIGH_LEVEL
+      assert(hierarchical_resources.find(did) == hierarchical_resources.end());
+#endif
+      hierarchical_resources[did] = forward;
+      record_change(false/*merged*/);
+    }
+
+    //--------------------------------------------------------------------------
+    void ReferenceBatch::remove_hierarchical_remote(DistributedID did,
+                                                    unsigned cnt)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock b_lock(batch_lock);
+      std::map<DistributedID,unsigned>::iterator finder = 
+        hierarchical_removes.find(did);
+      if (finder != hierarchical_removes.end())
+      {
+        finder->second += cnt;
+        record_change(true/*merged*/);
+      }
+      else
+      {
+        hierarchical_removes[did] = cnt;
+        record_change(false/*merged*/);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    void ReferenceBatch::flush(void)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock b_lock(batch_lock);
+      if (pending_changes > 0)
+        send_batch();
+    }
+
+    //--------------------------------------------------------------------------
+    void ReferenceBatch::flush_for_shutdown(void)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock b_lock(batch_lock);
+      if (pending_changes > 0)
+      {
+        shutdown_changes += pending_changes;
+        send_batch();
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    void ReferenceBatch::flush_stale(unsigned long long now)
+    //--------------------------------------------------------------------------
+    {
+      // Check without the lock first since this gets called
+      // every time the scheduler runs
+      unsigned long long since = pending_since;
+      if ((since == 0) || (now <= since) || 
+          ((now - since) < Runtime::max_message_delay))
+        return;
+      AutoLock b_lock(batch_lock);
+      since = pending_since;
+      if ((since != 0) && (now > since) &&
+          ((now - since) >= Runtime::max_message_delay))
+        send_batch();
+    }
+
+    //--------------------------------------------------------------------------
+    void ReferenceBatch::record_change(bool merged)
+    //--------------------------------------------------------------------------
+    {
+      total_changes++;
+      if (merged)
+        merged_changes++;
+      else
+        pending_changes++;
+      // Without a bound on the delay, or without a scheduler run
+      // outstanding on this node to act as the clock, there is
+      // nothing to flush the batch later so send the change right away
+      if ((Runtime::max_message_delay == 0) || 
+          (pending_changes >= Runtime::gc_batch_size) ||
+          !runtime->has_outstanding_schedulers())
+      {
+        send_batch();
+        return;
+      }
+      unsigned long long now = TimeStamp::get_current_time_in_micros();
+      if (pending_since == 0)
+        pending_since = now;
+      else if ((now > pending_since) && 
+               ((now - pending_since) >= Runtime::max_message_delay))
+        send_batch();
+    }
+
+    //--------------------------------------------------------------------------
+    void ReferenceBatch::send_batch(void)
+    //--------------------------------------------------------------------------
+    {
+      MessageManager *messenger = runtime->find_messenger(target);
+      // Additions have to go first so that a removal in the same
+      // batch can never make a count drop to zero prematurely
+      if (!distributed_adds.empty())
+      {
+        Serializer rez;
+        {
+          RezCheck z(rez);
+          rez.serialize(distributed_adds.size());
+          for (std::map<std::pair<DistributedID,AddressSpaceID>,unsigned>::
+                const_iterator it = distributed_adds.begin(); 
+                it != distributed_adds.end(); it++)
+          {
+            rez.serialize(it->first.first);
+            rez.serialize(it->first.second);
+            rez.serialize(it->second);
+          }
+        }
+        messenger->send_add_distributed_remote(rez, false/*flush*/);
+        distributed_adds.clear();
+      }
+      if (!distributed_removes.empty())
+      {
+        Serializer rez;
+        {
+          RezCheck z(rez);
+          rez.serialize(distributed_removes.size());
+          for (std::map<DistributedID,std::pair<Event,unsigned> >::
+                const_iterator it = distributed_removes.begin();
+                it != distributed_removes.end(); it++)
+          {
+            rez.serialize(it->first);
+            rez.serialize(it->second.first);
+            rez.serialize(it->second.second);
+          }
+        }
+        messenger->send_remove_distributed_remote(rez, false/*flush*/);
+        distributed_removes.clear();
+      }
+      if (!hierarchical_removes.empty())
+      {
+        Serializer rez;
+        {
+          RezCheck z(rez);
+          rez.serialize(hierarchical_removes.size());
+          for (std::map<DistributedID,unsigned>::const_iterator it = 
+                hierarchical_removes.begin(); it != 
+                hierarchical_removes.end(); it++)
+          {
+            rez.serialize(it->first);
+            rez.serialize(it->second);
+          }
+        }
+        messenger->send_remove_hierarchical_remote(rez, false/*flush*/);
+        hierarchical_removes.clear();
+      }
+      if (!distributed_resources.empty())
+      {
+        Serializer rez;
+        {
+          RezCheck z(rez);
+          rez.serialize(distributed_resources.size());
+          for (std::map<DistributedID,std::vector<AddressSpaceID> >::
+                const_iterator it = distributed_resources.begin();
+                it != distributed_resources.end(); it++)
+          {
+            rez.serialize(it->first);
+            rez.serialize(it->second.size());
+            for (unsigned idx = 0; idx < it->second.size(); idx++)
+              rez.serialize(it->second[idx]);
+          }
+        }
+        messenger->send_remove_distributed_resource(rez, false/*flush*/);
+        distributed_resources.clear();
+      }
+      if (!hierarchical_resources.empty())
+      {
+        Serializer rez;
+        {
+          RezCheck z(rez);
+          rez.serialize(hierarchical_resources.size());
+          for (std::map<DistributedID,
+                std::vector<std::pair<AddressSpaceID,DistributedID> > >::
+                const_iterator it = hierarchical_resources.begin();
+                it != hierarchical_resources.end(); it++)
+          {
+            rez.serialize(it->first);
+            rez.serialize(it->second.size());
+            for (unsigned idx = 0; idx < it->second.size(); idx++)
+            {
+              rez.serialize(it->second[idx].first);
+              rez.serialize(it->second[idx].second);
+            }
+          }
+        }
+        messenger->send_remove_hierarchical_resource(rez, false/*flush*/);
+        hierarchical_resources.clear();
+      }
+      // Don't hold the batch up any longer in the message manager
+      messenger->flush_messages();
+      pending_changes = 0;
+      pending_since = 0;
+      sent_batches++;
     }
 
   }; // namespace HighLevel
@@ -153,6 +153,12 @@ namespace LegionRuntime {
     public:
       // Will only be called on the owner
       virtual void notify_new_remote(AddressSpaceID sid) = 0;
+    public:
+      // Release the copies of a collectable on the target nodes through
+      // a tree so no node sends more than a few messages
+      static void send_remove_resource_references(Runtime *rt,
+                                                  DistributedID did,
+                               const std::vector<AddressSpaceID> &targets);
     public:
       static void process_remove_resource_reference(Runtime *rt,
                                                     Deserializer &derez);
@@ -245,6 +251,10 @@ namespace LegionRuntime {
     public:
       virtual void notify_valid(void) = 0;
       virtual void notify_invalid(void) = 0;
+    public:
+      // Release the subscribers on the target nodes through a tree
+      static void send_remove_resource_references(Runtime *rt,
+          const std::vector<std::pair<AddressSpaceID,DistributedID> > &targets);
     public:
       static void process_remove_resource_reference(Runtime *rt,
                                                     Deserializer &derez);
@@ -272,6 +282,75 @@ namespace LegionRuntime {
       bool free_distributed_id;
     };
 
+    /**
+     * \class ReferenceBatch
+     * A reference batch accumulates the reference count changes
+     * that this node needs to send to one other node.  Changes to
+     * the same collectable are merged into a single delta and all
+     * the changes are sent together when there are too many of them
+     * (-hl:gc_batch), when the oldest one has waited longer than
+     * the maximum message delay, when the last scheduler run on this
+     * node finishes, or at shutdown.  Changes recorded while no
+     * scheduler run is outstanding are sent right away since there
+     * would be nothing to flush them later.  Additions are
+     * always applied before removals from the same batch so merging
+     * can only make a collectable live longer, never shorter.
+     */
+    class ReferenceBatch {
+    public:
+      ReferenceBatch(Runtime *rt, AddressSpaceID target);
+      ReferenceBatch(const ReferenceBatch &rhs);
+      ~ReferenceBatch(void);
+    public:
+      ReferenceBatch& operator=(const ReferenceBatch &rhs);
+    public:
+      void remove_distributed_resource(DistributedID did,
+                              const std::vector<AddressSpaceID> &forward);
+      void remove_distributed_remote(DistributedID did, Event dest_event,
+                                     unsigned cnt);
+      void add_distributed_remote(DistributedID did, AddressSpaceID sid,
+                                  unsigned cnt);
+      void remove_hierarchical_resource(DistributedID did,
+          const std::vector<std::pair<AddressSpaceID,DistributedID> > &forward);
+      void remove_hierarchical_remote(DistributedID did, unsigned cnt);
+    public:
+      void flush(void);
+      // Flush for the runtime shutting down, counting the changes
+      // that were still waiting so a leak of pending changes shows
+      // up in the -hl:message_stats output
+      void flush_for_shutdown(void);
+      // Only flush if the oldest change has waited longer
+      // than the maximum message delay
+      void flush_stale(unsigned long long now);
+    protected:
+      // Must be called while holding the batch lock
+      void record_change(bool merged);
+      void send_batch(void);
+    public:
+      Runtime *const runtime;
+      const AddressSpaceID target;
+    protected:
+      Reservation batch_lock;
+      unsigned pending_changes;
+      // Time in microseconds at which the oldest pending change
+      // was recorded, zero if there are no pending changes
+      volatile unsigned long long pending_since;
+      std::map<std::pair<DistributedID,AddressSpaceID>,unsigned> 
+                                                      distributed_adds;
+      std::map<DistributedID,std::pair<Event,unsigned> > distributed_removes;
+      std::map<DistributedID,std::vector<AddressSpaceID> > 
+                                                      distributed_resources;
+      std::map<DistributedID,unsigned> hierarchical_removes;
+      std::map<DistributedID,
+        std::vector<std::pair<AddressSpaceID,DistributedID> > > 
+                                                      hierarchical_resources;
+    protected:
+      unsigned long long total_changes;
+      unsigned long long merged_changes;
+      unsigned long long sent_batches;
+      unsigned long long shutdown_changes;
+    };
+
 
     //--------------------------------------------------------------------------
     // Give some implementations here so things get inlined
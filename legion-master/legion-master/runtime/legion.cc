@@ -66,6 +66,11 @@ namespace LegionRuntime {
         new ProcessorProfiler[MAX_NUM_PROCS + 1];
       bool profiling_enabled;
       CopyProfiler copy_prof;
+      FILE *binary_file = NULL;
+      unsigned long long binary_init_time = 0;
+      pthread_key_t binary_buffer_key;
+      pthread_mutex_t binary_mutex = PTHREAD_MUTEX_INITIALIZER;
+      std::vector<BinaryBuffer*> binary_buffers;
     };
 #endif
 
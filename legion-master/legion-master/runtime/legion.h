@@ -1319,6 +1319,26 @@ namespace LegionRuntime {
       int remaining_elmts;
     };
 
+    /**
+     * Invoke 'functor(first, count)' on each run of contiguous
+     * points in an unstructured index space, the index space of a
+     * logical region, or a one-dimensional domain.  Runs longer than
+     * 'max_span' points are broken into pieces.  Combined with the
+     * span method of the AOS, SOA and HybridSOA accessors this lets
+     * task code work on whole runs of elements with loops that the
+     * compiler can vectorize instead of going through an accessor
+     * for every point.
+     */
+    template<typename FUNCTOR>
+    inline void for_each_span(IndexSpace space, FUNCTOR &functor,
+                              size_t max_span = (size_t)-1);
+    template<typename FUNCTOR>
+    inline void for_each_span(LogicalRegion handle, FUNCTOR &functor,
+                              size_t max_span = (size_t)-1);
+    template<typename FUNCTOR>
+    inline void for_each_span(const Domain &domain, FUNCTOR &functor,
+                              size_t max_span = (size_t)-1);
+
     //==========================================================================
     //                      Software Coherence Classes
     //==========================================================================
@@ -4269,6 +4289,12 @@ namespace LegionRuntime {
        *              can and will deadlock if any currently mapped
        *              regions conflict with those requested by a child
        *              task or other operation.
+       * -hl:memoize_mapping Remember the map_task decisions of the
+       *              tasks in a trace the first time the trace runs
+       *              and reuse them on later replays instead of asking
+       *              the mapper again.  This only saves the mapper
+       *              calls, the physical analysis is still performed
+       *              on every replay.
        * ---------------------
        *  Resiliency
        * ---------------------
@@ -5632,6 +5658,54 @@ namespace LegionRuntime {
       return result;
     }
 
+    //--------------------------------------------------------------------------
+    template<typename FUNCTOR>
+    inline void for_each_span(IndexSpace space, FUNCTOR &functor,
+                              size_t max_span)
+    //--------------------------------------------------------------------------
+    {
+      IndexIterator itr(space);
+      while (itr.has_next())
+      {
+        size_t count = 0;
+        ptr_t first = itr.next_span(count, max_span);
+        functor(first, count);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename FUNCTOR>
+    inline void for_each_span(LogicalRegion handle, FUNCTOR &functor,
+                              size_t max_span)
+    //--------------------------------------------------------------------------
+    {
+      for_each_span(handle.get_index_space(), functor, max_span);
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename FUNCTOR>
+    inline void for_each_span(const Domain &domain, FUNCTOR &functor,
+                              size_t max_span)
+    //--------------------------------------------------------------------------
+    {
+      if (domain.get_dim() == 0)
+      {
+        for_each_span(domain.get_index_space(), functor, max_span);
+        return;
+      }
+      // Only one-dimensional domains line up with ptr_t
+      assert(domain.get_dim() == 1);
+      Rect<1> rect = domain.get_rect<1>();
+      for (int lo = rect.lo[0]; lo <= rect.hi[0]; )
+      {
+        size_t count = rect.hi[0] - lo + 1;
+        if (count > max_span)
+          count = max_span;
+        functor(ptr_t(lo), count);
+        lo += count;
+      }
+    }
+
     //--------------------------------------------------------------------------
     inline UniqueID Task::get_unique_task_id(void) const
     //--------------------------------------------------------------------------
@@ -92,6 +92,12 @@
 #ifndef DEFAULT_MAX_MESSAGE_SIZE
 #define DEFAULT_MAX_MESSAGE_SIZE        16384
 #endif
+// The longest time in microseconds that a message may wait
+// in a send buffer for other messages to be aggregated with it
+// before the buffer is flushed, zero disables time-based flushes
+#ifndef DEFAULT_MAX_MESSAGE_DELAY
+#define DEFAULT_MAX_MESSAGE_DELAY       100
+#endif
 // Maximum number of tasks in logical region node before consolidation
 #ifndef DEFAULT_MAX_FILTER_SIZE
 #define DEFAULT_MAX_FILTER_SIZE         0
@@ -110,6 +116,23 @@
 #ifndef DEFAULT_GC_EPOCH_SIZE
 #define DEFAULT_GC_EPOCH_SIZE           64
 #endif
+// Maximum number of distinct reference count changes for
+// another node that are batched together before being sent
+#ifndef DEFAULT_GC_BATCH_SIZE
+#define DEFAULT_GC_BATCH_SIZE           256
+#endif
+// Number of nodes that the owner of a distributed collectable
+// releases directly when it is deleted, each of them forwards
+// the release on to a subtree of the other nodes with copies
+#ifndef DEFAULT_GC_RELEASE_RADIX
+#define DEFAULT_GC_RELEASE_RADIX        4
+#endif
+// Percentage of a memory's capacity that can be allocated
+// before the least recently used physical instances in it are
+// spilled to disk memory.  Zero disables spilling entirely.
+#ifndef DEFAULT_SPILL_THRESHOLD
+#define DEFAULT_SPILL_THRESHOLD         0
+#endif
 
 // Used for debugging memory leaks
 // How often tracing information is dumped
@@ -91,6 +91,7 @@ namespace LegionRuntime {
       completion_event = UserEvent::create_user_event();
       trace = NULL;
       tracing = false;
+      trace_local_id = 0;
       must_epoch = NULL;
       must_epoch_gen = 0;
       must_epoch_index = 0;
@@ -184,6 +185,13 @@ namespace LegionRuntime {
       tracing = !trace->is_fixed();
     }
 
+    //--------------------------------------------------------------------------
+    void Operation::set_trace_local_id(unsigned id)
+    //--------------------------------------------------------------------------
+    {
+      trace_local_id = id;
+    }
+
     //--------------------------------------------------------------------------
     void Operation::set_must_epoch(MustEpochOp *epoch, unsigned index)
     //--------------------------------------------------------------------------
@@ -238,6 +246,14 @@ namespace LegionRuntime {
       // then trigger mapping will occur immediately
     }
 
+    //--------------------------------------------------------------------------
+    bool Operation::find_analysis_trees(std::set<RegionTreeID> &trees) const
+    //--------------------------------------------------------------------------
+    {
+      // By default we don't know what an operation will touch
+      return false;
+    }
+
     //--------------------------------------------------------------------------
     void Operation::trigger_mapping(void)
     //--------------------------------------------------------------------------
@@ -1754,6 +1770,17 @@ namespace LegionRuntime {
 #endif
     }
 
+    //--------------------------------------------------------------------------
+    bool MapOp::find_analysis_trees(std::set<RegionTreeID> &trees) const
+    //--------------------------------------------------------------------------
+    {
+      // Traces and must epochs record state in more than one tree
+      if ((trace != NULL) || (must_epoch != NULL))
+        return false;
+      trees.insert(requirement.parent.get_tree_id());
+      return true;
+    }
+
     //--------------------------------------------------------------------------
     bool MapOp::trigger_execution(void)
     //--------------------------------------------------------------------------
@@ -2545,6 +2572,19 @@ namespace LegionRuntime {
 #endif
     }
 
+    //--------------------------------------------------------------------------
+    bool CopyOp::find_analysis_trees(std::set<RegionTreeID> &trees) const
+    //--------------------------------------------------------------------------
+    {
+      if ((trace != NULL) || (must_epoch != NULL))
+        return false;
+      for (unsigned idx = 0; idx < src_requirements.size(); idx++)
+        trees.insert(src_requirements[idx].parent.get_tree_id());
+      for (unsigned idx = 0; idx < dst_requirements.size(); idx++)
+        trees.insert(dst_requirements[idx].parent.get_tree_id());
+      return true;
+    }
+
     //--------------------------------------------------------------------------
     void CopyOp::resolve_true(void)
     //--------------------------------------------------------------------------
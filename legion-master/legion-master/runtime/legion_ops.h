@@ -68,6 +68,7 @@ namespace LegionRuntime {
       inline bool already_traced(void) const 
         { return ((trace != NULL) && !tracing); }
       inline LegionTrace* get_trace(void) const { return trace; }
+      inline unsigned get_trace_local_id(void) const { return trace_local_id; }
     public:
       // Be careful using this call as it is only valid when the operation
       // actually has a parent task.  Right now the only place it is used
@@ -85,6 +86,7 @@ namespace LegionRuntime {
                                    const RegionRequirement &req,
                                    LogicalPartition start_node);
       void set_trace(LegionTrace *trace);
+      void set_trace_local_id(unsigned id);
       void set_must_epoch(MustEpochOp *epoch, unsigned index);
     public:
       // Localize a region requirement to its parent context
@@ -105,6 +107,11 @@ namespace LegionRuntime {
       // about modifying.
       // The function to call for depence analysis
       virtual void trigger_dependence_analysis(void);
+      // Find the region trees that dependence analysis of this
+      // operation will traverse.  Returning false says that the
+      // analysis may touch more of the state of the parent context
+      // and has to be ordered with every other operation in it.
+      virtual bool find_analysis_trees(std::set<RegionTreeID> &trees) const;
       // The function to call when the operation is ready to map 
       // In general put this on the ready queue so the runtime
       // can invoke the trigger mapping call.
@@ -289,6 +296,8 @@ namespace LegionRuntime {
       LegionTrace *trace;
       // Track whether we are tracing this operation
       bool tracing;
+      // Our position in the trace, stable across replays
+      unsigned trace_local_id;
       // Our must epoch if we have one
       MustEpochOp *must_epoch;
       // Generation for out mapping epoch
@@ -434,6 +443,7 @@ namespace LegionRuntime {
       virtual const char* get_logging_name(void);
     public:
       virtual void trigger_dependence_analysis(void);
+      virtual bool find_analysis_trees(std::set<RegionTreeID> &trees) const;
       virtual bool trigger_execution(void);
       virtual void deferred_complete(void);
     public:
@@ -480,6 +490,7 @@ namespace LegionRuntime {
       virtual const char* get_logging_name(void);
     public:
       virtual void trigger_dependence_analysis(void);
+      virtual bool find_analysis_trees(std::set<RegionTreeID> &trees) const;
       virtual bool trigger_execution(void);
       virtual void deferred_complete(void);
       virtual void report_aliased_requirements(unsigned idx1, unsigned idx2);
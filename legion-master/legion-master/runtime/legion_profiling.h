@@ -23,7 +23,16 @@
 #include "legion_utilities.h"
 
 #include <cassert>
+#include <cstdio>
+#include <cstring>
 #include <deque>
+#include <vector>
+#include <pthread.h>
+
+// Size of the per-thread buffers for binary profiles
+#ifndef LEGION_PROF_BUFFER_SIZE
+#define LEGION_PROF_BUFFER_SIZE         (1 << 16)
+#endif
 
 namespace LegionRuntime {
   namespace HighLevel {
@@ -60,6 +69,60 @@ namespace LegionRuntime {
  
     namespace LegionProf {
 
+      // Binary profiles (-hl:prof_file <prefix>) write one file per
+      // node named <prefix>.<node> which starts with a BinaryHeader
+      // and is followed by records.  Each record is a one byte
+      // BinaryRecordKind followed by its fields in native byte order.
+      // Times are in micro-seconds since the init_time in the header.
+      enum BinaryRecordKind {
+        PROF_REC_PROCESSOR = 1,         // u64 proc, u8 utility, u8 kind
+        PROF_REC_MEMORY = 2,            // u64 mem, u8 kind
+        PROF_REC_TASK_VARIANT = 3,      // u32 task id, u16 length, name
+        PROF_REC_CURRENT_PROC = 4,      // u64 proc of the records after it
+        PROF_REC_UNIQUE_TASK = 5,       // u64 uid, u32 task id, u32 dim,
+                                        //   i32 point[3]
+        PROF_REC_UNIQUE_MAP = 6,        // u64 uid, u64 parent uid
+        PROF_REC_UNIQUE_CLOSE = 7,      // u64 uid, u64 parent uid
+        PROF_REC_UNIQUE_COPY = 8,       // u64 uid, u64 parent uid
+        PROF_REC_EVENT = 9,             // u8 kind, u64 uid, u64 time
+        PROF_REC_CREATE_INSTANCE = 10,  // u32 inst, u32 mem, u32 redop,
+                                        //   u64 blocking factor, u64 time
+        PROF_REC_INSTANCE_FIELD = 11,   // u32 inst, u32 field, u64 size
+        PROF_REC_DESTROY_INSTANCE = 12, // u32 inst, u64 time
+      };
+
+      struct BinaryHeader {
+      public:
+        char magic[8]; // "LEGPROF"
+        unsigned version;
+        unsigned node;
+        unsigned long long init_time;
+      };
+
+      // Every thread packs its records into its own buffer which
+      // is only appended to the file when it fills up so the cost
+      // of an event is a handful of stores and memory use is bounded.
+      // The lock is only contended when another thread flushes all
+      // the buffers, the owner holds it while it packs a record.
+      struct BinaryBuffer {
+      public:
+        BinaryBuffer(void) : used(0), proc_id(0) 
+          { pthread_mutex_init(&lock, NULL); }
+      public:
+        template<typename T>
+        inline void pack(const T &value)
+        {
+          memcpy(data+used, &value, sizeof(T));
+          used += sizeof(T);
+        }
+      public:
+        pthread_mutex_t lock;
+        size_t used;
+        // Processor that the records at the end of the buffer belong to
+        unsigned long long proc_id;
+        char data[LEGION_PROF_BUFFER_SIZE];
+      };
+
       struct ProfilingEvent {
       public:
         ProfilingEvent(unsigned k, UniqueID uid, unsigned long long t)
@@ -153,7 +216,7 @@ namespace LegionRuntime {
 
       struct CopyProfiler {
       public:
-        CopyProfiler(void) : dumped(0), init_time(0) { }
+        CopyProfiler(void) : dumped(0), init_time(0), proc_id(0) { }
       public:
         inline void add_event(const ProfilingEvent &event)
         { proc_events.push_back(event); }
@@ -166,6 +229,8 @@ namespace LegionRuntime {
       public:
         int dumped;
         unsigned long long init_time;
+        // Made up processor ID that copies are attributed to
+        unsigned long long proc_id;
         std::deque<ProfilingEvent> proc_events;
       };
 
@@ -175,36 +240,214 @@ namespace LegionRuntime {
       extern CopyProfiler copy_prof;
       // Indicator for when profiling is enabled and disabled
       extern bool profiling_enabled;
+      // State for binary profiles, binary_file is NULL when
+      // we are logging text through log_prof instead
+      extern FILE *binary_file;
+      extern unsigned long long binary_init_time;
+      extern pthread_key_t binary_buffer_key;
+      extern pthread_mutex_t binary_mutex;
+      extern std::vector<BinaryBuffer*> binary_buffers;
 
       static inline ProcessorProfiler& get_profiler(Processor proc)
       {
         return legion_prof_table[proc.local_id()];
       }
 
+      static inline unsigned long long binary_time(unsigned long long time)
+      {
+        return ((time > binary_init_time) ? (time - binary_init_time) : 0);
+      }
+
+      // Must be holding the buffer's lock and then the binary_mutex.
+      // Callers test binary_file without the binary_mutex so the file
+      // may have been closed since, in which case the records are lost.
+      static inline void flush_binary_buffer(BinaryBuffer &buffer)
+      {
+        if ((buffer.used > 0) && (binary_file != NULL))
+        {
+          size_t written = fwrite(buffer.data, 1, buffer.used, binary_file);
+          assert(written == buffer.used);
+        }
+        buffer.used = 0;
+        // Other threads' records will land in the file before our
+        // next ones so we have to say which processor those are for
+        buffer.proc_id = 0;
+      }
+
+      // Get the calling thread's buffer with space for a record of
+      // the given size, if the record belongs to a processor then
+      // make sure the buffer says so first.  The buffer stays locked
+      // until the matching end_binary_record.
+      static inline BinaryBuffer& begin_binary_record(size_t bytes,
+                                           unsigned long long proc_id = 0)
+      {
+        BinaryBuffer *buffer = 
+          (BinaryBuffer*)pthread_getspecific(binary_buffer_key);
+        if (buffer == NULL)
+        {
+          buffer = new BinaryBuffer();
+          pthread_setspecific(binary_buffer_key, buffer);
+          pthread_mutex_lock(&binary_mutex);
+          binary_buffers.push_back(buffer);
+          pthread_mutex_unlock(&binary_mutex);
+        }
+        pthread_mutex_lock(&buffer->lock);
+        const bool switch_proc = (proc_id != 0) && (proc_id != buffer->proc_id);
+        const size_t needed = bytes + 
+          (switch_proc ? (sizeof(unsigned char) + sizeof(proc_id)) : 0);
+        if ((buffer->used + needed) > LEGION_PROF_BUFFER_SIZE)
+        {
+          pthread_mutex_lock(&binary_mutex);
+          flush_binary_buffer(*buffer);
+          pthread_mutex_unlock(&binary_mutex);
+        }
+        if ((proc_id != 0) && (proc_id != buffer->proc_id))
+        {
+          buffer->pack<unsigned char>(PROF_REC_CURRENT_PROC);
+          buffer->pack<unsigned long long>(proc_id);
+          buffer->proc_id = proc_id;
+        }
+        return *buffer;
+      }
+
+      static inline void end_binary_record(BinaryBuffer &buffer)
+      {
+        pthread_mutex_unlock(&buffer.lock);
+      }
+
+      static inline void open_binary_profile(const char *prefix, 
+                                             unsigned node)
+      {
+        char file_name[1024];
+        snprintf(file_name, sizeof(file_name), "%s.%d", prefix, node);
+        binary_file = fopen(file_name, "wb");
+        if (binary_file == NULL)
+        {
+          log_prof(LEVEL_WARNING,"Unable to open binary profile %s, "
+                                 "falling back to text logging", file_name);
+          return;
+        }
+        pthread_key_create(&binary_buffer_key, NULL);
+        binary_init_time = TimeStamp::get_current_time_in_micros();
+        BinaryHeader header;
+        memset(&header, 0, sizeof(header));
+        strcpy(header.magic, "LEGPROF");
+        header.version = 1;
+        header.node = node;
+        header.init_time = binary_init_time;
+        size_t written = fwrite(&header, sizeof(header), 1, binary_file);
+        assert(written == 1);
+      }
+
+      // Other threads may be packing records into their buffers,
+      // so take each buffer's lock before the binary_mutex like
+      // the owners do.  Buffers are never deleted so the copy of
+      // the list stays valid after we let go of the binary_mutex.
+      static inline void flush_binary_profile(void)
+      {
+        pthread_mutex_lock(&binary_mutex);
+        std::vector<BinaryBuffer*> buffers(binary_buffers);
+        pthread_mutex_unlock(&binary_mutex);
+        for (unsigned idx = 0; idx < buffers.size(); idx++)
+        {
+          pthread_mutex_lock(&buffers[idx]->lock);
+          pthread_mutex_lock(&binary_mutex);
+          flush_binary_buffer(*buffers[idx]);
+          pthread_mutex_unlock(&binary_mutex);
+          pthread_mutex_unlock(&buffers[idx]->lock);
+        }
+        pthread_mutex_lock(&binary_mutex);
+        if (binary_file != NULL)
+          fflush(binary_file);
+        pthread_mutex_unlock(&binary_mutex);
+      }
+
+      static inline void close_binary_profile(void)
+      {
+        flush_binary_profile();
+        pthread_mutex_lock(&binary_mutex);
+        if (binary_file != NULL)
+          fclose(binary_file);
+        binary_file = NULL;
+        // Threads still own their buffers through the key, they
+        // just get recycled if profiling is ever turned on again
+        pthread_mutex_unlock(&binary_mutex);
+      }
+
       static inline void register_task_variant(unsigned task_id, 
                                                const char *name)
       {
-        if (profiling_enabled)
+        if (!profiling_enabled)
+          return;
+        if (binary_file != NULL)
+        {
+          unsigned short length = strlen(name);
+          BinaryBuffer &buffer = begin_binary_record(sizeof(unsigned char) +
+              sizeof(task_id) + sizeof(length) + length);
+          buffer.pack<unsigned char>(PROF_REC_TASK_VARIANT);
+          buffer.pack<unsigned>(task_id);
+          buffer.pack<unsigned short>(length);
+          memcpy(buffer.data+buffer.used, name, length);
+          buffer.used += length;
+          end_binary_record(buffer);
+        }
+        else
           log_prof(LEVEL_INFO,"Prof Task Variant %u %s", task_id, name);
       }
 
+      static inline void record_binary_processor(unsigned long long proc_id,
+                                                 bool util, unsigned kind)
+      {
+        BinaryBuffer &buffer = begin_binary_record(2*sizeof(unsigned char) +
+            sizeof(proc_id) + sizeof(unsigned char));
+        buffer.pack<unsigned char>(PROF_REC_PROCESSOR);
+        buffer.pack<unsigned long long>(proc_id);
+        buffer.pack<unsigned char>(util);
+        buffer.pack<unsigned char>(kind);
+        end_binary_record(buffer);
+      }
+
       static inline void initialize_processor(Processor proc, 
                                               bool util, 
                                               Processor::Kind kind)
       {
         ProcessorProfiler &p = get_profiler(proc);
         new (&p) ProcessorProfiler(proc, util, kind);
+        if (profiling_enabled && (binary_file != NULL))
+          record_binary_processor(proc.id, util, kind);
       }
 
       static inline void initialize_memory(Memory mem, Memory::Kind kind)
       {
-        if (profiling_enabled)
+        if (!profiling_enabled)
+          return;
+        if (binary_file != NULL)
+        {
+          BinaryBuffer &buffer = begin_binary_record(sizeof(unsigned char) +
+              sizeof(unsigned long long) + sizeof(unsigned char));
+          buffer.pack<unsigned char>(PROF_REC_MEMORY);
+          buffer.pack<unsigned long long>(mem.id);
+          buffer.pack<unsigned char>(kind);
+          end_binary_record(buffer);
+        }
+        else
           log_prof(LEVEL_INFO,"Prof Memory " IDFMT " %u", mem.id, kind);
       }
 
       static inline void initialize_copy_processor()
       {
         copy_prof.init_time = TimeStamp::get_current_time_in_micros();
+        // Copies get their own made up processor after all the real ones
+        unsigned long long last_proc_id = 0;
+        for (unsigned idx = 0; idx < (MAX_NUM_PROCS+1); idx++)
+        {
+          Processor proc = legion_prof_table[idx].proc;
+          if (proc.exists() && last_proc_id < proc.id)
+            last_proc_id = proc.id;
+        }
+        copy_prof.proc_id = last_proc_id + 1;
+        if (profiling_enabled && (binary_file != NULL))
+          record_binary_processor(copy_prof.proc_id, true/*util*/, 3/*copy*/);
       }
 
       static inline void finalize_processor(Processor proc)
@@ -214,6 +457,12 @@ namespace LegionRuntime {
         // Someone else has already dumped this processor
         if (perform_dump > 0)
           return;
+        // Binary records have been going to the file all along
+        if (binary_file != NULL)
+        {
+          flush_binary_profile();
+          return;
+        }
         if (profiling_enabled)
           log_prof(LEVEL_INFO,"Prof Processor " IDFMT " %u %u", 
                     proc.id, prof.utility, prof.kind);
@@ -300,6 +549,12 @@ namespace LegionRuntime {
         int perform_dump = __sync_fetch_and_add(&copy_prof.dumped, 1);
         // Someone else has already dumped this processor
         if (perform_dump > 0) return;
+        // This is the last thing to be dumped so we're done with the file
+        if (binary_file != NULL)
+        {
+          close_binary_profile();
+          return;
+        }
         if (profiling_enabled)
           log_prof(LEVEL_INFO,"Prof Processor " IDFMT " 1 3",
               last_proc_id);
@@ -314,12 +569,40 @@ namespace LegionRuntime {
         }
       }
 
+      static inline void record_binary_event(unsigned long long proc_id,
+                                             ProfKind kind, UniqueID uid,
+                                             unsigned long long time)
+      {
+        BinaryBuffer &buffer = begin_binary_record(2*sizeof(unsigned char) +
+            2*sizeof(unsigned long long), proc_id);
+        buffer.pack<unsigned char>(PROF_REC_EVENT);
+        buffer.pack<unsigned char>(kind);
+        buffer.pack<unsigned long long>(uid);
+        buffer.pack<unsigned long long>(binary_time(time));
+        end_binary_record(buffer);
+      }
+
+      static inline void record_binary_op(BinaryRecordKind rec,
+                                          Processor proc, UniqueID uid,
+                                          UniqueID pid)
+      {
+        BinaryBuffer &buffer = begin_binary_record(sizeof(unsigned char) +
+            2*sizeof(unsigned long long), proc.id);
+        buffer.pack<unsigned char>(rec);
+        buffer.pack<unsigned long long>(uid);
+        buffer.pack<unsigned long long>(pid);
+        end_binary_record(buffer);
+      }
+
       static inline void register_copy_event(ProfKind kind)
       {
         if (profiling_enabled)
         {
           unsigned long long time = TimeStamp::get_current_time_in_micros();
-          copy_prof.add_event(ProfilingEvent(kind, 0, time));
+          if (binary_file != NULL)
+            record_binary_event(copy_prof.proc_id, kind, 0, time);
+          else
+            copy_prof.add_event(ProfilingEvent(kind, 0, time));
         }
       }
 
@@ -329,7 +612,10 @@ namespace LegionRuntime {
         {
           unsigned long long time = TimeStamp::get_current_time_in_micros();
           Processor proc = Processor::get_executing_processor();
-          get_profiler(proc).add_event(ProfilingEvent(kind, uid, time));
+          if (binary_file != NULL)
+            record_binary_event(proc.id, kind, uid, time);
+          else
+            get_profiler(proc).add_event(ProfilingEvent(kind, uid, time));
         }
       }
 
@@ -339,7 +625,21 @@ namespace LegionRuntime {
         if (profiling_enabled)
         {
           Processor proc = Processor::get_executing_processor();
-          get_profiler(proc).add_task(TaskInstance(tid, uid, point));
+          if (binary_file != NULL)
+          {
+            BinaryBuffer &buffer = begin_binary_record(sizeof(unsigned char) +
+                sizeof(unsigned long long) + 2*sizeof(unsigned) + 
+                3*sizeof(int), proc.id);
+            buffer.pack<unsigned char>(PROF_REC_UNIQUE_TASK);
+            buffer.pack<unsigned long long>(uid);
+            buffer.pack<unsigned>(tid);
+            buffer.pack<unsigned>(point.get_dim());
+            for (int idx = 0; idx < 3; idx++)
+              buffer.pack<int>(point.point_data[idx]);
+            end_binary_record(buffer);
+          }
+          else
+            get_profiler(proc).add_task(TaskInstance(tid, uid, point));
         }
       }
 
@@ -348,7 +648,10 @@ namespace LegionRuntime {
         if (profiling_enabled)
         {
           Processor proc = Processor::get_executing_processor();
-          get_profiler(proc).add_map(OpInstance(uid, pid));
+          if (binary_file != NULL)
+            record_binary_op(PROF_REC_UNIQUE_MAP, proc, uid, pid);
+          else
+            get_profiler(proc).add_map(OpInstance(uid, pid));
         }
       }
 
@@ -357,7 +660,10 @@ namespace LegionRuntime {
         if (profiling_enabled)
         {
           Processor proc = Processor::get_executing_processor();
-          get_profiler(proc).add_close(OpInstance(uid, pid));
+          if (binary_file != NULL)
+            record_binary_op(PROF_REC_UNIQUE_CLOSE, proc, uid, pid);
+          else
+            get_profiler(proc).add_close(OpInstance(uid, pid));
         }
       }
 
@@ -366,7 +672,10 @@ namespace LegionRuntime {
         if (profiling_enabled)
         {
           Processor proc = Processor::get_executing_processor();
-          get_profiler(proc).add_copy(OpInstance(uid, pid));
+          if (binary_file != NULL)
+            record_binary_op(PROF_REC_UNIQUE_COPY, proc, uid, pid);
+          else
+            get_profiler(proc).add_copy(OpInstance(uid, pid));
         }
       }
 
@@ -378,7 +687,33 @@ namespace LegionRuntime {
         {
           unsigned long long time = TimeStamp::get_current_time_in_micros();
           Processor proc = Processor::get_executing_processor();
-          get_profiler(proc).add_event(MemoryEvent(inst_id, memory, 
+          if (binary_file != NULL)
+          {
+            BinaryBuffer &buffer = begin_binary_record(sizeof(unsigned char) +
+                3*sizeof(unsigned) + 2*sizeof(unsigned long long));
+            buffer.pack<unsigned char>(PROF_REC_CREATE_INSTANCE);
+            buffer.pack<unsigned>(inst_id);
+            buffer.pack<unsigned>(memory);
+            buffer.pack<unsigned>(redop);
+            buffer.pack<unsigned long long>(blocking_factor);
+            buffer.pack<unsigned long long>(binary_time(time));
+            end_binary_record(buffer);
+            // One record per field keeps records small
+            for (std::map<unsigned,size_t>::const_iterator it = 
+                  fields.begin(); it != fields.end(); it++)
+            {
+              BinaryBuffer &field_buffer = begin_binary_record(
+                  sizeof(unsigned char) + 2*sizeof(unsigned) + 
+                  sizeof(unsigned long long));
+              field_buffer.pack<unsigned char>(PROF_REC_INSTANCE_FIELD);
+              field_buffer.pack<unsigned>(inst_id);
+              field_buffer.pack<unsigned>(it->first);
+              field_buffer.pack<unsigned long long>(it->second);
+              end_binary_record(field_buffer);
+            }
+          }
+          else
+            get_profiler(proc).add_event(MemoryEvent(inst_id, memory, 
                                         redop, blocking_factor, fields, time));
         }
       }
@@ -389,7 +724,17 @@ namespace LegionRuntime {
         {
           unsigned long long time = TimeStamp::get_current_time_in_micros();
           Processor proc = Processor::get_executing_processor();
-          get_profiler(proc).add_event(MemoryEvent(inst_id, time));
+          if (binary_file != NULL)
+          {
+            BinaryBuffer &buffer = begin_binary_record(sizeof(unsigned char) +
+                sizeof(unsigned) + sizeof(unsigned long long));
+            buffer.pack<unsigned char>(PROF_REC_DESTROY_INSTANCE);
+            buffer.pack<unsigned>(inst_id);
+            buffer.pack<unsigned long long>(binary_time(time));
+            end_binary_record(buffer);
+          }
+          else
+            get_profiler(proc).add_event(MemoryEvent(inst_id, time));
         }
       }
 
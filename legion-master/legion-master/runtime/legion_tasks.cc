@@ -491,6 +491,18 @@ namespace LegionRuntime {
       return variants->name;
     }
 
+    //--------------------------------------------------------------------------
+    bool TaskOp::find_analysis_trees(std::set<RegionTreeID> &trees) const
+    //--------------------------------------------------------------------------
+    {
+      // Traces and must epochs record state in more than one tree
+      if ((trace != NULL) || (must_epoch != NULL))
+        return false;
+      for (unsigned idx = 0; idx < regions.size(); idx++)
+        trees.insert(regions[idx].parent.get_tree_id());
+      return true;
+    }
+
     //--------------------------------------------------------------------------
     void TaskOp::trigger_complete(void) 
     //--------------------------------------------------------------------------
@@ -4374,6 +4386,13 @@ namespace LegionRuntime {
       physical_instances.clear();
     }
 
+    //--------------------------------------------------------------------------
+    LegionTrace* SingleTask::find_mapping_trace(unsigned &trace_idx)
+    //--------------------------------------------------------------------------
+    {
+      return NULL;
+    }
+
     //--------------------------------------------------------------------------
     bool SingleTask::map_all_regions(Processor target, Event user_event,
                                      bool mapper_invoked)
@@ -4399,7 +4418,49 @@ namespace LegionRuntime {
         regions[idx].selected_memory = Memory::NO_MEMORY;
       }
       bool notify = false;
-      if (!mapper_invoked)
+      // See if we are replaying a trace that already captured
+      // the mapping decisions for this task
+      bool memoized = false;
+      unsigned trace_idx = 0;
+      LegionTrace *mapping_trace = NULL;
+      if (Runtime::memoize_mappings && !mapper_invoked)
+        mapping_trace = find_mapping_trace(trace_idx);
+      if (mapping_trace != NULL)
+      {
+        LegionTrace::TaskMappingRecord record;
+        if (mapping_trace->find_task_mapping(trace_idx, index_point, record) &&
+            (record.target == target) && 
+            (record.regions.size() == regions.size()))
+        {
+          memoized = true;
+          for (unsigned idx = 0; idx < regions.size(); idx++)
+          {
+            if (regions[idx].region != record.regions[idx].region)
+            {
+              memoized = false;
+              break;
+            }
+          }
+        }
+        if (memoized)
+        {
+          for (unsigned idx = 0; idx < regions.size(); idx++)
+          {
+            const LegionTrace::RegionMappingRecord &rec = record.regions[idx];
+            regions[idx].virtual_map = rec.virtual_map;
+            regions[idx].enable_WAR_optimization = rec.enable_WAR_optimization;
+            regions[idx].reduction_list = rec.reduction_list;
+            regions[idx].make_persistent = rec.make_persistent;
+            regions[idx].blocking_factor = rec.blocking_factor;
+            regions[idx].additional_fields = rec.additional_fields;
+            regions[idx].target_ranking.clear();
+            if (rec.selected_memory.exists())
+              regions[idx].target_ranking.push_back(rec.selected_memory);
+          }
+          notify = record.notify;
+        }
+      }
+      if (!mapper_invoked && !memoized)
         notify = runtime->invoke_mapper_map_task(current_proc, this);
       // Info for virtual mappings
       virtual_mapped.resize(regions.size(),false);
@@ -4461,8 +4522,12 @@ namespace LegionRuntime {
         // Clean up our mess
         virtual_mapped.clear();
         num_virtual_mappings = 0;
-        // Finally notify the mapper about the failed mapping
-        runtime->invoke_mapper_failed_mapping(current_proc, this);
+        // If we were replaying memoized decisions then they are
+        // stale, forget them and let the mapper decide next time
+        if (memoized)
+          mapping_trace->invalidate_task_mapping(trace_idx, index_point);
+        else // Finally notify the mapper about the failed mapping
+          runtime->invoke_mapper_failed_mapping(current_proc, this);
       }
       else 
       {
@@ -4535,6 +4600,29 @@ namespace LegionRuntime {
 #endif
         }
         executing_processor = target;
+        // Capture the decisions the first time through a trace
+        if ((mapping_trace != NULL) && !memoized)
+        {
+          LegionTrace::TaskMappingRecord record;
+          record.target = target;
+          record.notify = notify;
+          record.regions.resize(regions.size());
+          for (unsigned idx = 0; idx < regions.size(); idx++)
+          {
+            LegionTrace::RegionMappingRecord &rec = record.regions[idx];
+            rec.region = regions[idx].region;
+            rec.virtual_map = regions[idx].virtual_map;
+            rec.enable_WAR_optimization = 
+              regions[idx].enable_WAR_optimization;
+            rec.reduction_list = regions[idx].reduction_list;
+            rec.make_persistent = regions[idx].make_persistent;
+            rec.blocking_factor = regions[idx].blocking_factor;
+            rec.additional_fields = regions[idx].additional_fields;
+            rec.selected_memory = physical_instances[idx].has_ref() ?
+              physical_instances[idx].get_memory() : Memory::NO_MEMORY;
+          }
+          mapping_trace->record_task_mapping(trace_idx, index_point, record);
+        }
         if (notify)
           runtime->invoke_mapper_notify_result(current_proc, this);
       }
@@ -5526,12 +5614,13 @@ namespace LegionRuntime {
                                       local_id, END_SLICING);
 #endif
       // If we succeeded and this is an intermediate slice task
-      // then we can reclaim it, otherwise, if it is the original
+      // then we can reclaim it (unless it is aggregating the results 
+      // of its sub-slices), otherwise, if it is the original
       // index task then we want to keep it around. Note it is safe
       // to call get_task_kind here despite the cleanup race because
       // it is a static property of the object.
       if (success && (get_task_kind() == SLICE_TASK_KIND))
-        deactivate();
+        static_cast<SliceTask*>(this)->release_intermediate();
       return success;
     }
 
@@ -6750,6 +6839,17 @@ namespace LegionRuntime {
       // Now we're done, someone else will deactivate us
     }  
 
+    //--------------------------------------------------------------------------
+    LegionTrace* IndividualTask::find_mapping_trace(unsigned &trace_idx)
+    //--------------------------------------------------------------------------
+    {
+      // The trace only lives on the node that launched us
+      if ((trace == NULL) || is_remote())
+        return NULL;
+      trace_idx = get_trace_local_id();
+      return trace;
+    }
+
     //--------------------------------------------------------------------------
     void IndividualTask::pack_remote_mapped(Serializer &rez)
     //--------------------------------------------------------------------------
@@ -7205,6 +7305,13 @@ namespace LegionRuntime {
       assert(false);
     }
 
+    //--------------------------------------------------------------------------
+    LegionTrace* PointTask::find_mapping_trace(unsigned &trace_idx)
+    //--------------------------------------------------------------------------
+    {
+      return slice_owner->find_mapping_trace(trace_idx);
+    }
+
     //--------------------------------------------------------------------------
     RemoteTask* PointTask::find_outermost_physical_context(void)
     //--------------------------------------------------------------------------
@@ -7948,6 +8055,7 @@ namespace LegionRuntime {
       committed_points = 0;
       complete_received = false;
       commit_received = false; 
+      slices_complete_triggered = false;
       predicate_false_result = NULL;
       predicate_false_size = 0;
     }
@@ -8977,6 +9085,7 @@ namespace LegionRuntime {
     //--------------------------------------------------------------------------
     {
       bool need_trigger = false;
+      bool need_complete = false;
       {
         AutoLock o_lock(op_lock);
         total_points += points;
@@ -8984,13 +9093,26 @@ namespace LegionRuntime {
         slice_fraction.add(Fraction<long long>(1,denom));
         // Already know that mapped points is the same as total points
         if (slice_fraction.is_whole())
+        {
           need_trigger = true;
+          // Completions that were combined by intermediate slices
+          // can get here before the mapped notifications of the
+          // slices that they cover so check for them now
+          if ((complete_points == total_points) && 
+              !children_complete_invoked)
+          {
+            need_complete = true;
+            children_complete_invoked = true;
+          }
+        }
       }
       if (need_trigger)
       {
         complete_mapping();
         complete_execution();
       }
+      if (need_complete)
+        trigger_slices_complete();
     }
 
     //--------------------------------------------------------------------------
@@ -9003,7 +9125,8 @@ namespace LegionRuntime {
         complete_points += points;
 #ifdef DEBUG_HIGH_LEVEL
         assert(!complete_received);
-        assert(complete_points <= total_points);
+        assert(!slice_fraction.is_whole() || 
+               (complete_points <= total_points));
 #endif
         if (slice_fraction.is_whole() && 
             (complete_points == total_points) &&
@@ -9014,7 +9137,7 @@ namespace LegionRuntime {
         }
       }
       if (need_trigger)
-        trigger_children_complete();
+        trigger_slices_complete();
     }
 
     //--------------------------------------------------------------------------
@@ -9026,20 +9149,49 @@ namespace LegionRuntime {
         AutoLock o_lock(op_lock);
         committed_points += points;
 #ifdef DEBUG_HIGH_LEVEL
-        assert(committed_points <= total_points);
+        assert(!slice_fraction.is_whole() || 
+               (committed_points <= total_points));
 #endif
-        if (slice_fraction.is_whole() &&
-            (committed_points == total_points) && 
-            !children_commit_invoked)
-        {
-          need_trigger = true;
-          children_commit_invoked = true;
-        }
+        need_trigger = check_slice_commit();
       }
       if (need_trigger)
         trigger_children_committed();
     } 
 
+    //--------------------------------------------------------------------------
+    void IndexTask::trigger_slices_complete(void)
+    //--------------------------------------------------------------------------
+    {
+      trigger_children_complete();
+      // Now that the children complete is done see if all 
+      // the commits already came back while we were doing it
+      bool need_trigger = false;
+      {
+        AutoLock o_lock(op_lock);
+        slices_complete_triggered = true;
+        need_trigger = check_slice_commit();
+      }
+      if (need_trigger)
+        trigger_children_committed();
+    }
+
+    //--------------------------------------------------------------------------
+    bool IndexTask::check_slice_commit(void)
+    //--------------------------------------------------------------------------
+    {
+      // Should be holding the op lock when calling this. Commits are
+      // only triggered after the children complete is done since they
+      // can arrive on a different path when slice notifications are
+      // combined by intermediate slices
+      if (slice_fraction.is_whole() && slices_complete_triggered &&
+          (committed_points == total_points) && !children_commit_invoked)
+      {
+        children_commit_invoked = true;
+        return true;
+      }
+      return false;
+    }
+
     //--------------------------------------------------------------------------
     void IndexTask::unpack_slice_mapped(Deserializer &derez, 
                                         AddressSpaceID source)
@@ -9287,6 +9439,19 @@ namespace LegionRuntime {
       remote_owner_uid = 0;
       remote_unique_id = get_unique_task_id();
       locally_mapped = false;
+      aggregator = NULL;
+      aggregate_proc = Processor::NO_PROC;
+      aggregating = false;
+      aggregate_released = false;
+      aggregate_complete_invoked = false;
+      aggregate_complete_sent = false;
+      aggregate_commit_invoked = false;
+      aggregate_bypass = false;
+      aggregate_points = 0;
+      aggregate_complete_points = 0;
+      aggregate_commit_points = 0;
+      forward_complete_points = 0;
+      forward_commit_points = 0;
     }
 
     //--------------------------------------------------------------------------
@@ -9509,7 +9674,7 @@ namespace LegionRuntime {
       // Quick out in case we are reclaiming this task
       if (reclaim)
       {
-        deactivate();
+        release_intermediate();
         return;
       }
 #ifdef DEBUG_HIGH_LEVEL
@@ -9662,6 +9827,8 @@ namespace LegionRuntime {
         rez.serialize(remote_contexts[idx]);
       }
       rez.serialize(remote_owner_uid);
+      rez.serialize(aggregator);
+      rez.serialize(aggregate_proc);
       parent_ctx->pack_parent_task(rez);
       for (unsigned idx = 0; idx < points.size(); idx++)
       {
@@ -9691,6 +9858,8 @@ namespace LegionRuntime {
       for (unsigned idx = 0; idx < regions.size(); idx++)
         derez.deserialize(remote_contexts[idx]);
       derez.deserialize(remote_owner_uid);
+      derez.deserialize(aggregator);
+      derez.deserialize(aggregate_proc);
       RemoteTask *remote_ctx = 
         runtime->find_or_init_remote_context(remote_owner_uid);
       remote_ctx->unpack_parent_task(derez);
@@ -9781,6 +9950,20 @@ namespace LegionRuntime {
       result->denominator = this->denominator * scale_denominator;
       result->index_owner = this->index_owner;
       result->remote_owner_uid = this->remote_owner_uid;
+      // Intermediate slices on remote nodes stick around to combine the
+      // results of their sub-slices before sending them back to the origin
+      if (is_remote())
+      {
+        aggregating = true;
+        aggregate_points = index_domain.get_volume();
+        result->aggregator = this;
+        result->aggregate_proc = current_proc;
+      }
+      else
+      {
+        result->aggregator = this->aggregator;
+        result->aggregate_proc = this->aggregate_proc;
+      }
 #ifdef LEGION_LOGGING
       LegionLogging::log_slice_slice(Processor::get_executing_processor(),
                                      unique_op_id, result->get_unique_op_id());
@@ -9941,6 +10124,19 @@ namespace LegionRuntime {
       num_uncommitted_points = points.size();
     } 
 
+    //--------------------------------------------------------------------------
+    LegionTrace* SliceTask::find_mapping_trace(unsigned &trace_idx)
+    //--------------------------------------------------------------------------
+    {
+      // Our index owner is only valid on the node that launched it
+      if (is_remote() || (index_owner == NULL))
+        return NULL;
+      LegionTrace *result = index_owner->get_trace();
+      if (result != NULL)
+        trace_idx = index_owner->get_trace_local_id();
+      return result;
+    }
+
     //--------------------------------------------------------------------------
     void SliceTask::trigger_task_complete(void)
     //--------------------------------------------------------------------------
@@ -10079,7 +10275,9 @@ namespace LegionRuntime {
     void SliceTask::trigger_slice_complete(void)
     //--------------------------------------------------------------------------
     {
-      if (is_remote())
+      if (aggregator != NULL)
+        send_aggregate_complete();
+      else if (is_remote())
       {
         // Send back the message saying that this slice is complete
         Serializer rez;
@@ -10097,7 +10295,9 @@ namespace LegionRuntime {
     void SliceTask::trigger_slice_commit(void)
     //--------------------------------------------------------------------------
     {
-      if (is_remote())
+      if (aggregator != NULL)
+        send_aggregate_commit();
+      else if (is_remote())
       {
         Serializer rez;
         pack_remote_commit(rez);
@@ -10211,6 +10411,17 @@ namespace LegionRuntime {
       rez.serialize(index_owner);
       RezCheck z(rez);
       rez.serialize(points.size());
+#ifdef DEBUG_HIGH_LEVEL
+      // Already know how many futures we are packing 
+      assert((redop != 0) || (temporary_futures.size() == points.size()));
+#endif
+      pack_slice_results(rez, target);
+    }
+
+    //--------------------------------------------------------------------------
+    void SliceTask::pack_slice_results(Serializer &rez, AddressSpaceID target)
+    //--------------------------------------------------------------------------
+    {
       // Serialize the privilege state
       pack_privilege_state(rez, target); 
       // Now pack up the future results
@@ -10222,10 +10433,6 @@ namespace LegionRuntime {
       }
       else
       {
-        // Already know how many futures we are packing 
-#ifdef DEBUG_HIGH_LEVEL
-        assert(temporary_futures.size() == points.size());
-#endif
         for (std::map<DomainPoint,std::pair<void*,size_t>,
               DomainPoint::STLComparator>::const_iterator it =
               temporary_futures.begin(); it != temporary_futures.end(); it++)
@@ -10238,6 +10445,65 @@ namespace LegionRuntime {
       }
     }
 
+    //--------------------------------------------------------------------------
+    void SliceTask::unpack_slice_results(Deserializer &derez, size_t forward)
+    //--------------------------------------------------------------------------
+    {
+      // Hold the lock when unpacking the privileges
+      {
+        AutoLock o_lock(op_lock);
+        unpack_privilege_state(derez);
+      }
+      if (redop != 0)
+      {
+#ifdef DEBUG_HIGH_LEVEL
+        assert(reduction_op != NULL);
+        assert(reduction_state_size == reduction_op->sizeof_rhs);
+#endif
+        // Reduce the results on the way up
+        const void *reduc_ptr = derez.get_current_pointer();
+        fold_reduction_future(reduc_ptr, reduction_state_size,
+                              false /*owner*/, false/*exclusive*/);
+        derez.advance_pointer(reduction_state_size);
+      }
+      else
+      {
+        for (unsigned idx = 0; idx < forward; idx++)
+        {
+          DomainPoint p;
+          unpack_point(derez, p);
+          DerezCheck z2(derez);
+          size_t result_size;
+          derez.deserialize(result_size);
+          void *result = legion_malloc(FUTURE_RESULT_ALLOC, result_size);
+          derez.deserialize(result, result_size);
+          AutoLock o_lock(op_lock);
+#ifdef DEBUG_HIGH_LEVEL
+          assert(temporary_futures.find(p) == temporary_futures.end());
+#endif
+          temporary_futures[p] = std::pair<void*,size_t>(result,result_size);
+        }
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    bool SliceTask::has_created_state(void) const
+    //--------------------------------------------------------------------------
+    {
+      // Tree shapes for created state are sent to whoever receives
+      // the privileges so they have to go straight to the origin
+      if (!created_regions.empty() || !created_field_spaces.empty() ||
+          !created_index_spaces.empty())
+        return true;
+      for (std::deque<PointTask*>::const_iterator it = 
+            points.begin(); it != points.end(); it++)
+      {
+        if ((*it)->regions.size() > remote_contexts.size())
+          return true;
+      }
+      return false;
+    }
+
     //--------------------------------------------------------------------------
     void SliceTask::pack_remote_commit(Serializer &rez)
     //--------------------------------------------------------------------------
@@ -10247,6 +10513,295 @@ namespace LegionRuntime {
       rez.serialize(points.size());
     }
 
+    //--------------------------------------------------------------------------
+    void SliceTask::release_intermediate(void)
+    //--------------------------------------------------------------------------
+    {
+      // Intermediate slices that are not aggregating can go away as 
+      // soon as all their sub-slices have been triggered
+      if (!aggregating)
+      {
+        deactivate();
+        return;
+      }
+      bool need_forward = false;
+      {
+        AutoLock o_lock(op_lock);
+        aggregate_released = true;
+        if (!aggregate_complete_invoked &&
+            (aggregate_complete_points == aggregate_points))
+        {
+          aggregate_complete_invoked = true;
+          need_forward = true;
+        }
+      }
+      if (need_forward)
+        forward_aggregate_complete();
+    }
+
+    //--------------------------------------------------------------------------
+    void SliceTask::record_aggregate_complete(size_t forward, size_t delivered)
+    //--------------------------------------------------------------------------
+    {
+      bool need_forward = false;
+      {
+        AutoLock o_lock(op_lock);
+#ifdef DEBUG_HIGH_LEVEL
+        assert(aggregating);
+#endif
+        aggregate_complete_points += (forward + delivered);
+        forward_complete_points += forward;
+#ifdef DEBUG_HIGH_LEVEL
+        assert(aggregate_complete_points <= aggregate_points);
+#endif
+        // Wait until all of our sub-slices have been triggered
+        // before sending anything, otherwise we could be reclaimed
+        // while we are still slicing
+        if (aggregate_released && !aggregate_complete_invoked &&
+            (aggregate_complete_points == aggregate_points))
+        {
+          aggregate_complete_invoked = true;
+          need_forward = true;
+        }
+      }
+      if (need_forward)
+        forward_aggregate_complete();
+    }
+
+    //--------------------------------------------------------------------------
+    void SliceTask::record_aggregate_commit(size_t forward, size_t delivered)
+    //--------------------------------------------------------------------------
+    {
+      bool need_forward = false;
+      {
+        AutoLock o_lock(op_lock);
+#ifdef DEBUG_HIGH_LEVEL
+        assert(aggregating);
+#endif
+        aggregate_commit_points += (forward + delivered);
+        forward_commit_points += forward;
+#ifdef DEBUG_HIGH_LEVEL
+        assert(aggregate_commit_points <= aggregate_points);
+#endif
+        // Our commit has to go out after our complete
+        if (aggregate_complete_sent && !aggregate_commit_invoked &&
+            (aggregate_commit_points == aggregate_points))
+        {
+          aggregate_commit_invoked = true;
+          need_forward = true;
+        }
+      }
+      if (need_forward)
+        forward_aggregate_commit();
+    }
+
+    //--------------------------------------------------------------------------
+    void SliceTask::send_aggregate_complete(void)
+    //--------------------------------------------------------------------------
+    {
+      // Slices on the origin have already returned their futures and 
+      // privileges to the index owner, and slices with created state 
+      // need it to get to the origin before they are complete, so both
+      // report straight to the origin and only tell our aggregator 
+      // that their points are done
+      if (!is_remote())
+      {
+        index_owner->return_slice_complete(points.size());
+        aggregate_bypass = true;
+      }
+      else if (has_created_state())
+      {
+        Serializer rez;
+        pack_remote_complete(rez);
+        runtime->send_slice_remote_complete(orig_proc, rez);
+        aggregate_bypass = true;
+      }
+      const size_t forward = aggregate_bypass ? 0 : points.size();
+      Serializer rez;
+      rez.serialize(aggregator);
+      {
+        RezCheck z(rez);
+        rez.serialize(forward);
+        rez.serialize<size_t>(points.size() - forward);
+        if (forward > 0)
+          pack_slice_results(rez, runtime->find_address_space(aggregate_proc));
+      }
+      if (runtime->is_local(aggregate_proc))
+      {
+        Deserializer derez(rez.get_buffer(), rez.get_used_bytes());
+        process_aggregate_complete(derez);
+      }
+      else
+        runtime->send_slice_aggregate_complete(aggregate_proc, rez);
+    }
+
+    //--------------------------------------------------------------------------
+    void SliceTask::send_aggregate_commit(void)
+    //--------------------------------------------------------------------------
+    {
+      // Commits follow the same path as our completion did
+      if (aggregate_bypass)
+      {
+        if (is_remote())
+        {
+          Serializer rez;
+          pack_remote_commit(rez);
+          runtime->send_slice_remote_commit(orig_proc, rez);
+        }
+        else
+          index_owner->return_slice_commit(points.size());
+      }
+      const size_t forward = aggregate_bypass ? 0 : points.size();
+      Serializer rez;
+      rez.serialize(aggregator);
+      {
+        RezCheck z(rez);
+        rez.serialize(forward);
+        rez.serialize<size_t>(points.size() - forward);
+      }
+      if (runtime->is_local(aggregate_proc))
+      {
+        Deserializer derez(rez.get_buffer(), rez.get_used_bytes());
+        process_aggregate_commit(derez);
+      }
+      else
+        runtime->send_slice_aggregate_commit(aggregate_proc, rez);
+    }
+
+    //--------------------------------------------------------------------------
+    void SliceTask::forward_aggregate_complete(void)
+    //--------------------------------------------------------------------------
+    {
+      // All our sub-slices are complete so send one message with
+      // their combined results either to our own aggregator or back 
+      // to the origin if anything still needs to go there
+      if (aggregator != NULL)
+      {
+        Serializer rez;
+        rez.serialize(aggregator);
+        {
+          RezCheck z(rez);
+          rez.serialize(forward_complete_points);
+          rez.serialize<size_t>(aggregate_points - forward_complete_points);
+          if (forward_complete_points > 0)
+            pack_slice_results(rez, 
+                runtime->find_address_space(aggregate_proc));
+        }
+        if (runtime->is_local(aggregate_proc))
+        {
+          Deserializer derez(rez.get_buffer(), rez.get_used_bytes());
+          process_aggregate_complete(derez);
+        }
+        else
+          runtime->send_slice_aggregate_complete(aggregate_proc, rez);
+      }
+      else if (forward_complete_points > 0)
+      {
+        Serializer rez;
+        rez.serialize(index_owner);
+        {
+          RezCheck z(rez);
+          rez.serialize(forward_complete_points);
+#ifdef DEBUG_HIGH_LEVEL
+          assert((redop != 0) || 
+                 (temporary_futures.size() == forward_complete_points));
+#endif
+          pack_slice_results(rez, runtime->find_address_space(orig_proc));
+        }
+        runtime->send_slice_remote_complete(orig_proc, rez);
+      }
+      bool need_commit = false;
+      {
+        AutoLock o_lock(op_lock);
+        aggregate_complete_sent = true;
+        if (!aggregate_commit_invoked &&
+            (aggregate_commit_points == aggregate_points))
+        {
+          aggregate_commit_invoked = true;
+          need_commit = true;
+        }
+      }
+      if (need_commit)
+        forward_aggregate_commit();
+    }
+
+    //--------------------------------------------------------------------------
+    void SliceTask::forward_aggregate_commit(void)
+    //--------------------------------------------------------------------------
+    {
+      if (aggregator != NULL)
+      {
+        Serializer rez;
+        rez.serialize(aggregator);
+        {
+          RezCheck z(rez);
+          rez.serialize(forward_commit_points);
+          rez.serialize<size_t>(aggregate_points - forward_commit_points);
+        }
+        if (runtime->is_local(aggregate_proc))
+        {
+          Deserializer derez(rez.get_buffer(), rez.get_used_bytes());
+          process_aggregate_commit(derez);
+        }
+        else
+          runtime->send_slice_aggregate_commit(aggregate_proc, rez);
+      }
+      else if (forward_commit_points > 0)
+      {
+        Serializer rez;
+        rez.serialize(index_owner);
+        {
+          RezCheck z(rez);
+          rez.serialize(forward_commit_points);
+        }
+        runtime->send_slice_remote_commit(orig_proc, rez);
+      }
+      // All our sub-slices are done so we can reclaim ourselves
+      deactivate();
+    }
+
+    //--------------------------------------------------------------------------
+    void SliceTask::unpack_aggregate_complete(Deserializer &derez)
+    //--------------------------------------------------------------------------
+    {
+      DerezCheck z(derez);
+      size_t forward, delivered;
+      derez.deserialize(forward);
+      derez.deserialize(delivered);
+      if (forward > 0)
+        unpack_slice_results(derez, forward);
+      record_aggregate_complete(forward, delivered);
+    }
+
+    //--------------------------------------------------------------------------
+    void SliceTask::unpack_aggregate_commit(Deserializer &derez)
+    //--------------------------------------------------------------------------
+    {
+      DerezCheck z(derez);
+      size_t forward, delivered;
+      derez.deserialize(forward);
+      derez.deserialize(delivered);
+      record_aggregate_commit(forward, delivered);
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ void SliceTask::process_aggregate_complete(Deserializer &derez)
+    //--------------------------------------------------------------------------
+    {
+      SliceTask *slice;
+      derez.deserialize(slice);
+      slice->unpack_aggregate_complete(derez);
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ void SliceTask::process_aggregate_commit(Deserializer &derez)
+    //--------------------------------------------------------------------------
+    {
+      SliceTask *slice;
+      derez.deserialize(slice);
+      slice->unpack_aggregate_commit(derez);
+    }
+
     //--------------------------------------------------------------------------
     /*static*/ void SliceTask::handle_slice_return(Runtime *rt, 
                                                    Deserializer &derez)
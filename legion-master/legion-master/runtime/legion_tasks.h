@@ -84,6 +84,7 @@ namespace LegionRuntime {
       virtual const char* get_logging_name(void);
     public:
       virtual void trigger_dependence_analysis(void) = 0;
+      virtual bool find_analysis_trees(std::set<RegionTreeID> &trees) const;
       virtual void trigger_complete(void);
       virtual void trigger_commit(void);
       virtual void resolve_true(void);
@@ -391,6 +392,8 @@ namespace LegionRuntime {
     protected:
       bool map_all_regions(Processor target, Event user_event, 
                            bool mapper_invoked); 
+      // The trace holding memoized mappings for this task, if any
+      virtual LegionTrace* find_mapping_trace(unsigned &trace_idx);
       void initialize_region_tree_contexts(
           const std::vector<RegionRequirement> &clone_requirements,
           const std::vector<UserEvent> &unmap_events);
@@ -679,6 +682,8 @@ namespace LegionRuntime {
       virtual void find_enclosing_local_fields(
           LegionDeque<LocalFieldInfo,TASK_LOCAL_FIELD_ALLOC>::tracked &infos);
       virtual void perform_inlining(SingleTask *ctx, InlineFnptr fn);
+    protected:
+      virtual LegionTrace* find_mapping_trace(unsigned &trace_idx);
     protected:
       void pack_remote_mapped(Serializer &rez);
       void pack_remote_complete(Serializer &rez);
@@ -770,6 +775,8 @@ namespace LegionRuntime {
       virtual void find_enclosing_local_fields(
           LegionDeque<LocalFieldInfo,TASK_LOCAL_FIELD_ALLOC>::tracked &infos);
       virtual void perform_inlining(SingleTask *ctx, InlineFnptr fn);
+    protected:
+      virtual LegionTrace* find_mapping_trace(unsigned &trace_idx);
     public:
       virtual void handle_future(const void *res, 
                                  size_t res_size, bool owned);
@@ -1026,6 +1033,9 @@ namespace LegionRuntime {
       void return_slice_mapped(unsigned points, long long denom);
       void return_slice_complete(unsigned points);
       void return_slice_commit(unsigned points);
+    protected:
+      void trigger_slices_complete(void);
+      bool check_slice_commit(void);
     public:
       void unpack_slice_mapped(Deserializer &derez, AddressSpaceID source);
       void unpack_slice_complete(Deserializer &derez);
@@ -1056,6 +1066,8 @@ namespace LegionRuntime {
       // Track whether or not we've received our commit command
       bool complete_received;
       bool commit_received;
+      // Track whether the children complete has been triggered
+      bool slices_complete_triggered;
     protected:
       Future predicate_false_future;
       void *predicate_false_result;
@@ -1113,6 +1125,7 @@ namespace LegionRuntime {
       virtual void register_must_epoch(void);
       PointTask* clone_as_point_task(const DomainPoint &p);
       void enumerate_points(void);
+      LegionTrace* find_mapping_trace(unsigned &trace_idx);
     protected:
       virtual void trigger_task_complete(void);
       virtual void trigger_task_commit(void);
@@ -1129,8 +1142,26 @@ namespace LegionRuntime {
       void pack_remote_mapped(Serializer &rez);
       void pack_remote_complete(Serializer &rez);
       void pack_remote_commit(Serializer &rez);
+      void pack_slice_results(Serializer &rez, AddressSpaceID target);
+      void unpack_slice_results(Deserializer &derez, size_t forward);
+      bool has_created_state(void) const;
+    public:
+      // Methods for aggregating the results of sub-slices
+      // in intermediate slices on their way back to the origin
+      void release_intermediate(void);
+    protected:
+      void record_aggregate_complete(size_t forward, size_t delivered);
+      void record_aggregate_commit(size_t forward, size_t delivered);
+      void send_aggregate_complete(void);
+      void send_aggregate_commit(void);
+      void forward_aggregate_complete(void);
+      void forward_aggregate_commit(void);
+      void unpack_aggregate_complete(Deserializer &derez);
+      void unpack_aggregate_commit(Deserializer &derez);
     public:
       static void handle_slice_return(Runtime *rt, Deserializer &derez);
+      static void process_aggregate_complete(Deserializer &derez);
+      static void process_aggregate_commit(Deserializer &derez);
     protected:
       friend class IndexTask;
       bool reclaim; // used for reclaiming intermediate slices
@@ -1151,6 +1182,26 @@ namespace LegionRuntime {
       RegionTreeContext remote_outermost_context;
       bool locally_mapped;
       UniqueID remote_owner_uid;
+    protected:
+      // The intermediate slice (on aggregate_proc's node) that combines
+      // our complete and commit notifications, NULL to go to the origin
+      SliceTask *aggregator;
+      Processor aggregate_proc;
+      // Set on remote intermediate slices that act as an aggregator
+      bool aggregating;
+      bool aggregate_released;
+      bool aggregate_complete_invoked;
+      bool aggregate_complete_sent;
+      bool aggregate_commit_invoked;
+      // Set when this slice reported directly to the origin
+      bool aggregate_bypass;
+      // Points in the domain of an aggregator, the points seen so far, 
+      // and the points whose results still need to be forwarded
+      size_t aggregate_points;
+      size_t aggregate_complete_points;
+      size_t aggregate_commit_points;
+      size_t forward_complete_points;
+      size_t forward_commit_points;
     protected:
       // Temporary storage for future results
       std::map<DomainPoint,std::pair<void*,size_t>,
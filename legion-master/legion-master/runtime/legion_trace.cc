@@ -31,7 +31,8 @@ namespace LegionRuntime {
 
     //--------------------------------------------------------------------------
     LegionTrace::LegionTrace(TraceID t, SingleTask *c)
-      : tid(t), ctx(c), fixed(false), tracing(true)
+      : tid(t), ctx(c), fixed(false), tracing(true),
+        mapping_lock(Reservation::create_reservation())
     //--------------------------------------------------------------------------
     {
     }
@@ -49,6 +50,8 @@ namespace LegionRuntime {
     LegionTrace::~LegionTrace(void)
     //--------------------------------------------------------------------------
     {
+      mapping_lock.destroy_reservation();
+      mapping_lock = Reservation::NO_RESERVATION;
     }
 
     //--------------------------------------------------------------------------
@@ -108,6 +111,8 @@ namespace LegionRuntime {
     {
       std::pair<Operation*,GenerationID> key(op,gen);
       const unsigned index = operations.size();
+      if (!op->is_close_op())
+        op->set_trace_local_id(index);
       // Only need to save this in the map if we are not done tracing
       if (tracing)
       {
@@ -333,6 +338,61 @@ namespace LegionRuntime {
       }
     }
 
+    //--------------------------------------------------------------------------
+    void LegionTrace::record_task_mapping(unsigned trace_idx,
+                                          const DomainPoint &point,
+                                          const TaskMappingRecord &record)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock m_lock(mapping_lock);
+      std::map<unsigned,std::set<DomainPoint,
+        DomainPoint::STLComparator> >::const_iterator finder = 
+          invalid_mappings.find(trace_idx);
+      if ((finder != invalid_mappings.end()) && 
+          (finder->second.find(point) != finder->second.end()))
+        return;
+      task_mappings[trace_idx][point] = record;
+    }
+
+    //--------------------------------------------------------------------------
+    bool LegionTrace::find_task_mapping(unsigned trace_idx,
+                                        const DomainPoint &point,
+                                        TaskMappingRecord &record)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock m_lock(mapping_lock,1,false/*exclusive*/);
+      std::map<unsigned,std::map<DomainPoint,TaskMappingRecord,
+        DomainPoint::STLComparator> >::const_iterator finder = 
+          task_mappings.find(trace_idx);
+      if (finder == task_mappings.end())
+        return false;
+      std::map<DomainPoint,TaskMappingRecord,
+        DomainPoint::STLComparator>::const_iterator point_finder = 
+          finder->second.find(point);
+      if (point_finder == finder->second.end())
+        return false;
+      record = point_finder->second;
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionTrace::invalidate_task_mapping(unsigned trace_idx,
+                                              const DomainPoint &point)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock m_lock(mapping_lock);
+      std::map<unsigned,std::map<DomainPoint,TaskMappingRecord,
+        DomainPoint::STLComparator> >::iterator finder = 
+          task_mappings.find(trace_idx);
+      if (finder != task_mappings.end())
+      {
+        finder->second.erase(point);
+        if (finder->second.empty())
+          task_mappings.erase(finder);
+      }
+      invalid_mappings[trace_idx].insert(point);
+    }
+
     /////////////////////////////////////////////////////////////
     // TraceCaptureOp 
     /////////////////////////////////////////////////////////////
@@ -53,6 +53,35 @@ namespace LegionRuntime {
         DependenceType dtype;
         FieldMask dependent_mask;
       };
+      // With mapping memoization (-hl:memoize_mapping) the map_task
+      // decisions for the tasks in a trace are captured the first time
+      // they map and handed back on later replays in place of calling
+      // the mapper. Each region remembers the memory its instance ended
+      // up in so the replay goes straight to the same instance. Only the
+      // mapper calls are skipped: the physical analysis and the event
+      // graph of every replay are still computed from scratch.
+      // TODO: physical replay. Capture the instance views, the copies
+      // and reductions issued, and the event preconditions of each
+      // operation the first time, then reissue them on replay without
+      // walking the physical region tree. Needs invalidation whenever
+      // the instances or the valid views change outside the trace.
+      struct RegionMappingRecord {
+      public:
+        LogicalRegion region;
+        bool virtual_map;
+        bool enable_WAR_optimization;
+        bool reduction_list;
+        bool make_persistent;
+        size_t blocking_factor;
+        Memory selected_memory;
+        std::set<FieldID> additional_fields;
+      };
+      struct TaskMappingRecord {
+      public:
+        Processor target;
+        bool notify;
+        std::vector<RegionMappingRecord> regions;
+      };
     public:
       LegionTrace(TraceID tid, SingleTask *ctx);
       LegionTrace(const LegionTrace &rhs);
@@ -77,6 +106,14 @@ namespace LegionRuntime {
                                     unsigned target_idx, unsigned source_idx,
                                     DependenceType dtype, bool validates,
                                     const FieldMask &dependent_mask);
+    public:
+      // Called by mapping threads
+      void record_task_mapping(unsigned trace_idx, const DomainPoint &point,
+                               const TaskMappingRecord &record);
+      bool find_task_mapping(unsigned trace_idx, const DomainPoint &point,
+                             TaskMappingRecord &record);
+      void invalidate_task_mapping(unsigned trace_idx, 
+                                   const DomainPoint &point);
     protected:
       std::vector<std::pair<Operation*,GenerationID> > operations;
       // Only need this backwards lookup for recording dependences
@@ -100,6 +137,14 @@ namespace LegionRuntime {
       SingleTask *const ctx;
       bool fixed;
       bool tracing;
+    protected:
+      // Memoized mapping decisions by trace operation and index point,
+      // invalidated entries are never memoized again
+      Reservation mapping_lock;
+      std::map<unsigned,std::map<DomainPoint,TaskMappingRecord,
+                                 DomainPoint::STLComparator> > task_mappings;
+      std::map<unsigned,std::set<DomainPoint,
+                                 DomainPoint::STLComparator> > invalid_mappings;
     };
 
     /**
@@ -242,12 +242,14 @@ namespace LegionRuntime {
     class NodeTraverser;
     class PremapTraverser;
     class MappingTraverser;
+    class InstanceSpiller;
 
     struct LogicalState;
     class PhysicalVersion;
 
     class DistributedCollectable;
     class HierarchicalCollectable;
+    class ReferenceBatch;
     class LayoutDescription;
     class PhysicalManager; // base class for instance and reduction
     class LogicalView; // base class for instance and reduction
@@ -35,6 +35,7 @@ using namespace LegionRuntime::Accessor;
 #include <sys/file.h>
 #include <fcntl.h>
 #include <dirent.h>
+#include <sys/mman.h>
 
 #ifdef DEADLOCK_TRACE
 #include <signal.h>
@@ -42,6 +43,9 @@ using namespace LegionRuntime::Accessor;
 #endif
 #include <signal.h>
 #include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #ifdef LEGION_BACKTRACE
 #include <execinfo.h>
 #endif
@@ -49,6 +53,9 @@ using namespace LegionRuntime::Accessor;
 #ifdef __SSE2__
 #include <emmintrin.h>
 #endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 // like strdup, but works on arbitrary byte arrays
 static void *bytedup(const void *data, size_t datalen)
@@ -60,6 +67,53 @@ static void *bytedup(const void *data, size_t datalen)
   return dst;
 }
 
+#ifdef FAST_CONTEXT_SWITCH
+// switches user-level task contexts: pushes the callee-saved registers and
+//  the SSE/x87 control words on the current stack, saves the stack pointer
+//  in *save_sp and pops the same from load_sp - everything else is
+//  caller-saved, so this is all the state a switch has to carry
+extern "C" void lowlevel_switch_context(void **save_sp, void *load_sp);
+// return address of a fresh context: calls the function in %r13 on the
+//  context in %r12
+extern "C" void lowlevel_context_trampoline(void);
+
+asm(".text\n"
+    ".globl lowlevel_switch_context\n"
+    ".hidden lowlevel_switch_context\n"
+    ".type lowlevel_switch_context, @function\n"
+    "lowlevel_switch_context:\n"
+    "\tpushq %rbp\n"
+    "\tpushq %rbx\n"
+    "\tpushq %r12\n"
+    "\tpushq %r13\n"
+    "\tpushq %r14\n"
+    "\tpushq %r15\n"
+    "\tsubq $8, %rsp\n"
+    "\tstmxcsr (%rsp)\n"
+    "\tfnstcw 4(%rsp)\n"
+    "\tmovq %rsp, (%rdi)\n"
+    "\tmovq %rsi, %rsp\n"
+    "\tldmxcsr (%rsp)\n"
+    "\tfldcw 4(%rsp)\n"
+    "\taddq $8, %rsp\n"
+    "\tpopq %r15\n"
+    "\tpopq %r14\n"
+    "\tpopq %r13\n"
+    "\tpopq %r12\n"
+    "\tpopq %rbx\n"
+    "\tpopq %rbp\n"
+    "\tret\n"
+    ".size lowlevel_switch_context, .-lowlevel_switch_context\n"
+    ".globl lowlevel_context_trampoline\n"
+    ".hidden lowlevel_context_trampoline\n"
+    ".type lowlevel_context_trampoline, @function\n"
+    "lowlevel_context_trampoline:\n"
+    "\tmovq %r12, %rdi\n"
+    "\tcallq *%r13\n"
+    "\tud2\n"
+    ".size lowlevel_context_trampoline, .-lowlevel_context_trampoline\n");
+#endif
+
 // Implementation of Detailed Timer
 namespace LegionRuntime {
   namespace LowLevel {
@@ -707,6 +761,9 @@ namespace LegionRuntime {
 	}
 	
 	valid_mask = new ElementMask(num_elmts);
+	// the data arrives in pieces straight into the bit array, so it has
+	//  to exist before the first one does
+	valid_mask->get_raw();
 	valid_mask_owner = ID(me).node(); // a good guess?
 	valid_mask_count = (valid_mask->raw_size() + 2047) >> 11;
 	valid_mask_complete = false;
@@ -1365,12 +1422,100 @@ namespace LegionRuntime {
     ///*static*/ Event::Impl *Event::Impl::first_free = 0;
     ///*static*/ gasnet_hsl_t Event::Impl::freelist_mutex = GASNET_HSL_INITIALIZER;
 
+    // Per-thread caches for the small objects the event system allocates
+    //  and frees at a high rate (waiter nodes and event mergers) - an object
+    //  freed by a different thread than the one that allocated it simply
+    //  migrates to the freeing thread's cache
+    struct EventObjectCache {
+      enum { WAITER_NODE, EVENT_MERGER, NUM_KINDS };
+      static const unsigned MAX_CACHED = 1024;
+
+      struct FreeBlock {
+	FreeBlock *next;
+      };
+
+      FreeBlock *heads[NUM_KINDS];
+      unsigned counts[NUM_KINDS];
+    };
+
+    static pthread_key_t event_cache_key;
+    static pthread_once_t event_cache_once = PTHREAD_ONCE_INIT;
+
+    static void event_cache_destroy(void *arg)
+    {
+      EventObjectCache *cache = (EventObjectCache *)arg;
+      for(int kind = 0; kind < EventObjectCache::NUM_KINDS; kind++)
+	while(cache->heads[kind]) {
+	  EventObjectCache::FreeBlock *block = cache->heads[kind];
+	  cache->heads[kind] = block->next;
+	  free(block);
+	}
+      delete cache;
+    }
+
+    static void event_cache_create_key(void)
+    {
+      CHECK_PTHREAD( pthread_key_create(&event_cache_key, event_cache_destroy) );
+    }
+
+    static EventObjectCache *get_event_cache(void)
+    {
+      pthread_once(&event_cache_once, event_cache_create_key);
+      EventObjectCache *cache = (EventObjectCache *)pthread_getspecific(event_cache_key);
+      if(!cache) {
+	cache = new EventObjectCache;
+	memset(cache, 0, sizeof(EventObjectCache));
+	CHECK_PTHREAD( pthread_setspecific(event_cache_key, cache) );
+      }
+      return cache;
+    }
+
+    static void *event_cache_alloc(int kind, size_t bytes)
+    {
+      EventObjectCache *cache = get_event_cache();
+      EventObjectCache::FreeBlock *block = cache->heads[kind];
+      if(block) {
+	cache->heads[kind] = block->next;
+	cache->counts[kind]--;
+	return block;
+      }
+      void *ptr = malloc(bytes);
+      assert(ptr != 0);
+      return ptr;
+    }
+
+    static void event_cache_release(int kind, void *ptr)
+    {
+      if(!ptr) return;
+      EventObjectCache *cache = get_event_cache();
+      if(cache->counts[kind] >= EventObjectCache::MAX_CACHED) {
+	free(ptr);
+	return;
+      }
+      EventObjectCache::FreeBlock *block = (EventObjectCache::FreeBlock *)ptr;
+      block->next = cache->heads[kind];
+      cache->heads[kind] = block;
+      cache->counts[kind]++;
+    }
+
+    /*static*/ void *GenEventImpl::WaiterNode::operator new(size_t bytes)
+    {
+      assert(bytes == sizeof(WaiterNode));
+      return event_cache_alloc(EventObjectCache::WAITER_NODE, bytes);
+    }
+
+    /*static*/ void GenEventImpl::WaiterNode::operator delete(void *ptr)
+    {
+      event_cache_release(EventObjectCache::WAITER_NODE, ptr);
+    }
+
     GenEventImpl::GenEventImpl(void)
       : me((IDType)-1), owner(-1)
     {
       generation = 0;
       gen_subscribed = 0;
       next_free = 0;
+      local_waiters = 0;
     }
 
     void GenEventImpl::init(ID _me, unsigned _init_owner)
@@ -1380,6 +1525,7 @@ namespace LegionRuntime {
       generation = 0;
       gen_subscribed = 0;
       next_free = 0;
+      local_waiters = 0;
     }
 
     struct EventSubscribeArgs {
@@ -1485,19 +1631,21 @@ namespace LegionRuntime {
 	  GenEventImpl *e = n->events.lookup_entry(j, i/*node*/);
 	  AutoHSLLock a2(e->mutex);
 
-	  // print anything with either local or remote waiters
-	  if(e->local_waiters.empty() && e->remote_waiters.empty())
+	  // print anything with either local or remote waiters - the local
+	  //  waiter stack can change under us, so this is only a snapshot
+	  size_t num_local = 0;
+	  for(GenEventImpl::WaiterNode *w = e->local_waiters; w; w = w->next)
+	    num_local++;
+	  if((num_local == 0) && e->remote_waiters.empty())
 	    continue;
 
           fprintf(f,"Event " IDFMT ": gen=%d subscr=%d local=%zd remote=%zd\n",
 		  e->me.id(), e->generation, e->gen_subscribed, 
-		  e->local_waiters.size(),
+		  num_local,
                   e->remote_waiters.size());
-	  for(std::vector<EventWaiter *>::iterator it = e->local_waiters.begin();
-	      it != e->local_waiters.end();
-	      it++) {
-	      fprintf(f, "  [%d] L:%p ", e->generation + 1, *it);
-	      (*it)->print_info(f);
+	  for(GenEventImpl::WaiterNode *w = e->local_waiters; w; w = w->next) {
+	      fprintf(f, "  [%d] L:%p ", w->needed_gen, w->waiter);
+	      w->waiter->print_info(f);
 	  }
 	  // for(std::map<Event::gen_t, NodeMask>::const_iterator it = e->remote_waiters.begin();
 	  //     it != e->remote_waiters.end();
@@ -1597,6 +1745,19 @@ namespace LegionRuntime {
       {
       }
 
+      // mergers are created and destroyed for nearly every task launch, so
+      //  they come from a per-thread cache instead of the heap
+      static void *operator new(size_t bytes)
+      {
+	assert(bytes == sizeof(EventMerger));
+	return event_cache_alloc(EventObjectCache::EVENT_MERGER, bytes);
+      }
+
+      static void operator delete(void *ptr)
+      {
+	event_cache_release(EventObjectCache::EVENT_MERGER, ptr);
+      }
+
       void add_event(Event wait_for)
       {
 	if(wait_for.has_triggered()) return; // early out
@@ -1856,31 +2017,88 @@ namespace LegionRuntime {
       return impl;
     }
     
-    void GenEventImpl::check_for_catchup(Event::gen_t implied_trigger_gen)
+    bool GenEventImpl::advance_generation(Event::gen_t new_gen, Event::gen_t& prev_gen)
     {
-      // early out before we take a lock
-      if(implied_trigger_gen <= generation) return;
-
-      // now take a lock and see if we really need to catch up
-      std::vector<EventWaiter *> stale_waiters;
-      {
-	AutoHSLLock a(mutex);
+      while(true) {
+	prev_gen = generation;
+	if(new_gen <= prev_gen) return false;
+	if(__sync_bool_compare_and_swap(&generation, prev_gen, new_gen))
+	  return true;
+      }
+    }
 
-	if(implied_trigger_gen > generation) {
-	  assert(owner != gasnet_mynode());  // cannot be a local event
+    void GenEventImpl::push_waiters(WaiterNode *first, WaiterNode *last,
+				    Event::gen_t min_gen)
+    {
+      while(true) {
+	WaiterNode *head = local_waiters;
+	last->next = head;
+	if(__sync_bool_compare_and_swap(&local_waiters, head, first))
+	  break;
+      }
+      // a trigger that moved the generation forward before the push landed
+      //  may already have popped the stack - pick up whatever it missed
+      //  (the compare-and-swap above orders this read after the push)
+      if(min_gen <= generation)
+	notify_waiters();
+    }
 
-	  log_event.info("event catchup: " IDFMT "/%d -> %d",
-			 me.id(), generation, implied_trigger_gen);
-	  generation = implied_trigger_gen;
-	  stale_waiters.swap(local_waiters);  // we'll actually notify them below
+    void GenEventImpl::notify_waiters(void)
+    {
+      // pop the whole stack at once
+      WaiterNode *list;
+      do {
+	list = local_waiters;
+	if(!list) return;
+      } while(!__sync_bool_compare_and_swap(&local_waiters, list, (WaiterNode *)0));
+
+      // split into the waiters that are ready (reversing them back into the
+      //  order they were added in) and the ones waiting for a later generation
+      Event::gen_t cur_gen = generation;
+      WaiterNode *ready = 0;
+      WaiterNode *keep_first = 0, *keep_last = 0;
+      Event::gen_t keep_min = 0;
+      while(list) {
+	WaiterNode *node = list;
+	list = node->next;
+	if(node->needed_gen <= cur_gen) {
+	  node->next = ready;
+	  ready = node;
+	} else {
+	  if(!keep_first) {
+	    keep_last = node;
+	    keep_min = node->needed_gen;
+	  } else if(node->needed_gen < keep_min)
+	    keep_min = node->needed_gen;
+	  node->next = keep_first;
+	  keep_first = node;
 	}
       }
+      if(keep_first)
+	push_waiters(keep_first, keep_last, keep_min);
 
-      if(!stale_waiters.empty()) {
-	for(std::vector<EventWaiter *>::iterator it = stale_waiters.begin();
-	    it != stale_waiters.end();
-	    it++)
-	  (*it)->event_triggered();
+      while(ready) {
+	WaiterNode *node = ready;
+	ready = node->next;
+	bool nuke = node->waiter->event_triggered();
+	if(nuke)
+	  delete node->waiter;
+	delete node;
+      }
+    }
+
+    void GenEventImpl::check_for_catchup(Event::gen_t implied_trigger_gen)
+    {
+      // early out without touching anything shared
+      if(implied_trigger_gen <= generation) return;
+
+      Event::gen_t prev_gen;
+      if(advance_generation(implied_trigger_gen, prev_gen)) {
+	assert(owner != gasnet_mynode());  // cannot be a local event
+
+	log_event.info("event catchup: " IDFMT "/%d -> %d",
+		       me.id(), prev_gen, implied_trigger_gen);
+	notify_waiters();
       }
     }
 
@@ -1894,50 +2112,47 @@ namespace LegionRuntime {
         item.action = EventTraceItem::ACT_WAIT;
       }
 #endif
-      bool trigger_now = false;
-
-      int subscribe_owner = -1;
-      EventSubscribeArgs args;
-      // initialization to make not-as-clever compilers happy
-      args.node = 0;
-      args.event = Event::NO_EVENT;
-      args.previous_subscribe_gen = 0;
-      {
-	AutoHSLLock a(mutex);
-
-	if(needed_gen > generation) {
-	  log_event(LEVEL_DEBUG, "event not ready: event=" IDFMT "/%d owner=%d gen=%d subscr=%d",
-		    me.id(), needed_gen, owner, generation, gen_subscribed);
+      // fast path: the generation only ever moves forward, so if we can
+      //  see it has triggered there's nothing to enqueue
+      if(needed_gen <= generation) {
+	bool nuke = waiter->event_triggered();
+        if(nuke)
+          delete waiter;
+	return true;
+      }
 
-	  // catchup code for remote events has been moved to get_genevent_impl, so
-	  //  we should never be asking for a stale version here
-	  assert(needed_gen == (generation + 1));
+      log_event(LEVEL_DEBUG, "event not ready: event=" IDFMT "/%d owner=%d gen=%d subscr=%d",
+		me.id(), needed_gen, owner, generation, gen_subscribed);
 
-	  // do we need to subscribe?
-	  if((owner != gasnet_mynode()) && (gen_subscribed < needed_gen)) {
-	    gen_subscribed = needed_gen;
-	    subscribe_owner = owner;
-	    args.node = gasnet_mynode();
-	    args.event = me.convert<Event>();
-	    args.event.gen = needed_gen;
-	  }
+      // catchup code for remote events has been moved to get_genevent_impl, so
+      //  we should never be asking for a generation past the next one
+      assert(needed_gen <= (generation + 1));
 
-	  // now we add to the local waiter list
-	  local_waiters.push_back(waiter);
-	} else {
-	  // event we are interested in has already triggered!
-	  trigger_now = true; // actually do trigger outside of mutex
+      // do we need to subscribe?
+      bool subscribe = false;
+      EventSubscribeArgs args;
+      if(owner != gasnet_mynode()) {
+	AutoHSLLock a(mutex);
+	if(gen_subscribed < needed_gen) {
+	  args.previous_subscribe_gen = 0;
+	  gen_subscribed = needed_gen;
+	  args.node = gasnet_mynode();
+	  args.event = me.convert<Event>();
+	  args.event.gen = needed_gen;
+	  subscribe = true;
 	}
       }
 
-      if((subscribe_owner != -1))
-	EventSubscribeMessage::request(owner, args);
+      // now we add to the local waiter stack (which notifies the waiter
+      //  right away if we lost a race with the trigger)
+      WaiterNode *node = new WaiterNode;
+      node->waiter = waiter;
+      node->needed_gen = needed_gen;
+      node->next = 0;
+      push_waiters(node, node, needed_gen);
 
-      if(trigger_now) {
-	bool nuke = waiter->event_triggered();
-        if(nuke)
-          delete waiter;
-      }
+      if(subscribe)
+	EventSubscribeMessage::request(owner, args);
 
       return true;  // waiter is always either enqueued or triggered right now
     }
@@ -1952,13 +2167,14 @@ namespace LegionRuntime {
         item.action = EventTraceItem::ACT_QUERY;
       }
 #endif
+      // no lock needed - the generation is only ever moved forward atomically
       return (needed_gen <= generation);
     }
 
     class PthreadCondWaiter : public EventWaiter {
     public:
       PthreadCondWaiter(GASNetCondVar &_cv)
-        : cv(_cv)
+        : cv(_cv), notified(false)
       {
       }
       virtual ~PthreadCondWaiter(void) 
@@ -1968,36 +2184,52 @@ namespace LegionRuntime {
       virtual bool event_triggered(void)
       {
         // Need to hold the lock to avoid the race
-        AutoHSLLock(cv.mutex);
+        AutoHSLLock a(cv.mutex);
+        notified = true;
 	cv.signal();
-        // we're allocated on caller's stack, so deleting would be bad
+        // we're allocated on caller's stack, so deleting would be bad -
+        //  and once 'notified' is visible the caller may already be gone
         return false;
       }
       virtual void print_info(FILE *f) { fprintf(f,"external waiter\n"); }
 
     public:
       GASNetCondVar &cv;
+      // set under cv.mutex by event_triggered - the waiting thread must not
+      //  leave (and pop this object off its stack) until this is true
+      bool notified;
     };
 
     void GenEventImpl::external_wait(Event::gen_t gen_needed)
     {
+      if(gen_needed <= generation) return;
+
       GASNetCondVar cv(mutex);
       PthreadCondWaiter w(cv);
-      {
-	AutoHSLLock a(mutex);
-
-	if(gen_needed > generation) {
-	  local_waiters.push_back(&w);
-    
-	  if((owner != gasnet_mynode()) && (gen_needed > gen_subscribed)) {
-	    printf("AAAH!  Can't subscribe to another node's event in external_wait()!\n");
-	    exit(1);
-	  }
 
-	  // now just sleep on the condition variable - hope we wake up
-	  cv.wait();
+      if(owner != gasnet_mynode()) {
+	AutoHSLLock a(mutex);
+	if(gen_needed > gen_subscribed) {
+	  printf("AAAH!  Can't subscribe to another node's event in external_wait()!\n");
+	  exit(1);
 	}
       }
+
+      // the waiter is enqueued before we take the lock (a trigger that
+      //  wins the race notifies it right here), and it signals while
+      //  holding the lock, so checking the flag under the lock cannot miss
+      //  the wakeup - we wait for the notification itself rather than the
+      //  generation because trigger() advances the generation before it
+      //  walks the waiter list, and 'w' must outlive that walk
+      WaiterNode *node = new WaiterNode;
+      node->waiter = &w;
+      node->needed_gen = gen_needed;
+      node->next = 0;
+      push_waiters(node, node, gen_needed);
+
+      AutoHSLLock a(mutex);
+      while(!w.notified)
+	cv.wait();
     }
 
     class DeferredEventTrigger : public EventWaiter {
@@ -2053,79 +2285,58 @@ namespace LegionRuntime {
       }
 #endif
 
-      std::vector<EventWaiter *> to_wake;
-      {
-	AutoHSLLock a(mutex);
-
-        // SJT: there is at least one unavoidable case where we'll receive
-	//  duplicate trigger notifications, so if we see a triggering of
-	//  an older generation, just ignore it
-	if(gen_triggered <= generation) return;
-
-	// in preparation for switching everybody over to trigger_current(), complain
-	//  LOUDLY if this wouldn't actually be a triggering of the current generation
-	if(gen_triggered != (generation + 1))
-	  log_event.error("HELP!  non-current event generation being triggered: " IDFMT "/%d vs %d",
-			  me.id(), gen_triggered, generation + 1);
-
-        generation = gen_triggered;
-
-	// grab whole list of local waiters - we'll trigger them once we let go of the lock
-	//printf("[%d] LOCAL WAITERS: %zd\n", gasnet_mynode(), local_waiters.size());
-	to_wake.swap(local_waiters);
+      // SJT: there is at least one unavoidable case where we'll receive
+      //  duplicate trigger notifications, so if we see a triggering of
+      //  an older generation, just ignore it
+      Event::gen_t prev_gen;
+      if(!advance_generation(gen_triggered, prev_gen)) return;
 
-	// notify remote waiters and/or event's actual owner
-	if(owner == gasnet_mynode()) {
-	  // send notifications to every other node that has subscribed
-	  //  (except the one that triggered)
-          if (!remote_waiters.empty())
-          {
-            EventTriggerArgs args;
-            args.node = trigger_node;
-            args.event = me.convert<Event>();
-            args.event.gen = gen_triggered;
-
-            NodeSet send_mask;
-            send_mask.swap(remote_waiters);
-            send_mask.map(args);
-            //for(int node = 0; node < MAX_NUM_NODES; node++)
-            //  if (send_mask.contains(node) && (node != trigger_node))
-            //    EventTriggerMessage::request(node, args);
-          }
-	} else {
-	  if(((unsigned)trigger_node) == gasnet_mynode()) {
-	    // if we're not the owner, we just send to the owner and let him
-	    //  do the broadcast (assuming the trigger was local)
-	    //assert(remote_waiters == 0);
+      // in preparation for switching everybody over to trigger_current(), complain
+      //  LOUDLY if this wouldn't actually be a triggering of the current generation
+      if(gen_triggered != (prev_gen + 1))
+	log_event.error("HELP!  non-current event generation being triggered: " IDFMT "/%d vs %d",
+			me.id(), gen_triggered, prev_gen + 1);
 
+      // notify remote waiters and/or event's actual owner
+      if(owner == gasnet_mynode()) {
+	// send notifications to every other node that has subscribed
+	//  (except the one that triggered) - subscriptions only ever come
+	//  from other nodes, so a single node never needs the lock
+	if(gasnet_nodes() > 1) {
+	  NodeSet send_mask;
+	  {
+	    AutoHSLLock a(mutex);
+	    send_mask.swap(remote_waiters);
+	  }
+	  if(!send_mask.empty()) {
 	    EventTriggerArgs args;
 	    args.node = trigger_node;
 	    args.event = me.convert<Event>();
 	    args.event.gen = gen_triggered;
-	    EventTriggerMessage::request(owner, args);
+	    send_mask.map(args);
 	  }
 	}
+      } else {
+	if(((unsigned)trigger_node) == gasnet_mynode()) {
+	  // if we're not the owner, we just send to the owner and let him
+	  //  do the broadcast (assuming the trigger was local)
+	  EventTriggerArgs args;
+	  args.node = trigger_node;
+	  args.event = me.convert<Event>();
+	  args.event.gen = gen_triggered;
+	  EventTriggerMessage::request(owner, args);
+	}
       }
 
       // if this is one of our events, put ourselves on the free
-      //  list (we don't need our lock for this)
+      //  list - waiters for the next generation that show up before we
+      //  get to notify ours are left on the stack by notify_waiters
       if(owner == gasnet_mynode()) {
 	get_runtime()->local_event_free_list->free_entry(this);
       }
 
-      // now that we've let go of the lock, notify all the waiters who wanted
-      //  this event generation (or an older one)
-      {
-	for(std::vector<EventWaiter *>::iterator it = to_wake.begin();
-	    it != to_wake.end();
-	    it++) {
-	  bool nuke = (*it)->event_triggered();
-          if(nuke) {
-            //printf("deleting: "); (*it)->print_info(); fflush(stdout);
-            delete (*it);
-          }
-        }
-      }
+      // now wake everybody who was waiting on this generation in one batch
+      notify_waiters();
     }
 
     static Logger::Category log_barrier("barrier");
@@ -3746,7 +3957,8 @@ namespace LegionRuntime {
     static const off_t ZERO_SIZE_INSTANCE_OFFSET = 1ULL << 50;
 
     Memory::Impl::Impl(Memory _me, size_t _size, MemoryKind _kind, size_t _alignment, Kind _lowlevel_kind)
-      : me(_me), size(_size), kind(_kind), alignment(_alignment), lowlevel_kind(_lowlevel_kind)
+      : me(_me), size(_size), kind(_kind), alignment(_alignment), lowlevel_kind(_lowlevel_kind),
+	allocator((_alignment > 0) ? _alignment : 16)
 #ifdef REALM_PROFILE_MEMORY_USAGE
       , usage(0), peak_usage(0), peak_footprint(0)
 #endif
@@ -3761,9 +3973,163 @@ namespace LegionRuntime {
 	     me.id, 
 	     peak_usage, peak_usage / 1048576.0,
 	     peak_footprint, peak_footprint / 1048576.0);
+      RangeAllocator::Stats stats;
+      allocator.apply_deferred_frees();
+      allocator.get_stats(stats);
+      printf("Memory " IDFMT " free: total=%zd largest=%zd ranges=%zd fragmentation=%.3f\n",
+	     me.id, stats.total_free, stats.largest_free, stats.free_ranges,
+	     stats.fragmentation);
 #endif
     }
 
+    RangeAllocator::RangeAllocator(size_t _granule)
+      : granule(_granule), total_free(0), deferred_frees(0)
+    {
+      assert(granule > 0);
+    }
+
+    RangeAllocator::~RangeAllocator(void)
+    {
+      apply_deferred_frees();
+    }
+
+    // small sizes that are a multiple of the granule get an exact-size bin,
+    //  anything else lives in the size-ordered tree
+    int RangeAllocator::size_class(off_t size) const
+    {
+      if((size % granule) != 0) return -1;
+      size_t c = (size / granule) - 1;
+      return ((c < NUM_SMALL_CLASSES) ? (int)c : -1);
+    }
+
+    void RangeAllocator::insert_range(off_t offset, off_t size)
+    {
+      free_blocks[offset] = size;
+      int c = size_class(size);
+      if(c >= 0)
+	small_bins[c].insert(offset);
+      else
+	large_blocks.insert(std::make_pair(size, offset));
+      total_free += size;
+    }
+
+    void RangeAllocator::remove_range(std::map<off_t, off_t>::iterator it)
+    {
+      int c = size_class(it->second);
+      if(c >= 0)
+	small_bins[c].erase(it->first);
+      else
+	large_blocks.erase(std::make_pair(it->second, it->first));
+      total_free -= it->second;
+      free_blocks.erase(it);
+    }
+
+    void RangeAllocator::add_range(off_t offset, size_t size)
+    {
+      // merge with the ranges right after and before us, if they're free
+      std::map<off_t, off_t>::iterator after = free_blocks.lower_bound(offset);
+      if(after != free_blocks.end()) {
+	assert((offset + (off_t)size) <= after->first); // no overlap!
+	if((offset + (off_t)size) == after->first) {
+	  size += after->second;
+	  std::map<off_t, off_t>::iterator to_erase = after++;
+	  remove_range(to_erase);
+	}
+      }
+      if(after != free_blocks.begin()) {
+	std::map<off_t, off_t>::iterator before = after; before--;
+	assert((before->first + before->second) <= offset);
+	if((before->first + before->second) == offset) {
+	  offset = before->first;
+	  size += before->second;
+	  remove_range(before);
+	}
+      }
+      insert_range(offset, size);
+    }
+
+    off_t RangeAllocator::allocate(size_t size)
+    {
+      // best fit - smallest sufficient range, highest address among those
+      //  to keep the footprint down
+      off_t found_ofs = -1;
+      off_t found_size = 0;
+
+      int c = size_class(size);
+      if(c >= 0) {
+	for(size_t i = c; i < NUM_SMALL_CLASSES; i++)
+	  if(!small_bins[i].empty()) {
+	    found_ofs = *(small_bins[i].rbegin());
+	    found_size = (i + 1) * granule;
+	    break;
+	  }
+      }
+
+      if(found_ofs < 0) {
+	std::set<std::pair<off_t, off_t> >::iterator it =
+	  large_blocks.lower_bound(std::make_pair((off_t)size, (off_t)0));
+	if(it == large_blocks.end())
+	  return -1;
+	// skip to the last range of this same size
+	std::set<std::pair<off_t, off_t> >::iterator last =
+	  large_blocks.lower_bound(std::make_pair(it->first + 1, (off_t)0));
+	last--;
+	found_ofs = last->second;
+	found_size = last->first;
+      }
+
+      std::map<off_t, off_t>::iterator it = free_blocks.find(found_ofs);
+      assert((it != free_blocks.end()) && (it->second == found_size));
+      remove_range(it);
+
+      // hand out the top of the range, and keep what's left over
+      off_t leftover = found_size - size;
+      if(leftover > 0)
+	insert_range(found_ofs, leftover);
+      return found_ofs + leftover;
+    }
+
+    void RangeAllocator::defer_free(off_t offset, size_t size)
+    {
+      DeferredFree *f = new DeferredFree;
+      f->offset = offset;
+      f->size = size;
+      do {
+	f->next = deferred_frees;
+      } while(!__sync_bool_compare_and_swap(&deferred_frees, f->next, f));
+    }
+
+    void RangeAllocator::apply_deferred_frees(void)
+    {
+      if(!deferred_frees) return;
+      DeferredFree *f = __sync_lock_test_and_set(&deferred_frees, (DeferredFree *)0);
+      while(f) {
+	add_range(f->offset, f->size);
+	DeferredFree *next = f->next;
+	delete f;
+	f = next;
+      }
+    }
+
+    void RangeAllocator::get_stats(Stats& stats) const
+    {
+      stats.total_free = total_free;
+      stats.free_ranges = free_blocks.size();
+      stats.largest_free = 0;
+      if(!large_blocks.empty())
+	stats.largest_free = large_blocks.rbegin()->first;
+      // ranges in the tree aren't necessarily bigger than the small classes
+      for(int i = NUM_SMALL_CLASSES - 1; i >= 0; i--)
+	if(!small_bins[i].empty()) {
+	  if(((i + 1) * granule) > stats.largest_free)
+	    stats.largest_free = (i + 1) * granule;
+	  break;
+	}
+      stats.fragmentation = ((total_free > 0) ?
+			       (1.0 - ((double)stats.largest_free / total_free)) :
+			       0.0);
+    }
+
     off_t Memory::Impl::alloc_bytes_local(size_t size)
     {
       AutoHSLLock al(mutex);
@@ -3785,52 +4151,34 @@ namespace LegionRuntime {
       //  the end of their allocations
       size += 0;
 
-      // try to minimize footprint by allocating at the highest address possible
-      if(!free_blocks.empty()) {
-	std::map<off_t, off_t>::iterator it = free_blocks.end();
-	do {
-	  --it;  // predecrement since we started at the end
+      // pick up whatever was freed since the last allocation
+      allocator.apply_deferred_frees();
 
-	  if(it->second == (off_t)size) {
-	    // perfect match
-	    off_t retval = it->first;
-	    free_blocks.erase(it);
-	    log_malloc.info("alloc full block: mem=" IDFMT " size=%zd ofs=%zd", me.id, size, retval);
-#ifdef REALM_PROFILE_MEMORY_USAGE
-	    usage += size;
-	    if(usage > peak_usage) peak_usage = usage;
-	    size_t footprint = this->size - retval;
-	    if(footprint > peak_footprint) peak_footprint = footprint;
-#endif
-	    return retval;
-	  }
-	
-	  if(it->second > (off_t)size) {
-	    // some left over
-	    off_t leftover = it->second - size;
-	    off_t retval = it->first + leftover;
-	    it->second = leftover;
-	    log_malloc.info("alloc partial block: mem=" IDFMT " size=%zd ofs=%zd", me.id, size, retval);
+      off_t retval = allocator.allocate(size);
+      if(retval >= 0) {
+	log_malloc.info("alloc block: mem=" IDFMT " size=%zd ofs=%zd", me.id, size, retval);
 #ifdef REALM_PROFILE_MEMORY_USAGE
-	    usage += size;
-	    if(usage > peak_usage) peak_usage = usage;
-	    size_t footprint = this->size - retval;
-	    if(footprint > peak_footprint) peak_footprint = footprint;
+	// frees update the usage without the lock
+	size_t new_usage = __sync_add_and_fetch(&usage, size);
+	if(new_usage > peak_usage) peak_usage = new_usage;
+	size_t footprint = this->size - retval;
+	if(footprint > peak_footprint) peak_footprint = footprint;
 #endif
-	    return retval;
-	  }
-	} while(it != free_blocks.begin());
+	return retval;
       }
 
       // no blocks large enough - boo hoo
-      log_malloc.info("alloc FAILED: mem=" IDFMT " size=%zd", me.id, size);
+      RangeAllocator::Stats stats;
+      allocator.get_stats(stats);
+      log_malloc.info("alloc FAILED: mem=" IDFMT " size=%zd (free=%zd largest=%zd ranges=%zd fragmentation=%.3f)",
+		      me.id, size, stats.total_free, stats.largest_free,
+		      stats.free_ranges, stats.fragmentation);
       return -1;
     }
 
     void Memory::Impl::free_bytes_local(off_t offset, size_t size)
     {
       log_malloc.info("free block: mem=" IDFMT " size=%zd ofs=%zd", me.id, size, offset);
-      AutoHSLLock al(mutex);
 
       // frees of zero bytes should have the special offset
       if(size == 0) {
@@ -3848,64 +4196,13 @@ namespace LegionRuntime {
       }
 
 #ifdef REALM_PROFILE_MEMORY_USAGE
-      usage -= size;
+      __sync_fetch_and_sub(&usage, size);
       // only made things smaller, so can't impact the peak usage
 #endif
 
-      if(free_blocks.size() > 0) {
-	// find the first existing block that comes _after_ us
-	std::map<off_t, off_t>::iterator after = free_blocks.lower_bound(offset);
-	if(after != free_blocks.end()) {
-	  // found one - is it the first one?
-	  if(after == free_blocks.begin()) {
-	    // yes, so no "before"
-	    assert((offset + (off_t)size) <= after->first); // no overlap!
-	    if((offset + (off_t)size) == after->first) {
-	      // merge the ranges by eating the "after"
-	      size += after->second;
-	      free_blocks.erase(after);
-	    }
-	    free_blocks[offset] = size;
-	  } else {
-	    // no, get range that comes before us too
-	    std::map<off_t, off_t>::iterator before = after; before--;
-
-	    // if we're adjacent to the after, merge with it
-	    assert((offset + (off_t)size) <= after->first); // no overlap!
-	    if((offset + (off_t)size) == after->first) {
-	      // merge the ranges by eating the "after"
-	      size += after->second;
-	      free_blocks.erase(after);
-	    }
-
-	    // if we're adjacent with the before, grow it instead of adding
-	    //  a new range
-	    assert((before->first + before->second) <= offset);
-	    if((before->first + before->second) == offset) {
-	      before->second += size;
-	    } else {
-	      free_blocks[offset] = size;
-	    }
-	  }
-	} else {
-	  // nothing's after us, so just see if we can merge with the range
-	  //  that's before us
-
-	  std::map<off_t, off_t>::iterator before = after; before--;
-
-	  // if we're adjacent with the before, grow it instead of adding
-	  //  a new range
-	  assert((before->first + before->second) <= offset);
-	  if((before->first + before->second) == offset) {
-	    before->second += size;
-	  } else {
-	    free_blocks[offset] = size;
-	  }
-	}
-      } else {
-	// easy case - nothing was free, so now just our block is
-	free_blocks[offset] = size;
-      }
+      // no need to take the lock - the range is coalesced back in by the
+      //  next allocation
+      allocator.defer_free(offset, size);
     }
 
     off_t Memory::Impl::alloc_bytes_remote(size_t size)
@@ -3961,7 +4258,7 @@ namespace LegionRuntime {
 	}
 	log_copy.debug("CPU memory at %p, size = %zd%s%s", base, _size, 
 		       prealloced ? " (prealloced)" : "", registered ? " (registered)" : "");
-	free_blocks[0] = _size;
+	allocator.add_range(0, _size);
       }
 
       virtual ~LocalCPUMemory(void)
@@ -4777,7 +5074,7 @@ namespace LegionRuntime {
       size = size_per_node * num_nodes;
       memory_stride = MEMORY_STRIDE;
       
-      free_blocks[0] = size;
+      allocator.add_range(0, size);
     }
 
     GASNetMemory::~GASNetMemory(void)
@@ -5383,12 +5680,17 @@ namespace LegionRuntime {
 
     ProcessorGroup::ProcessorGroup(void)
       : Processor::Impl(Processor::NO_PROC, Processor::PROC_GROUP),
-	members_valid(false), members_requested(false), next_free(0)
+	members_valid(false), members_requested(false), next_free(0),
+	stealing(false), next_member(0)
     {
     }
 
     ProcessorGroup::~ProcessorGroup(void)
     {
+      for(std::vector<JobQueue<Task> *>::iterator it = member_queues.begin();
+	  it != member_queues.end();
+	  it++)
+	delete *it;
     }
 
     void ProcessorGroup::init(Processor _me, int _owner)
@@ -5414,6 +5716,23 @@ namespace LegionRuntime {
 	members.push_back(m_impl);
       }
 
+      // work stealing only if every member can take part
+      stealing = !members.empty();
+      for(std::vector<Processor::Impl *>::const_iterator it = members.begin();
+	  it != members.end();
+	  it++)
+	if(!(*it)->can_steal()) {
+	  stealing = false;
+	  break;
+	}
+
+      if(stealing) {
+	for(size_t i = 0; i < members.size(); i++)
+	  member_queues.push_back(new JobQueue<Task>);
+	for(size_t i = 0; i < members.size(); i++)
+	  members[i]->join_group(this, i);
+      }
+
       members_requested = true;
       members_valid = true;
     }
@@ -5439,6 +5758,14 @@ namespace LegionRuntime {
 
     void ProcessorGroup::enqueue_task(Task *task)
     {
+      if(stealing) {
+	// one member gets the task (round robin) - if it's busy, the others
+	//  steal it from that member's queue
+	int index = __sync_fetch_and_add(&next_member, 1) % members.size();
+	members[index]->enqueue_group_task(this, index, task);
+	return;
+      }
+
       for (std::vector<Processor::Impl *>::const_iterator it = members.begin();
             it != members.end(); it++)
       {
@@ -5452,9 +5779,11 @@ namespace LegionRuntime {
 						Event start_event, Event finish_event,
 						int priority)
     {
-      // create a task object and insert it into the queue
+      // create a task object and insert it into the queue - without work
+      //  stealing, each member gets a reference to the task
       Task *task = new Task(me, func_id, args, arglen, 
-                            finish_event, priority, members.size());
+                            finish_event, priority,
+			    (stealing ? 1 : members.size()));
 
       if (start_event.has_triggered())
         enqueue_task(task);
@@ -5462,6 +5791,14 @@ namespace LegionRuntime {
         start_event.impl()->add_waiter(start_event.gen, new DeferredTaskSpawn(this, task));
     }
 
+    void ProcessorGroup::wake_thief_for(int index)
+    {
+      // start after the busy member so that thieves are spread around
+      for(size_t i = 1; i < members.size(); i++)
+	if(members[(index + i) % members.size()]->wake_thief())
+	  return;
+    }
+
     class LocalProcessor : public Processor::Impl {
     public:
 #if 0
@@ -5598,6 +5935,12 @@ namespace LegionRuntime {
 
 	virtual void sleep_on_event(Event wait_for, bool block = false)
 	{
+	  // a task running on a user-level context just parks the context -
+	  //  this thread goes back to its loop and runs something else
+	  if(cur_context && !block) {
+	    park_context(wait_for);
+	    return;
+	  }
 #ifdef EVENT_GRAPH_TRACE
           unsigned long long start = TimeStamp::get_current_time_in_micros(); 
 #endif
@@ -5642,11 +5985,33 @@ namespace LegionRuntime {
 	      // plan B - if there's a ready task, we can run it while
 	      //   we're waiting (unless 'block' is set)
 	      if(!block) {
-                if(!proc->task_queue.empty()) {
-		  Task *newtask = proc->task_queue.pop();
+		if(!proc->resumable_contexts.empty()) {
+		  TaskContext *ctx = proc->resumable_contexts.front();
+		  proc->resumable_contexts.pop_front();
+		  log_task.info("thread %p (proc " IDFMT ") resuming context %p instead of sleeping",
+			        this, proc->me.id, ctx);
+
+		  al.release();
+		  resume_context(ctx);
+		  al.reacquire();
+		  continue;
+		}
+
+		Task *newtask = proc->pop_next_task();
+                if(newtask) {
 		  log_task.info("thread %p (proc " IDFMT ") running task %p instead of sleeping",
 			        this, proc->me.id, newtask);
 
+		  if(TaskContext::enabled) {
+		    al.release();
+		    if (__sync_fetch_and_add(&(newtask->run_count),1) == 0)
+		      run_in_context(newtask, Processor::NO_PROC);
+		    else if (__sync_add_and_fetch(&(newtask->finish_count),-1) == 0)
+		      delete newtask;
+		    al.reacquire();
+		    continue;
+		  }
+
 		  al.release();
                   if (__sync_fetch_and_add(&(newtask->run_count),1) == 0)
                     run_task(newtask);
@@ -5774,10 +6139,26 @@ namespace LegionRuntime {
 	    // first priority - try to run a task if one is available and
 	    //   we're not at the active thread count limit
 	    if(proc->active_thread_count < proc->max_active_threads) {
-              Task *newtask = 0;
-              if(!proc->task_queue.empty()) {
-                newtask = proc->task_queue.pop();
-              }
+	      // parked contexts whose events have triggered go ahead of new
+	      //  tasks, just like resumable threads do
+	      if(!proc->resumable_contexts.empty()) {
+		TaskContext *ctx = proc->resumable_contexts.front();
+		proc->resumable_contexts.pop_front();
+		proc->active_thread_count++;
+		state = STATE_RUN;
+
+		al.release();
+		log_task.info("thread %p resuming context %p for proc " IDFMT "",
+			      this, ctx, proc->me.id);
+		resume_context(ctx);
+		al.reacquire();
+
+		state = STATE_IDLE;
+		proc->active_thread_count--;
+		continue;
+	      }
+
+              Task *newtask = proc->pop_next_task();
               if(newtask) {
                 // Keep holding the lock until we are sure we're
                 // going to run this task
@@ -5789,11 +6170,17 @@ namespace LegionRuntime {
                   al.release();
                   log_task.info("thread running ready task %p for proc " IDFMT "",
                                 newtask, proc->me.id);
-                  run_task(newtask, proc->me);
-                  log_task.info("thread finished running task %p for proc " IDFMT "",
-                                newtask, proc->me.id);
-                  if (__sync_add_and_fetch(&(newtask->finish_count),-1) == 0)
-                    delete newtask;
+                  if(TaskContext::enabled) {
+                    // the context drops its reference to the task when
+                    //  the task is done, which may be after we get back
+                    run_in_context(newtask, proc->me);
+                  } else {
+                    run_task(newtask, proc->me);
+                    log_task.info("thread finished running task %p for proc " IDFMT "",
+                                  newtask, proc->me.id);
+                    if (__sync_add_and_fetch(&(newtask->finish_count),-1) == 0)
+                      delete newtask;
+                  }
                   al.reacquire();
 
                   state = STATE_IDLE;
@@ -5853,6 +6240,11 @@ namespace LegionRuntime {
         {
           return proc->me;
         }
+
+	virtual void context_resumable(TaskContext *ctx)
+	{
+	  proc->context_resumable(ctx);
+	}
       };
 
       class DeferredTaskSpawn : public EventWaiter {
@@ -5996,20 +6388,160 @@ namespace LegionRuntime {
 	}
       }
 
-      // see if there are resumable threads and/or new tasks to run, respecting
-      //  the available thread and runnable thread limits
+      // a parked context can run again - wake up a thread to resume it if
+      //  we're below the active thread limit
+      void context_resumable(TaskContext *ctx)
+      {
+	AutoHSLLock a(mutex);
+
+	resumable_contexts.push_back(ctx);
+	log_task.info("context %p resumable on proc " IDFMT "", ctx, me.id);
+	wake_some_thread();
+      }
+
+      // wakes up an idle thread, or failing that preempts a sleeping one,
+      //  if we're below the active thread limit - returns false if no
+      //  thread could be woken
       // ASSUMES LOCK IS HELD BY CALLER
-      void start_some_threads(void)
+      bool wake_some_thread(void)
       {
-	// favor once-running threads that now want to resume
-	while((active_thread_count < max_active_threads) &&
-	      (resumable_threads.size() > 0)) {
-	  Thread *t = resumable_threads.front();
-	  resumable_threads.pop_front();
-	  active_thread_count++;
-	  log_task(LEVEL_SPEW, "ATC = %d", active_thread_count);
-	  assert(t->state == Thread::STATE_RESUMABLE);
-	  t->state = Thread::STATE_RUN;
+	if(active_thread_count >= max_active_threads)
+	  return false;
+
+	if(avail_threads.size() > 0) {
+	  Thread *t = avail_threads.front();
+	  avail_threads.pop_front();
+	  assert(t->state == Thread::STATE_IDLE);
+	  log_task.info("waking up thread %p", t);
+	  gasnett_cond_signal(&t->condvar);
+	  return true;
+	}
+
+	if(preemptable_threads.size() > 0) {
+	  Thread *t = preemptable_threads.front();
+	  preemptable_threads.pop_front();
+	  assert(t->state == Thread::STATE_PREEMPTABLE);
+	  t->state = Thread::STATE_RUN;
+	  active_thread_count++;
+	  log_task.info("preempting thread %p", t);
+	  gasnett_cond_signal(&t->condvar);
+	  return true;
+	}
+
+	return false;
+      }
+
+      virtual bool can_steal(void) const
+      {
+	return true;
+      }
+
+      virtual void join_group(ProcessorGroup *group, int index)
+      {
+	AutoHSLLock a(mutex);
+	groups.push_back(std::make_pair(group, index));
+      }
+
+      virtual void enqueue_group_task(ProcessorGroup *group, int index,
+				      Task *task)
+      {
+	bool woken;
+	{
+	  AutoHSLLock a(mutex);
+	  // we're the only one inserting into our queue of the group
+	  group->member_queues[index]->insert(task, task->priority);
+	  log_task.info("pushing group task %p onto list for proc " IDFMT "",
+			task, me.id);
+	  woken = wake_some_thread();
+	}
+	// all our threads are busy - get another member to steal the task,
+	//  after letting go of our lock so that two members doing this to
+	//  each other can't deadlock
+	if(!woken)
+	  group->wake_thief_for(index);
+      }
+
+      virtual bool wake_thief(void)
+      {
+	AutoHSLLock a(mutex);
+	if(groups.empty()) return false;
+	return wake_some_thread();
+      }
+
+      // the highest priority task of the groups we're in whose band is above
+      //  'min_band' - our own share of the tasks of each group wins a tie,
+      //  otherwise the task is stolen from another member of the group
+      // ASSUMES LOCK IS HELD BY CALLER
+      Task *pop_group_task(int min_band = -1)
+      {
+	JobQueue<Task> *best = 0;
+	int best_band = min_band;
+	for(std::vector<std::pair<ProcessorGroup *, int> >::const_iterator it = groups.begin();
+	    it != groups.end();
+	    it++) {
+	  JobQueue<Task> *queue = it->first->member_queues[it->second];
+	  int band = queue->top_band();
+	  if(band > best_band) {
+	    best = queue;
+	    best_band = band;
+	  }
+	}
+
+	ProcessorGroup *victim_group = 0;
+	size_t victim = 0;
+	for(std::vector<std::pair<ProcessorGroup *, int> >::const_iterator it = groups.begin();
+	    it != groups.end();
+	    it++) {
+	  const std::vector<JobQueue<Task> *>& queues = it->first->member_queues;
+	  // start with the member after us so that thieves spread out
+	  for(size_t i = 1; i < queues.size(); i++) {
+	    size_t index = (it->second + i) % queues.size();
+	    int band = queues[index]->top_band();
+	    if(band > best_band) {
+	      best = queues[index];
+	      best_band = band;
+	      victim_group = it->first;
+	      victim = index;
+	    }
+	  }
+	}
+
+	// somebody else may take it first, the caller just tries again
+	if(!best) return 0;
+	Task *task = best->pop();
+	if(task && victim_group)
+	  log_task.info("proc " IDFMT " stole task %p from group " IDFMT " member %zd",
+			me.id, task, victim_group->me.id, victim);
+	return task;
+      }
+
+      // the highest priority task of our own queue and the group queues,
+      //  a tie goes to our own queue
+      // ASSUMES LOCK IS HELD BY CALLER
+      Task *pop_next_task(void)
+      {
+	Task *task = pop_group_task(task_queue.top_band());
+	if(!task)
+	  task = task_queue.pop();
+	if(!task)
+	  task = pop_group_task();
+	return task;
+      }
+
+      // see if there are resumable threads and/or new tasks to run, respecting
+      //  the available thread and runnable thread limits
+      // ASSUMES LOCK IS HELD BY CALLER
+      void start_some_threads(void)
+      {
+	// favor once-running threads that now want to resume
+	while((active_thread_count < max_active_threads) &&
+	      (resumable_threads.size() > 0)) {
+	  Thread *t = resumable_threads.front();
+	  resumable_threads.pop_front();
+	  active_thread_count++;
+	  log_task(LEVEL_SPEW, "ATC = %d", active_thread_count);
+	  assert(t->state == Thread::STATE_RESUMABLE);
+	  t->state = Thread::STATE_RUN;
 	  gasnett_cond_signal(&t->condvar);
 	}
       }
@@ -6045,7 +6577,9 @@ namespace LegionRuntime {
       std::list<Thread *> avail_threads;
       std::list<Thread *> resumable_threads;
       std::list<Thread *> preemptable_threads;
+      std::list<TaskContext *> resumable_contexts;
       std::set<Thread *> all_threads;
+      std::vector<std::pair<ProcessorGroup *, int> > groups;
       gasnet_hsl_t mutex;
       bool init_done, shutdown_requested;
       GenEventImpl *shutdown_event;
@@ -6127,6 +6661,197 @@ namespace LegionRuntime {
       return 0;
     }
 
+    void PreemptableThread::run_in_context(Task *task, Processor actual_proc)
+    {
+      // a task that never waits finishes on the same context the previous
+      //  one did, so the pool is only touched when contexts get parked
+      TaskContext *ctx = spare_context;
+      if(ctx)
+	spare_context = 0;
+      else
+	ctx = TaskContext::acquire(&context_main);
+      ctx->task = task;
+      ctx->actual_proc = actual_proc;
+      resume_context(ctx);
+    }
+
+    void PreemptableThread::resume_context(TaskContext *ctx)
+    {
+      ctx->host = this;
+      ctx->state = TaskContext::CTX_RUNNING;
+      cur_context = ctx;
+      TaskContext::switch_context(&host_regs, &ctx->regs);
+      cur_context = 0;
+
+      // the context is off its stack now, so it's safe to hand it to the
+      //  event (which may resume it on another thread right away) or to
+      //  the next task
+      if(ctx->state == TaskContext::CTX_PARKING) {
+	ctx->state = TaskContext::CTX_PARKED;
+	Event wait_for = ctx->wait_for;
+	get_runtime()->get_event_impl(wait_for)->add_waiter(wait_for.gen, ctx);
+	return;
+      }
+
+      assert(ctx->state == TaskContext::CTX_DONE);
+      if(spare_context)
+	TaskContext::release(ctx);
+      else
+	spare_context = ctx;
+    }
+
+    void PreemptableThread::park_context(Event wait_for)
+    {
+      TaskContext *ctx = cur_context;
+      assert(ctx != 0);
+      log_task.info("context %p (thread %p) parked on event " IDFMT "/%d",
+		    ctx, this, wait_for.id, wait_for.gen);
+      ctx->wait_for = wait_for;
+      ctx->state = TaskContext::CTX_PARKING;
+      TaskContext::switch_context(&ctx->regs, &host_regs);
+      // we're back, but maybe on another thread - don't touch 'this'
+    }
+
+    /*static*/ void PreemptableThread::context_main(TaskContext *ctx)
+    {
+      while(true) {
+	Task *task = ctx->task;
+	ctx->host->run_task(task, ctx->actual_proc);
+	if (__sync_add_and_fetch(&(task->finish_count),-1) == 0)
+	  delete task;
+	ctx->task = 0;
+	ctx->state = TaskContext::CTX_DONE;
+	// the next task (if any) picks up right here
+	TaskContext::switch_context(&ctx->regs, &(ctx->host->host_regs));
+      }
+    }
+
+    ///////////////////////////////////////////////////
+    // TaskContext
+
+    /*static*/ bool TaskContext::enabled = false;
+    /*static*/ size_t TaskContext::stack_size = 2 << 20;
+    /*static*/ gasnet_hsl_t TaskContext::pool_mutex = GASNET_HSL_INITIALIZER;
+    /*static*/ TaskContext *TaskContext::free_list = 0;
+
+#ifndef FAST_CONTEXT_SWITCH
+    static void ucontext_start(int ptr_hi, int ptr_lo)
+    {
+      uintptr_t ptr = (((uintptr_t)(unsigned)ptr_hi) << 32) | (unsigned)ptr_lo;
+      TaskContext::context_start((TaskContext *)ptr);
+    }
+#endif
+
+    TaskContext::TaskContext(EntryFn _entry)
+      : state(CTX_IDLE), task(0), host(0), wait_for(Event::NO_EVENT),
+	entry(_entry), next_free(0)
+    {
+      // stacks are mapped rather than malloc'd so that only the pages that
+      //  are actually touched get committed, with a guard page at the bottom
+      //  to catch overflows
+      size_t page_size = sysconf(_SC_PAGESIZE);
+      char *base = (char *)mmap(0, stack_size + page_size,
+				PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if(base == (char *)MAP_FAILED) {
+	fprintf(stderr, "failed to map a %zd byte task context stack: %s\n",
+		stack_size, strerror(errno));
+	assert(0);
+      }
+      mprotect(base, page_size, PROT_NONE);
+      stack_base = base + page_size;
+
+#ifdef FAST_CONTEXT_SWITCH
+      // build the frame lowlevel_switch_context expects to pop, returning
+      //  into the trampoline with a 16-byte aligned stack
+      void **sp = (void **)(((uintptr_t)(stack_base + stack_size) & ~(uintptr_t)15) - 16);
+      *--sp = (void *)&lowlevel_context_trampoline;
+      *--sp = 0;                       // rbp
+      *--sp = 0;                       // rbx
+      *--sp = (void *)this;            // r12
+      *--sp = (void *)&context_start;  // r13
+      *--sp = 0;                       // r14
+      *--sp = 0;                       // r15
+      *--sp = (void *)(0x1F80ULL | (0x037FULL << 32)); // default mxcsr/fpu cw
+      regs.sp = (void *)sp;
+#else
+      if(getcontext(&regs.uc) != 0) {
+	fprintf(stderr, "getcontext failed: %s\n", strerror(errno));
+	assert(0);
+      }
+      regs.uc.uc_stack.ss_sp = stack_base;
+      regs.uc.uc_stack.ss_size = stack_size;
+      regs.uc.uc_link = 0;
+      // makecontext only passes ints, so the pointer goes in two halves
+      uintptr_t ptr = (uintptr_t)this;
+      makecontext(&regs.uc, (void (*)(void))&ucontext_start, 2,
+		  (int)(ptr >> 32), (int)(ptr & 0xFFFFFFFFU));
+#endif
+    }
+
+    TaskContext::~TaskContext(void)
+    {
+      size_t page_size = sysconf(_SC_PAGESIZE);
+      munmap(stack_base - page_size, stack_size + page_size);
+    }
+
+    /*static*/ void TaskContext::context_start(TaskContext *ctx)
+    {
+      (*ctx->entry)(ctx);
+      // entry functions loop forever, there's nowhere to return to
+      assert(0);
+    }
+
+    /*static*/ TaskContext *TaskContext::acquire(EntryFn entry)
+    {
+      {
+	AutoHSLLock al(pool_mutex);
+	if(free_list) {
+	  TaskContext *ctx = free_list;
+	  free_list = ctx->next_free;
+	  ctx->next_free = 0;
+	  return ctx;
+	}
+      }
+      return new TaskContext(entry);
+    }
+
+    /*static*/ void TaskContext::release(TaskContext *ctx)
+    {
+      ctx->state = CTX_IDLE;
+      AutoHSLLock al(pool_mutex);
+      ctx->next_free = free_list;
+      free_list = ctx;
+    }
+
+    /*static*/ void TaskContext::switch_context(Registers *from, Registers *to)
+    {
+#ifdef FAST_CONTEXT_SWITCH
+      lowlevel_switch_context(&from->sp, to->sp);
+#else
+      if(swapcontext(&from->uc, &to->uc) != 0) {
+	fprintf(stderr, "swapcontext failed: %s\n", strerror(errno));
+	assert(0);
+      }
+#endif
+    }
+
+    /*virtual*/ bool TaskContext::event_triggered(void)
+    {
+      log_task.info("context %p notified for event " IDFMT "/%d",
+		    this, wait_for.id, wait_for.gen);
+      // any thread of the processor the context last ran on can resume it
+      host->context_resumable(this);
+      // contexts are pooled, don't have the caller delete us
+      return false;
+    }
+
+    /*virtual*/ void TaskContext::print_info(FILE *f)
+    {
+      fprintf(f,"task context %p waiting on " IDFMT "/%d\n",
+	      this, wait_for.id, wait_for.gen);
+    }
+
     class UtilityProcessor::UtilityThread : public PreemptableThread {
     public:
       UtilityThread(UtilityProcessor *_proc)
@@ -6136,6 +6861,11 @@ namespace LegionRuntime {
 
       void sleep_on_event(Event wait_for, bool block = false)
       {
+        // park a task running on a user-level context instead of spinning
+        if(cur_context && !block) {
+          park_context(wait_for);
+          return;
+        }
 #ifdef EVENT_GRAPH_TRACE
         unsigned long long start = TimeStamp::get_current_time_in_micros(); 
 #endif
@@ -6182,6 +6912,11 @@ namespace LegionRuntime {
         return proc->me;
       }
 
+      virtual void context_resumable(TaskContext *ctx)
+      {
+        proc->context_resumable(ctx);
+      }
+
     protected:
       void thread_main(void)
       {
@@ -6209,7 +6944,18 @@ namespace LegionRuntime {
 
 	while(!proc->shutdown_requested) {
 	  // try to run tasks from the runnable queue
-	  while(!proc->task_queue.empty()) {
+	  while(!proc->task_queue.empty() || !proc->resumable_contexts.empty()) {
+
+	    // parked contexts that can continue go first
+	    if(!proc->resumable_contexts.empty()) {
+	      TaskContext *ctx = proc->resumable_contexts.front();
+	      proc->resumable_contexts.pop_front();
+	      gasnet_hsl_unlock(&proc->mutex);
+	      log_util.info("resuming context %p in utility thread", ctx);
+	      resume_context(ctx);
+	      gasnet_hsl_lock(&proc->mutex);
+	      continue;
+	    }
 
 	    Task *task = proc->task_queue.pop();
 
@@ -6226,10 +6972,14 @@ namespace LegionRuntime {
             if (__sync_fetch_and_add(&(task->run_count),1) == 0) {
               gasnet_hsl_unlock(&proc->mutex);
               log_util.info("running task %p (%d) in utility thread", task, task->func_id);
-              run_task(task, proc->me);
-              log_util.info("done with task %p (%d) in utility thread", task, task->func_id);
-              if (__sync_add_and_fetch(&(task->finish_count),-1) == 0)
-                delete task;
+              if(TaskContext::enabled) {
+                run_in_context(task, proc->me);
+              } else {
+                run_task(task, proc->me);
+                log_util.info("done with task %p (%d) in utility thread", task, task->func_id);
+                if (__sync_add_and_fetch(&(task->finish_count),-1) == 0)
+                  delete task;
+              }
               gasnet_hsl_lock(&proc->mutex);
             } else if (__sync_add_and_fetch(&(task->finish_count),-1) == 0) {
               delete task;
@@ -6237,7 +6987,8 @@ namespace LegionRuntime {
 	  }
 
 	  // if we really have nothing to do, it's ok to go to sleep
-	  if(proc->task_queue.empty() && !proc->shutdown_requested) {
+	  if(proc->task_queue.empty() && proc->resumable_contexts.empty() &&
+	     !proc->shutdown_requested) {
 	    log_util.info("utility thread going to sleep (%p, %p)", this, proc);
 	    gasnett_cond_wait(&proc->condvar, &proc->mutex.lock);
 	    log_util.info("utility thread awake again");
@@ -6328,6 +7079,13 @@ namespace LegionRuntime {
       gasnett_cond_signal(&condvar);
     }
 
+    void UtilityProcessor::context_resumable(TaskContext *ctx)
+    {
+      AutoHSLLock al(mutex);
+      resumable_contexts.push_back(ctx);
+      gasnett_cond_signal(&condvar);
+    }
+
     void UtilityProcessor::wait_for_shutdown(void)
     {
       AutoHSLLock al(mutex);
@@ -7105,19 +7863,704 @@ namespace LegionRuntime {
     ///////////////////////////////////////////////////
     // Element Masks
 
+    // sets or clears bits [start, end) of a bit array, returns the change
+    //  in the number of set bits
+    static int set_bit_range(uint64_t *bits, int start, int end, bool value)
+    {
+      int delta = 0;
+      while(start < end) {
+	int w = start >> 6;
+	int lo = start & 0x3f;
+	int hi = ((end - (w << 6)) < 64) ? (end - (w << 6)) : 64;
+	uint64_t m = ((hi == 64) ? ~0ULL : ((1ULL << hi) - 1)) & ~((1ULL << lo) - 1);
+	uint64_t old = bits[w];
+	bits[w] = (value ? (old | m) : (old & ~m));
+	delta += __builtin_popcountll(bits[w]) - __builtin_popcountll(old);
+	start = (w + 1) << 6;
+      }
+      return delta;
+    }
+
+    static void runs_to_bits(const std::vector<ElementMaskChunks::Run>& runs,
+			     uint64_t *bits)
+    {
+      memset(bits, 0, ElementMaskChunks::CHUNK_WORDS * sizeof(uint64_t));
+      for(std::vector<ElementMaskChunks::Run>::const_iterator it = runs.begin();
+	  it != runs.end();
+	  it++)
+	set_bit_range(bits, it->first, it->last + 1, true);
+    }
+
+    // returns false (leaving 'runs' in an unspecified state) if the bits
+    //  need more than 'limit' runs
+    static bool bits_to_runs(const uint64_t *bits, int nwords,
+			     std::vector<ElementMaskChunks::Run>& runs, size_t limit)
+    {
+      runs.clear();
+      int pos = 0;
+      const int nbits = nwords << 6;
+      while(pos < nbits) {
+	// find the next set bit
+	int w = pos >> 6;
+	uint64_t v = bits[w] & ~((1ULL << (pos & 0x3f)) - 1);
+	while(!v) {
+	  if(++w >= nwords) return true;
+	  v = bits[w];
+	}
+	int first = (w << 6) + __builtin_ctzll(v);
+	// and the next clear one after it
+	v = ~bits[w] & ~((1ULL << (first & 0x3f)) - 1);
+	while(!v) {
+	  if(++w >= nwords) break;
+	  v = ~bits[w];
+	}
+	int end = ((w >= nwords) ? nbits : ((w << 6) + __builtin_ctzll(v)));
+	if(runs.size() >= limit) return false;
+	ElementMaskChunks::Run r;
+	r.first = first;
+	r.last = end - 1;
+	runs.push_back(r);
+	pos = end;
+      }
+      return true;
+    }
+
+    static int count_runs(const std::vector<ElementMaskChunks::Run>& runs)
+    {
+      int count = 0;
+      for(std::vector<ElementMaskChunks::Run>::const_iterator it = runs.begin();
+	  it != runs.end();
+	  it++)
+	count += (it->last - it->first + 1);
+      return count;
+    }
+
+    static bool run_ends_before(const ElementMaskChunks::Run& r, int pos)
+    {
+      return r.last < pos;
+    }
+
+    // dst = dst <op> src over whole chunks, returns the resulting bit count
+    static int bits_op(ElementMaskChunks::SetOp op, uint64_t *dst, const uint64_t *src,
+		       int nwords)
+    {
+      int i = 0;
+#ifdef __AVX2__
+      switch(op) {
+      case ElementMaskChunks::OP_OR:
+	for(; (i + 4) <= nwords; i += 4)
+	  _mm256_storeu_si256((__m256i *)(dst + i),
+			      _mm256_or_si256(_mm256_loadu_si256((const __m256i *)(dst + i)),
+					      _mm256_loadu_si256((const __m256i *)(src + i))));
+	break;
+      case ElementMaskChunks::OP_AND:
+	for(; (i + 4) <= nwords; i += 4)
+	  _mm256_storeu_si256((__m256i *)(dst + i),
+			      _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(dst + i)),
+					       _mm256_loadu_si256((const __m256i *)(src + i))));
+	break;
+      case ElementMaskChunks::OP_SUB:
+	// andnot computes ~first & second
+	for(; (i + 4) <= nwords; i += 4)
+	  _mm256_storeu_si256((__m256i *)(dst + i),
+			      _mm256_andnot_si256(_mm256_loadu_si256((const __m256i *)(src + i)),
+						  _mm256_loadu_si256((const __m256i *)(dst + i))));
+	break;
+      }
+#endif
+      switch(op) {
+      case ElementMaskChunks::OP_OR:
+	for(; i < nwords; i++) dst[i] |= src[i];
+	break;
+      case ElementMaskChunks::OP_AND:
+	for(; i < nwords; i++) dst[i] &= src[i];
+	break;
+      case ElementMaskChunks::OP_SUB:
+	for(; i < nwords; i++) dst[i] &= ~src[i];
+	break;
+      }
+      int count = 0;
+      for(i = 0; i < nwords; i++)
+	count += __builtin_popcountll(dst[i]);
+      return count;
+    }
+
+    static bool bits_intersect(const uint64_t *a, const uint64_t *b, int nwords)
+    {
+      int i = 0;
+#ifdef __AVX2__
+      for(; (i + 4) <= nwords; i += 4) {
+	__m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+	__m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+	if(!_mm256_testz_si256(va, vb)) return true;
+      }
+#endif
+      for(; i < nwords; i++)
+	if(a[i] & b[i]) return true;
+      return false;
+    }
+
+    // the set operations on two run lists
+    static void runs_op(ElementMaskChunks::SetOp op,
+			const std::vector<ElementMaskChunks::Run>& a,
+			const std::vector<ElementMaskChunks::Run>& b,
+			std::vector<ElementMaskChunks::Run>& out)
+    {
+      out.clear();
+      size_t i = 0, j = 0;
+      switch(op) {
+      case ElementMaskChunks::OP_OR:
+	{
+	  while((i < a.size()) || (j < b.size())) {
+	    ElementMaskChunks::Run next;
+	    if((j >= b.size()) || ((i < a.size()) && (a[i].first <= b[j].first)))
+	      next = a[i++];
+	    else
+	      next = b[j++];
+	    // merge with the previous run if they overlap or touch
+	    if(!out.empty() && ((int)next.first <= ((int)out.back().last + 1))) {
+	      if(next.last > out.back().last)
+		out.back().last = next.last;
+	    } else
+	      out.push_back(next);
+	  }
+	  break;
+	}
+      case ElementMaskChunks::OP_AND:
+	{
+	  while((i < a.size()) && (j < b.size())) {
+	    unsigned short lo = std::max(a[i].first, b[j].first);
+	    unsigned short hi = std::min(a[i].last, b[j].last);
+	    if(lo <= hi) {
+	      ElementMaskChunks::Run r;
+	      r.first = lo;
+	      r.last = hi;
+	      out.push_back(r);
+	    }
+	    if(a[i].last < b[j].last) i++; else j++;
+	  }
+	  break;
+	}
+      case ElementMaskChunks::OP_SUB:
+	{
+	  for(i = 0; i < a.size(); i++) {
+	    int lo = a[i].first;
+	    const int hi = a[i].last;
+	    // skip subtrahend runs that end before this one starts
+	    while((j < b.size()) && ((int)b[j].last < lo)) j++;
+	    size_t k = j;
+	    while((k < b.size()) && ((int)b[k].first <= hi)) {
+	      if((int)b[k].first > lo) {
+		ElementMaskChunks::Run r;
+		r.first = lo;
+		r.last = b[k].first - 1;
+		out.push_back(r);
+	      }
+	      lo = b[k].last + 1;
+	      if(lo > hi) break;
+	      k++;
+	    }
+	    if(lo <= hi) {
+	      ElementMaskChunks::Run r;
+	      r.first = lo;
+	      r.last = hi;
+	      out.push_back(r);
+	    }
+	  }
+	  break;
+	}
+      }
+    }
+
+    ElementMaskChunks::Chunk::Chunk(Kind _kind)
+      : kind(_kind), count(0), bits(0)
+    {
+      if(kind == CHUNK_BITS)
+	bits = (uint64_t *)calloc(CHUNK_WORDS, sizeof(uint64_t));
+    }
+
+    ElementMaskChunks::Chunk::Chunk(const Chunk& copy_from)
+      : kind(copy_from.kind), count(copy_from.count), runs(copy_from.runs), bits(0)
+    {
+      if(copy_from.bits) {
+	bits = (uint64_t *)malloc(CHUNK_WORDS * sizeof(uint64_t));
+	memcpy(bits, copy_from.bits, CHUNK_WORDS * sizeof(uint64_t));
+      }
+    }
+
+    ElementMaskChunks::Chunk::~Chunk(void)
+    {
+      if(bits)
+	free(bits);
+    }
+
+    ElementMaskChunks::ElementMaskChunks(int _num_elements)
+      : num_elements(_num_elements)
+    {
+      chunks.resize((num_elements + CHUNK_SIZE - 1) >> CHUNK_SHIFT, 0);
+    }
+
+    ElementMaskChunks::ElementMaskChunks(const ElementMaskChunks& copy_from)
+      : num_elements(copy_from.num_elements)
+    {
+      chunks.resize(copy_from.chunks.size(), 0);
+      for(size_t i = 0; i < chunks.size(); i++)
+	if(copy_from.chunks[i])
+	  chunks[i] = new Chunk(*copy_from.chunks[i]);
+    }
+
+    ElementMaskChunks::~ElementMaskChunks(void)
+    {
+      for(size_t i = 0; i < chunks.size(); i++)
+	if(chunks[i])
+	  delete chunks[i];
+    }
+
+    int ElementMaskChunks::chunk_length(int idx) const
+    {
+      int len = num_elements - (idx << CHUNK_SHIFT);
+      return ((len < CHUNK_SIZE) ? len : CHUNK_SIZE);
+    }
+
+    // returns the chunk as a bitmap, building it in 'scratch' if needed
+    const uint64_t *ElementMaskChunks::chunk_bits(int idx, uint64_t *scratch) const
+    {
+      const Chunk *c = chunks[idx];
+      if(!c) {
+	memset(scratch, 0, CHUNK_WORDS * sizeof(uint64_t));
+	return scratch;
+      }
+      switch(c->kind) {
+      case Chunk::CHUNK_BITS:
+	return c->bits;
+      case Chunk::CHUNK_RUNS:
+	runs_to_bits(c->runs, scratch);
+	return scratch;
+      case Chunk::CHUNK_FULL:
+	memset(scratch, 0, CHUNK_WORDS * sizeof(uint64_t));
+	set_bit_range(scratch, 0, chunk_length(idx), true);
+	return scratch;
+      }
+      return scratch;
+    }
+
+    void ElementMaskChunks::make_bits(int idx)
+    {
+      Chunk *c = chunks[idx];
+      if(c->kind == Chunk::CHUNK_BITS) return;
+      c->bits = (uint64_t *)malloc(CHUNK_WORDS * sizeof(uint64_t));
+      chunk_bits(idx, c->bits);
+      c->runs.clear();
+      c->kind = Chunk::CHUNK_BITS;
+    }
+
+    void ElementMaskChunks::normalize(int idx, bool try_runs)
+    {
+      Chunk *c = chunks[idx];
+      if(!c) return;
+      if(c->count == 0) {
+	delete c;
+	chunks[idx] = 0;
+	return;
+      }
+      if(c->count == chunk_length(idx)) {
+	if(c->bits) {
+	  free(c->bits);
+	  c->bits = 0;
+	}
+	c->runs.clear();
+	c->kind = Chunk::CHUNK_FULL;
+	return;
+      }
+      if((c->kind == Chunk::CHUNK_RUNS) && (c->runs.size() > MAX_RUNS)) {
+	make_bits(idx);
+	return;
+      }
+      // going from bits back to runs needs a scan of the whole chunk, so
+      //  it's only tried after whole-chunk operations
+      if(try_runs && (c->kind == Chunk::CHUNK_BITS)) {
+	if(bits_to_runs(c->bits, CHUNK_WORDS, c->runs, MAX_RUNS)) {
+	  free(c->bits);
+	  c->bits = 0;
+	  c->kind = Chunk::CHUNK_RUNS;
+	} else
+	  c->runs.clear();
+      }
+    }
+
+    void ElementMaskChunks::set_range(int start, int count, bool value)
+    {
+      const int end = start + count;
+      for(int idx = (start >> CHUNK_SHIFT); (idx << CHUNK_SHIFT) < end; idx++) {
+	const int base = idx << CHUNK_SHIFT;
+	const int len = chunk_length(idx);
+	const int lo = ((start > base) ? start : base) - base;
+	const int hi = ((end < (base + len)) ? end : (base + len)) - base;
+	Chunk *c = chunks[idx];
+
+	// whole chunk
+	if((lo == 0) && (hi == len)) {
+	  if(c) delete c;
+	  chunks[idx] = 0;
+	  if(value) {
+	    c = new Chunk(Chunk::CHUNK_FULL);
+	    c->count = len;
+	    chunks[idx] = c;
+	  }
+	  continue;
+	}
+
+	if(!c) {
+	  if(!value) continue;
+	  c = new Chunk(Chunk::CHUNK_RUNS);
+	  Run r;
+	  r.first = lo;
+	  r.last = hi - 1;
+	  c->runs.push_back(r);
+	  c->count = hi - lo;
+	  chunks[idx] = c;
+	  continue;
+	}
+
+	if(c->kind == Chunk::CHUNK_FULL) {
+	  if(value) continue;
+	  c->kind = Chunk::CHUNK_RUNS;
+	  Run r;
+	  r.first = 0;
+	  r.last = len - 1;
+	  c->runs.push_back(r);
+	}
+
+	if(c->kind == Chunk::CHUNK_BITS) {
+	  c->count += set_bit_range(c->bits, lo, hi, value);
+	} else {
+	  // splice [lo, hi) into or out of the sorted run list
+	  std::vector<Run>& runs = c->runs;
+	  std::vector<Run>::iterator first =
+	    std::lower_bound(runs.begin(), runs.end(), (value ? (lo - 1) : lo), run_ends_before);
+	  std::vector<Run>::iterator last = first;
+	  while((last != runs.end()) && ((int)last->first <= (value ? hi : (hi - 1))))
+	    last++;
+	  Run pieces[2];
+	  int num_pieces = 0;
+	  if(value) {
+	    pieces[0].first = lo;
+	    pieces[0].last = hi - 1;
+	    if((first != last) && (first->first < pieces[0].first))
+	      pieces[0].first = first->first;
+	    if((first != last) && ((last - 1)->last > pieces[0].last))
+	      pieces[0].last = (last - 1)->last;
+	    num_pieces = 1;
+	  } else if(first != last) {
+	    if((int)first->first < lo) {
+	      pieces[num_pieces].first = first->first;
+	      pieces[num_pieces].last = lo - 1;
+	      num_pieces++;
+	    }
+	    if((int)(last - 1)->last >= hi) {
+	      pieces[num_pieces].first = hi;
+	      pieces[num_pieces].last = (last - 1)->last;
+	      num_pieces++;
+	    }
+	  }
+	  for(std::vector<Run>::iterator it = first; it != last; it++)
+	    c->count -= (it->last - it->first + 1);
+	  for(int i = 0; i < num_pieces; i++)
+	    c->count += (pieces[i].last - pieces[i].first + 1);
+	  std::vector<Run>::iterator pos = runs.erase(first, last);
+	  runs.insert(pos, pieces, pieces + num_pieces);
+	}
+	normalize(idx, false);
+      }
+    }
+
+    bool ElementMaskChunks::is_set(int pos) const
+    {
+      const Chunk *c = chunks[pos >> CHUNK_SHIFT];
+      if(!c) return false;
+      const int ofs = pos & (CHUNK_SIZE - 1);
+      switch(c->kind) {
+      case Chunk::CHUNK_FULL:
+	return true;
+      case Chunk::CHUNK_BITS:
+	return ((c->bits[ofs >> 6] >> (ofs & 0x3f)) & 1) != 0;
+      case Chunk::CHUNK_RUNS:
+	{
+	  std::vector<Run>::const_iterator it =
+	    std::lower_bound(c->runs.begin(), c->runs.end(), ofs, run_ends_before);
+	  return ((it != c->runs.end()) && ((int)it->first <= ofs));
+	}
+      }
+      return false;
+    }
+
+    size_t ElementMaskChunks::pop_count(void) const
+    {
+      size_t count = 0;
+      for(size_t i = 0; i < chunks.size(); i++)
+	if(chunks[i])
+	  count += chunks[i]->count;
+      return count;
+    }
+
+    bool ElementMaskChunks::empty(void) const
+    {
+      for(size_t i = 0; i < chunks.size(); i++)
+	if(chunks[i])
+	  return false;
+      return true;
+    }
+
+    bool ElementMaskChunks::equals(const ElementMaskChunks& other) const
+    {
+      if(num_elements != other.num_elements) return false;
+      uint64_t scratch1[CHUNK_WORDS], scratch2[CHUNK_WORDS];
+      for(size_t i = 0; i < chunks.size(); i++) {
+	const Chunk *a = chunks[i];
+	const Chunk *b = other.chunks[i];
+	if(!a || !b) {
+	  if(a != b) return false;
+	  continue;
+	}
+	if(a->count != b->count) return false;
+	if(a->kind == Chunk::CHUNK_FULL) continue; // same count means b is full too
+	if((a->kind == Chunk::CHUNK_RUNS) && (b->kind == Chunk::CHUNK_RUNS)) {
+	  if(a->runs.size() != b->runs.size()) return false;
+	  for(size_t j = 0; j < a->runs.size(); j++)
+	    if((a->runs[j].first != b->runs[j].first) ||
+	       (a->runs[j].last != b->runs[j].last))
+	      return false;
+	  continue;
+	}
+	if(memcmp(chunk_bits(i, scratch1), other.chunk_bits(i, scratch2),
+		  CHUNK_WORDS * sizeof(uint64_t)))
+	  return false;
+      }
+      return true;
+    }
+
+    bool ElementMaskChunks::overlaps(const ElementMaskChunks& other) const
+    {
+      assert(num_elements == other.num_elements);
+      uint64_t scratch1[CHUNK_WORDS], scratch2[CHUNK_WORDS];
+      for(size_t i = 0; i < chunks.size(); i++) {
+	const Chunk *a = chunks[i];
+	const Chunk *b = other.chunks[i];
+	if(!a || !b) continue;
+	if((a->kind == Chunk::CHUNK_FULL) || (b->kind == Chunk::CHUNK_FULL))
+	  return true;
+	if((a->kind == Chunk::CHUNK_RUNS) && (b->kind == Chunk::CHUNK_RUNS)) {
+	  size_t j = 0, k = 0;
+	  while((j < a->runs.size()) && (k < b->runs.size())) {
+	    if((a->runs[j].first <= b->runs[k].last) &&
+	       (b->runs[k].first <= a->runs[j].last))
+	      return true;
+	    if(a->runs[j].last < b->runs[k].last) j++; else k++;
+	  }
+	  continue;
+	}
+	if(bits_intersect(chunk_bits(i, scratch1), other.chunk_bits(i, scratch2),
+			  CHUNK_WORDS))
+	  return true;
+      }
+      return false;
+    }
+
+    void ElementMaskChunks::apply(SetOp op, const ElementMaskChunks& other)
+    {
+      assert(num_elements == other.num_elements);
+      uint64_t scratch[CHUNK_WORDS];
+      std::vector<Run> result;
+      for(size_t i = 0; i < chunks.size(); i++) {
+	Chunk *a = chunks[i];
+	const Chunk *b = other.chunks[i];
+
+	// the cases where one side is empty or full don't look at the contents
+	switch(op) {
+	case OP_OR:
+	  if(!b || (a && (a->kind == Chunk::CHUNK_FULL))) continue;
+	  if(!a || (b->kind == Chunk::CHUNK_FULL)) {
+	    if(a) delete a;
+	    chunks[i] = new Chunk(*b);
+	    continue;
+	  }
+	  break;
+	case OP_AND:
+	  if(!a || (b && (b->kind == Chunk::CHUNK_FULL))) continue;
+	  if(!b || (a->kind == Chunk::CHUNK_FULL)) {
+	    delete a;
+	    chunks[i] = (b ? new Chunk(*b) : 0);
+	    continue;
+	  }
+	  break;
+	case OP_SUB:
+	  if(!a || !b) continue;
+	  if(b->kind == Chunk::CHUNK_FULL) {
+	    delete a;
+	    chunks[i] = 0;
+	    continue;
+	  }
+	  if(a->kind == Chunk::CHUNK_FULL) {
+	    a->kind = Chunk::CHUNK_RUNS;
+	    Run r;
+	    r.first = 0;
+	    r.last = chunk_length(i) - 1;
+	    a->runs.push_back(r);
+	  }
+	  break;
+	}
+
+	if((a->kind == Chunk::CHUNK_RUNS) && (b->kind == Chunk::CHUNK_RUNS)) {
+	  runs_op(op, a->runs, b->runs, result);
+	  a->runs.swap(result);
+	  a->count = count_runs(a->runs);
+	} else {
+	  make_bits(i);
+	  a->count = bits_op(op, a->bits, other.chunk_bits(i, scratch), CHUNK_WORDS);
+	}
+	normalize(i, true);
+      }
+    }
+
+    int ElementMaskChunks::find_first(int pos, bool value) const
+    {
+      if(pos < 0) pos = 0;
+      for(int idx = (pos >> CHUNK_SHIFT); idx < (int)chunks.size(); idx++) {
+	const int base = idx << CHUNK_SHIFT;
+	const int len = chunk_length(idx);
+	const int ofs = ((pos > base) ? (pos - base) : 0);
+	const Chunk *c = chunks[idx];
+	if(!c) {
+	  if(!value) return base + ofs;
+	  continue;
+	}
+	switch(c->kind) {
+	case Chunk::CHUNK_FULL:
+	  if(value) return base + ofs;
+	  break;
+	case Chunk::CHUNK_RUNS:
+	  {
+	    std::vector<Run>::const_iterator it =
+	      std::lower_bound(c->runs.begin(), c->runs.end(), ofs, run_ends_before);
+	    if(value) {
+	      if(it != c->runs.end())
+		return base + (((int)it->first > ofs) ? (int)it->first : ofs);
+	    } else {
+	      // either we're in a gap or the gap starts right after this run
+	      if((it == c->runs.end()) || ((int)it->first > ofs))
+		return base + ofs;
+	      if(((int)it->last + 1) < len)
+		return base + it->last + 1;
+	    }
+	    break;
+	  }
+	case Chunk::CHUNK_BITS:
+	  {
+	    const int nwords = (len + 63) >> 6;
+	    int w = ofs >> 6;
+	    uint64_t v = (value ? c->bits[w] : ~c->bits[w]) & ~((1ULL << (ofs & 0x3f)) - 1);
+	    while(!v && (++w < nwords))
+	      v = (value ? c->bits[w] : ~c->bits[w]);
+	    if(v) {
+	      int found = (w << 6) + __builtin_ctzll(v);
+	      // the unused tail of the last word reads as clear
+	      if(found < len)
+		return base + found;
+	    }
+	    break;
+	  }
+	}
+      }
+      return num_elements;
+    }
+
+    int ElementMaskChunks::find_last_enabled(void) const
+    {
+      for(int idx = (int)chunks.size() - 1; idx >= 0; idx--) {
+	const Chunk *c = chunks[idx];
+	if(!c) continue;
+	const int base = idx << CHUNK_SHIFT;
+	switch(c->kind) {
+	case Chunk::CHUNK_FULL:
+	  return base + chunk_length(idx) - 1;
+	case Chunk::CHUNK_RUNS:
+	  return base + c->runs.back().last;
+	case Chunk::CHUNK_BITS:
+	  for(int w = CHUNK_WORDS - 1; w >= 0; w--)
+	    if(c->bits[w])
+	      return base + (w << 6) + 63 - __builtin_clzll(c->bits[w]);
+	  break;
+	}
+      }
+      return -1;
+    }
+
+    bool ElementMaskChunks::next_run(int pos, bool polarity, int& position, int& length) const
+    {
+      int start = find_first(pos, polarity);
+      if(start >= num_elements) return false;
+      int end = find_first(start, !polarity);
+      position = start;
+      length = end - start;
+      return true;
+    }
+
+    void ElementMaskChunks::to_dense(uint64_t *bits) const
+    {
+      for(size_t i = 0; i < chunks.size(); i++) {
+	const Chunk *c = chunks[i];
+	if(!c) continue;
+	const int base = i << CHUNK_SHIFT;
+	switch(c->kind) {
+	case Chunk::CHUNK_FULL:
+	  set_bit_range(bits, base, base + chunk_length(i), true);
+	  break;
+	case Chunk::CHUNK_RUNS:
+	  for(std::vector<Run>::const_iterator it = c->runs.begin();
+	      it != c->runs.end();
+	      it++)
+	    set_bit_range(bits, base + it->first, base + it->last + 1, true);
+	  break;
+	case Chunk::CHUNK_BITS:
+	  memcpy(bits + (base >> 6), c->bits,
+		 ((chunk_length(i) + 63) >> 6) * sizeof(uint64_t));
+	  break;
+	}
+      }
+    }
+
+    void ElementMaskChunks::from_dense(const uint64_t *bits)
+    {
+      for(size_t i = 0; i < chunks.size(); i++) {
+	if(chunks[i]) {
+	  delete chunks[i];
+	  chunks[i] = 0;
+	}
+	const int nwords = (chunk_length(i) + 63) >> 6;
+	const uint64_t *src = bits + (i << (CHUNK_SHIFT - 6));
+	int count = 0;
+	for(int w = 0; w < nwords; w++)
+	  count += __builtin_popcountll(src[w]);
+	if(!count) continue;
+	Chunk *c = new Chunk(Chunk::CHUNK_BITS);
+	memcpy(c->bits, src, nwords * sizeof(uint64_t));
+	c->count = count;
+	chunks[i] = c;
+	normalize(i, true);
+      }
+    }
+
     ElementMask::ElementMask(void)
       : first_element(-1), num_elements(-1), memory(Memory::NO_MEMORY), offset(-1),
-	raw_data(0), first_enabled_elmt(-1), last_enabled_elmt(-1)
+	raw_data(0), chunks(0), first_enabled_elmt(-1), last_enabled_elmt(-1)
     {
     }
 
     ElementMask::ElementMask(int _num_elements, int _first_element /*= 0*/)
-      : first_element(_first_element), num_elements(_num_elements), memory(Memory::NO_MEMORY), offset(-1), first_enabled_elmt(-1), last_enabled_elmt(-1)
+      : first_element(_first_element), num_elements(_num_elements), memory(Memory::NO_MEMORY), offset(-1), raw_data(0), first_enabled_elmt(-1), last_enabled_elmt(-1)
     {
-      size_t bytes_needed = ElementMaskImpl::bytes_needed(first_element, num_elements);
-      raw_data = calloc(1, bytes_needed);
-      //((ElementMaskImpl *)raw_data)->count = num_elements;
-      //((ElementMaskImpl *)raw_data)->offset = first_element;
+      // no bit array until somebody needs one
+      chunks = new ElementMaskChunks(num_elements);
     }
 
     ElementMask::ElementMask(const ElementMask &copy_from, 
@@ -7127,6 +8570,14 @@ namespace LegionRuntime {
       num_elements = copy_from.num_elements;
       first_enabled_elmt = copy_from.first_enabled_elmt;
       last_enabled_elmt = copy_from.last_enabled_elmt;
+      chunks = 0;
+      raw_data = 0;
+
+      if(!copy_from.raw_data && copy_from.chunks) {
+	chunks = new ElementMaskChunks(*copy_from.chunks);
+	return;
+      }
+
       size_t bytes_needed = ElementMaskImpl::bytes_needed(first_element, num_elements);
       raw_data = calloc(1, bytes_needed);
 
@@ -7143,6 +8594,10 @@ namespace LegionRuntime {
         free(raw_data);
         raw_data = 0;
       }
+      if (chunks) {
+        delete chunks;
+        chunks = 0;
+      }
     }
 
     ElementMask& ElementMask::operator=(const ElementMask &rhs)
@@ -7151,9 +8606,19 @@ namespace LegionRuntime {
       num_elements = rhs.num_elements;
       first_enabled_elmt = rhs.first_enabled_elmt;
       last_enabled_elmt = rhs.last_enabled_elmt;
-      size_t bytes_needed = rhs.raw_size();
+      if (this == &rhs)
+        return *this;
       if (raw_data)
         free(raw_data);
+      raw_data = 0;
+      if (chunks)
+        delete chunks;
+      chunks = 0;
+      if (!rhs.raw_data && rhs.chunks) {
+        chunks = new ElementMaskChunks(*rhs.chunks);
+        return *this;
+      }
+      size_t bytes_needed = rhs.raw_size();
       raw_data = calloc(1, bytes_needed);
       if (rhs.raw_data)
         memcpy(raw_data, rhs.raw_data, bytes_needed);
@@ -7172,6 +8637,18 @@ namespace LegionRuntime {
       raw_data = memory.impl()->get_direct_ptr(offset, bytes_needed);
     }
 
+    void ElementMask::make_dense(void) const
+    {
+      if(raw_data || !chunks) return;
+      size_t bytes_needed = ElementMaskImpl::bytes_needed(first_element, num_elements);
+      void *bits = calloc(1, bytes_needed);
+      chunks->to_dense(((ElementMaskImpl *)bits)->bits);
+      // somebody else may have beaten us to it - the chunks stay around
+      //  (until the destructor) in case another thread is still reading them
+      if(!__sync_bool_compare_and_swap(&raw_data, (void *)0, bits))
+	free(bits);
+    }
+
     void ElementMask::enable(int start, int count /*= 1*/)
     {
       if(raw_data != 0) {
@@ -7185,6 +8662,8 @@ namespace LegionRuntime {
 	  pos++;
 	}
 	//printf("ENABLED %p %d %d %d " IDFMT "\n", raw_data, offset, start, count, impl->bits[0]);
+      } else if(chunks != 0) {
+	chunks->set_range(start - first_element, count, true);
       } else {
 	//printf("ENABLE(2) " IDFMT " %d %d %d\n", memory.id, offset, start, count);
 	Memory::Impl *m_impl = memory.impl();
@@ -7218,6 +8697,8 @@ namespace LegionRuntime {
 	  *ptr &= ~(1ULL << (pos & 0x3f));
 	  pos++;
 	}
+      } else if(chunks != 0) {
+	chunks->set_range(start - first_element, count, false);
       } else {
 	//printf("DISABLE(2) " IDFMT " %d %d %d\n", memory.id, offset, start, count);
 	Memory::Impl *m_impl = memory.impl();
@@ -7257,6 +8738,13 @@ namespace LegionRuntime {
 	    if(run >= count) return pos - run;
 	  }
 	}
+      } else if(chunks != 0) {
+	int position, length;
+	int pos = ((start > 0) ? start : 0);
+	while(chunks->next_run(pos, true, position, length)) {
+	  if(length >= count) return position;
+	  pos = position + length;
+	}
       } else {
 	Memory::Impl *m_impl = memory.impl();
 	//printf("FIND_ENABLED(2) " IDFMT " %d %d %d\n", memory.id, offset, first_element, count);
@@ -7291,6 +8779,13 @@ namespace LegionRuntime {
 	    if(run >= count) return pos - run;
 	  }
 	}
+      } else if(chunks != 0) {
+	int position, length;
+	int pos = ((start > 0) ? start : 0);
+	while(chunks->next_run(pos, false, position, length)) {
+	  if(length >= count) return position;
+	  pos = position + length;
+	}
       } else {
 	assert(0);
       }
@@ -7304,6 +8799,8 @@ namespace LegionRuntime {
 
     const void *ElementMask::get_raw(void) const
     {
+      // the dense layout is what gets sent over the wire and to the GPU
+      make_dense();
       return raw_data;
     }
 
@@ -7321,6 +8818,8 @@ namespace LegionRuntime {
 	uint64_t val = (impl->bits[pos >> 6]);
         uint64_t bit = ((val) >> (pos & 0x3f));
         return ((bit & 1) != 0);
+      } else if(chunks != 0) {
+        return chunks->is_set(ptr);
       } else {
         assert(0);
 	Memory::Impl *m_impl = memory.impl();
@@ -7347,6 +8846,10 @@ namespace LegionRuntime {
           count += __builtin_popcountll(impl->bits[max_full]);
         if (!enabled)
           count = num_elements - count;
+      } else if (chunks != 0) {
+        count = chunks->pop_count();
+        if (!enabled)
+          count = num_elements - count;
       } else {
         // TODO: implement this
         assert(0);
@@ -7363,6 +8866,8 @@ namespace LegionRuntime {
           if (impl->bits[index])
             return false;
         }
+      } else if (chunks != 0) {
+        return chunks->empty();
       } else {
         // TODO: implement this
         assert(0);
@@ -7374,8 +8879,19 @@ namespace LegionRuntime {
     {
       if (num_elements != other.num_elements)
         return false;
+      if (!raw_data && chunks) {
+        if (!other.raw_data && other.chunks)
+          return chunks->equals(*other.chunks);
+        // compare against a compressed copy rather than densifying ourselves
+        assert(other.raw_data != 0);
+        ElementMaskChunks tmp(num_elements);
+        tmp.from_dense(((const ElementMaskImpl *)other.raw_data)->bits);
+        return chunks->equals(tmp);
+      }
       if (raw_data != 0) {
         ElementMaskImpl *impl = (ElementMaskImpl *)raw_data;
+        if (!other.raw_data && other.chunks)
+          return (other == *this);
         if (other.raw_data != 0) {
           ElementMaskImpl *other_impl = (ElementMaskImpl *)other.raw_data;
           const int max_full = ((num_elements+63) >> 6);
@@ -7402,87 +8918,57 @@ namespace LegionRuntime {
 
     ElementMask ElementMask::operator|(const ElementMask &other) const
     {
-      ElementMask result(num_elements);
-      ElementMaskImpl *target = (ElementMaskImpl *)result.raw_data;
-      if (raw_data != 0) {
-        ElementMaskImpl *impl = (ElementMaskImpl *)raw_data;
-        if (other.raw_data != 0) {
-          ElementMaskImpl *other_impl = (ElementMaskImpl *)other.raw_data;
-          assert(num_elements == other.num_elements);
-          const int max_full = ((num_elements+63) >> 6);
-          for (int index = 0; index < max_full; index++) {
-            target->bits[index] = impl->bits[index] | other_impl->bits[index]; 
-          }
-        } else {
-          // TODO implement this
-          assert(0);
-        }
-      } else {
-        // TODO: implement this
-        assert(0);
-      }
+      ElementMask result(*this);
+      result |= other;
       return result;
     }
 
     ElementMask ElementMask::operator&(const ElementMask &other) const
     {
-      ElementMask result(num_elements);
-      ElementMaskImpl *target = (ElementMaskImpl *)result.raw_data;
-      if (raw_data != 0) {
-        ElementMaskImpl *impl = (ElementMaskImpl *)raw_data;
-        if (other.raw_data != 0) {
-          ElementMaskImpl *other_impl = (ElementMaskImpl *)other.raw_data;
-          assert(num_elements == other.num_elements);
-          const int max_full = ((num_elements+63) >> 6);
-          for (int index = 0; index < max_full; index++) {
-            target->bits[index] = impl->bits[index] & other_impl->bits[index];
-          }
-        } else {
-          // TODO: implement this
-          assert(0);
-        }
-      } else {
-        // TODO: implement this
-        assert(0);
-      }
+      ElementMask result(*this);
+      result &= other;
       return result;
     }
 
     ElementMask ElementMask::operator-(const ElementMask &other) const
     {
-      ElementMask result(num_elements);
-      ElementMaskImpl *target = (ElementMaskImpl *)result.raw_data;
-      if (raw_data != 0) {
-        ElementMaskImpl *impl = (ElementMaskImpl *)raw_data;
-        if (other.raw_data != 0) {
-          ElementMaskImpl *other_impl = (ElementMaskImpl *)other.raw_data;
-          assert(num_elements == other.num_elements);
-          const int max_full = ((num_elements+63) >> 6);
-          for (int index = 0; index < max_full; index++) {
-            target->bits[index] = impl->bits[index] & ~(other_impl->bits[index]);
-          }
-        } else {
-          // TODO: implement this
-          assert(0);
-        }
-      } else {
-        // TODO: implement this
-        assert(0);
-      }
+      ElementMask result(*this);
+      result -= other;
       return result;
     }
 
-    ElementMask& ElementMask::operator|=(const ElementMask &other)
+    void ElementMask::apply_op(int op, const ElementMask &other)
     {
-      if (raw_data != 0) {
+      assert(num_elements == other.num_elements);
+      ElementMaskChunks::SetOp set_op = (ElementMaskChunks::SetOp)op;
+      if (!raw_data && chunks) {
+        if (!other.raw_data && other.chunks) {
+          chunks->apply(set_op, *other.chunks);
+        } else {
+          assert(other.raw_data != 0);
+          ElementMaskChunks tmp(num_elements);
+          tmp.from_dense(((const ElementMaskImpl *)other.raw_data)->bits);
+          chunks->apply(set_op, tmp);
+        }
+        // the result is exact, unlike what enable/disable can track
+        int first = chunks->find_first(0, true);
+        if (first < num_elements) {
+          first_enabled_elmt = first_element + first;
+          last_enabled_elmt = first_element + chunks->find_last_enabled();
+        } else {
+          first_enabled_elmt = -1;
+          last_enabled_elmt = -1;
+        }
+      } else if (raw_data != 0) {
         ElementMaskImpl *impl = (ElementMaskImpl *)raw_data;
+        const int max_full = ((num_elements+63) >> 6);
         if (other.raw_data != 0) {
           ElementMaskImpl *other_impl = (ElementMaskImpl *)other.raw_data;
-          assert(num_elements == other.num_elements);
-          const int max_full = ((num_elements+63) >> 6);
-          for (int index = 0; index < max_full; index++) {
-            impl->bits[index] |= other_impl->bits[index];
-          }
+          bits_op(set_op, impl->bits, other_impl->bits, max_full);
+        } else if (other.chunks != 0) {
+          std::vector<uint64_t> other_bits(max_full, 0);
+          other.chunks->to_dense(&other_bits[0]);
+          bits_op(set_op, impl->bits, &other_bits[0], max_full);
         } else {
           // TODO: implement this
           assert(0);
@@ -7491,56 +8977,44 @@ namespace LegionRuntime {
         // TODO: implement this
         assert(0);
       }
+    }
+
+    ElementMask& ElementMask::operator|=(const ElementMask &other)
+    {
+      apply_op(ElementMaskChunks::OP_OR, other);
       return *this;
     }
 
     ElementMask& ElementMask::operator&=(const ElementMask &other)
     {
-      if (raw_data != 0) {
-        ElementMaskImpl *impl = (ElementMaskImpl *)raw_data;
-        if (other.raw_data != 0) {
-          ElementMaskImpl *other_impl = (ElementMaskImpl *)other.raw_data;
-          assert(num_elements == other.num_elements);
-          const int max_full = ((num_elements+63) >> 6);
-          for (int index = 0; index < max_full; index++) {
-            impl->bits[index] &= other_impl->bits[index];
-          }
-        } else {
-          // TODO: implement this
-          assert(0);
-        }
-      } else {
-        // TODO: implement this
-        assert(0);
-      }
+      apply_op(ElementMaskChunks::OP_AND, other);
       return *this;
     }
 
     ElementMask& ElementMask::operator-=(const ElementMask &other)
     {
-      if (raw_data != 0) {
-        ElementMaskImpl *impl = (ElementMaskImpl *)raw_data;
-        if (other.raw_data != 0) {
-          ElementMaskImpl *other_impl = (ElementMaskImpl *)other.raw_data;
-          assert(num_elements == other.num_elements);
-          const int max_full = ((num_elements+63) >> 6);
-          for (int index = 0; index < max_full; index++) {
-            impl->bits[index] &= ~(other_impl->bits[index]);
-          }
-        } else {
-          // TODO: implement this
-          assert(0);
-        }
-      } else {
-        // TODO: implement this
-        assert(0);
-      }
+      apply_op(ElementMaskChunks::OP_SUB, other);
       return *this;
     }
 
     ElementMask::OverlapResult ElementMask::overlaps_with(const ElementMask& other,
 							  off_t max_effort /*= -1*/) const
     {
+      const bool compressed = (!raw_data && chunks);
+      const bool other_compressed = (!other.raw_data && other.chunks);
+      if (compressed || other_compressed) {
+        assert(num_elements == other.num_elements);
+        if (compressed && other_compressed)
+          return (chunks->overlaps(*other.chunks) ?
+                    ElementMask::OVERLAP_YES : ElementMask::OVERLAP_NO);
+        const ElementMask& dense = (compressed ? other : *this);
+        if (dense.raw_data == 0)
+          return ElementMask::OVERLAP_MAYBE;
+        ElementMaskChunks tmp(num_elements);
+        tmp.from_dense(((const ElementMaskImpl *)dense.raw_data)->bits);
+        return ((compressed ? chunks : other.chunks)->overlaps(tmp) ?
+                  ElementMask::OVERLAP_YES : ElementMask::OVERLAP_NO);
+      }
       if (raw_data != 0) {
         ElementMaskImpl *i1 = (ElementMaskImpl *)raw_data;
         if (other.raw_data != 0) {
@@ -7575,6 +9049,16 @@ namespace LegionRuntime {
 
     bool ElementMask::Enumerator::get_next(int &position, int &length)
     {
+      if(!mask.raw_data && mask.chunks) {
+	if(pos >= mask.num_elements)
+	  return false;
+	if(!mask.chunks->next_run(pos, polarity != 0, position, length)) {
+	  pos = mask.num_elements; // so we don't scan again
+	  return false;
+	}
+	pos = position + length;
+	return true;
+      }
       if(mask.raw_data != 0) {
 	ElementMaskImpl *impl = (ElementMaskImpl *)(mask.raw_data);
 
@@ -9303,6 +10787,7 @@ namespace LegionRuntime {
       size_t cpu_mem_size_in_mb = 512;
       size_t reg_mem_size_in_mb = 0;
       size_t disk_mem_size_in_mb = 0;
+      int disk_mem_mmap = 0;
       // Static variable for stack size since we need to 
       // remember it when we launch threads in run 
       stack_size_in_mb = 2;
@@ -9348,6 +10833,7 @@ namespace LegionRuntime {
 	INT_ARG("-ll:csize", cpu_mem_size_in_mb);
 	INT_ARG("-ll:rsize", reg_mem_size_in_mb);
         INT_ARG("-ll:dsize", disk_mem_size_in_mb);
+        INT_ARG("-ll:dmmap", disk_mem_mmap);
         INT_ARG("-ll:stack", stack_size_in_mb);
 	INT_ARG("-ll:cpu", num_local_cpus);
 	INT_ARG("-ll:util", num_util_procs);
@@ -9356,6 +10842,7 @@ namespace LegionRuntime {
 	INT_ARG("-ll:amsg", active_msg_worker_threads);
         BOOL_ARG("-ll:senders", active_msg_sender_threads);
 	INT_ARG("-ll:bind", bind_localproc_threads);
+	INT_ARG("-ll:uthreads", TaskContext::enabled);
 #ifdef USE_CUDA
 	INT_ARG("-ll:fsize", fb_mem_size_in_mb);
 	INT_ARG("-ll:zsize", zc_mem_size_in_mb);
@@ -9409,6 +10896,17 @@ namespace LegionRuntime {
 	}
       }
 
+      // task contexts get the same stack size as worker threads
+      TaskContext::stack_size = stack_size_in_mb << 20;
+#if defined(EVENT_GRAPH_TRACE) || defined(DETAILED_TIMING)
+      // both keep per-thread stacks that a context resumed on another
+      //  thread would corrupt
+      if(TaskContext::enabled) {
+	fprintf(stderr, "WARNING: user-level task contexts are not supported with EVENT_GRAPH_TRACE or DETAILED_TIMING, ignoring -ll:uthreads\n");
+	TaskContext::enabled = false;
+      }
+#endif
+
       if(bind_localproc_threads) {
 	// this has to preceed all spawning of threads, including the ones done by things like gasnet_init()
 	proc_assignment = new ProcessorAssignment(num_local_cpus);
@@ -9710,7 +11208,8 @@ namespace LegionRuntime {
                                     gasnet_mynode(),
                                     n->memories.size(), 0).convert<Memory>(),
                                  disk_mem_size_in_mb << 20,
-                                 "disk_file.tmp");
+                                 "disk_file.tmp",
+                                 (disk_mem_mmap != 0));
         n->memories.push_back(diskmem);
         adata[apos++] = NODE_ANNOUNCE_MEM;
         adata[apos++] = diskmem->me.id;
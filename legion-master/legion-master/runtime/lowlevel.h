@@ -440,6 +440,8 @@ namespace LegionRuntime {
       size_t capacity(void) const;
     };
 
+    class ElementMaskChunks;
+
     class ElementMask {
     public:
       ElementMask(void);
@@ -519,13 +521,24 @@ namespace LegionRuntime {
 			       bool do_enabled1 = true,
 			       bool do_enabled2 = true);
 
+    protected:
+      // switches a compressed mask over to the dense bit array
+      void make_dense(void) const;
+      // shared body of the in-place set operators
+      void apply_op(int op, const ElementMask &other);
+
     public:
       friend class Enumerator;
       int first_element;
       int num_elements;
       Memory memory;
       off_t offset;
-      void *raw_data;
+      // locally created masks start out compressed (chunks != 0) and only
+      //  get a dense bit array once somebody asks for the raw data - once
+      //  raw_data is set it is authoritative and chunks is just kept alive
+      //  for readers that were already walking it
+      mutable void *raw_data;
+      mutable ElementMaskChunks *chunks;
       int first_enabled_elmt, last_enabled_elmt;
     };
 
@@ -16,14 +16,19 @@
 #include "lowlevel_impl.h"
 #include "lowlevel.h"
 #include <aio.h>
+#include <errno.h>
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <time.h>
 #include <unistd.h>
+#include <algorithm>
 
 namespace LegionRuntime {
   namespace LowLevel {
-    DiskMemory::DiskMemory(Memory _me, size_t _size, std::string _file)
-      : Memory::Impl(_me, _size, MKIND_DISK, ALIGNMENT, Memory::DISK_MEM), file(_file)
+    DiskMemory::DiskMemory(Memory _me, size_t _size, std::string _file,
+			   bool _use_mmap /*= false*/)
+      : Memory::Impl(_me, _size, MKIND_DISK, ALIGNMENT, Memory::DISK_MEM), file(_file),
+	mmap_base(0), io_shutdown(false)
     {
       printf("file = %s\n", _file.c_str());
       // do not overwrite an existing file
@@ -32,11 +37,38 @@ namespace LegionRuntime {
       // resize the file to what we want
       int ret = ftruncate(fd, _size);
       assert(ret == 0);
-      free_blocks[0] = _size;
+      allocator.add_range(0, _size);
+
+      if(_use_mmap) {
+	void *base = mmap(0, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(base != MAP_FAILED)
+	  mmap_base = (char *)base;
+	else
+	  fprintf(stderr, "WARNING: failed to map disk file %s: %s\n",
+		  _file.c_str(), strerror(errno));
+      }
+
+      gasnet_hsl_init(&io_mutex);
+      gasnett_cond_init(&io_condvar);
+      CHECK_PTHREAD( pthread_create(&io_thread, 0, io_thread_entry, this) );
+#ifdef DEADLOCK_TRACE
+      get_runtime()->add_thread(&io_thread);
+#endif
     }
 
     DiskMemory::~DiskMemory(void)
     {
+      // the I/O thread finishes whatever is still queued before it exits
+      {
+	AutoHSLLock al(io_mutex);
+	io_shutdown = true;
+	gasnett_cond_signal(&io_condvar);
+      }
+      void *dummy;
+      CHECK_PTHREAD( pthread_join(io_thread, &dummy) );
+
+      if(mmap_base)
+	munmap(mmap_base, size);
       close(fd);
       // attempt to delete the file
       unlink(file.c_str());
@@ -74,42 +106,189 @@ namespace LegionRuntime {
       free_bytes_local(offset, size);
     }
 
+    // these are synchronous by nature - a plain pread/pwrite blocks in the
+    //  kernel instead of spinning on aio_error
     void DiskMemory::get_bytes(off_t offset, void *dst, size_t size)
     {
-      aiocb cb;
-      memset(&cb, 0, sizeof(cb));
-      cb.aio_nbytes = size;
-      cb.aio_fildes = fd;
-      cb.aio_offset = offset;
-      cb.aio_buf = dst;
-      int ret = aio_read(&cb);
-      assert(ret == 0);
-      while(true) {
-	ret = aio_error(&cb);
-	if(ret == 0) break; // completed
-	assert(ret == EINPROGRESS); // only other choice we expect to see
+      char *pos = (char *)dst;
+      while(size > 0) {
+	ssize_t count = pread(fd, pos, size, offset);
+	if((count < 0) && (errno == EINTR)) continue;
+	assert(count > 0);
+	pos += count;
+	offset += count;
+	size -= count;
       }
-      ssize_t count = aio_return(&cb);
-      assert(count == (ssize_t)size);
     }
 
     void DiskMemory::put_bytes(off_t offset, const void *src, size_t size)
     {
-      aiocb cb;
-      memset(&cb, 0, sizeof(cb));
-      cb.aio_nbytes = size;
-      cb.aio_fildes = fd;
-      cb.aio_offset = offset;
-      cb.aio_buf = (void *)src;
-      int ret = aio_write(&cb);
-      assert(ret == 0);
+      const char *pos = (const char *)src;
+      while(size > 0) {
+	ssize_t count = pwrite(fd, pos, size, offset);
+	if((count < 0) && (errno == EINTR)) continue;
+	assert(count > 0);
+	pos += count;
+	offset += count;
+	size -= count;
+      }
+    }
+
+    /*static*/ void DiskMemory::add_span(std::vector<IOSpan>& spans, off_t file_offset,
+					 char *mem_ptr, size_t bytes)
+    {
+      if(!spans.empty()) {
+	IOSpan& last = spans.back();
+	if(((last.file_offset + (off_t)last.bytes) == file_offset) &&
+	   ((last.mem_ptr + last.bytes) == mem_ptr)) {
+	  last.bytes += bytes;
+	  return;
+	}
+      }
+      IOSpan span;
+      span.file_offset = file_offset;
+      span.mem_ptr = mem_ptr;
+      span.bytes = bytes;
+      spans.push_back(span);
+    }
+
+    static bool span_before(const DiskMemory::IOSpan& a, const DiskMemory::IOSpan& b)
+    {
+      return a.file_offset < b.file_offset;
+    }
+
+    /*static*/ void DiskMemory::coalesce_spans(std::vector<IOSpan>& spans)
+    {
+      // spans arrive in the order the copy walks the instances, which for
+      //  SOA layouts jumps around the file - sorting them makes neighbors
+      //  out of pieces add_span couldn't merge on the way in
+      std::sort(spans.begin(), spans.end(), span_before);
+      size_t merged = 0;
+      for(size_t i = 1; i < spans.size(); i++) {
+	IOSpan& last = spans[merged];
+	if(((last.file_offset + (off_t)last.bytes) == spans[i].file_offset) &&
+	   ((last.mem_ptr + last.bytes) == spans[i].mem_ptr))
+	  last.bytes += spans[i].bytes;
+	else
+	  spans[++merged] = spans[i];
+      }
+      if(!spans.empty())
+	spans.resize(merged + 1);
+    }
+
+    void DiskMemory::submit_batch(bool is_write, std::vector<IOSpan>& spans, Event done)
+    {
+      coalesce_spans(spans);
+
+      if(spans.empty()) {
+	if(done.exists())
+	  get_runtime()->get_genevent_impl(done)->trigger(done.gen, gasnet_mynode());
+	return;
+      }
+
+      IOBatch *batch = new IOBatch;
+      batch->pending = spans.size();
+      batch->done = done;
+
+      AutoHSLLock al(io_mutex);
+      for(std::vector<IOSpan>::const_iterator it = spans.begin();
+	  it != spans.end();
+	  it++) {
+	IORequest *req = new IORequest;
+	memset(&req->cb, 0, sizeof(req->cb));
+	req->cb.aio_fildes = fd;
+	req->cb.aio_offset = it->file_offset;
+	req->cb.aio_buf = it->mem_ptr;
+	req->cb.aio_nbytes = it->bytes;
+	req->is_write = is_write;
+	req->batch = batch;
+	io_queue.push_back(req);
+      }
+      gasnett_cond_signal(&io_condvar);
+    }
+
+    void DiskMemory::perform_batch(bool is_write, std::vector<IOSpan>& spans)
+    {
+      coalesce_spans(spans);
+      for(std::vector<IOSpan>::const_iterator it = spans.begin();
+	  it != spans.end();
+	  it++)
+	if(is_write)
+	  put_bytes(it->file_offset, it->mem_ptr, it->bytes);
+	else
+	  get_bytes(it->file_offset, it->mem_ptr, it->bytes);
+    }
+
+    /*static*/ void *DiskMemory::io_thread_entry(void *data)
+    {
+      ((DiskMemory *)data)->io_thread_main();
+      return 0;
+    }
+
+    void DiskMemory::io_thread_main(void)
+    {
+      // requests in flight are only ever touched by this thread
+      std::vector<IORequest *> inflight;
+      std::vector<const aiocb *> cbs;
+      std::vector<Event> finished;
+
+      gasnet_hsl_lock(&io_mutex);
       while(true) {
-	ret = aio_error(&cb);
-	if(ret == 0) break; // completed
-	assert(ret == EINPROGRESS); // only other choice we expect to see
+	// issue queued requests up to the limit
+	while(!io_queue.empty() && (inflight.size() < MAX_OUTSTANDING_IO)) {
+	  IORequest *req = io_queue.front();
+	  io_queue.pop_front();
+	  int ret = (req->is_write ? aio_write(&req->cb) : aio_read(&req->cb));
+	  assert(ret == 0);
+	  inflight.push_back(req);
+	}
+
+	if(inflight.empty()) {
+	  if(io_shutdown) break;
+	  gasnett_cond_wait(&io_condvar, &io_mutex.lock);
+	  continue;
+	}
+
+	// sleep until something completes - the timeout picks up requests
+	//  queued in the mean time
+	gasnet_hsl_unlock(&io_mutex);
+	cbs.resize(inflight.size());
+	for(size_t i = 0; i < inflight.size(); i++)
+	  cbs[i] = &(inflight[i]->cb);
+	struct timespec timeout;
+	timeout.tv_sec = 0;
+	timeout.tv_nsec = 1000000;
+	aio_suspend(&cbs[0], cbs.size(), &timeout);
+
+	size_t still_inflight = 0;
+	for(size_t i = 0; i < inflight.size(); i++) {
+	  IORequest *req = inflight[i];
+	  int ret = aio_error(&req->cb);
+	  if(ret == EINPROGRESS) {
+	    inflight[still_inflight++] = req;
+	    continue;
+	  }
+	  assert(ret == 0);
+	  ssize_t count = aio_return(&req->cb);
+	  assert(count == (ssize_t)(req->cb.aio_nbytes));
+	  if(--(req->batch->pending) == 0) {
+	    if(req->batch->done.exists())
+	      finished.push_back(req->batch->done);
+	    delete req->batch;
+	  }
+	  delete req;
+	}
+	inflight.resize(still_inflight);
+
+	for(std::vector<Event>::const_iterator it = finished.begin();
+	    it != finished.end();
+	    it++)
+	  get_runtime()->get_genevent_impl(*it)->trigger(it->gen, gasnet_mynode());
+	finished.clear();
+
+	gasnet_hsl_lock(&io_mutex);
       }
-      ssize_t count = aio_return(&cb);
-      assert(count == (ssize_t)size);
+      gasnet_hsl_unlock(&io_mutex);
     }
 
     void DiskMemory::apply_reduction_list(off_t offset, const ReductionOpUntyped *redop,
@@ -119,7 +298,9 @@ namespace LegionRuntime {
 
     void *DiskMemory::get_direct_ptr(off_t offset, size_t size)
     {
-      return 0; // cannot provide a pointer for it.
+      // only a mapped file can provide a pointer
+      if(!mmap_base) return 0;
+      return mmap_base + offset;
     }
 
     int DiskMemory::get_home_node(off_t offset, size_t size)
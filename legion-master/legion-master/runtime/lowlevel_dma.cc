@@ -20,6 +20,11 @@
 #include "accessor.h"
 
 #include <queue>
+#include <climits>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 #define CHECK_PTHREAD(cmd) do { \
   int ret = (cmd); \
@@ -66,22 +71,46 @@ namespace LegionRuntime {
 
     class DmaRequest;
 
+    // requests are spread over channels by the memories they touch - each
+    //  channel is served by its own worker thread, so copies between
+    //  unrelated memories don't wait behind each other, and copies between
+    //  the same pair of memories meet in one queue where they can be merged
     class DmaRequestQueue {
     public:
-      DmaRequestQueue(void);
+      DmaRequestQueue(int _num_channels);
+
+      ~DmaRequestQueue(void);
 
       void enqueue_request(DmaRequest *r);
 
-      DmaRequest *dequeue_request(bool sleep = true);
+      // also pulls out (up to MAX_MERGED) queued requests that can be
+      //  performed together with the one returned - the given channel is
+      //  tried first, and then the others so that no worker sits idle while
+      //  another one has a backlog
+      DmaRequest *dequeue_request(int channel, std::vector<DmaRequest *>& merged,
+				  bool sleep = true);
 
       void shutdown_queue(void);
 
+      int num_channels(void) const { return channels.size(); }
+
+      static const size_t MAX_MERGED = 16;
+
     protected:
-      gasnet_hsl_t queue_mutex;
-      gasnett_cond_t queue_condvar;
-      std::map<int, std::list<DmaRequest *> *> queues;
-      int queue_sleepers;
-      bool shutdown_flag;
+      struct Channel {
+	gasnet_hsl_t queue_mutex;
+	std::map<int, std::list<DmaRequest *> *> queues;
+      };
+
+      DmaRequest *try_dequeue_request(Channel *c, std::vector<DmaRequest *>& merged);
+
+      std::vector<Channel *> channels;
+      volatile bool shutdown_flag;
+      // idle workers of every channel sleep here until something is queued
+      gasnet_hsl_t idle_mutex;
+      gasnett_cond_t idle_condvar;
+      size_t num_queued;
+      int idle_sleepers;
     };
 
     class DmaRequest {
@@ -97,6 +126,12 @@ namespace LegionRuntime {
 
       virtual void perform_dma(void) = 0;
 
+      // picks the DMA channel the request is queued on
+      virtual unsigned channel_hash(void) = 0;
+
+      // only copies between the same pair of memories report one
+      virtual bool get_memory_pair(MemPair& pair) { return false; }
+
       enum State {
 	STATE_INIT,
 	STATE_METADATA_FETCH,
@@ -155,10 +190,22 @@ namespace LegionRuntime {
       template <unsigned DIM>
       void perform_dma_rect(MemPairCopier *mpc);
 
+      void begin_dma(void);
+
+      void copy_into(MemPairCopier *mpc);
+
       virtual void perform_dma(void);
 
+      // performs all the requests with a single copier, so that their
+      //  spans can be combined into fewer, larger transfers
+      static void perform_merged_dma(std::vector<DmaRequest *>& reqs);
+
       virtual bool handler_safe(void) { return(false); }
 
+      virtual unsigned channel_hash(void);
+
+      virtual bool get_memory_pair(MemPair& pair);
+
       Domain domain;
       OASByInst *oas_by_inst;
       Event before_copy;
@@ -199,6 +246,8 @@ namespace LegionRuntime {
 
       virtual bool handler_safe(void) { return(false); }
 
+      virtual unsigned channel_hash(void);
+
       Domain domain;
       std::vector<Domain::CopySrcDstField> srcs;
       Domain::CopySrcDstField dst;
@@ -210,88 +259,163 @@ namespace LegionRuntime {
       Waiter waiter; // if we need to wait on events
     };
 
-    DmaRequestQueue::DmaRequestQueue(void)
+    DmaRequestQueue::DmaRequestQueue(int _num_channels)
     {
-      gasnet_hsl_init(&queue_mutex);
-      gasnett_cond_init(&queue_condvar);
-      queue_sleepers = 0;
+      assert(_num_channels > 0);
+      channels.resize(_num_channels);
+      for(int i = 0; i < _num_channels; i++) {
+	Channel *c = new Channel;
+	gasnet_hsl_init(&c->queue_mutex);
+	channels[i] = c;
+      }
       shutdown_flag = false;
+      gasnet_hsl_init(&idle_mutex);
+      gasnett_cond_init(&idle_condvar);
+      num_queued = 0;
+      idle_sleepers = 0;
     }
 
-    void DmaRequestQueue::shutdown_queue(void)
+    DmaRequestQueue::~DmaRequestQueue(void)
     {
-      gasnet_hsl_lock(&queue_mutex);
+      for(std::vector<Channel *>::iterator it = channels.begin();
+	  it != channels.end();
+	  it++) {
+	gasnet_hsl_destroy(&(*it)->queue_mutex);
+	delete *it;
+      }
+      gasnet_hsl_destroy(&idle_mutex);
+      gasnett_cond_destroy(&idle_condvar);
+    }
 
-      assert(queues.empty());
+    void DmaRequestQueue::shutdown_queue(void)
+    {
+      for(std::vector<Channel *>::iterator it = channels.begin();
+	  it != channels.end();
+	  it++) {
+	Channel *c = *it;
+	gasnet_hsl_lock(&c->queue_mutex);
+	assert(c->queues.empty());
+	gasnet_hsl_unlock(&c->queue_mutex);
+      }
 
       // set the shutdown flag and wake up any sleepers
+      gasnet_hsl_lock(&idle_mutex);
       shutdown_flag = true;
-
-      gasnett_cond_broadcast(&queue_condvar);
-
-      gasnet_hsl_unlock(&queue_mutex);
+      gasnett_cond_broadcast(&idle_condvar);
+      gasnet_hsl_unlock(&idle_mutex);
     }
 
     void DmaRequestQueue::enqueue_request(DmaRequest *r)
     {
-      gasnet_hsl_lock(&queue_mutex);
+      Channel *c = channels[r->channel_hash() % channels.size()];
+
+      gasnet_hsl_lock(&c->queue_mutex);
 
       // there's a queue per priority level
       // priorities are negated so that the highest logical priority comes first
       int p = -r->priority;
-      std::map<int, std::list<DmaRequest *> *>::iterator it = queues.find(p);
-      if(it == queues.end()) {
+      std::map<int, std::list<DmaRequest *> *>::iterator it = c->queues.find(p);
+      if(it == c->queues.end()) {
 	// nothing at this priority level - make a new list
 	std::list<DmaRequest *> *l = new std::list<DmaRequest *>;
 	l->push_back(r);
-	queues[p] = l;
+	c->queues[p] = l;
       } else {
 	// push ourselves onto the back of the existing queue
 	it->second->push_back(r);
       }
 
-      // if anybody was sleeping, wake them up
-      if(queue_sleepers > 0) {
-	queue_sleepers = 0;
-	gasnett_cond_broadcast(&queue_condvar);
-      }
+      gasnet_hsl_unlock(&c->queue_mutex);
 
-      gasnet_hsl_unlock(&queue_mutex);
+      // one more request for somebody to do - wake up an idle worker
+      //  (whichever channel it belongs to) if there is one
+      gasnet_hsl_lock(&idle_mutex);
+      num_queued++;
+      if(idle_sleepers > 0) {
+	idle_sleepers--;
+	gasnett_cond_signal(&idle_condvar);
+      }
+      gasnet_hsl_unlock(&idle_mutex);
     }
 
-    DmaRequest *DmaRequestQueue::dequeue_request(bool sleep /*= true*/)
+    DmaRequest *DmaRequestQueue::try_dequeue_request(Channel *c,
+						     std::vector<DmaRequest *>& merged)
     {
-      gasnet_hsl_lock(&queue_mutex);
+      gasnet_hsl_lock(&c->queue_mutex);
 
       // quick check - are there any requests at all?
-      while(queues.empty()) {
-	if(!sleep || shutdown_flag) {
-	  gasnet_hsl_unlock(&queue_mutex);
-	  return 0;
-	}
-
-	// sleep until there are, or until shutdown
-	queue_sleepers++;
-	gasnett_cond_wait(&queue_condvar, &queue_mutex.lock);
+      if(c->queues.empty()) {
+	gasnet_hsl_unlock(&c->queue_mutex);
+	return 0;
       }
 
       // grab the first request from the highest-priority queue there is
       // priorities are negated so that the highest logical priority comes first
-      std::map<int, std::list<DmaRequest *> *>::iterator it = queues.begin();
+      std::map<int, std::list<DmaRequest *> *>::iterator it = c->queues.begin();
       assert(!it->second->empty());
       DmaRequest *r = it->second->front();
       it->second->pop_front();
+
+      // anything else at this priority between the same memories comes along -
+      //  these are all ready to go, so order within the batch doesn't matter
+      MemPair pair;
+      if(r->get_memory_pair(pair)) {
+	std::list<DmaRequest *>::iterator it2 = it->second->begin();
+	while((it2 != it->second->end()) && (merged.size() < MAX_MERGED)) {
+	  MemPair pair2;
+	  if((*it2)->get_memory_pair(pair2) && (pair2 == pair)) {
+	    merged.push_back(*it2);
+	    it2 = it->second->erase(it2);
+	  } else
+	    it2++;
+	}
+      }
+
       // if queue is empty, delete from list
       if(it->second->empty()) {
 	delete it->second;
-	queues.erase(it);
+	c->queues.erase(it);
       }
 
-      gasnet_hsl_unlock(&queue_mutex);
-      
+      gasnet_hsl_unlock(&c->queue_mutex);
+
+      gasnet_hsl_lock(&idle_mutex);
+      num_queued -= 1 + merged.size();
+      gasnet_hsl_unlock(&idle_mutex);
+
       return r;
     }
 
+    DmaRequest *DmaRequestQueue::dequeue_request(int channel,
+						 std::vector<DmaRequest *>& merged,
+						 bool sleep /*= true*/)
+    {
+      const int count = channels.size();
+      while(true) {
+	// our own channel first so that copies between the same memories tend
+	//  to stay on one worker and get merged, then steal from the others
+	for(int i = 0; i < count; i++) {
+	  DmaRequest *r = try_dequeue_request(channels[(channel + i) % count], merged);
+	  if(r)
+	    return r;
+	}
+
+	// nothing anywhere - sleep until something is queued, or until shutdown
+	// (a request that was counted but not yet dequeued by someone else just
+	//  means another trip around the channels)
+	gasnet_hsl_lock(&idle_mutex);
+	if(!sleep || shutdown_flag) {
+	  gasnet_hsl_unlock(&idle_mutex);
+	  return 0;
+	}
+	if(num_queued == 0) {
+	  idle_sleepers++;
+	  gasnett_cond_wait(&idle_condvar, &idle_mutex.lock);
+	}
+	gasnet_hsl_unlock(&idle_mutex);
+      }
+    }
+
     CopyRequest::CopyRequest(const Domain& _domain,
 			     OASByInst *_oas_by_inst,
 			     Event _before_copy,
@@ -1085,11 +1209,22 @@ namespace LegionRuntime {
 	// if both source and dest fill up an entire field, we might be able to copy whole ranges at the same time
 	if((src_field_start == src_offset) && (src_field_size == bytes) &&
 	   (dst_field_start == dst_offset) && (dst_field_size == bytes)) {
+	  // in an AOS instance (block size of 1) consecutive elements are a
+	  //  whole element apart, otherwise they're adjacent within a block
+	  int src_bsize = src_inst->metadata.block_size;
+	  int dst_bsize = dst_inst->metadata.block_size;
+	  off_t src_estride = ((src_bsize == 1) ? src_inst->metadata.elmt_size : bytes);
+	  off_t dst_estride = ((dst_bsize == 1) ? dst_inst->metadata.elmt_size : bytes);
+
 	  // let's see how many we can copy
 	  int done = 0;
 	  while(done < elem_count) {
-	    int src_in_this_block = src_inst->metadata.block_size - ((src_index + done) % src_inst->metadata.block_size);
-	    int dst_in_this_block = dst_inst->metadata.block_size - ((dst_index + done) % dst_inst->metadata.block_size);
+	    int src_in_this_block = ((src_bsize == 1) ?
+				       (elem_count - done) :
+				       (src_bsize - ((src_index + done) % src_bsize)));
+	    int dst_in_this_block = ((dst_bsize == 1) ?
+				       (elem_count - done) :
+				       (dst_bsize - ((dst_index + done) % dst_bsize)));
 	    int todo = min(elem_count - done, min(src_in_this_block, dst_in_this_block));
 
 	    //printf("copying range of %d elements (%d, %d, %d)\n", todo, src_index, dst_index, done);
@@ -1101,20 +1236,27 @@ namespace LegionRuntime {
 					   dst_field_start, dst_field_size, dst_inst->metadata.elmt_size,
 					   dst_inst->metadata.block_size, dst_index + done);
 
-	    // sanity check that the range we calculated really is contiguous
+	    // sanity check that the range we calculated really is evenly strided
 	    assert(calc_mem_loc(src_inst->metadata.alloc_offset + (src_offset - src_field_start),
 				src_field_start, src_field_size, src_inst->metadata.elmt_size,
 				src_inst->metadata.block_size, src_index + done + todo - 1) == 
-		   (src_start + (todo - 1) * bytes));
+		   (src_start + (todo - 1) * src_estride));
 	    assert(calc_mem_loc(dst_inst->metadata.alloc_offset + (dst_offset - dst_field_start),
 				dst_field_start, dst_field_size, dst_inst->metadata.elmt_size,
 				dst_inst->metadata.block_size, dst_index + done + todo - 1) == 
-		   (dst_start + (todo - 1) * bytes));
+		   (dst_start + (todo - 1) * dst_estride));
 
 #ifdef NEW2D_DEBUG
 	    printf("ZZZ: %zd %zd %d\n", src_start, dst_start, bytes * todo);
 #endif
-	    span_copier->copy_span(src_start, dst_start, bytes * todo);
+	    if((src_estride == (off_t)bytes) && (dst_estride == (off_t)bytes)) {
+	      span_copier->copy_span(src_start, dst_start, bytes * todo);
+	    } else {
+	      // AOS<->SOA - a single strided (gather/scatter) copy instead of
+	      //  one span per element
+	      span_copier->copy_span(src_start, dst_start, bytes,
+				     src_estride, dst_estride, todo);
+	    }
 	    //src_mem->get_bytes(src_start, buffer, bytes * todo);
 	    //dst_mem->put_bytes(dst_start, buffer, bytes * todo);
 
@@ -1559,6 +1701,90 @@ namespace LegionRuntime {
       char *buffer;
     };
      
+    // strided copies of a single field are what AOS<->SOA conversions turn
+    //  into - with the field size known at compile time each line is a
+    //  register move, and with AVX2 4- and 8-byte fields can be gathered
+    //  out of an AOS source several at a time
+    template <size_t BYTES>
+    static inline void strided_copy_fixed(char *dst, const char *src,
+					  off_t dst_stride, off_t src_stride,
+					  size_t lines)
+    {
+      for(size_t i = 0; i < lines; i++) {
+	memcpy(dst, src, BYTES);
+	dst += dst_stride;
+	src += src_stride;
+      }
+    }
+
+#ifdef __AVX2__
+    template <>
+    inline void strided_copy_fixed<4>(char *dst, const char *src,
+				      off_t dst_stride, off_t src_stride,
+				      size_t lines)
+    {
+      if((dst_stride == 4) && (src_stride > 0) && (src_stride <= (INT_MAX / 8))) {
+	const int s = src_stride;
+	const __m256i index = _mm256_setr_epi32(0, s, 2*s, 3*s, 4*s, 5*s, 6*s, 7*s);
+	while(lines >= 8) {
+	  __m256i v = _mm256_i32gather_epi32((const int *)src, index, 1);
+	  _mm256_storeu_si256((__m256i *)dst, v);
+	  dst += 32;
+	  src += 8 * src_stride;
+	  lines -= 8;
+	}
+      }
+      for(size_t i = 0; i < lines; i++) {
+	memcpy(dst, src, 4);
+	dst += dst_stride;
+	src += src_stride;
+      }
+    }
+
+    template <>
+    inline void strided_copy_fixed<8>(char *dst, const char *src,
+				      off_t dst_stride, off_t src_stride,
+				      size_t lines)
+    {
+      if((dst_stride == 8) && (src_stride > 0) && (src_stride <= (INT_MAX / 4))) {
+	const int s = src_stride;
+	const __m128i index = _mm_setr_epi32(0, s, 2*s, 3*s);
+	while(lines >= 4) {
+	  __m256i v = _mm256_i32gather_epi64((const long long *)src, index, 1);
+	  _mm256_storeu_si256((__m256i *)dst, v);
+	  dst += 32;
+	  src += 4 * src_stride;
+	  lines -= 4;
+	}
+      }
+      for(size_t i = 0; i < lines; i++) {
+	memcpy(dst, src, 8);
+	dst += dst_stride;
+	src += src_stride;
+      }
+    }
+#endif
+
+    static void strided_copy(char *dst, const char *src, size_t bytes,
+			     off_t dst_stride, off_t src_stride, size_t lines)
+    {
+      switch(bytes) {
+      case 1: strided_copy_fixed<1>(dst, src, dst_stride, src_stride, lines); break;
+      case 2: strided_copy_fixed<2>(dst, src, dst_stride, src_stride, lines); break;
+      case 4: strided_copy_fixed<4>(dst, src, dst_stride, src_stride, lines); break;
+      case 8: strided_copy_fixed<8>(dst, src, dst_stride, src_stride, lines); break;
+      case 16: strided_copy_fixed<16>(dst, src, dst_stride, src_stride, lines); break;
+      default:
+	{
+	  for(size_t i = 0; i < lines; i++) {
+	    memcpy(dst, src, bytes);
+	    dst += dst_stride;
+	    src += src_stride;
+	  }
+	}
+      }
+    }
+
     class MemcpyMemPairCopier : public MemPairCopier {
     public:
       MemcpyMemPairCopier(Memory _src_mem, Memory _dst_mem)
@@ -1590,15 +1816,20 @@ namespace LegionRuntime {
 #endif
       }
 
-      // default behavior of 2D copy is to unroll to 1D copies
       void copy_span(off_t src_offset, off_t dst_offset, size_t bytes,
 		     off_t src_stride, off_t dst_stride, size_t lines)
       {
-	while(lines-- > 0) {
-	  copy_span(src_offset, dst_offset, bytes);
-	  src_offset += src_stride;
-	  dst_offset += dst_stride;
+	// lines that abut on both sides are really just a 1D copy
+	if(((size_t)src_stride == bytes) && ((size_t)dst_stride == bytes)) {
+	  copy_span(src_offset, dst_offset, bytes * lines);
+	  return;
 	}
+
+	strided_copy(dst_base + dst_offset, src_base + src_offset, bytes,
+		     dst_stride, src_stride, lines);
+#ifdef EVENT_GRAPH_TRACE
+        record_bytes(bytes * lines);
+#endif
       }
 
     protected:
@@ -2320,15 +2551,17 @@ namespace LegionRuntime {
       bool fold;
     };
 
-    // MemPairCopier from disk memory to cpu memory
+    // MemPairCopier from disk memory to cpu memory - spans are only
+    //  collected here and handed to the disk's I/O thread as one batch in
+    //  flush, which triggers the copy's event when the last read lands
     class DisktoCPUMemPairCopier : public MemPairCopier {
     public:
-      DisktoCPUMemPairCopier(int _fd, Memory _dst_mem)
+      DisktoCPUMemPairCopier(DiskMemory *_disk, Memory _dst_mem)
+        : disk(_disk)
       {
         Memory::Impl *dst_impl = _dst_mem.impl();
         dst_base = (char *)(dst_impl->get_direct_ptr(0, dst_impl->size));
         assert(dst_base);
-        fd = _fd;
       }
 
       virtual ~DisktoCPUMemPairCopier(void)
@@ -2344,15 +2577,10 @@ namespace LegionRuntime {
 
       void copy_span(off_t src_offset, off_t dst_offset, size_t bytes)
       {
-        aiocb cb;
-        memset(&cb, 0, sizeof(cb));
-        cb.aio_nbytes = bytes;
-        cb.aio_fildes = fd;
-        cb.aio_offset = src_offset;
-        cb.aio_buf = dst_base + dst_offset;
-        assert(aio_read(&cb) != -1);
-        while (aio_error(&cb) == EINPROGRESS) {}
-        assert((size_t)aio_return(&cb) == bytes);
+        DiskMemory::add_span(spans, src_offset, dst_base + dst_offset, bytes);
+#ifdef EVENT_GRAPH_TRACE
+        record_bytes(bytes);
+#endif
       }
 
       void copy_span(off_t src_offset, off_t dst_offset, size_t bytes,
@@ -2364,20 +2592,32 @@ namespace LegionRuntime {
           dst_offset += dst_stride;
         }
       }
+
+      virtual void flush(Event after_copy)
+      {
+#ifdef EVENT_GRAPH_TRACE
+        report_bytes(after_copy);
+#endif
+        if(after_copy.exists())
+          disk->submit_batch(false /*!is_write*/, spans, after_copy);
+        else
+          disk->perform_batch(false /*!is_write*/, spans);
+      }
     protected:
+      DiskMemory *disk;
       char *dst_base;
-      int fd; // file descriptor
+      std::vector<DiskMemory::IOSpan> spans;
     };
 
-    // MemPairCopier from disk memory to cpu memory
+    // MemPairCopier from cpu memory to disk memory
     class DiskfromCPUMemPairCopier : public MemPairCopier {
     public:
-      DiskfromCPUMemPairCopier(Memory _src_mem, int _fd)
+      DiskfromCPUMemPairCopier(Memory _src_mem, DiskMemory *_disk)
+        : disk(_disk)
       { 
         Memory::Impl *src_impl = _src_mem.impl();
         src_base = (char *)(src_impl->get_direct_ptr(0, src_impl->size));
         assert(src_base);
-        fd = _fd;
       }
 
       virtual ~DiskfromCPUMemPairCopier(void)
@@ -2393,15 +2633,10 @@ namespace LegionRuntime {
 
       void copy_span(off_t src_offset, off_t dst_offset, size_t bytes)
       {
-        aiocb cb;
-        memset(&cb, 0, sizeof(cb));
-        cb.aio_nbytes = bytes;
-        cb.aio_fildes = fd;
-        cb.aio_offset = dst_offset;
-        cb.aio_buf = src_base + src_offset;
-        assert(aio_write(&cb) != -1);
-        while (aio_error(&cb) == EINPROGRESS) {}
-        assert((size_t)aio_return(&cb) == bytes);
+        DiskMemory::add_span(spans, dst_offset, src_base + src_offset, bytes);
+#ifdef EVENT_GRAPH_TRACE
+        record_bytes(bytes);
+#endif
       }
 
       void copy_span(off_t src_offset, off_t dst_offset, size_t bytes,
@@ -2413,9 +2648,21 @@ namespace LegionRuntime {
           dst_offset += dst_stride;
         }
       }
+
+      virtual void flush(Event after_copy)
+      {
+#ifdef EVENT_GRAPH_TRACE
+        report_bytes(after_copy);
+#endif
+        if(after_copy.exists())
+          disk->submit_batch(true /*is_write*/, spans, after_copy);
+        else
+          disk->perform_batch(true /*is_write*/, spans);
+      }
     protected:
+      DiskMemory *disk;
       char *src_base;
-      int fd; // file descriptor
+      std::vector<DiskMemory::IOSpan> spans;
     };
      
     MemPairCopier *MemPairCopier::create_copier(Memory src_mem, Memory dst_mem,
@@ -2441,15 +2688,13 @@ namespace LegionRuntime {
         if (((src_kind == Memory::Impl::MKIND_SYSMEM) || (src_kind == Memory::Impl::MKIND_ZEROCOPY)) &&
             (dst_kind == Memory::Impl::MKIND_DISK)) {
           printf("Create DiskfromCPUMemPairCopier\n");
-          int fd = ((DiskMemory *)dst_impl)->fd;
-          return new DiskfromCPUMemPairCopier(src_mem, fd);
+          return new DiskfromCPUMemPairCopier(src_mem, (DiskMemory *)dst_impl);
         }
 
         if ((src_kind == Memory::Impl::MKIND_DISK) &&
             ((dst_kind == Memory::Impl::MKIND_SYSMEM) || (dst_kind == Memory::Impl::MKIND_ZEROCOPY))) {
           printf("Create DisktoCPUMemPairCopier\n");
-          int fd = ((DiskMemory *)src_impl)->fd;
-          return new DisktoCPUMemPairCopier(fd, dst_mem);
+          return new DisktoCPUMemPairCopier((DiskMemory *)src_impl, dst_mem);
         }
 
 #ifdef USE_CUDA
@@ -2760,7 +3005,7 @@ namespace LegionRuntime {
     };
 #endif
 
-    void CopyRequest::perform_dma(void)
+    void CopyRequest::begin_dma(void)
     {
       log_dma.info("request %p executing", this);
 
@@ -2777,15 +3022,10 @@ namespace LegionRuntime {
       after_copy.impl()->add_waiter(after_copy.gen,
           new CopyCompletionProfiler(after_copy));
 #endif
+    }
 
-      DetailedTimer::ScopedPush sp(TIME_COPY);
-
-      // create a copier for the memory used by all of these instance pairs
-      Memory src_mem = oas_by_inst->begin()->first.first.impl()->memory;
-      Memory dst_mem = oas_by_inst->begin()->first.second.impl()->memory;
-
-      MemPairCopier *mpc = MemPairCopier::create_copier(src_mem, dst_mem);
-
+    void CopyRequest::copy_into(MemPairCopier *mpc)
+    {
       switch(domain.get_dim()) {
       case 0:
 	{
@@ -2813,6 +3053,21 @@ namespace LegionRuntime {
 		   domain.is_id,
 		   before_copy.id, before_copy.gen,
 		   after_copy.id, after_copy.gen);
+    }
+
+    void CopyRequest::perform_dma(void)
+    {
+      begin_dma();
+
+      DetailedTimer::ScopedPush sp(TIME_COPY);
+
+      // create a copier for the memory used by all of these instance pairs
+      MemPair pair;
+      get_memory_pair(pair);
+
+      MemPairCopier *mpc = MemPairCopier::create_copier(pair.first, pair.second);
+
+      copy_into(mpc);
 
       // if(after_copy.exists())
       // 	after_copy.impl()->trigger(after_copy.gen, gasnet_mynode());
@@ -3103,6 +3358,87 @@ namespace LegionRuntime {
 #endif
     }
     
+    // triggers the completion events of copies that were merged into one
+    //  pass through a MemPairCopier, once that copier is done
+    class MergedCopyTrigger : public EventWaiter {
+    public:
+      MergedCopyTrigger(const std::vector<Event>& _events)
+	: events(_events) {}
+
+      virtual ~MergedCopyTrigger(void) {}
+
+      virtual bool event_triggered(void)
+      {
+	for(std::vector<Event>::const_iterator it = events.begin();
+	    it != events.end();
+	    it++)
+	  get_runtime()->get_genevent_impl(*it)->trigger(it->gen, gasnet_mynode());
+	// delete us
+	return true;
+      }
+
+      virtual void print_info(FILE *f)
+      {
+	fprintf(f,"merged copy: %zd completion events\n", events.size());
+      }
+
+    protected:
+      std::vector<Event> events;
+    };
+
+    /*static*/ void CopyRequest::perform_merged_dma(std::vector<DmaRequest *>& reqs)
+    {
+      assert(!reqs.empty());
+
+      DetailedTimer::ScopedPush sp(TIME_COPY);
+
+      // all requests were merged because they share a memory pair
+      MemPair pair;
+      reqs[0]->get_memory_pair(pair);
+
+      log_dma.info("merging %zd copy requests: " IDFMT " -> " IDFMT,
+		   reqs.size(), pair.first.id, pair.second.id);
+
+      MemPairCopier *mpc = MemPairCopier::create_copier(pair.first, pair.second);
+
+      std::vector<Event> events;
+      for(std::vector<DmaRequest *>::iterator it = reqs.begin();
+	  it != reqs.end();
+	  it++) {
+	CopyRequest *r = (CopyRequest *)(*it);
+	r->begin_dma();
+	r->copy_into(mpc);
+	if(r->after_copy.exists())
+	  events.push_back(r->after_copy);
+      }
+
+      // the copier only knows how to trigger a single event
+      Event merged_copy = Event::NO_EVENT;
+      if(!events.empty()) {
+	GenEventImpl *impl = GenEventImpl::create_genevent();
+	merged_copy = impl->current_event();
+	impl->add_waiter(merged_copy.gen, new MergedCopyTrigger(events));
+      }
+
+      mpc->flush(merged_copy);
+      delete mpc;
+    }
+
+    unsigned CopyRequest::channel_hash(void)
+    {
+      MemPair pair;
+      get_memory_pair(pair);
+      return (pair.first.id * 0x9e3779b1U) ^ pair.second.id;
+    }
+
+    bool CopyRequest::get_memory_pair(MemPair& pair)
+    {
+      // all the instance pairs of a copy request are in the same memories
+      pair.first = oas_by_inst->begin()->first.first.impl()->memory;
+      pair.second = oas_by_inst->begin()->first.second.impl()->memory;
+      return true;
+    }
+
     ReduceRequest::ReduceRequest(const Domain& _domain,
 				 const std::vector<Domain::CopySrcDstField>& _srcs,
 				 const Domain::CopySrcDstField& _dst,
@@ -3457,6 +3793,12 @@ namespace LegionRuntime {
       delete ipc;
     }
 
+    unsigned ReduceRequest::channel_hash(void)
+    {
+      // reductions are performed by whoever owns the destination
+      return dst.inst.impl()->memory.id;
+    }
+
     void ReduceRequest::perform_dma(void)
     {
       log_dma.info("request %p executing", this);
@@ -3729,22 +4071,41 @@ namespace LegionRuntime {
     static int num_threads = 0;
     static pthread_t *worker_threads = 0;
 
-    // for now we use a single queue for all (local) dmas
+    // one channel per worker thread
     static DmaRequestQueue *dma_queue = 0;
+
+    struct DmaWorkerArgs {
+      DmaRequestQueue *rq;
+      int channel;
+    };
     
     static void *dma_worker_thread_loop(void *arg)
     {
-      DmaRequestQueue *rq = (DmaRequestQueue *)arg;
+      DmaWorkerArgs *args = (DmaWorkerArgs *)arg;
+      DmaRequestQueue *rq = args->rq;
+      int channel = args->channel;
+      delete args;
 
-      log_dma.info("dma worker thread created");
+      log_dma.info("dma worker thread created for channel %d", channel);
 
+      std::vector<DmaRequest *> merged;
       while(!terminate_flag) {
 	// get a request, sleeping as necessary
-	DmaRequest *r = rq->dequeue_request(true);
+	DmaRequest *r = rq->dequeue_request(channel, merged, true);
 
 	if(r) {
-	  r->perform_dma();
-	  delete r;
+	  if(merged.empty()) {
+	    r->perform_dma();
+	    delete r;
+	  } else {
+	    merged.insert(merged.begin(), r);
+	    CopyRequest::perform_merged_dma(merged);
+	    for(std::vector<DmaRequest *>::iterator it = merged.begin();
+		it != merged.end();
+		it++)
+	      delete *it;
+	    merged.clear();
+	  }
 	}
       }
 
@@ -3755,7 +4116,8 @@ namespace LegionRuntime {
     
     void start_dma_worker_threads(int count)
     {
-      dma_queue = new DmaRequestQueue;
+      // requests still need somewhere to wait if there are no workers
+      dma_queue = new DmaRequestQueue((count > 0) ? count : 1);
       num_threads = count;
 
       worker_threads = new pthread_t[count];
@@ -3764,8 +4126,11 @@ namespace LegionRuntime {
 	CHECK_PTHREAD( pthread_attr_init(&attr) );
 	if(proc_assignment)
 	  proc_assignment->bind_thread(-1, &attr, "DMA worker");
+	DmaWorkerArgs *args = new DmaWorkerArgs;
+	args->rq = dma_queue;
+	args->channel = i;
 	CHECK_PTHREAD( pthread_create(&worker_threads[i], 0, 
-				      dma_worker_thread_loop, dma_queue) );
+				      dma_worker_thread_loop, args) );
 	CHECK_PTHREAD( pthread_attr_destroy(&attr) );
 #ifdef DEADLOCK_TRACE
         get_runtime()->add_thread(&worker_threads[i]);
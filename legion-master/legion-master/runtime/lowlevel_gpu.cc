@@ -1586,7 +1586,7 @@ namespace LegionRuntime {
 	gpu(_gpu)
     {
       base = (char *)(gpu->get_fbmem_gpu_base());
-      free_blocks[0] = size;
+      allocator.add_range(0, size);
     }
 
     GPUFBMemory::~GPUFBMemory(void) {}
@@ -1615,7 +1615,7 @@ namespace LegionRuntime {
 	gpu(_gpu)
     {
       cpu_base = (char *)(gpu->get_zcmem_cpu_base());
-      free_blocks[0] = size;
+      allocator.add_range(0, size);
     }
 
     GPUZCMemory::~GPUZCMemory(void) {}
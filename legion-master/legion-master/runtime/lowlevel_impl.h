@@ -57,6 +57,15 @@ GASNETT_THREADKEY_DECLARE(cur_thread);
 #include <map>
 #include <aio.h>
 
+// x86-64 Linux switches user-level task contexts with a few instructions,
+//  everything else (or -DUSE_UCONTEXT) falls back to swapcontext, which
+//  also saves the signal mask and costs a system call per switch
+#if defined(__x86_64__) && defined(__linux__) && !defined(USE_UCONTEXT)
+#define FAST_CONTEXT_SWITCH
+#else
+#include <ucontext.h>
+#endif
+
 #if __cplusplus >= 201103L
 #define typeof decltype
 #endif
@@ -692,16 +701,43 @@ namespace LegionRuntime {
 
       void check_for_catchup(Event::gen_t implied_trigger_gen);
 
+      // local waiters live on a lock-free stack - each entry remembers the
+      //  generation it is waiting for, so whoever pops the stack can tell
+      //  which waiters are ready and which belong back on it
+      struct WaiterNode {
+      public:
+	EventWaiter *waiter;
+	Event::gen_t needed_gen;
+	WaiterNode *next;
+
+	// nodes come from a per-thread cache
+	static void *operator new(size_t bytes);
+	static void operator delete(void *ptr);
+      };
+
+    protected:
+      // moves the generation forward, returns false if it was already there
+      bool advance_generation(Event::gen_t new_gen, Event::gen_t& prev_gen);
+
+      // pushes the chain first..last and then makes sure none of its entries
+      //  missed a trigger that happened in the mean time
+      void push_waiters(WaiterNode *first, WaiterNode *last, Event::gen_t min_gen);
+
+      // pops every local waiter, notifies the ones whose generation has
+      //  triggered and pushes back the rest
+      void notify_waiters(void);
+
     public: //protected:
       ID me;
       unsigned owner;
-      Event::gen_t generation, gen_subscribed;
+      volatile Event::gen_t generation;
+      Event::gen_t gen_subscribed;
       GenEventImpl *next_free;
 
-      GASNetHSL mutex; // controls which local thread has access to internal data (not runtime-visible event)
+      GASNetHSL mutex; // guards remote_waiters and gen_subscribed (not runtime-visible event)
 
       NodeSet remote_waiters;
-      std::vector<EventWaiter *> local_waiters; // set of local threads that are waiting on event
+      WaiterNode * volatile local_waiters; // local threads that are waiting on event
     };
 
     class BarrierImpl : public Event::Impl {
@@ -773,6 +809,78 @@ namespace LegionRuntime {
 	
     };
 
+    // Compressed representation of an ElementMask: the elements are cut into
+    //  chunks of 2^16 and each chunk with anything enabled holds either a list
+    //  of runs or a dense bitmap, whichever is smaller (full chunks need
+    //  neither), so memory and set operations scale with the number of runs
+    //  rather than the size of the index space
+    class ElementMaskChunks {
+    public:
+      static const int CHUNK_SHIFT = 16;
+      static const int CHUNK_SIZE = (1 << CHUNK_SHIFT);
+      static const int CHUNK_WORDS = (CHUNK_SIZE >> 6);
+      // a run takes 4 bytes, so past this many the bitmap is smaller
+      static const size_t MAX_RUNS = (CHUNK_WORDS * 2);
+
+      enum SetOp { OP_OR, OP_AND, OP_SUB };
+
+      // inclusive bounds, relative to the start of the chunk
+      struct Run {
+	unsigned short first, last;
+      };
+
+      struct Chunk {
+      public:
+	enum Kind { CHUNK_RUNS, CHUNK_BITS, CHUNK_FULL };
+
+	Chunk(Kind _kind);
+	Chunk(const Chunk& copy_from);
+	~Chunk(void);
+
+	Kind kind;
+	int count;
+	std::vector<Run> runs;
+	uint64_t *bits;
+      };
+
+      ElementMaskChunks(int _num_elements);
+      ElementMaskChunks(const ElementMaskChunks& copy_from);
+      ~ElementMaskChunks(void);
+
+      void set_range(int start, int count, bool value);
+      bool is_set(int pos) const;
+
+      size_t pop_count(void) const;
+      bool empty(void) const;
+      bool equals(const ElementMaskChunks& other) const;
+      bool overlaps(const ElementMaskChunks& other) const;
+
+      // this = this <op> other
+      void apply(SetOp op, const ElementMaskChunks& other);
+
+      // first element at or after 'pos' with the given value, or
+      //  num_elements if there is none
+      int find_first(int pos, bool value) const;
+      int find_last_enabled(void) const;
+
+      // the maximal run of 'polarity' elements starting at or after 'pos'
+      bool next_run(int pos, bool polarity, int& position, int& length) const;
+
+      // conversion from/to the dense layout of ElementMaskImpl::bits
+      void to_dense(uint64_t *bits) const;
+      void from_dense(const uint64_t *bits);
+
+    protected:
+      int chunk_length(int idx) const;
+      const uint64_t *chunk_bits(int idx, uint64_t *scratch) const;
+      void make_bits(int idx);
+      // picks the representation that fits the chunk's contents
+      void normalize(int idx, bool try_runs);
+
+      int num_elements;
+      std::vector<Chunk *> chunks; // NULL for chunks with nothing enabled
+    };
+
     class Reservation::Impl {
     public:
       Impl(void);
@@ -958,6 +1066,20 @@ namespace LegionRuntime {
 			      Event start_event, Event finish_event,
                               int priority) = 0;
 
+      // processors that can steal work join the groups they're members of -
+      //  a group made only of such processors gives each task to one member
+      //  and lets the others steal it instead of handing everybody a copy
+      virtual bool can_steal(void) const { return false; }
+
+      virtual void join_group(ProcessorGroup *group, int index) { assert(0); }
+
+      virtual void enqueue_group_task(ProcessorGroup *group, int index,
+				      Task *task) { assert(0); }
+
+      // wake up an idle thread to look for work to steal, returns false if
+      //  there was none
+      virtual bool wake_thief(void) { return false; }
+
       void finished(void)
       {
 	if(run_counter)
@@ -970,8 +1092,121 @@ namespace LegionRuntime {
       Atomic<int> *run_counter;
     }; 
 
-    // generic way of keeping a prioritized queue of stuff to do
-    // Needs to be protected by owner lock
+    // priorities are kept in a fixed set of bands, anything outside the
+    //  range shares the lowest or highest band
+#define JOB_QUEUE_MIN_PRIORITY  -3
+#define JOB_QUEUE_NUM_BANDS      8
+
+    // one band of a JobQueue: a Chase-Lev style circular array that grows
+    //  as needed - pushes happen at the bottom, serialized by the owner's
+    //  lock, while the owner and any number of thieves take from the top
+    //  with a compare-and-swap, so jobs come out in FIFO order
+    template <typename JOBTYPE>
+    class WorkDeque {
+    public:
+      WorkDeque(void);
+      ~WorkDeque(void);
+
+      bool empty(void) const { return top >= bottom; }
+
+      // owner only
+      void push(JOBTYPE *job);
+
+      // anybody, returns 0 if the deque is empty
+      JOBTYPE *take(void);
+
+    protected:
+      struct Array {
+	long mask;        // size - 1, size is a power of two
+	JOBTYPE *slots[1];
+      };
+
+      static Array *alloc_array(long size);
+
+      void grow(void);
+
+      volatile long top, bottom;
+      Array * volatile array;
+      // arrays that have been replaced - a thief may still be reading one,
+      //  so they stay around until the deque goes away
+      std::vector<Array *> retired;
+    };
+
+    template <typename JOBTYPE>
+    WorkDeque<JOBTYPE>::WorkDeque(void)
+      : top(0), bottom(0), array(0)
+    {
+    }
+
+    template <typename JOBTYPE>
+    WorkDeque<JOBTYPE>::~WorkDeque(void)
+    {
+      free(array);
+      for(typename std::vector<Array *>::iterator it = retired.begin();
+	  it != retired.end();
+	  it++)
+	free(*it);
+    }
+
+    template <typename JOBTYPE>
+    /*static*/ typename WorkDeque<JOBTYPE>::Array *WorkDeque<JOBTYPE>::alloc_array(long size)
+    {
+      Array *a = (Array *)malloc(sizeof(Array) + (size - 1) * sizeof(JOBTYPE *));
+      assert(a != 0);
+      a->mask = size - 1;
+      return a;
+    }
+
+    template <typename JOBTYPE>
+    void WorkDeque<JOBTYPE>::grow(void)
+    {
+      Array *old_array = array;
+      Array *new_array = alloc_array(old_array ? 2 * (old_array->mask + 1) : 64);
+      for(long i = top; i < bottom; i++)
+	new_array->slots[i & new_array->mask] = old_array->slots[i & old_array->mask];
+      // the copies have to be visible before the new array is
+      __sync_synchronize();
+      array = new_array;
+      if(old_array)
+	retired.push_back(old_array);
+    }
+
+    template <typename JOBTYPE>
+    void WorkDeque<JOBTYPE>::push(JOBTYPE *job)
+    {
+      long b = bottom;
+      // leave one slot free so a thief never reads a slot being refilled
+      if(!array || ((b - top) >= array->mask))
+	grow();
+      array->slots[b & array->mask] = job;
+      // publish the job before the new bottom
+      __sync_synchronize();
+      bottom = b + 1;
+    }
+
+    template <typename JOBTYPE>
+    JOBTYPE *WorkDeque<JOBTYPE>::take(void)
+    {
+      while(true) {
+	long t = top;
+	__sync_synchronize();
+	long b = bottom;
+	if(t >= b) return 0;
+
+	// the array has to be read after the bottom that covers slot 't' - a
+	//  replaced array still holds that slot if nobody has taken it yet
+	__sync_synchronize();
+	Array *a = array;
+	JOBTYPE *job = a->slots[t & a->mask];
+	if(__sync_bool_compare_and_swap(&top, t, t + 1))
+	  return job;
+	// lost a race with another taker - try again
+      }
+    }
+
+    // generic way of keeping a prioritized queue of stuff to do - inserts
+    //  need to be protected by the owner lock, but pop is lock-free, so
+    //  other processors can steal from the queue without taking that lock
     template <typename JOBTYPE>
     class JobQueue {
     public:
@@ -979,20 +1214,18 @@ namespace LegionRuntime {
 
       bool empty(void) const;
 
+      // the band of the highest priority job, or -1 if there are none
+      //  (only a hint if others can pop from the queue concurrently)
+      int top_band(void) const;
+
       void insert(JOBTYPE *job, int priority);
 
       JOBTYPE *pop(void);
 
-      struct WaitingJob : public EventWaiter {
-	JOBTYPE *job;
-	int priority;
-	JobQueue *queue;
-
-	virtual bool event_triggered(void);
-	virtual void print_info(FILE *f);
-      };
+    protected:
+      static int band_of(int priority);
 
-      std::map<int, std::deque<JOBTYPE*> > ready;
+      WorkDeque<JOBTYPE> bands[JOB_QUEUE_NUM_BANDS];
     };
 
     template <typename JOBTYPE>
@@ -1000,38 +1233,46 @@ namespace LegionRuntime {
     {
     }
 
+    template <typename JOBTYPE>
+    /*static*/ int JobQueue<JOBTYPE>::band_of(int priority)
+    {
+      int band = priority - JOB_QUEUE_MIN_PRIORITY;
+      if(band < 0) return 0;
+      if(band >= JOB_QUEUE_NUM_BANDS) return JOB_QUEUE_NUM_BANDS - 1;
+      return band;
+    }
+
     template<typename JOBTYPES>
     bool JobQueue<JOBTYPES>::empty(void) const
     {
-      return ready.empty();
+      for(int i = 0; i < JOB_QUEUE_NUM_BANDS; i++)
+	if(!bands[i].empty()) return false;
+      return true;
+    }
+
+    template <typename JOBTYPE>
+    int JobQueue<JOBTYPE>::top_band(void) const
+    {
+      for(int i = JOB_QUEUE_NUM_BANDS - 1; i >= 0; i--)
+	if(!bands[i].empty()) return i;
+      return -1;
     }
 
     template <typename JOBTYPE>
     void JobQueue<JOBTYPE>::insert(JOBTYPE *job, int priority)
     {
-      std::deque<JOBTYPE *>& dq = ready[-priority];
-      dq.push_back(job);
+      bands[band_of(priority)].push(job);
     }
 
     template <typename JOBTYPE>
     JOBTYPE *JobQueue<JOBTYPE>::pop(void)
     {
-      if(ready.empty()) return 0;
-
-      // get the sublist with the highest priority (remember, we negate before lookup)
-      typename std::map<int, std::deque<JOBTYPE *> >::iterator it = ready.begin();
-
-      // any deque that's present better be non-empty
-      assert(!(it->second.empty()));
-      JOBTYPE *job = it->second.front();
-      it->second.pop_front();
-
-      // if the list is now empty, remove it and update the new max priority
-      if(it->second.empty()) {
-	ready.erase(it);
+      // highest priority band first
+      for(int i = JOB_QUEUE_NUM_BANDS - 1; i >= 0; i--) {
+	JOBTYPE *job = bands[i].take();
+	if(job) return job;
       }
-
-      return job;
+      return 0;
     }
 
     class ProcessorGroup : public Processor::Impl {
@@ -1058,6 +1299,9 @@ namespace LegionRuntime {
 			      Event start_event, Event finish_event,
                               int priority);
 
+      // wakes up a member other than 'index' to steal a task
+      void wake_thief_for(int index);
+
     public: //protected:
       bool members_valid;
       bool members_requested;
@@ -1065,12 +1309,77 @@ namespace LegionRuntime {
       Reservation::Impl lock;
       ProcessorGroup *next_free;
 
+      // with work stealing, each member has its own queue of the group's
+      //  tasks, which only that member inserts into
+      bool stealing;
+      std::vector<JobQueue<Task> *> member_queues;
+      unsigned next_member;
+
       void request_group_members(void);
     };
     
+    class PreemptableThread;
+
+    // a user-level context with its own pooled stack that a preemptable
+    //  thread runs tasks on (when enabled with -ll:uthreads 1) - a task that
+    //  waits on an event parks its context instead of putting its kernel
+    //  thread to sleep or running the next task on top of it, and the
+    //  context is resumed (possibly by another thread of the same processor)
+    //  once the event triggers
+    class TaskContext : public EventWaiter {
+    public:
+      enum State { CTX_IDLE, CTX_RUNNING, CTX_PARKING, CTX_PARKED, CTX_DONE };
+
+      struct Registers {
+#ifdef FAST_CONTEXT_SWITCH
+	void *sp;
+#else
+	ucontext_t uc;
+#endif
+      };
+
+      typedef void (*EntryFn)(TaskContext *ctx);
+
+      // contexts are never freed, a finished context goes back to the pool
+      //  along with its stack for the next task to use
+      static TaskContext *acquire(EntryFn entry);
+      static void release(TaskContext *ctx);
+
+      // saves the current registers in 'from' and continues from 'to'
+      static void switch_context(Registers *from, Registers *to);
+
+      virtual bool event_triggered(void);
+      virtual void print_info(FILE *f);
+
+      // first function run on a fresh context, never returns
+      static void context_start(TaskContext *ctx);
+
+      static bool enabled;
+      static size_t stack_size;
+
+      State state;
+      Task *task;
+      Processor actual_proc;
+      PreemptableThread *host; // thread the context is running on (or last ran on)
+      Event wait_for;          // valid while the context is parked
+      Registers regs;
+
+    protected:
+      TaskContext(EntryFn _entry);
+      virtual ~TaskContext(void);
+
+      EntryFn entry;
+      char *stack_base;
+      TaskContext *next_free;
+
+      static gasnet_hsl_t pool_mutex;
+      static TaskContext *free_list;
+    };
+
     class PreemptableThread {
     public:
       PreemptableThread(void) 
+	: cur_context(0), spare_context(0)
       {
 #ifdef EVENT_GRAPH_TRACE
         enclosing_stack.push_back(Event::NO_EVENT);
@@ -1084,6 +1393,10 @@ namespace LegionRuntime {
 
       virtual Processor get_processor(void) const = 0;
 
+      // a parked context's event has triggered, the processor has to
+      //  queue it up to be resumed
+      virtual void context_resumable(TaskContext *ctx) = 0;
+
 #ifdef EVENT_GRAPH_TRACE
       inline Event find_enclosing(void) 
       { assert(!enclosing_stack.empty()); return enclosing_stack.back(); }
@@ -1102,7 +1415,24 @@ namespace LegionRuntime {
 
       void run_task(Task *task, Processor actual_proc = Processor::NO_PROC);
 
+      // runs a task on a pooled context, returns once the task is done or
+      //  has parked its context
+      void run_in_context(Task *task, Processor actual_proc);
+
+      // continues a parked context whose event has triggered
+      void resume_context(TaskContext *ctx);
+
+      // called from the context when its task waits on an event - returns
+      //  once the context has been resumed, possibly on another thread
+      void park_context(Event wait_for);
+
+      // runs the tasks handed to a context
+      static void context_main(TaskContext *ctx);
+
       pthread_t thread;
+      TaskContext *cur_context;   // context running on this thread, if any
+      TaskContext *spare_context; // finished context kept for the next task
+      TaskContext::Registers host_regs;
 
 #ifdef EVENT_GRAPH_TRACE
       std::deque<Event> enclosing_stack; 
@@ -1133,6 +1463,8 @@ namespace LegionRuntime {
 
       void wait_for_shutdown(void);
 
+      void context_resumable(TaskContext *ctx);
+
       class UtilityThread;
 
     protected:
@@ -1151,6 +1483,63 @@ namespace LegionRuntime {
       std::set<UtilityThread *> threads;
 
       JobQueue<Task> task_queue;
+      std::list<TaskContext *> resumable_contexts;
+    };
+
+    // hands out ranges of a memory's address space - free ranges are kept
+    //  both by offset (for coalescing) and by size, in exact-size bins for
+    //  the common small sizes and a size-ordered tree for everything else,
+    //  so best-fit allocation and coalescing frees are O(log n) in the number
+    //  of free fragments
+    // all methods except defer_free need to be called with the owning
+    //  memory's lock held
+    class RangeAllocator {
+    public:
+      static const size_t NUM_SMALL_CLASSES = 32;
+
+      RangeAllocator(size_t _granule);
+
+      ~RangeAllocator(void);
+
+      // makes a range available, coalescing it with any free neighbors
+      void add_range(off_t offset, size_t size);
+
+      // returns -1 if no free range is large enough
+      off_t allocate(size_t size);
+
+      // frees can be queued without the memory's lock, they are applied
+      //  the next time the allocator is used
+      void defer_free(off_t offset, size_t size);
+      void apply_deferred_frees(void);
+
+      struct Stats {
+	size_t total_free;
+	size_t largest_free;
+	size_t free_ranges;
+	// 0 when all the free space is in one range, approaching 1 as it
+	//  is spread over more and smaller ranges
+	double fragmentation;
+      };
+
+      void get_stats(Stats& stats) const;
+
+    protected:
+      int size_class(off_t size) const;
+      void insert_range(off_t offset, off_t size);
+      void remove_range(std::map<off_t, off_t>::iterator it);
+
+      struct DeferredFree {
+	off_t offset;
+	size_t size;
+	DeferredFree *next;
+      };
+
+      size_t granule;
+      size_t total_free;
+      std::map<off_t, off_t> free_blocks; // offset -> size
+      std::set<off_t> small_bins[NUM_SMALL_CLASSES];
+      std::set<std::pair<off_t, off_t> > large_blocks; // (size, offset)
+      DeferredFree * volatile deferred_frees;
     };
 
     class Memory::Impl {
@@ -1242,7 +1631,7 @@ namespace LegionRuntime {
       Kind lowlevel_kind;
       gasnet_hsl_t mutex; // protection for resizing vectors
       std::vector<RegionInstance::Impl *> instances;
-      std::map<off_t, off_t> free_blocks;
+      RangeAllocator allocator;
 #ifdef REALM_PROFILE_MEMORY_USAGE
       size_t usage, peak_usage, peak_footprint;
 #endif
@@ -1302,7 +1691,13 @@ namespace LegionRuntime {
     public:
       static const size_t ALIGNMENT = 256;
 
-      DiskMemory(Memory _me, size_t _size, std::string _file);
+      // how many requests the I/O thread keeps in flight at once
+      static const size_t MAX_OUTSTANDING_IO = 64;
+
+      // if 'use_mmap' is set the file is also mapped, so that
+      //  get_direct_ptr can hand out pointers into it
+      DiskMemory(Memory _me, size_t _size, std::string _file,
+		 bool _use_mmap = false);
 
       virtual ~DiskMemory(void);
 
@@ -1333,9 +1728,55 @@ namespace LegionRuntime {
       virtual void *get_direct_ptr(off_t offset, size_t size);
       virtual int get_home_node(off_t offset, size_t size);
 
+      // one contiguous piece of a transfer between the file and memory
+      struct IOSpan {
+	off_t file_offset;
+	char *mem_ptr;
+	size_t bytes;
+      };
+
+      // adds a span to a batch, merging it into the last one if both the
+      //  file and the memory sides continue where that one ends
+      static void add_span(std::vector<IOSpan>& spans, off_t file_offset,
+			   char *mem_ptr, size_t bytes);
+
+      // hands a batch of reads (or writes) to the I/O thread - spans that
+      //  are adjacent once sorted by file offset are coalesced, and 'done'
+      //  is triggered when the last of them completes
+      void submit_batch(bool is_write, std::vector<IOSpan>& spans, Event done);
+
+      // performs a batch right away, for callers with no event to trigger
+      void perform_batch(bool is_write, std::vector<IOSpan>& spans);
+
+    protected:
+      struct IOBatch {
+	int pending;
+	Event done;
+      };
+
+      struct IORequest {
+	aiocb cb;
+	bool is_write;
+	IOBatch *batch;
+      };
+
+      static void coalesce_spans(std::vector<IOSpan>& spans);
+
+      static void *io_thread_entry(void *data);
+
+      void io_thread_main(void);
+
     public:
       int fd; // file descriptor
       std::string file;  // file name
+      char *mmap_base; // base of the mapping of the file, if any
+
+    protected:
+      gasnet_hsl_t io_mutex;
+      gasnett_cond_t io_condvar;
+      std::deque<IORequest *> io_queue; // submitted, not yet issued
+      bool io_shutdown;
+      pthread_t io_thread;
     };
 
     class MetadataBase {
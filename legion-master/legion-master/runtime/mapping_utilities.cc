@@ -613,6 +613,13 @@ namespace LegionRuntime {
           max_samples = max;
       }
       
+      //------------------------------------------------------------------------
+      void MappingProfiler::ignore_processor_kind(Processor::Kind kind)
+      //------------------------------------------------------------------------
+      {
+        ignored_kinds.insert(kind);
+      }
+      
       //------------------------------------------------------------------------
       bool MappingProfiler::profiling_complete(const Task *task) const
       //------------------------------------------------------------------------
@@ -623,7 +630,7 @@ namespace LegionRuntime {
         for (VariantMap::const_iterator it = finder->second.begin();
               it != finder->second.end(); it++)
         {
-          if (it->second.execution_times.size() < max_samples)
+          if (it->second.execution_times.size() < needed_samples)
             return false;
         }
         return true;
@@ -671,16 +678,43 @@ namespace LegionRuntime {
       {
         TaskMap::const_iterator finder = task_profiles.find(task->task_id);
         if (finder == task_profiles.end())
-          return task->variants->get_all_variants().begin()->second.proc_kind;
+        {
+          const std::map<VariantID,TaskVariantCollection::Variant>& variants =
+            task->variants->get_all_variants();
+          for (std::map<VariantID,TaskVariantCollection::Variant>::
+               const_iterator it = variants.begin(); it != variants.end(); it++)
+          {
+            if (ignored_kinds.find(it->second.proc_kind) == 
+                ignored_kinds.end())
+              return it->second.proc_kind;
+          }
+          return variants.begin()->second.proc_kind;
+        }
         for (VariantMap::const_iterator it = finder->second.begin();
               it != finder->second.end(); it++)
         {
-          if (it->second.execution_times.size() < max_samples)
+          if (it->second.execution_times.size() < needed_samples)
             return it->first;
         }
         return best_processor_kind(task);
       }
 
+      //------------------------------------------------------------------------
+      long long MappingProfiler::average_execution_time(const Task *task,
+                                                  Processor::Kind kind) const
+      //------------------------------------------------------------------------
+      {
+        TaskMap::const_iterator finder = task_profiles.find(task->task_id);
+        if (finder == task_profiles.end())
+          return -1;
+        VariantMap::const_iterator var_finder = finder->second.find(kind);
+        if ((var_finder == finder->second.end()) ||
+            var_finder->second.execution_times.empty())
+          return -1;
+        return (var_finder->second.total_time / 
+                var_finder->second.execution_times.size());
+      }
+
       //------------------------------------------------------------------------
       void MappingProfiler::update_profiling_info(const Task *task, 
                                                   Processor target, 
@@ -688,6 +722,8 @@ namespace LegionRuntime {
                                         const Mapper::ExecutionProfile &profile)
       //------------------------------------------------------------------------
       {
+        if (ignored_kinds.find(kind) != ignored_kinds.end())
+          return;
         TaskMap::iterator finder = task_profiles.find(task->task_id);
         if (finder == task_profiles.end())
         {
@@ -696,6 +732,9 @@ namespace LegionRuntime {
           for (std::map<VariantID,TaskVariantCollection::Variant>::
                const_iterator it = variants.begin(); it != variants.end(); it++)
           {
+            if (ignored_kinds.find(it->second.proc_kind) != 
+                ignored_kinds.end())
+              continue;
             task_profiles[task->task_id][it->second.proc_kind] = 
               VariantProfile();
           }
@@ -196,6 +196,12 @@ namespace LegionRuntime {
          * around for any variant. By default it is 32.
          */
         void set_max_profiling_samples(unsigned max_samples);
+        /**
+         * Ignore variants of the given processor kind when profiling.
+         * This is useful for variants that have been registered
+         * for processor kinds that do not exist in the machine.
+         */
+        void ignore_processor_kind(Processor::Kind kind);
         /**
          * Check to see if profiling is complete for all the 
          * variants of this task.
@@ -211,6 +217,13 @@ namespace LegionRuntime {
          * profiling.  If all are complete the best variant will be returned.
          */
         Processor::Kind next_processor_kind(const Task *task) const;
+        /**
+         * Return the average execution time in microseconds of the
+         * variant of this task for the given processor kind.  Returns
+         * a negative value if there are no samples for the variant.
+         */
+        long long average_execution_time(const Task *task, 
+                                         Processor::Kind kind) const;
         /**
          * Update the profiling kind for the variants of the task on 
          * the given processor kind.
@@ -231,6 +244,7 @@ namespace LegionRuntime {
         typedef std::map<Processor::TaskFuncID,VariantMap> TaskMap;
         unsigned needed_samples;
         unsigned max_samples; 
+        std::set<Processor::Kind> ignored_kinds;
         TaskMap task_profiles;
       };
 
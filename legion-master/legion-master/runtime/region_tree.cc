@@ -24,6 +24,7 @@
 #include "legion_profiling.h"
 #include "interval_tree.h"
 #include "rectangle_set.h"
+#include "spatial_index.h"
 
 namespace LegionRuntime {
   namespace HighLevel {
@@ -769,7 +770,8 @@ namespace LegionRuntime {
 #endif
       // Finally do the traversal, note that we don't need to hold the
       // context lock since the runtime guarantees that all dependence
-      // analysis for a single context are performed in order
+      // analysis for a single region tree in a context are performed
+      // in order (see ProcessorManager::add_to_dependence_queue)
       parent_node->register_logical_node(ctx.get_id(), user, path, trace_info);
       // Now check to see if we have any simultaneous restrictions
       // we need to check
@@ -4581,6 +4583,25 @@ namespace LegionRuntime {
         std::set<Domain> &result_domains, bool compute)
     //--------------------------------------------------------------------------
     {
+      // For big sets of structured domains use a spatial index
+      // rather than testing every pair of domains
+      if ((left.size() * right.size()) >= SPATIAL_INDEX_THRESHOLD)
+      {
+        switch (left.begin()->get_dim())
+        {
+          case 1:
+            return compute_indexed_intersections<1>(left, right,
+                                                    result_domains, compute);
+          case 2:
+            return compute_indexed_intersections<2>(left, right,
+                                                    result_domains, compute);
+          case 3:
+            return compute_indexed_intersections<3>(left, right,
+                                                    result_domains, compute);
+          default:
+            break; // unstructured index spaces do it the slow way
+        }
+      }
       for (std::set<Domain>::const_iterator lit = left.begin();
             lit != left.end(); lit++)
       {
@@ -4852,30 +4873,8 @@ namespace LegionRuntime {
             }
           case 3:
             {
-              // TODO: Improve this terrible approximation
-              dominates = true;
-              for (std::set<Domain>::const_iterator rit = right_set.begin();
-                    (rit != right_set.end()) && dominates; rit++)
-              {
-                Rect<3> right_rect = rit->get_rect<3>();
-                bool has_dominator = false;
-                // See if any of the rectangles on the left dominate it
-                for (std::set<Domain>::const_iterator lit = left_set.begin();
-                      lit != left_set.end(); lit++)
-                {
-                  Rect<3> left_rect = lit->get_rect<3>();
-                  if (right_rect.intersection(left_rect) == right_rect)
-                  {
-                    has_dominator = true;
-                    break;
-                  }
-                }
-                if (!has_dominator)
-                {
-                  dominates = false;
-                  break;
-                }
-              }
+              // Exact test against the union of the left rectangles
+              dominates = compute_indexed_dominates<3>(left_set, right_set);
               break;
             }
           default:
@@ -4885,6 +4884,137 @@ namespace LegionRuntime {
       return dominates;
     }
 
+    //--------------------------------------------------------------------------
+    /*static*/ bool IndexTreeNode::find_overlapping_colors(
+        const std::map<Color,Domain> &coloring, Color &first, Color &second)
+    //--------------------------------------------------------------------------
+    {
+      std::map<Color,std::set<Domain> > multi_coloring;
+      for (std::map<Color,Domain>::const_iterator it = coloring.begin();
+            it != coloring.end(); it++)
+        multi_coloring[it->first].insert(it->second);
+      return find_overlapping_colors(multi_coloring, first, second);
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ bool IndexTreeNode::find_overlapping_colors(
+                        const std::map<Color,std::set<Domain> > &coloring,
+                        Color &first, Color &second)
+    //--------------------------------------------------------------------------
+    {
+      if (coloring.empty())
+        return false;
+      int dim = -1;
+      for (std::map<Color,std::set<Domain> >::const_iterator it = 
+            coloring.begin(); (dim < 0) && (it != coloring.end()); it++)
+      {
+        if (!it->second.empty())
+          dim = it->second.begin()->get_dim();
+      }
+      switch (dim)
+      {
+        case -1:
+          return false;
+        case 1:
+          return find_indexed_overlaps<1>(coloring, first, second);
+        case 2:
+          return find_indexed_overlaps<2>(coloring, first, second);
+        case 3:
+          return find_indexed_overlaps<3>(coloring, first, second);
+        default:
+          assert(false); // should never get here
+      }
+      return false;
+    }
+
+    //--------------------------------------------------------------------------
+    template<unsigned DIM>
+    /*static*/ bool IndexTreeNode::compute_indexed_intersections(
+        const std::set<Domain> &left, const std::set<Domain> &right,
+        std::set<Domain> &result_domains, bool compute)
+    //--------------------------------------------------------------------------
+    {
+      // Index the bigger set and probe it with the smaller one
+      const bool index_left = (left.size() > right.size());
+      const std::set<Domain> &indexed = index_left ? left : right;
+      const std::set<Domain> &probes = index_left ? right : left;
+      SpatialIndex<DIM> index;
+      for (std::set<Domain>::const_iterator it = indexed.begin();
+            it != indexed.end(); it++)
+      {
+#ifdef DEBUG_HIGH_LEVEL
+        assert(it->get_dim() == int(DIM));
+#endif
+        index.add_rect(it->get_rect<DIM>());
+      }
+      std::vector<unsigned> overlapping;
+      for (std::set<Domain>::const_iterator it = probes.begin();
+            it != probes.end(); it++)
+      {
+#ifdef DEBUG_HIGH_LEVEL
+        assert(it->get_dim() == int(DIM));
+#endif
+        Rect<DIM> probe = it->get_rect<DIM>();
+        if (!compute)
+        {
+          if (index.intersects(probe))
+            return true;
+          continue;
+        }
+        overlapping.clear();
+        index.find_intersections(probe, overlapping);
+        for (std::vector<unsigned>::const_iterator oit = overlapping.begin();
+              oit != overlapping.end(); oit++)
+        {
+          Rect<DIM> temp = probe.intersection(index.get_entry(*oit).rect);
+          result_domains.insert(Domain::from_rect<DIM>(temp));
+        }
+      }
+      return !result_domains.empty();
+    }
+
+    //--------------------------------------------------------------------------
+    template<unsigned DIM>
+    /*static*/ bool IndexTreeNode::compute_indexed_dominates(
+            const std::set<Domain> &left_set, const std::set<Domain> &right_set)
+    //--------------------------------------------------------------------------
+    {
+      SpatialIndex<DIM> index;
+      for (std::set<Domain>::const_iterator it = left_set.begin();
+            it != left_set.end(); it++)
+        index.add_rect(it->get_rect<DIM>());
+      for (std::set<Domain>::const_iterator it = right_set.begin();
+            it != right_set.end(); it++)
+      {
+        if (!index.covers(it->get_rect<DIM>()))
+          return false;
+      }
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    template<unsigned DIM>
+    /*static*/ bool IndexTreeNode::find_indexed_overlaps(
+                        const std::map<Color,std::set<Domain> > &coloring,
+                        Color &first, Color &second)
+    //--------------------------------------------------------------------------
+    {
+      SpatialIndex<DIM> index;
+      for (std::map<Color,std::set<Domain> >::const_iterator cit = 
+            coloring.begin(); cit != coloring.end(); cit++)
+      {
+        for (std::set<Domain>::const_iterator it = cit->second.begin();
+              it != cit->second.end(); it++)
+        {
+#ifdef DEBUG_HIGH_LEVEL
+          assert(it->get_dim() == int(DIM));
+#endif
+          index.add_rect(it->get_rect<DIM>(), cit->first);
+        }
+      }
+      return index.has_overlaps(first, second);
+    }
+
 
     /////////////////////////////////////////////////////////////
     // Index Space Node 
@@ -5954,7 +6084,7 @@ namespace LegionRuntime {
           if (compute)
             intersections[other] = IntersectInfo(intersect);
           else
-            intersections[other] = IntersectInfo(false/*result*/);
+            intersections[other] = IntersectInfo(true/*result*/);
         }
       }
       else
@@ -8591,10 +8721,33 @@ namespace LegionRuntime {
         // If we're restricted we can't make instances, so just keep going
         if (info.req.restricted)
           continue;
+        // If we are allowed to spill instances out of this memory
+        // then make room if we are over budget or out of space
+        const bool can_spill = (Runtime::spill_threshold > 0) &&
+                               (mit->kind() != Memory::DISK_MEM);
+        size_t needed_size = 0;
+        if (can_spill)
+        {
+          for (std::set<FieldID>::const_iterator it = new_fields.begin();
+                it != new_fields.end(); it++)
+            needed_size += node->column_source->get_field_size(*it);
+          needed_size *= node->get_domain().get_volume();
+          if (node->context->runtime->is_over_budget(*mit, needed_size))
+            spill_instances(node, *mit, needed_size, valid_instances);
+        }
         // If it didn't find a valid instance, try to make one
         chosen_inst = node->create_instance(*mit, new_fields, 
                                             blocking_factor,
                                             info.mappable->get_depth());
+        // If we failed, spill instances and try one more time, this
+        // will only succeed if the spilled instances could be collected
+        // right away, otherwise the memory will be available by the
+        // time the mapper tries again
+        if ((chosen_inst == NULL) && can_spill &&
+            spill_instances(node, *mit, needed_size, valid_instances))
+          chosen_inst = node->create_instance(*mit, new_fields,
+                                              blocking_factor,
+                                              info.mappable->get_depth());
         if (chosen_inst != NULL)
         {
           // We successfully made an instance
@@ -8605,7 +8758,12 @@ namespace LegionRuntime {
       // Save our chosen instance if it exists in the mapping
       // reference and then return if we have an instance
       if (chosen_inst != NULL)
+      {
         result = MappingRef(chosen_inst, needed_fields);
+        // Record the use for picking instances to spill
+        if (Runtime::spill_threshold > 0)
+          node->context->runtime->record_instance_use(chosen_inst->manager);
+      }
       // Remove any valid references we are still holding
       // This has to go after we create the mapping reference to 
       // guarantee we hold a valid reference to the chosen instance
@@ -8713,6 +8871,197 @@ namespace LegionRuntime {
       return (chosen_inst != NULL);
     }
 
+    //--------------------------------------------------------------------------
+    bool MappingTraverser::spill_instances(RegionNode *node, Memory target,
+                                           size_t needed_size,
+             const LegionMap<InstanceView*,FieldMask>::aligned &valid_instances)
+    //--------------------------------------------------------------------------
+    {
+      Runtime *runtime = node->context->runtime;
+      Memory disk_memory = runtime->find_spill_memory(target);
+      if (!disk_memory.exists())
+        return false;
+      // Never spill the instances we are considering for this mapping
+      std::set<PhysicalManager*> exclude;
+      for (LegionMap<InstanceView*,FieldMask>::aligned::const_iterator it = 
+            valid_instances.begin(); it != valid_instances.end(); it++)
+      {
+        exclude.insert(it->first->as_materialized_view()->manager);
+      }
+      std::set<InstanceManager*> candidates;
+      runtime->find_spill_candidates(target, needed_size, 
+                                     exclude, candidates);
+      if (candidates.empty())
+        return false;
+      // Spilling has to update the state of every node in the context
+      // that has a valid view of a candidate, so start at the root
+      RegionTreeNode *root = node;
+      while (root->get_parent() != NULL)
+        root = root->get_parent();
+      InstanceSpiller spiller(info, disk_memory, candidates);
+      root->visit_node(&spiller);
+      log_region(LEVEL_DEBUG,"Spilled %d views of %ld instances in memory "
+                             IDFMT " to disk memory " IDFMT " when mapping "
+                             "region %d of mappable (ID %lld)",
+                             spiller.get_spilled_count(), 
+                             long(candidates.size()),
+                             target.id, disk_memory.id, index,
+                             info.mappable->get_unique_mappable_id());
+      return spiller.has_spilled();
+    }
+
+    /////////////////////////////////////////////////////////////
+    // InstanceSpiller
+    /////////////////////////////////////////////////////////////
+
+    //--------------------------------------------------------------------------
+    InstanceSpiller::InstanceSpiller(const MappableInfo &in, Memory disk,
+                                     const std::set<InstanceManager*> &cands)
+      : info(in), disk_memory(disk), candidates(cands), spilled_count(0)
+    //--------------------------------------------------------------------------
+    {
+    }
+
+    //--------------------------------------------------------------------------
+    InstanceSpiller::InstanceSpiller(const InstanceSpiller &rhs)
+      : info(rhs.info), disk_memory(Memory::NO_MEMORY), 
+        candidates(rhs.candidates)
+    //--------------------------------------------------------------------------
+    {
+      // should never be called
+      assert(false);
+    }
+
+    //--------------------------------------------------------------------------
+    InstanceSpiller::~InstanceSpiller(void)
+    //--------------------------------------------------------------------------
+    {
+      // Remove the references we were holding on the disk instances
+      for (std::map<InstanceManager*,MaterializedView*>::const_iterator it =
+            disk_instances.begin(); it != disk_instances.end(); it++)
+      {
+        if (it->second == NULL)
+          continue;
+        if (it->second->remove_valid_reference())
+          legion_delete(it->second);
+      }
+      disk_instances.clear();
+    }
+
+    //--------------------------------------------------------------------------
+    InstanceSpiller& InstanceSpiller::operator=(const InstanceSpiller &rhs)
+    //--------------------------------------------------------------------------
+    {
+      // should never be called
+      assert(false);
+      return *this;
+    }
+
+    //--------------------------------------------------------------------------
+    bool InstanceSpiller::visit_only_valid(void) const
+    //--------------------------------------------------------------------------
+    {
+      return false;
+    }
+
+    //--------------------------------------------------------------------------
+    bool InstanceSpiller::visit_region(RegionNode *node)
+    //--------------------------------------------------------------------------
+    {
+      PhysicalState *state = 
+        node->acquire_physical_state(info.ctx, true/*exclusive*/);
+      LegionMap<MaterializedView*,FieldMask>::aligned to_spill;
+      for (LegionMap<InstanceView*,FieldMask>::aligned::const_iterator it = 
+            state->valid_views.begin(); it != state->valid_views.end(); it++)
+      {
+        if (it->first->is_composite_view() || !it->second)
+          continue;
+        MaterializedView *view = it->first->as_materialized_view();
+        if (candidates.find(view->manager) == candidates.end())
+          continue;
+        // Leave views alone that still have updates in flight
+        if (state->pending_updates.find(view) != state->pending_updates.end())
+          continue;
+        to_spill[view] = it->second;
+      }
+      for (LegionMap<MaterializedView*,FieldMask>::aligned::const_iterator it =
+            to_spill.begin(); it != to_spill.end(); it++)
+      {
+        MaterializedView *disk_view = find_disk_view(it->first);
+        if (disk_view == NULL)
+          continue;
+        // Copy the valid data out to the disk instance, the copy
+        // will wait for any users still using the instance
+        LegionMap<InstanceView*,FieldMask>::aligned sources;
+        sources[it->first] = it->second;
+        node->issue_update_copies(info, disk_view, it->second, sources);
+        // Make the disk instance valid in place of the spilled one
+        node->update_valid_views(state, it->second, 
+                                 false/*dirty*/, disk_view);
+        state->valid_views.erase(it->first);
+        spilled_count++;
+        if (it->first->remove_valid_reference())
+          legion_delete(it->first);
+      }
+      node->release_physical_state(state);
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    bool InstanceSpiller::visit_partition(PartitionNode *node)
+    //--------------------------------------------------------------------------
+    {
+      // Partitions never have valid instance views
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    MaterializedView* InstanceSpiller::find_disk_view(MaterializedView *view)
+    //--------------------------------------------------------------------------
+    {
+      InstanceManager *manager = view->manager;
+      std::map<InstanceManager*,MaterializedView*>::const_iterator finder = 
+        disk_instances.find(manager);
+      MaterializedView *top = NULL;
+      if (finder == disk_instances.end())
+      {
+        // Make a disk instance with the same shape and fields 
+        std::set<FieldID> spill_fields;
+        manager->region_node->column_source->to_field_set(
+            manager->layout->allocated_fields, spill_fields);
+        top = manager->region_node->create_instance(disk_memory, spill_fields,
+                                                    view->get_blocking_factor(),
+                                                    manager->depth);
+        // Hold a reference until we are done, record failures too
+        // so we do not try to make the instance again
+        if (top != NULL)
+          top->add_valid_reference();
+        else
+          log_region(LEVEL_WARNING,"WARNING: Unable to spill physical "
+                                   "instance " IDFMT " to disk memory " IDFMT
+                                   " because the disk memory is full!",
+                                   manager->get_instance().id, 
+                                   disk_memory.id);
+        disk_instances[manager] = top;
+      }
+      else
+        top = finder->second;
+      if (top == NULL)
+        return NULL;
+      return find_disk_subview(top, view->logical_node);
+    }
+
+    //--------------------------------------------------------------------------
+    MaterializedView* InstanceSpiller::find_disk_subview(MaterializedView *top,
+                                                        RegionTreeNode *node)
+    //--------------------------------------------------------------------------
+    {
+      if (node == top->logical_node)
+        return top;
+      MaterializedView *parent = find_disk_subview(top, node->get_parent());
+      return parent->get_materialized_subview(node->get_color());
+    }
+
     /////////////////////////////////////////////////////////////
     // StateSender
     /////////////////////////////////////////////////////////////
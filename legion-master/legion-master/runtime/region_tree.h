@@ -848,6 +848,26 @@ namespace LegionRuntime {
                                        Domain &result, bool compute);
       static bool compute_dominates(const std::set<Domain> &left_set,
                                     const std::set<Domain> &right_set);
+      // Find a pair of colors whose domains overlap if there is one
+      static bool find_overlapping_colors(
+                                    const std::map<Color,Domain> &coloring,
+                                    Color &first, Color &second);
+      static bool find_overlapping_colors(
+                          const std::map<Color,std::set<Domain> > &coloring,
+                          Color &first, Color &second);
+    protected:
+      template<unsigned DIM>
+      static bool compute_indexed_intersections(const std::set<Domain> &left,
+                                                const std::set<Domain> &right,
+                                                std::set<Domain> &result,
+                                                bool compute);
+      template<unsigned DIM>
+      static bool compute_indexed_dominates(const std::set<Domain> &left_set,
+                                        const std::set<Domain> &right_set);
+      template<unsigned DIM>
+      static bool find_indexed_overlaps(
+                          const std::map<Color,std::set<Domain> > &coloring,
+                          Color &first, Color &second);
     public:
       const unsigned depth;
       const Color color;
@@ -3811,6 +3831,9 @@ namespace LegionRuntime {
       void traverse_node(RegionTreeNode *node);
       bool map_physical_region(RegionNode *node);
       bool map_reduction_region(RegionNode *node);
+      bool spill_instances(RegionNode *node, Memory target, 
+                           size_t needed_size,
+          const LegionMap<InstanceView*,FieldMask>::aligned &valid_instances);
     public:
       const MappableInfo &info;
       const RegionUsage usage;
@@ -3821,6 +3844,46 @@ namespace LegionRuntime {
       MappingRef result;
     }; 
 
+    /**
+     * \class InstanceSpiller
+     * A traverser of the physical region tree for a context
+     * which moves the valid data in a set of physical instances
+     * out to instances in disk memory.  The views of the spilled
+     * instances are replaced by views of the disk instances in
+     * the physical states so that the data remains valid and
+     * will be copied back by later mappings that need it.  Once
+     * the spilled instances are no longer valid anywhere they
+     * will be garbage collected and their memory reclaimed.
+     */
+    class InstanceSpiller : public NodeTraverser {
+    public:
+      InstanceSpiller(const MappableInfo &info, Memory disk,
+                      const std::set<InstanceManager*> &candidates);
+      InstanceSpiller(const InstanceSpiller &rhs);
+      ~InstanceSpiller(void);
+    public:
+      InstanceSpiller& operator=(const InstanceSpiller &rhs);
+    public:
+      virtual bool visit_only_valid(void) const;
+      virtual bool visit_region(RegionNode *node);
+      virtual bool visit_partition(PartitionNode *node);
+    public:
+      inline bool has_spilled(void) const { return (spilled_count > 0); }
+      inline unsigned get_spilled_count(void) const { return spilled_count; }
+    protected:
+      MaterializedView* find_disk_view(MaterializedView *view);
+      MaterializedView* find_disk_subview(MaterializedView *top,
+                                          RegionTreeNode *node);
+    public:
+      const MappableInfo &info;
+      const Memory disk_memory;
+      const std::set<InstanceManager*> &candidates;
+    protected:
+      // Top-level views of the disk instance made for each spilled instance
+      std::map<InstanceManager*,MaterializedView*> disk_instances;
+      unsigned spilled_count;
+    };
+
   };
 };
 
@@ -25,6 +25,7 @@
 #include "legion_spy.h"
 #include "legion_logging.h"
 #include "legion_profiling.h"
+#include <algorithm>
 #ifdef HANG_TRACE
 #include <signal.h>
 #include <execinfo.h>
@@ -1756,6 +1757,7 @@ namespace LegionRuntime {
       this->thieving_lock = Reservation::create_reservation();
       context_states.resize(DEFAULT_CONTEXTS);
       dependence_preconditions.resize(DEFAULT_CONTEXTS, Event::NO_EVENT);
+      tree_preconditions.resize(DEFAULT_CONTEXTS);
       local_scheduler_preconditions.resize(superscalar_width, Event::NO_EVENT);
     }
 
@@ -2664,6 +2666,7 @@ namespace LegionRuntime {
       SchedulerArgs sched_args;
       sched_args.hlr_id = HLR_SCHEDULER_ID;
       sched_args.proc = local_proc;
+      runtime->notify_scheduler_launch();
       utility_proc.spawn(HLR_TASK_ID, &sched_args, sizeof(sched_args));
     } 
 
@@ -2714,6 +2717,7 @@ namespace LegionRuntime {
       {
         AutoLock d_lock(dependence_lock);
         dependence_preconditions.resize(max_contexts, Event::NO_EVENT);
+        tree_preconditions.resize(max_contexts);
       }
       AutoLock q_lock(queue_lock);
       context_states.resize(max_contexts);
@@ -2914,9 +2918,56 @@ namespace LegionRuntime {
       args.manager = this;
       args.op = op;
       ContextID ctx_id = op->get_parent()->get_context_id();
+      std::set<RegionTreeID> trees;
+      if (Runtime::parallel_analysis && op->find_analysis_trees(trees))
+      {
+        // Logical state lives in the region tree nodes so operations
+        // that touch different trees can be analyzed at the same time
+        // on different utility processors.  We only need to order
+        // ourselves after the last operation in each of our trees.
+        std::set<Event> preconditions;
+        AutoLock d_lock(dependence_lock);
+        std::map<RegionTreeID,Event> &tree_events = 
+                                            tree_preconditions[ctx_id];
+        for (std::set<RegionTreeID>::const_iterator it = trees.begin();
+              it != trees.end(); it++)
+        {
+          std::map<RegionTreeID,Event>::const_iterator finder = 
+            tree_events.find(*it);
+          if (finder != tree_events.end())
+            preconditions.insert(finder->second);
+          else
+            preconditions.insert(dependence_preconditions[ctx_id]);
+        }
+        if (preconditions.empty())
+          preconditions.insert(dependence_preconditions[ctx_id]);
+        Event next = utility_proc.spawn(HLR_TASK_ID, &args, sizeof(args),
+                                        Event::merge_events(preconditions));
+        for (std::set<RegionTreeID>::const_iterator it = trees.begin();
+              it != trees.end(); it++)
+          tree_events[*it] = next;
+        // Operations without any trees still have to finish
+        // before the next operation that needs the whole context
+        if (trees.empty())
+          tree_events[0] = Event::merge_events(next, tree_events[0]);
+        return;
+      }
       AutoLock d_lock(dependence_lock);
+      Event precondition = dependence_preconditions[ctx_id];
+      // Wait for every tree that has moved on since the last time
+      if (!tree_preconditions[ctx_id].empty())
+      {
+        std::set<Event> preconditions;
+        preconditions.insert(precondition);
+        for (std::map<RegionTreeID,Event>::const_iterator it = 
+              tree_preconditions[ctx_id].begin(); it != 
+              tree_preconditions[ctx_id].end(); it++)
+          preconditions.insert(it->second);
+        tree_preconditions[ctx_id].clear();
+        precondition = Event::merge_events(preconditions);
+      }
       Event next = utility_proc.spawn(HLR_TASK_ID, &args, sizeof(args),
-                                      dependence_preconditions[ctx_id]);
+                                      precondition);
       dependence_preconditions[ctx_id] = next;
     }
 
@@ -3235,7 +3286,7 @@ namespace LegionRuntime {
     MemoryManager::MemoryManager(Memory m, Runtime *rt)
       : memory(m), capacity(m.capacity()),
         remaining_capacity(capacity), runtime(rt), 
-        manager_lock(Reservation::create_reservation())
+        manager_lock(Reservation::create_reservation()), use_clock(0)
     //--------------------------------------------------------------------------
     {
     }
@@ -3284,6 +3335,7 @@ namespace LegionRuntime {
       {
         InstanceManager *inst = manager->as_instance_manager();
         physical_instances[inst] = inst_size;
+        instance_uses[inst] = use_clock++;
       }
     }
 
@@ -3310,6 +3362,7 @@ namespace LegionRuntime {
         assert(finder != physical_instances.end());
 #endif
         remaining_capacity += finder->second;
+        instance_uses.erase(finder->first);
         physical_instances.erase(finder);
       }
     }
@@ -3435,6 +3488,71 @@ namespace LegionRuntime {
       return (capacity - remaining_capacity); 
     }
 
+    //--------------------------------------------------------------------------
+    void MemoryManager::record_instance_use(InstanceManager *manager)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock m_lock(manager_lock);
+      LegionMap<InstanceManager*,unsigned long long,
+                MEMORY_INSTANCES_ALLOC>::tracked::iterator finder = 
+                  instance_uses.find(manager);
+      // Remote instances are not tracked here
+      if (finder != instance_uses.end())
+        finder->second = use_clock++;
+    }
+
+    //--------------------------------------------------------------------------
+    bool MemoryManager::is_over_budget(size_t needed_size)
+    //--------------------------------------------------------------------------
+    {
+      if ((Runtime::spill_threshold == 0) || 
+          (Runtime::spill_threshold >= 100))
+        return false;
+      AutoLock m_lock(manager_lock, 1, false/*exclusive*/);
+      const size_t allocated = capacity - remaining_capacity;
+      // Do this in floating point to avoid overflowing large memories
+      return ((double(allocated) + double(needed_size)) > 
+              (double(capacity) * Runtime::spill_threshold / 100.0));
+    }
+
+    //--------------------------------------------------------------------------
+    void MemoryManager::find_spill_candidates(size_t needed_size,
+                                     const std::set<PhysicalManager*> &exclude,
+                                     std::set<InstanceManager*> &candidates)
+    //--------------------------------------------------------------------------
+    {
+      // Sort the instances by the time they were last used so that
+      // we pick the least recently used ones first.  Instances which 
+      // are already waiting to be recycled are not valid anywhere
+      // so there is no point in spilling them.  Note that the caller
+      // only uses the results to match against instances that it
+      // holds references on so we do not need to add any here.
+      std::vector<std::pair<unsigned long long,InstanceManager*> > ordered;
+      AutoLock m_lock(manager_lock, 1, false/*exclusive*/);
+      ordered.reserve(instance_uses.size());
+      for (LegionMap<InstanceManager*,unsigned long long,
+                     MEMORY_INSTANCES_ALLOC>::tracked::const_iterator it = 
+            instance_uses.begin(); it != instance_uses.end(); it++)
+      {
+        if (available_instances.find(it->first) != available_instances.end())
+          continue;
+        if (exclude.find(it->first) != exclude.end())
+          continue;
+        ordered.push_back(
+            std::pair<unsigned long long,InstanceManager*>(it->second,
+                                                           it->first));
+      }
+      std::sort(ordered.begin(), ordered.end());
+      size_t spill_size = 0;
+      for (std::vector<std::pair<unsigned long long,InstanceManager*> >::
+            const_iterator it = ordered.begin(); (it != ordered.end()) &&
+            (spill_size < needed_size); it++)
+      {
+        candidates.insert(it->second);
+        spill_size += physical_instances[it->second];
+      }
+    }
+
     //--------------------------------------------------------------------------
     size_t MemoryManager::sample_free_space(void)
     //--------------------------------------------------------------------------
@@ -3507,6 +3625,14 @@ namespace LegionRuntime {
       sending_index += sizeof(packaged_messages);
       last_message_event = Event::NO_EVENT;
       partial = false;
+      pending_since = 0;
+      for (unsigned idx = 0; idx < LAST_MESSAGE_KIND; idx++)
+      {
+        sent_messages[idx] = 0;
+        sent_bytes[idx] = 0;
+      }
+      active_messages = 0;
+      active_message_bytes = 0;
       // Set up the receiving buffer
       received_messages = 0;
       receiving_index = 0;
@@ -3526,6 +3652,8 @@ namespace LegionRuntime {
     MessageManager::~MessageManager(void)
     //--------------------------------------------------------------------------
     {
+      if (Runtime::message_statistics)
+        dump_message_statistics();
       send_lock.destroy_reservation();
       send_lock = Reservation::NO_RESERVATION;
       free(sending_buffer);
@@ -3694,6 +3822,22 @@ namespace LegionRuntime {
       package_message(rez, SLICE_REMOTE_COMMIT, flush);
     }
 
+    //--------------------------------------------------------------------------
+    void MessageManager::send_slice_aggregate_complete(Serializer &rez,
+                                                       bool flush)
+    //--------------------------------------------------------------------------
+    {
+      package_message(rez, SLICE_AGGREGATE_COMPLETE, flush);
+    }
+
+    //--------------------------------------------------------------------------
+    void MessageManager::send_slice_aggregate_commit(Serializer &rez,
+                                                     bool flush)
+    //--------------------------------------------------------------------------
+    {
+      package_message(rez, SLICE_AGGREGATE_COMMIT, flush);
+    }
+
     //--------------------------------------------------------------------------
     void MessageManager::send_remove_distributed_resource(Serializer &rez,
                                                           bool flush)
@@ -4018,6 +4162,8 @@ namespace LegionRuntime {
       const char *buffer = (const char*)rez.get_buffer();
       // Need to hold the lock when manipulating the buffer
       AutoLock s_lock(send_lock);
+      sent_messages[k]++;
+      sent_bytes[k] += buffer_size;
       if ((sending_index+buffer_size+sizeof(k)+sizeof(buffer_size)) > 
           sending_buffer_size)
       {
@@ -4064,6 +4210,24 @@ namespace LegionRuntime {
       }
       if (flush)
         send_message(true/*complete*/);
+      else if (Runtime::max_message_delay > 0)
+      {
+        // With no scheduler run outstanding on this node there is
+        // nothing that would flush the buffer later so send it now
+        if (!runtime->has_outstanding_schedulers())
+        {
+          send_message(true/*complete*/);
+          return;
+        }
+        // Bound how long messages can sit in the buffer waiting
+        // for other messages to be aggregated with them
+        unsigned long long now = TimeStamp::get_current_time_in_micros();
+        if (pending_since == 0)
+          pending_since = now;
+        else if ((now > pending_since) && 
+                 ((now - pending_since) >= Runtime::max_message_delay))
+          send_message(true/*complete*/);
+      }
     }
 
     //--------------------------------------------------------------------------
@@ -4087,6 +4251,8 @@ namespace LegionRuntime {
                           sizeof(local_address_space))) = header;
       *((unsigned*)(sending_buffer + sizeof(HLRTaskID) +
             sizeof(local_address_space) + sizeof(header))) = packaged_messages;
+      active_messages++;
+      active_message_bytes += sending_index;
       // Send the message
       Event next_event = target.spawn(HLR_TASK_ID, sending_buffer,
                                       sending_index, last_message_event);
@@ -4100,6 +4266,137 @@ namespace LegionRuntime {
       else
         header = FULL_MESSAGE;
       packaged_messages = 0;
+      pending_since = 0;
+    }
+
+    //--------------------------------------------------------------------------
+    void MessageManager::flush_messages(void)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock s_lock(send_lock);
+      if (partial || (packaged_messages > 0))
+        send_message(true/*complete*/);
+    }
+
+    //--------------------------------------------------------------------------
+    void MessageManager::flush_stale_messages(unsigned long long now)
+    //--------------------------------------------------------------------------
+    {
+      // Check without the lock first since this gets called
+      // every time the scheduler runs
+      unsigned long long since = pending_since;
+      if ((since == 0) || (now <= since) || 
+          ((now - since) < Runtime::max_message_delay))
+        return;
+      AutoLock s_lock(send_lock);
+      since = pending_since;
+      if ((since != 0) && (now > since) && 
+          ((now - since) >= Runtime::max_message_delay))
+        send_message(true/*complete*/);
+    }
+
+    //--------------------------------------------------------------------------
+    void MessageManager::dump_message_statistics(void)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock s_lock(send_lock);
+      unsigned long long total_messages = 0, total_bytes = 0;
+      for (unsigned idx = 0; idx < LAST_MESSAGE_KIND; idx++)
+      {
+        total_messages += sent_messages[idx];
+        total_bytes += sent_bytes[idx];
+      }
+      log_run(LEVEL_PRINT,"Messages from node %d to node %d: %lld messages "
+                          "(%lld bytes) in %lld active messages (%lld bytes)",
+                          local_address_space, remote_address_space,
+                          total_messages, total_bytes, 
+                          active_messages, active_message_bytes);
+      for (unsigned idx = 0; idx < LAST_MESSAGE_KIND; idx++)
+      {
+        if (sent_messages[idx] == 0)
+          continue;
+        log_run(LEVEL_PRINT,"  %s: %lld messages (%lld bytes)",
+                get_message_kind_name((MessageKind)idx),
+                sent_messages[idx], sent_bytes[idx]);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ const char* MessageManager::get_message_kind_name(
+                                                              MessageKind kind)
+    //--------------------------------------------------------------------------
+    {
+      const char *const message_names[LAST_MESSAGE_KIND] = {
+        "TASK_MESSAGE",
+        "STEAL_MESSAGE",
+        "ADVERTISEMENT_MESSAGE",
+        "SEND_INDEX_SPACE_NODE",
+        "SEND_INDEX_PARTITION_NODE",
+        "SEND_FIELD_SPACE_NODE",
+        "SEND_LOGICAL_REGION_NODE",
+        "INDEX_SPACE_DESTRUCTION_MESSAGE",
+        "INDEX_PARTITION_DESTRUCTION_MESSAGE",
+        "FIELD_SPACE_DESTRUCTION_MESSAGE",
+        "LOGICAL_REGION_DESTRUCTION_MESSAGE",
+        "LOGICAL_PARTITION_DESTRUCTION_MESSAGE",
+        "FIELD_ALLOCATION_MESSAGE",
+        "FIELD_DESTRUCTION_MESSAGE",
+        "INDIVIDUAL_REMOTE_MAPPED",
+        "INDIVIDUAL_REMOTE_COMPLETE",
+        "INDIVIDUAL_REMOTE_COMMIT",
+        "SLICE_REMOTE_MAPPED",
+        "SLICE_REMOTE_COMPLETE",
+        "SLICE_REMOTE_COMMIT",
+        "SLICE_AGGREGATE_COMPLETE",
+        "SLICE_AGGREGATE_COMMIT",
+        "DISTRIBUTED_REMOVE_RESOURCE",
+        "DISTRIBUTED_REMOVE_REMOTE",
+        "DISTRIBUTED_ADD_REMOTE",
+        "HIERARCHICAL_REMOVE_RESOURCE",
+        "HIERARCHICAL_REMOVE_REMOTE",
+        "SEND_BACK_USER",
+        "SEND_BACK_ATOMIC",
+        "SEND_SUBSCRIBER",
+        "SEND_MATERIALIZED_VIEW",
+        "SEND_MATERIALIZED_UPDATE",
+        "SEND_BACK_MATERIALIZED_VIEW",
+        "SEND_COMPOSITE_VIEW",
+        "SEND_BACK_COMPOSITE_VIEW",
+        "SEND_COMPOSITE_UPDATE",
+        "SEND_REDUCTION_VIEW",
+        "SEND_REDUCTION_UPDATE",
+        "SEND_BACK_REDUCTION_VIEW",
+        "SEND_INSTANCE_MANAGER",
+        "SEND_REDUCTION_MANAGER",
+        "SEND_REGION_STATE",
+        "SEND_PARTITION_STATE",
+        "SEND_BACK_REGION_STATE",
+        "SEND_BACK_PARTITION_STATE",
+        "SEND_REMOTE_REFERENCES",
+        "SEND_INDIVIDUAL_REQUEST",
+        "SEND_INDIVIDUAL_RETURN",
+        "SEND_SLICE_REQUEST",
+        "SEND_SLICE_RETURN",
+        "SEND_FUTURE",
+        "SEND_FUTURE_RESULT",
+        "SEND_FUTURE_SUBSCRIPTION",
+        "SEND_MAKE_PERSISTENT",
+        "SEND_MAPPER_MESSAGE",
+        "SEND_MAPPER_BROADCAST",
+        "SEND_INDEX_SPACE_SEMANTIC_INFO",
+        "SEND_INDEX_PARTITION_SEMANTIC_INFO",
+        "SEND_FIELD_SPACE_SEMANTIC_INFO",
+        "SEND_FIELD_SEMANTIC_INFO",
+        "SEND_LOGICAL_REGION_SEMANTIC_INFO",
+        "SEND_LOGICAL_PARTITION_SEMANTIC_INFO",
+        "SEND_FREE_REMOTE_CONTEXT",
+        "SEND_VALIDATE_REMOTE_STATE",
+        "SEND_INVALIDATE_REMOTE_STATE",
+      };
+#ifdef DEBUG_HIGH_LEVEL
+      assert(kind < LAST_MESSAGE_KIND);
+#endif
+      return message_names[kind];
     }
 
     //--------------------------------------------------------------------------
@@ -4277,6 +4574,16 @@ namespace LegionRuntime {
               runtime->handle_slice_remote_commit(derez);
               break;
             }
+          case SLICE_AGGREGATE_COMPLETE:
+            {
+              runtime->handle_slice_aggregate_complete(derez);
+              break;
+            }
+          case SLICE_AGGREGATE_COMMIT:
+            {
+              runtime->handle_slice_aggregate_commit(derez);
+              break;
+            }
           case DISTRIBUTED_REMOVE_RESOURCE:
             {
               runtime->handle_distributed_remove_resource(derez); 
@@ -4553,6 +4860,9 @@ namespace LegionRuntime {
     Event MessageManager::notify_pending_shutdown(void)
     //--------------------------------------------------------------------------
     {
+      // Anything still in the buffer has to go out before we shutdown
+      flush_messages();
+      AutoLock s_lock(send_lock);
       return last_message_event;
     }
 
@@ -4670,7 +4980,7 @@ namespace LegionRuntime {
         local_procs(locals), local_utils(local_utilities),
         memory_manager_lock(Reservation::create_reservation()),
         message_manager_lock(Reservation::create_reservation()),
-        proc_spaces(processor_spaces),
+        proc_spaces(processor_spaces), outstanding_schedulers(0),
         mapper_info_lock(Reservation::create_reservation()),
         unique_partition_id((unique == 0) ? runtime_stride : unique), 
         unique_field_space_id((unique == 0) ? runtime_stride : unique),
@@ -4745,6 +5055,11 @@ namespace LegionRuntime {
         // If it's less than zero, then they are all enabled by default
         else
           LegionProf::enable_profiling();
+        // Switch to binary profiles if we were given a file for them
+        if ((Runtime::profiling_file_prefix != NULL) && 
+            LegionProf::profiling_enabled)
+          LegionProf::open_binary_profile(Runtime::profiling_file_prefix,
+                                          address_space);
         const std::map<Processor::TaskFuncID,TaskVariantCollection*>& table =
           Runtime::get_collection_table();
         for (std::map<Processor::TaskFuncID,TaskVariantCollection*>::
@@ -4826,7 +5141,10 @@ namespace LegionRuntime {
       // Initialize the message manager array so that we can construct
       // message managers lazily as they are needed
       for (unsigned idx = 0; idx < MAX_NUM_NODES; idx++)
+      {
         message_managers[idx] = NULL;
+        reference_batches[idx] = NULL;
+      }
       
       // Make the default number of contexts
       // No need to hold the lock yet because nothing is running
@@ -4928,6 +5246,8 @@ namespace LegionRuntime {
       proc_managers.clear();
       for (unsigned idx = 0; idx < MAX_NUM_NODES; idx++)
       {
+        if (reference_batches[idx] != NULL)
+          delete reference_batches[idx];
         if (message_managers[idx] != NULL)
           delete message_managers[idx];
       }
@@ -5851,53 +6171,14 @@ namespace LegionRuntime {
       }
       if (disjoint && verify_disjointness)
       {
-        std::set<Color> current_colors;
-        for (std::map<Color,Domain>::const_iterator it1 = 
-              coloring.begin(); it1 != coloring.end(); it1++)
+        Color first, second;
+        if (IndexTreeNode::find_overlapping_colors(coloring, first, second))
         {
-          current_colors.insert(it1->first);
-          for (std::map<Color,Domain>::const_iterator it2 = 
-                coloring.begin(); it2 != coloring.end(); it2++)
-          {
-            if (current_colors.find(it2->first) != current_colors.end())
-              continue;
-            assert(it1->second.get_dim() == it2->second.get_dim());
-            bool overlaps = false;
-            switch (it1->second.get_dim())
-            {
-              case 1:
-                {
-                  Rect<1> d1 = it1->second.get_rect<1>();
-                  Rect<1> d2 = it2->second.get_rect<1>();
-                  overlaps = d1.overlaps(d2);
-                  break;
-                }
-              case 2:
-                {
-                  Rect<2> d1 = it1->second.get_rect<2>();
-                  Rect<2> d2 = it2->second.get_rect<2>();
-                  overlaps = d1.overlaps(d2);
-                  break;
-                }
-              case 3:
-                {
-                  Rect<3> d1 = it1->second.get_rect<3>();
-                  Rect<3> d2 = it2->second.get_rect<3>();
-                  overlaps = d1.overlaps(d2);
-                  break;
-                }
-              default:
-                assert(false); // should never get here
-            }
-            if (overlaps)
-            {
-              log_run(LEVEL_ERROR, "ERROR: colors %d and %d of partition %d "
-                              "are not disjoint when they are claimed to be!",
-                              it1->first, it2->first, pid);
-              assert(false);
-              exit(ERROR_DISJOINTNESS_TEST_FAILURE);
-            }
-          }
+          log_run(LEVEL_ERROR, "ERROR: colors %d and %d of partition %d "
+                          "are not disjoint when they are claimed to be!",
+                          first, second, pid);
+          assert(false);
+          exit(ERROR_DISJOINTNESS_TEST_FAILURE);
         }
       }
 #endif
@@ -5964,61 +6245,14 @@ namespace LegionRuntime {
       }
       if (disjoint && verify_disjointness)
       {
-        std::set<Color> current_colors;
-        for (std::map<Color,std::set<Domain> >::const_iterator it1 = 
-              coloring.begin(); it1 != coloring.end(); it1++)
+        Color first, second;
+        if (IndexTreeNode::find_overlapping_colors(coloring, first, second))
         {
-          current_colors.insert(it1->first);
-          for (std::map<Color,std::set<Domain> >::const_iterator it2 = 
-                coloring.begin(); it2 != coloring.end(); it2++)
-          {
-            if (current_colors.find(it2->first) != current_colors.end())
-              continue;
-            bool overlaps = false;
-            for (std::set<Domain>::const_iterator it3 = it1->second.begin();
-                  !overlaps && (it3 != it1->second.end()); it3++)
-            {
-              for (std::set<Domain>::const_iterator it4 = it2->second.begin();
-                    !overlaps && (it4 != it2->second.end()); it4++)
-              {
-                assert(it3->get_dim() == it4->get_dim());
-                switch (it3->get_dim())
-                {
-                  case 1:
-                    {
-                      Rect<1> d1 = it3->get_rect<1>();
-                      Rect<1> d2 = it4->get_rect<1>();
-                      overlaps = d1.overlaps(d2);
-                      break;
-                    }
-                  case 2:
-                    {
-                      Rect<2> d1 = it3->get_rect<2>();
-                      Rect<2> d2 = it4->get_rect<2>();
-                      overlaps = d1.overlaps(d2);
-                      break;
-                    }
-                  case 3:
-                    {
-                      Rect<3> d1 = it3->get_rect<3>();
-                      Rect<3> d2 = it4->get_rect<3>();
-                      overlaps = d1.overlaps(d2);
-                      break;
-                    }
-                  default:
-                    assert(false);
-                }
-              }
-            }
-            if (overlaps)
-            {
-              log_run(LEVEL_ERROR, "ERROR: colors %d and %d of multi-domain "
-                              "partition %d are not disjoint when they are "
-                              "claimed to be!", it1->first, it2->first, pid);
-              assert(false);
-              exit(ERROR_DISJOINTNESS_TEST_FAILURE);
-            }
-          }
+          log_run(LEVEL_ERROR, "ERROR: colors %d and %d of multi-domain "
+                          "partition %d are not disjoint when they are "
+                          "claimed to be!", first, second, pid);
+          assert(false);
+          exit(ERROR_DISJOINTNESS_TEST_FAILURE);
         }
       }
 #endif
@@ -9380,6 +9614,51 @@ namespace LegionRuntime {
                                                       depth, use_event);
     }
 
+    //--------------------------------------------------------------------------
+    void Runtime::record_instance_use(InstanceManager *instance)
+    //--------------------------------------------------------------------------
+    {
+      find_memory(instance->memory)->record_instance_use(instance);
+    }
+
+    //--------------------------------------------------------------------------
+    bool Runtime::is_over_budget(Memory mem, size_t needed_size)
+    //--------------------------------------------------------------------------
+    {
+      return find_memory(mem)->is_over_budget(needed_size);
+    }
+
+    //--------------------------------------------------------------------------
+    void Runtime::find_spill_candidates(Memory mem, size_t needed_size,
+                                     const std::set<PhysicalManager*> &exclude,
+                                     std::set<InstanceManager*> &candidates)
+    //--------------------------------------------------------------------------
+    {
+      find_memory(mem)->find_spill_candidates(needed_size, exclude, 
+                                              candidates);
+    }
+
+    //--------------------------------------------------------------------------
+    Memory Runtime::find_spill_memory(Memory mem)
+    //--------------------------------------------------------------------------
+    {
+      // Never spill out of disk memory
+      if (mem.kind() == Memory::DISK_MEM)
+        return Memory::NO_MEMORY;
+      // Find a disk memory in the same address space that
+      // can be used as the target of a copy from this memory
+      std::set<Memory> visible_memories;
+      machine.get_visible_memories(mem, visible_memories);
+      for (std::set<Memory>::const_iterator it = visible_memories.begin();
+            it != visible_memories.end(); it++)
+      {
+        if ((it->kind() == Memory::DISK_MEM) && 
+            (it->address_space() == mem.address_space()))
+          return *it;
+      }
+      return Memory::NO_MEMORY;
+    }
+
     //--------------------------------------------------------------------------
     size_t Runtime::sample_allocated_space(Memory mem)
     //--------------------------------------------------------------------------
@@ -9482,6 +9761,68 @@ namespace LegionRuntime {
       return find_messenger(find_address_space(target));
     }
 
+    //--------------------------------------------------------------------------
+    ReferenceBatch* Runtime::find_reference_batch(AddressSpaceID sid)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_HIGH_LEVEL
+      assert(sid < MAX_NUM_NODES);
+      assert(sid != address_space);
+#endif
+      ReferenceBatch *result = reference_batches[sid];
+      if (result != NULL)
+        return result;
+      AutoLock m_lock(message_manager_lock);
+      // Re-check in case we lost the race
+      result = *(((ReferenceBatch**volatile)reference_batches)+sid);
+      if (result == NULL)
+      {
+        result = new ReferenceBatch(this, sid);
+        reference_batches[sid] = result;
+      }
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    void Runtime::flush_stale_messages(void)
+    //--------------------------------------------------------------------------
+    {
+      unsigned long long now = TimeStamp::get_current_time_in_micros();
+      for (unsigned idx = 0; idx < MAX_NUM_NODES; idx++)
+      {
+        // Flush reference changes first so they can go out with
+        // the rest of the messages in the buffer
+        ReferenceBatch *batch = reference_batches[idx];
+        if (batch != NULL)
+          batch->flush_stale(now);
+        MessageManager *manager = message_managers[idx];
+        if (manager != NULL)
+          manager->flush_stale_messages(now);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    void Runtime::flush_pending_messages(void)
+    //--------------------------------------------------------------------------
+    {
+      for (unsigned idx = 0; idx < MAX_NUM_NODES; idx++)
+      {
+        ReferenceBatch *batch = reference_batches[idx];
+        if (batch != NULL)
+          batch->flush();
+        MessageManager *manager = message_managers[idx];
+        if (manager != NULL)
+          manager->flush_messages();
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    void Runtime::notify_scheduler_launch(void)
+    //--------------------------------------------------------------------------
+    {
+      __sync_fetch_and_add(&outstanding_schedulers, 1);
+    }
+
     //--------------------------------------------------------------------------
     AddressSpaceID Runtime::find_address_space(Processor target) const
     //--------------------------------------------------------------------------
@@ -9817,47 +10158,19 @@ namespace LegionRuntime {
     }
 
     //--------------------------------------------------------------------------
-    void Runtime::send_remove_distributed_resource(AddressSpaceID target,
-                                                   Serializer &rez)
+    void Runtime::send_slice_aggregate_complete(Processor target, 
+                                                Serializer &rez)
     //--------------------------------------------------------------------------
     {
-      find_messenger(target)->send_remove_distributed_resource(rez,
-                                                               true/*flush*/);
+      find_messenger(target)->send_slice_aggregate_complete(rez, 
+                                                            true/*flush*/);
     }
 
     //--------------------------------------------------------------------------
-    void Runtime::send_remove_distributed_remote(AddressSpaceID target,
-                                                 Serializer &rez)
-    //--------------------------------------------------------------------------
-    {
-      find_messenger(target)->send_remove_distributed_remote(rez, 
-                                                             true/*flush*/);
-    }
-
-    //--------------------------------------------------------------------------
-    void Runtime::send_add_distributed_remote(AddressSpaceID target,
-                                              Serializer &rez)
+    void Runtime::send_slice_aggregate_commit(Processor target, Serializer &rez)
     //--------------------------------------------------------------------------
     {
-      find_messenger(target)->send_add_distributed_remote(rez, true/*flush*/);
-    }
-
-    //--------------------------------------------------------------------------
-    void Runtime::send_remove_hierarchical_resource(AddressSpaceID target,
-                                                    Serializer &rez)
-    //--------------------------------------------------------------------------
-    {
-      find_messenger(target)->send_remove_hierarchical_resource(rez, 
-                                                                true/*flush*/);
-    }
-
-    //--------------------------------------------------------------------------
-    void Runtime::send_remove_hierarchical_remote(AddressSpaceID target,
-                                                  Serializer &rez)
-    //--------------------------------------------------------------------------
-    {
-      find_messenger(target)->send_remove_hierarchical_remote(rez,
-                                                              true/*flush*/);
+      find_messenger(target)->send_slice_aggregate_commit(rez, true/*flush*/);
     }
 
     //--------------------------------------------------------------------------
@@ -10350,6 +10663,20 @@ namespace LegionRuntime {
       IndexTask::process_slice_commit(derez);
     }
 
+    //--------------------------------------------------------------------------
+    void Runtime::handle_slice_aggregate_complete(Deserializer &derez)
+    //--------------------------------------------------------------------------
+    {
+      SliceTask::process_aggregate_complete(derez);
+    }
+
+    //--------------------------------------------------------------------------
+    void Runtime::handle_slice_aggregate_commit(Deserializer &derez)
+    //--------------------------------------------------------------------------
+    {
+      SliceTask::process_aggregate_commit(derez);
+    }
+
     //--------------------------------------------------------------------------
     void Runtime::handle_distributed_remove_resource(Deserializer &derez)
     //--------------------------------------------------------------------------
@@ -10783,6 +11110,16 @@ namespace LegionRuntime {
 #endif
       ProcessorManager *manager = proc_managers[proc];
       manager->perform_scheduling();
+      // Use the scheduler as a clock for time-based message flushes
+      if (max_message_delay > 0)
+        flush_stale_messages();
+      // If this was the last scheduler run on the node (it did not
+      // launch another one and no other processor has one pending)
+      // then the clock stops here, so send whatever is still buffered
+      // instead of leaving it for the next run which may never come
+      if ((__sync_sub_and_fetch(&outstanding_schedulers, 1) == 0) &&
+          (max_message_delay > 0))
+        flush_pending_messages();
 #ifdef TRACE_ALLOCATION
       unsigned long long trace_count = 
         __sync_fetch_and_add(&allocation_tracing_count,1); 
@@ -11686,6 +12023,8 @@ namespace LegionRuntime {
       std::set<Event> shutdown_preconditions;
       for (unsigned idx = 0; idx < MAX_NUM_NODES; idx++)
       {
+        if (reference_batches[idx] != NULL)
+          reference_batches[idx]->flush_for_shutdown();
         if (message_managers[idx] != NULL)
         {
           Event last_event = message_managers[idx]->notify_pending_shutdown();
@@ -13149,16 +13488,27 @@ namespace LegionRuntime {
                                       DEFAULT_SUPERSCALAR_WIDTH;
     /*static*/ unsigned Runtime::max_message_size = 
                                       DEFAULT_MAX_MESSAGE_SIZE;
+    /*static*/ unsigned Runtime::max_message_delay = 
+                                      DEFAULT_MAX_MESSAGE_DELAY;
     /*static*/ unsigned Runtime::max_filter_size = 
                                       DEFAULT_MAX_FILTER_SIZE;
     /*static*/ unsigned Runtime::gc_epoch_size = 
                                       DEFAULT_GC_EPOCH_SIZE;
+    /*static*/ unsigned Runtime::gc_batch_size = 
+                                      DEFAULT_GC_BATCH_SIZE;
+    /*static*/ unsigned Runtime::gc_release_radix = 
+                                      DEFAULT_GC_RELEASE_RADIX;
+    /*static*/ unsigned Runtime::spill_threshold = 
+                                      DEFAULT_SPILL_THRESHOLD;
     /*static*/ bool Runtime::enable_imprecise_filter = false;
     /*static*/ bool Runtime::separate_runtime_instances = false;
     /*static*/ bool Runtime::record_registration = false;
     /*sattic*/ bool Runtime::stealing_disabled = false;
     /*static*/ bool Runtime::resilient_mode = false;
     /*static*/ bool Runtime::unsafe_launch = false;
+    /*static*/ bool Runtime::memoize_mappings = false;
+    /*static*/ bool Runtime::message_statistics = false;
+    /*static*/ bool Runtime::parallel_analysis = false;
     /*static*/ unsigned Runtime::shutdown_counter = 0;
     /*static*/ int Runtime::mpi_rank = -1;
     /*static*/ unsigned Runtime::mpi_rank_table[MAX_NUM_NODES];
@@ -13184,6 +13534,7 @@ namespace LegionRuntime {
 #endif
 #ifdef LEGION_PROF
     /*static*/ int Runtime::num_profiling_nodes = -1;
+    /*static*/ const char* Runtime::profiling_file_prefix = NULL;
 #endif
 
 #ifdef HANG_TRACE
@@ -13269,14 +13620,21 @@ namespace LegionRuntime {
         stealing_disabled = false;
         resilient_mode = false;
         unsafe_launch = false;
+        memoize_mappings = false;
+        message_statistics = false;
+        parallel_analysis = false;
         initial_task_window_size = DEFAULT_MAX_TASK_WINDOW;
         initial_task_window_hysteresis = DEFAULT_TASK_WINDOW_HYSTERESIS;
         initial_tasks_to_schedule = DEFAULT_MIN_TASKS_TO_SCHEDULE;
         initial_directory_size = DEFAULT_MAX_DIRECTORY_SIZE;
         superscalar_width = DEFAULT_SUPERSCALAR_WIDTH;
         max_message_size = DEFAULT_MAX_MESSAGE_SIZE;
+        max_message_delay = DEFAULT_MAX_MESSAGE_DELAY;
         max_filter_size = DEFAULT_MAX_FILTER_SIZE;
         gc_epoch_size = DEFAULT_GC_EPOCH_SIZE;
+        gc_batch_size = DEFAULT_GC_BATCH_SIZE;
+        gc_release_radix = DEFAULT_GC_RELEASE_RADIX;
+        spill_threshold = DEFAULT_SPILL_THRESHOLD;
 #ifdef INORDER_EXECUTION
         program_order_execution = true;
 #endif
@@ -13285,6 +13643,7 @@ namespace LegionRuntime {
 #endif
 #ifdef LEGION_PROF
         num_profiling_nodes = -1;
+        profiling_file_prefix = NULL;
 #endif
 #ifdef DEBUG_HIGH_LEVEL
         logging_region_tree_state = false;
@@ -13303,6 +13662,9 @@ namespace LegionRuntime {
           BOOL_ARG("-hl:nosteal",stealing_disabled);
           BOOL_ARG("-hl:resilient",resilient_mode);
           BOOL_ARG("-hl:unsafe_launch",unsafe_launch);
+          BOOL_ARG("-hl:memoize_mapping",memoize_mappings);
+          BOOL_ARG("-hl:message_stats",message_statistics);
+          BOOL_ARG("-hl:parallel_analysis",parallel_analysis);
 #ifdef INORDER_EXECUTION
           if (!strcmp(argv[i],"-hl:outorder"))
             program_order_execution = false;
@@ -13313,8 +13675,12 @@ namespace LegionRuntime {
           INT_ARG("-hl:directory", initial_directory_size);
           INT_ARG("-hl:width", superscalar_width);
           INT_ARG("-hl:message",max_message_size);
+          INT_ARG("-hl:message_delay",max_message_delay);
           INT_ARG("-hl:filter", max_filter_size);
           INT_ARG("-hl:epoch", gc_epoch_size);
+          INT_ARG("-hl:gc_batch", gc_batch_size);
+          INT_ARG("-hl:gc_radix", gc_release_radix);
+          INT_ARG("-hl:spill", spill_threshold);
 #ifdef DYNAMIC_TESTS
           if (!strcmp(argv[i],"-hl:no_dyn"))
             dynamic_independence_tests = false;
@@ -13345,13 +13711,22 @@ namespace LegionRuntime {
 #endif
 #ifdef LEGION_PROF
           INT_ARG("-hl:prof", num_profiling_nodes);
+          if (!strcmp(argv[i],"-hl:prof_file"))
+          {
+            profiling_file_prefix = argv[++i];
+            continue;
+          }
 #else
-          if (!strcmp(argv[i],"-hl:prof"))
+          if (!strcmp(argv[i],"-hl:prof") || 
+              !strcmp(argv[i],"-hl:prof_file"))
           {
             log_run(LEVEL_WARNING,"WARNING: Legion Prof is disabled.  The "
-                                  "-hl:prof flag will be ignored.  Recompile "
+                                  "%s flag will be ignored.  Recompile "
                                   "with the -DLEGION_PROF flag to enable "
-                                  "profiling.");
+                                  "profiling.", argv[i]);
+            // Skip the flag's argument too
+            i++;
+            continue;
           }
 #endif
         }
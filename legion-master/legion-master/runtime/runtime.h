@@ -610,6 +610,11 @@ namespace LegionRuntime {
       // Dependence analysis state
       Reservation dependence_lock;
       std::vector<Event> dependence_preconditions;
+      // With -hl:parallel_analysis operations only wait for the last
+      // operation analyzed in each of the region trees they touch,
+      // dependence_preconditions is then the last operation which
+      // had to be ordered with everything in the context
+      std::vector<std::map<RegionTreeID,Event> > tree_preconditions;
     protected:
       // Local queue state
       Reservation local_queue_lock;
@@ -687,6 +692,13 @@ namespace LegionRuntime {
                           const std::vector<size_t> &field_sizes,
                           const Domain &dom, const size_t blocking_factor,
                           const unsigned depth, Event &use_event);
+    public:
+      // Methods for spilling instances out of this memory
+      void record_instance_use(InstanceManager *manager);
+      bool is_over_budget(size_t needed_size);
+      void find_spill_candidates(size_t needed_size,
+                                 const std::set<PhysicalManager*> &exclude,
+                                 std::set<InstanceManager*> &candidates);
     public:
       // Method for mapper introspection
       size_t sample_allocated_space(void);
@@ -713,6 +725,11 @@ namespace LegionRuntime {
       // Set of physical instances which are currently eligible for recycling
       LegionSet<InstanceManager*,
                 MEMORY_AVAILABLE_ALLOC>::tracked available_instances;
+      // The logical time at which each physical instance was last
+      // used so that the least recently used ones can be spilled
+      LegionMap<InstanceManager*, unsigned long long,
+                MEMORY_INSTANCES_ALLOC>::tracked instance_uses;
+      unsigned long long use_clock;
     };
 
     /**
@@ -756,6 +773,8 @@ namespace LegionRuntime {
         SLICE_REMOTE_MAPPED,
         SLICE_REMOTE_COMPLETE,
         SLICE_REMOTE_COMMIT,
+        SLICE_AGGREGATE_COMPLETE,
+        SLICE_AGGREGATE_COMMIT,
         DISTRIBUTED_REMOVE_RESOURCE,
         DISTRIBUTED_REMOVE_REMOTE,
         DISTRIBUTED_ADD_REMOTE,
@@ -799,6 +818,7 @@ namespace LegionRuntime {
         SEND_FREE_REMOTE_CONTEXT,
         SEND_VALIDATE_REMOTE_STATE,
         SEND_INVALIDATE_REMOTE_STATE,
+        LAST_MESSAGE_KIND, // must be last
       };
       // Implement a three-state state-machine for sending
       // messages.  Either fully self-contained messages
@@ -839,6 +859,8 @@ namespace LegionRuntime {
       void send_slice_remote_mapped(Serializer &rez, bool flush);
       void send_slice_remote_complete(Serializer &rez, bool flush);
       void send_slice_remote_commit(Serializer &rez, bool flush);
+      void send_slice_aggregate_complete(Serializer &rez, bool flush);
+      void send_slice_aggregate_commit(Serializer &rez, bool flush);
       void send_remove_distributed_resource(Serializer &rez, bool flush);
       void send_remove_distributed_remote(Serializer &rez, bool flush);
       void send_add_distributed_remote(Serializer &rez, bool flush);
@@ -885,6 +907,14 @@ namespace LegionRuntime {
     public:
       // Receiving message method
       void process_message(const void *args, size_t arglen);
+    public:
+      // Send anything that is still sitting in the buffer
+      void flush_messages(void);
+      // Only flush if the oldest buffered message has waited
+      // longer than the maximum message delay
+      void flush_stale_messages(unsigned long long now);
+      void dump_message_statistics(void);
+      static const char* get_message_kind_name(MessageKind kind);
     private:
       void package_message(Serializer &rez, MessageKind k, bool flush);
       void send_message(bool complete);
@@ -909,6 +939,15 @@ namespace LegionRuntime {
       MessageHeader header;
       unsigned packaged_messages;
       bool partial;
+      // Time in microseconds at which the oldest message still
+      // in the sending buffer was packaged, zero if it is empty
+      volatile unsigned long long pending_since;
+      // Statistics for each kind of message and for the 
+      // active messages that actually get sent
+      unsigned long long sent_messages[LAST_MESSAGE_KIND];
+      unsigned long long sent_bytes[LAST_MESSAGE_KIND];
+      unsigned long long active_messages;
+      unsigned long long active_message_bytes;
       // State for receiving messages
       // No lock for receiving messages since we know
       // that they are ordered
@@ -1350,6 +1389,14 @@ namespace LegionRuntime {
                                      const size_t blocking_factor,
                                      const unsigned depth,
                                      Event &use_event);
+    public:
+      // Functions for spilling physical instances out of core
+      void record_instance_use(InstanceManager *instance);
+      bool is_over_budget(Memory mem, size_t needed_size);
+      void find_spill_candidates(Memory mem, size_t needed_size,
+                                 const std::set<PhysicalManager*> &exclude,
+                                 std::set<InstanceManager*> &candidates);
+      Memory find_spill_memory(Memory mem);
     public:
       // Mapper introspection methods
       size_t sample_allocated_space(Memory mem);
@@ -1361,6 +1408,15 @@ namespace LegionRuntime {
       MessageManager* find_messenger(AddressSpaceID sid);
       MessageManager* find_messenger(Processor target);
       AddressSpaceID find_address_space(Processor target) const;
+      void flush_stale_messages(void);
+      // Send everything that is still buffered for any other node
+      void flush_pending_messages(void);
+      // Scheduler runs are the clock for time-based message flushes,
+      // without an outstanding one nothing would flush a buffer later
+      void notify_scheduler_launch(void);
+      inline bool has_outstanding_schedulers(void) const
+        { return (outstanding_schedulers > 0); }
+      ReferenceBatch* find_reference_batch(AddressSpaceID sid);
       void send_task(Processor target, TaskOp *task);
       void send_tasks(Processor target, const std::set<TaskOp*> &tasks);
       void send_steal_request(const std::multimap<Processor,MapperID> &targets,
@@ -1393,15 +1449,8 @@ namespace LegionRuntime {
       void send_slice_remote_mapped(Processor target, Serializer &rez);
       void send_slice_remote_complete(Processor target, Serializer &rez);
       void send_slice_remote_commit(Processor target, Serializer &rez);
-      void send_remove_distributed_resource(AddressSpaceID target,
-                                            Serializer &rez);
-      void send_remove_distributed_remote(AddressSpaceID target,
-                                          Serializer &rez);
-      void send_add_distributed_remote(AddressSpaceID target, Serializer &rez);
-      void send_remove_hierarchical_resource(AddressSpaceID target,
-                                             Serializer &rez);
-      void send_remove_hierarchical_remote(AddressSpaceID target, 
-                                           Serializer &rez);
+      void send_slice_aggregate_complete(Processor target, Serializer &rez);
+      void send_slice_aggregate_commit(Processor target, Serializer &rez);
       void send_back_user(AddressSpaceID target, Serializer &rez);
       void send_back_atomic(AddressSpaceID target, Serializer &rez);
       void send_subscriber(AddressSpaceID target, Serializer &rez);
@@ -1476,6 +1525,8 @@ namespace LegionRuntime {
                                       AddressSpaceID source);
       void handle_slice_remote_complete(Deserializer &derez);
       void handle_slice_remote_commit(Deserializer &derez);
+      void handle_slice_aggregate_complete(Deserializer &derez);
+      void handle_slice_aggregate_commit(Deserializer &derez);
       void handle_distributed_remove_resource(Deserializer &derez);
       void handle_distributed_remove_remote(Deserializer &derez,
                                             AddressSpaceID source);
@@ -1779,8 +1830,13 @@ namespace LegionRuntime {
       std::map<Memory,MemoryManager*> memory_managers;
       // Message managers for each of the other runtimes
       MessageManager *message_managers[MAX_NUM_NODES];
+      // Pending reference count changes for each of the other runtimes
+      ReferenceBatch *reference_batches[MAX_NUM_NODES];
       // For every processor map it to its address space
       const std::map<Processor,AddressSpaceID> proc_spaces;
+      // Number of scheduler runs launched on this node which have
+      // not finished yet (a finished run may have launched the next)
+      volatile unsigned outstanding_schedulers;
     protected:
       struct MapperInfo {
         MapperInfo(void)
@@ -2015,14 +2071,21 @@ namespace LegionRuntime {
       static unsigned initial_directory_size;
       static unsigned superscalar_width;
       static unsigned max_message_size;
+      static unsigned max_message_delay;
       static unsigned max_filter_size;
       static unsigned gc_epoch_size;
+      static unsigned gc_batch_size;
+      static unsigned gc_release_radix;
+      static unsigned spill_threshold;
       static bool enable_imprecise_filter;
       static bool separate_runtime_instances;
       static bool record_registration;
       static bool stealing_disabled;
       static bool unsafe_launch;
       static bool resilient_mode;
+      static bool memoize_mappings;
+      static bool message_statistics;
+      static bool parallel_analysis;
       static unsigned shutdown_counter;
       static int mpi_rank;
       static unsigned mpi_rank_table[MAX_NUM_NODES];
@@ -2051,6 +2114,7 @@ namespace LegionRuntime {
 #ifdef LEGION_PROF
     public:
       static int num_profiling_nodes;
+      static const char *profiling_file_prefix;
 #endif
     public:
       // The baseline time for profiling
@@ -43,6 +43,14 @@ using namespace LegionRuntime::Accessor;
 
 #include <signal.h>
 #include <unistd.h>
+#include <climits>
+// On Linux blocking waits on events sleep on a futex on the
+// generation of the event instead of a per-event condition variable
+#ifdef __linux__
+#define USE_FUTEX_WAIT
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
 #ifdef LEGION_BACKTRACE
 #include <execinfo.h>
 #endif
@@ -191,6 +199,9 @@ namespace LegionRuntime {
       MemoryImpl*          get_memory_impl(Memory m);
       ProcessorImpl*       get_processor_impl(Processor p);
       IndexSpace::Impl*  get_metadata_impl(IndexSpace is);
+      // Instances of structured domains have no index space of their
+      //  own, they are all tracked by the reserved NO_SPACE metadata
+      IndexSpace::Impl*  get_structured_metadata_impl(void);
       RegionInstance::Impl*  get_instance_impl(RegionInstance i);
 
       EventImpl*           get_free_event(void);
@@ -256,24 +267,45 @@ namespace LegionRuntime {
     Runtime::Impl *Runtime::Impl::runtime = NULL;
     DMAQueue *Runtime::Impl::dma_queue = NULL;
 
+    /**
+     * Copies are distributed round-robin over a queue for each
+     * DMA thread.  Threads work from the front of their own queue
+     * and steal from the back of the other queues when they run
+     * out, only going to sleep when there are no copies anywhere.
+     */
     class DMAQueue {
     public:
       DMAQueue(unsigned num_threads);
+      ~DMAQueue(void);
     public:
       void start(void);
       void shutdown(void);
-      void run_dma_loop(void);
+      void run_dma_loop(unsigned worker);
       void enqueue_dma(CopyOperation *copy);
+    protected:
+      CopyOperation* next_copy(unsigned worker);
     public:
       static void* start_dma_thread(void *args);
     public:
       const unsigned num_dma_threads;
     protected:
-      bool dma_shutdown;
+      struct DMAWorker {
+      public:
+        DMAQueue *queue;
+        unsigned index;
+        pthread_mutex_t lock;
+        std::deque<CopyOperation*> copies;
+      };
+    protected:
+      volatile bool dma_shutdown;
+      // Copies enqueued but not yet started and sleeping threads
+      volatile unsigned pending_copies;
+      volatile unsigned sleeping_threads;
+      unsigned next_worker;
       pthread_mutex_t dma_lock;
       pthread_cond_t dma_cond;
       std::vector<pthread_t> dma_threads;
-      std::deque<CopyOperation*> ready_copies;
+      std::vector<DMAWorker> workers;
     };
     
     struct TimerStackEntry {
@@ -474,10 +506,13 @@ namespace LegionRuntime {
 	  generation = 0;
           free_generation = 0;
 	  sources = 0;
+          waiters = 0;
           mutex = (pthread_mutex_t*)malloc(sizeof(pthread_mutex_t));
-          wait_cond = (pthread_cond_t*)malloc(sizeof(pthread_cond_t));
 	  PTHREAD_SAFE_CALL(pthread_mutex_init(mutex,NULL));
+#ifndef USE_FUTEX_WAIT
+          wait_cond = (pthread_cond_t*)malloc(sizeof(pthread_cond_t));
 	  PTHREAD_SAFE_CALL(pthread_cond_init(wait_cond,NULL));
+#endif
 	  if (in_use)
 	  {
 	    // Always initialize the current event to hand out to
@@ -495,9 +530,11 @@ namespace LegionRuntime {
         ~EventImpl(void)
         {
           PTHREAD_SAFE_CALL(pthread_mutex_destroy(mutex));
-          PTHREAD_SAFE_CALL(pthread_cond_destroy(wait_cond));
           free(mutex);
+#ifndef USE_FUTEX_WAIT
+          PTHREAD_SAFE_CALL(pthread_cond_destroy(wait_cond));
           free(wait_cond);
+#endif
 
 	  // free barrier-related data (if present)
 	  if(initial_value)
@@ -531,6 +568,8 @@ namespace LegionRuntime {
 			    const void *_initial_value, size_t _initial_value_size);
         // Alter the arrival count for the barrier
         void alter_arrival_count(int delta, EventGeneration alter_gen);
+        // Release a barrier, return true if it can be reused right away
+        bool destroy_barrier(void);
         void perform_arrival(int count, Event wait_on,
                              EventGeneration apply_gen);
         bool get_result(Event::gen_t needed_gen, void *value, size_t value_size);
@@ -538,19 +577,28 @@ namespace LegionRuntime {
     public:
         // A debug helper method
         void print_waiters(void);
+    protected:
+        // Wake up any threads blocked in wait, must hold the lock
+        void notify_waiters(void);
     private: 
 	bool in_use;
 	unsigned sources;
         unsigned arrivals; // for use with barriers
 	const EventIndex index;
-	EventGeneration generation;
+        // Only ever increases, updated while holding the lock but
+        // read without it to test whether the event has triggered
+	volatile EventGeneration generation;
         EventGeneration free_generation;
 	// The version of the event to hand out (i.e. with generation+1)
 	// so we can detect when the event has triggered with testing
 	// generational equality
 	Event current; 
 	pthread_mutex_t *mutex;
+#ifndef USE_FUTEX_WAIT
 	pthread_cond_t *wait_cond;
+#endif
+        // Number of threads blocked in wait on this event
+        volatile unsigned waiters;
         std::list<TriggerableInfo> triggerables;
         const ReductionOpUntyped *redop;
         void *initial_value;
@@ -632,8 +680,10 @@ namespace LegionRuntime {
         const std::set<Processor>& get_utility_users(void) const;
         void add_utility_user(Processor p, ProcessorImpl *impl);
     public:
-        void add_to_group(ProcessorGroup *grp) { groups.push_back(grp); }
+        void add_to_group(ProcessorGroup *grp);
         virtual void get_group_members(std::vector<Processor>& members);
+        // Wake up the processor thread if it is sleeping waiting for work
+        bool wake_if_idle(void);
     public:
         virtual Event spawn(Processor::TaskFuncID func_id, const void * args,
                             size_t arglen, Event wait_on, int priority);
@@ -647,6 +697,7 @@ namespace LegionRuntime {
     protected:
 	bool execute_task(bool permit_shutdown);
         bool perform_scheduling(bool need_lock);
+        bool steal_group_task(void);
     protected:
 	class TaskDesc {
         public:
@@ -701,6 +752,7 @@ namespace LegionRuntime {
 	// Used for detecting the shutdown condition
 	bool shutdown;
 	EventImpl *shutdown_trigger;
+        bool idle; // sleeping waiting for work
         const bool is_utility_proc;
         const bool return_on_finish;
         unsigned remaining_stops; // for utility processor knowing when to stop
@@ -711,6 +763,14 @@ namespace LegionRuntime {
         std::vector<ProcessorGroup *> groups;  // groups this proc is a member of
     };
 
+    /**
+     * Tasks launched on a processor group go into a single shared
+     * queue for the group.  Members steal tasks from the queue of
+     * each of their groups whenever their own ready queue runs dry
+     * or the group has a higher priority task than their own next one,
+     * so a task is picked up by whichever member becomes free first
+     * and only one idle member has to be woken up for each task.
+     */
     class ProcessorGroup : public ProcessorImpl {
     public:
       static const Processor::id_t FIRST_PROC_GROUP_ID = 1000;
@@ -719,6 +779,11 @@ namespace LegionRuntime {
 	: ProcessorImpl(0 /*init*/, Processor::TaskIDTable(), p, 0 /*stacksize*/), next_target(0)
       {
 	proc_kind = Processor::PROC_GROUP;
+        PTHREAD_SAFE_CALL(pthread_mutex_init(&group_lock,NULL));
+      }
+      virtual ~ProcessorGroup(void)
+      {
+        PTHREAD_SAFE_CALL(pthread_mutex_destroy(&group_lock));
       }
 
       void add_member(ProcessorImpl *new_member) {
@@ -730,10 +795,36 @@ namespace LegionRuntime {
 
       virtual Event spawn(Processor::TaskFuncID func_id, const void * args,
 			  size_t arglen, Event wait_on, int priority);
-
+    public:
+      // Put a task whose precondition has triggered on the shared queue
+      void add_ready_task(TaskDesc *task);
+      // Priority of the task at the head of the shared queue, false if empty
+      bool head_priority(int &priority);
+      // Called by members to take a task from the shared queue, only
+      // if it has a higher priority than min_priority
+      TaskDesc* steal_task(int min_priority = INT_MIN);
+    protected:
+      // Defers a task until its precondition triggers
+      class DeferredGroupTask : public Triggerable {
+      public:
+        DeferredGroupTask(ProcessorGroup *g, TaskDesc *t)
+          : group(g), task(t) { }
+      public:
+        virtual bool trigger(unsigned count = 1, TriggerHandle handle = 0)
+        {
+          group->add_ready_task(task);
+          // Delete us
+          return true;
+        }
+      protected:
+        ProcessorGroup *const group;
+        TaskDesc *const task;
+      };
     protected:
       std::vector<ProcessorImpl *> members;
       size_t next_target;
+      pthread_mutex_t group_lock;
+      std::deque<TaskDesc*> group_queue;
     };
 
     ////////////////////////////////////////////////////////
@@ -850,10 +941,12 @@ namespace LegionRuntime {
 
     bool EventImpl::has_triggered(EventGeneration needed_gen)
     {
-	bool result = false;
-	PTHREAD_SAFE_CALL(pthread_mutex_lock(mutex));
-	result = (needed_gen <= generation);
-	PTHREAD_SAFE_CALL(pthread_mutex_unlock(mutex));
+        // The generation only ever increases so we can test it
+        // without taking the lock, the barrier makes sure anything
+        // written before the event triggered is visible to us
+	bool result = (needed_gen <= generation);
+        if (result)
+          __sync_synchronize();
 	return result;
     }
 
@@ -861,15 +954,35 @@ namespace LegionRuntime {
     {
         if (block)
         {
-            // First check to see if the event has triggered
+            if (has_triggered(needed_gen))
+              return;
+            DetailedTimer::ScopedPush sp(TIME_NONE);
+#ifdef USE_FUTEX_WAIT
+            // Sleep on the generation word directly, the kernel will
+            // only put us to sleep if the generation still has the value
+            // we observed so we can't miss the wake-up in trigger
+            __sync_fetch_and_add(&waiters, 1);
+            while (true)
+            {
+              EventGeneration observed = generation;
+              if (needed_gen <= observed)
+                break;
+              syscall(SYS_futex, (int*)&generation, FUTEX_WAIT_PRIVATE,
+                      (int)observed, NULL, NULL, 0);
+            }
+            __sync_fetch_and_sub(&waiters, 1);
+            __sync_synchronize();
+#else
             PTHREAD_SAFE_CALL(pthread_mutex_lock(mutex));	
+            waiters++;
             // Wait until the generation indicates that the event has occurred
             while (needed_gen > generation) 
             {
-                    DetailedTimer::ScopedPush sp(TIME_NONE);
                     PTHREAD_SAFE_CALL(pthread_cond_wait(wait_cond,mutex));
             }
+            waiters--;
             PTHREAD_SAFE_CALL(pthread_mutex_unlock(mutex));
+#endif
         }
         else
         {
@@ -1012,7 +1125,7 @@ namespace LegionRuntime {
                   }
                 }
                 // Wake up any waiters
-		PTHREAD_SAFE_CALL(pthread_cond_broadcast(wait_cond));
+                notify_waiters();
 		// Can't be holding the lock when triggering other triggerables
 		PTHREAD_SAFE_CALL(pthread_mutex_unlock(mutex));
 		// Trigger any dependent events for this generation
@@ -1048,6 +1161,22 @@ namespace LegionRuntime {
         return false;
     }
 
+    void EventImpl::notify_waiters(void)
+    {
+      // Make sure the new generation is visible before we
+      // check for waiters, this pairs with the increment of
+      // the waiters count in wait
+      __sync_synchronize();
+      if (waiters == 0)
+        return;
+#ifdef USE_FUTEX_WAIT
+      syscall(SYS_futex, (int*)&generation, FUTEX_WAKE_PRIVATE,
+              INT_MAX, NULL, NULL, 0);
+#else
+      PTHREAD_SAFE_CALL(pthread_cond_broadcast(wait_cond));
+#endif
+    }
+
     bool EventImpl::activate(void)
     {
 	bool result = false;
@@ -1143,6 +1272,33 @@ namespace LegionRuntime {
       return result;
     }
 
+    bool EventImpl::destroy_barrier(void)
+    {
+      bool result = false;
+      PTHREAD_SAFE_CALL(pthread_mutex_lock(mutex));
+#ifdef DEBUG_LOW_LEVEL
+      assert(in_use);
+#endif
+      if (triggerables.empty() && (waiters == 0) && 
+          pending_alterations.empty() && pending_arrivals.empty())
+      {
+        // Nobody is depending on the current phase so retire it
+        // now and make the event available for reuse, anyone still
+        // holding the barrier will see all its phases as triggered
+        generation = current.gen;
+        in_use = false;
+        result = true;
+      }
+      else
+      {
+        // Otherwise stop at the current phase so that the event
+        // is freed once the last phase that is in use triggers
+        free_generation = current.gen;
+      }
+      PTHREAD_SAFE_CALL(pthread_mutex_unlock(mutex));
+      return result;
+    }
+
     void EventImpl::alter_arrival_count(int delta, EventGeneration alter_gen)
     {
 #ifdef DEBUG_LOW_LEVEL
@@ -1312,7 +1468,11 @@ namespace LegionRuntime {
     {
       DetailedTimer::ScopedPush sp(TIME_LOW_LEVEL);
       EventImpl *impl = Runtime::Impl::get_runtime()->get_event_impl(*this);
-      Runtime::Impl::get_runtime()->free_event(impl);
+      // The barrier can only go back on the free list once none of
+      // its phases are still in use, otherwise it will be freed when
+      // its last phase triggers
+      if (impl->destroy_barrier())
+        Runtime::Impl::get_runtime()->free_event(impl);
     }
 
     Barrier Barrier::advance_barrier(void) const
@@ -1906,6 +2066,58 @@ namespace LegionRuntime {
         PTHREAD_SAFE_CALL(pthread_attr_setstacksize(&attr,stacksize));
         shutdown = false;
         shutdown_trigger = NULL;
+        idle = false;
+    }
+
+    void ProcessorImpl::add_to_group(ProcessorGroup *grp)
+    {
+        // Groups can be created while we're running
+        PTHREAD_SAFE_CALL(pthread_mutex_lock(mutex));
+        groups.push_back(grp);
+        PTHREAD_SAFE_CALL(pthread_mutex_unlock(mutex));
+    }
+
+    bool ProcessorImpl::wake_if_idle(void)
+    {
+        bool result = false;
+        PTHREAD_SAFE_CALL(pthread_mutex_lock(mutex));
+        if (idle)
+        {
+          idle = false;
+          PTHREAD_SAFE_CALL(pthread_cond_signal(wait_cond));
+          result = true;
+        }
+        PTHREAD_SAFE_CALL(pthread_mutex_unlock(mutex));
+        return result;
+    }
+
+    bool ProcessorImpl::steal_group_task(void)
+    {
+        // Better already hold the lock when calling this method
+        // Find the group with the highest priority task that beats
+        // the head of our own ready queue, ties go to our own tasks
+        int min_priority = ready_queue.empty() ? INT_MIN : 
+                            ready_queue.front()->priority;
+        ProcessorGroup *target = NULL;
+        int target_priority = min_priority;
+        for (std::vector<ProcessorGroup*>::const_iterator it = groups.begin();
+              it != groups.end(); it++)
+        {
+          int priority;
+          if ((*it)->head_priority(priority) && (priority > target_priority))
+          {
+            target = *it;
+            target_priority = priority;
+          }
+        }
+        if (target == NULL)
+          return false;
+        // Another member might have beaten us to it
+        TaskDesc *task = target->steal_task(min_priority);
+        if (task == NULL)
+          return false;
+        add_to_ready_queue(task);
+        return true;
     }
 
     void ProcessorImpl::get_group_members(std::vector<Processor>& members)
@@ -2131,8 +2343,12 @@ namespace LegionRuntime {
     // returns true if the shutdown task was executed
     bool ProcessorImpl::execute_task(bool permit_shutdown)
     {
-        // Look through the waiting queue, to see if any tasks
-        // have been woken up	
+        // See if any of our groups have a task with a higher priority
+        // than our next one, or any task at all if we're out of work.
+        // We hold the lock from here until we go to sleep so a group 
+        // can't miss waking us.
+        if (!groups.empty())
+          steal_group_task();
         	
         // If we don't have any work to do, check to see
         // if we can run the idle task.  Also if we're the utility
@@ -2147,7 +2363,9 @@ namespace LegionRuntime {
         }
         else if (is_utility_proc && !shutdown && ready_queue.empty())
         {
+          idle = true;
 	  PTHREAD_SAFE_CALL(pthread_cond_wait(wait_cond,mutex));
+          idle = false;
 
           PTHREAD_SAFE_CALL(pthread_mutex_unlock(mutex));
           // Note we don't need the lock to read these
@@ -2218,7 +2436,9 @@ namespace LegionRuntime {
                 if (!shutdown)
                 {
                   DetailedTimer::ScopedPush sp(TIME_NONE);
+                  idle = true;
                   PTHREAD_SAFE_CALL(pthread_cond_wait(wait_cond,mutex));
+                  idle = false;
                 }
 		PTHREAD_SAFE_CALL(pthread_mutex_unlock(mutex));
 	}
@@ -2337,17 +2557,78 @@ namespace LegionRuntime {
     Event ProcessorGroup::spawn(Processor::TaskFuncID func_id, const void * args,
 				size_t arglen, Event wait_on, int priority)
     {
-      // Create a new task description and enqueue it for all the members
+      // Create a new task description that will be run by exactly
+      // one of the members of the group
       TaskDesc *task = new TaskDesc(func_id, args, arglen, wait_on,
                                     Runtime::Impl::get_runtime()->get_free_event(),
-                                    priority, 0, 0, members.size());
+                                    priority, 0, 0, 1);
       Event result = task->complete->get_event();
 
-      for (std::vector<ProcessorImpl*>::const_iterator it = members.begin();
-            it != members.end(); it++)
+      if (wait_on.exists())
       {
-        (*it)->enqueue_task(task);
+        DeferredGroupTask *deferred = new DeferredGroupTask(this, task);
+        EventImpl *wait_impl = Runtime::Impl::get_runtime()->get_event_impl(wait_on);
+        if (!wait_impl->register_dependent(deferred, wait_on.gen))
+        {
+          // Already triggered so the task is ready now
+          delete deferred;
+          add_ready_task(task);
+        }
       }
+      else
+        add_ready_task(task);
+      return result;
+    }
+
+    void ProcessorGroup::add_ready_task(TaskDesc *task)
+    {
+      PTHREAD_SAFE_CALL(pthread_mutex_lock(&group_lock));
+      // Keep the queue sorted by priority like the ready queues
+      if (group_queue.empty() || (group_queue.back()->priority >= task->priority))
+        group_queue.push_back(task);
+      else
+      {
+        std::deque<TaskDesc*>::iterator it = group_queue.begin();
+        while ((it != group_queue.end()) && ((*it)->priority >= task->priority))
+          it++;
+        group_queue.insert(it, task);
+      }
+      size_t start = next_target;
+      next_target = (next_target + 1) % members.size();
+      PTHREAD_SAFE_CALL(pthread_mutex_unlock(&group_lock));
+      // Wake up one idle member to come steal the task, if all the
+      // members are busy the first one to finish will pick it up
+      for (unsigned idx = 0; idx < members.size(); idx++)
+      {
+        if (members[(start + idx) % members.size()]->wake_if_idle())
+          break;
+      }
+    }
+
+    bool ProcessorGroup::head_priority(int &priority)
+    {
+      bool result = false;
+      PTHREAD_SAFE_CALL(pthread_mutex_lock(&group_lock));
+      if (!group_queue.empty())
+      {
+        priority = group_queue.front()->priority;
+        result = true;
+      }
+      PTHREAD_SAFE_CALL(pthread_mutex_unlock(&group_lock));
+      return result;
+    }
+
+    ProcessorImpl::TaskDesc* ProcessorGroup::steal_task(int min_priority)
+    {
+      TaskDesc *result = NULL;
+      PTHREAD_SAFE_CALL(pthread_mutex_lock(&group_lock));
+      if (!group_queue.empty() && 
+          (group_queue.front()->priority > min_priority))
+      {
+        result = group_queue.front();
+        group_queue.pop_front();
+      }
+      PTHREAD_SAFE_CALL(pthread_mutex_unlock(&group_lock));
       return result;
     }
 
@@ -2467,13 +2748,13 @@ namespace LegionRuntime {
 
     ElementMask::ElementMask(void)
       : first_element(-1), num_elements(-1), memory(Memory::NO_MEMORY), offset(-1),
-	raw_data(0), first_enabled_elmt(-1), last_enabled_elmt(-1)
+	raw_data(0), chunks(0), first_enabled_elmt(-1), last_enabled_elmt(-1)
     {
     }
 
     ElementMask::ElementMask(int _num_elements, int _first_element /*= 0*/)
       : first_element(_first_element), num_elements(_num_elements), memory(Memory::NO_MEMORY), offset(-1),
-        first_enabled_elmt(-1), last_enabled_elmt(-1)
+        chunks(0), first_enabled_elmt(-1), last_enabled_elmt(-1)
     {
       size_t bytes_needed = ElementMaskImpl::bytes_needed(first_element, num_elements);
       raw_data = calloc(1, bytes_needed);
@@ -2488,6 +2769,7 @@ namespace LegionRuntime {
       num_elements = copy_from.num_elements;
       first_enabled_elmt = copy_from.first_enabled_elmt;
       last_enabled_elmt = copy_from.last_enabled_elmt;
+      chunks = 0;
       size_t bytes_needed = ElementMaskImpl::bytes_needed(first_element, num_elements);
       //if (raw_data)
       //  free(raw_data);
@@ -3903,7 +4185,7 @@ namespace LegionRuntime {
 
 	  default: assert(0);
 	  }
-	  IndexSpace::Impl *r = Runtime::Impl::get_runtime()->get_metadata_impl(get_index_space());
+	  IndexSpace::Impl *r = Runtime::Impl::get_runtime()->get_structured_metadata_impl();
 	  return r->create_instance(memory, field_sizes, block_size, dl, int(inst_extent.hi) + 1, redop_id);
 	} else {
 	  IndexSpace::Impl *r = Runtime::Impl::get_runtime()->get_metadata_impl(get_index_space());
@@ -4720,11 +5002,27 @@ namespace LegionRuntime {
     ////////////////////////////////////////////////////////
 
     DMAQueue::DMAQueue(unsigned num_threads)
-      : num_dma_threads(num_threads), dma_shutdown(false)
+      : num_dma_threads(num_threads), dma_shutdown(false),
+        pending_copies(0), sleeping_threads(0), next_worker(0)
     {
       PTHREAD_SAFE_CALL(pthread_mutex_init(&dma_lock,NULL));
       PTHREAD_SAFE_CALL(pthread_cond_init(&dma_cond,NULL));
       dma_threads.resize(num_dma_threads);
+      workers.resize(num_dma_threads);
+      for (unsigned idx = 0; idx < num_dma_threads; idx++)
+      {
+        workers[idx].queue = this;
+        workers[idx].index = idx;
+        PTHREAD_SAFE_CALL(pthread_mutex_init(&(workers[idx].lock),NULL));
+      }
+    }
+
+    DMAQueue::~DMAQueue(void)
+    {
+      for (unsigned idx = 0; idx < num_dma_threads; idx++)
+        PTHREAD_SAFE_CALL(pthread_mutex_destroy(&(workers[idx].lock)));
+      PTHREAD_SAFE_CALL(pthread_mutex_destroy(&dma_lock));
+      PTHREAD_SAFE_CALL(pthread_cond_destroy(&dma_cond));
     }
 
     void DMAQueue::start(void)
@@ -4734,7 +5032,8 @@ namespace LegionRuntime {
       for (unsigned idx = 0; idx < num_dma_threads; idx++)
       {
         PTHREAD_SAFE_CALL(pthread_create(&dma_threads[idx], &attr,
-                                         DMAQueue::start_dma_thread, (void*)this));
+                                         DMAQueue::start_dma_thread, 
+                                         (void*)&(workers[idx])));
       }
       PTHREAD_SAFE_CALL(pthread_attr_destroy(&attr));
     }
@@ -4753,38 +5052,63 @@ namespace LegionRuntime {
       }
     }
 
-    void DMAQueue::run_dma_loop(void)
+    CopyOperation* DMAQueue::next_copy(unsigned worker)
     {
-      while (true)
+      CopyOperation *copy = NULL;
+      // First try our own queue
       {
-        CopyOperation *copy = NULL;
-        PTHREAD_SAFE_CALL(pthread_mutex_lock(&dma_lock));
-        if (ready_copies.empty() && !dma_shutdown)
+        DMAWorker &local = workers[worker];
+        PTHREAD_SAFE_CALL(pthread_mutex_lock(&local.lock));
+        if (!local.copies.empty())
         {
-          // Go to sleep
-          PTHREAD_SAFE_CALL(pthread_cond_wait(&dma_cond, &dma_lock));
+          copy = local.copies.front();
+          local.copies.pop_front();
         }
-        // When we wake up see if there is anything
-        // to do or see if we are done
-        if (!ready_copies.empty())
-        {
-          copy = ready_copies.front();
-          ready_copies.pop_front();
-        }
-        else if (dma_shutdown)
+        PTHREAD_SAFE_CALL(pthread_mutex_unlock(&local.lock));
+      }
+      // Otherwise steal from the back of somebody else's queue
+      for (unsigned idx = 1; (copy == NULL) && (idx < num_dma_threads); idx++)
+      {
+        DMAWorker &victim = workers[(worker + idx) % num_dma_threads];
+        PTHREAD_SAFE_CALL(pthread_mutex_lock(&victim.lock));
+        if (!victim.copies.empty())
         {
-          PTHREAD_SAFE_CALL(pthread_mutex_unlock(&dma_lock));
-          // Break out of the loop
-          break;
+          copy = victim.copies.back();
+          victim.copies.pop_back();
         }
-        // Release our lock
-        PTHREAD_SAFE_CALL(pthread_mutex_unlock(&dma_lock));
-        // If we have a copy perform it and then delete it
+        PTHREAD_SAFE_CALL(pthread_mutex_unlock(&victim.lock));
+      }
+      if (copy != NULL)
+        __sync_fetch_and_sub(&pending_copies, 1);
+      return copy;
+    }
+
+    void DMAQueue::run_dma_loop(unsigned worker)
+    {
+      while (true)
+      {
+        CopyOperation *copy = next_copy(worker);
         if (copy != NULL)
         {
           copy->perform_copy_operation();
           delete copy;
+          continue;
         }
+        PTHREAD_SAFE_CALL(pthread_mutex_lock(&dma_lock));
+        // Advertise that we're going to sleep before checking for
+        // copies one last time, this pairs with enqueue_dma
+        __sync_fetch_and_add(&sleeping_threads, 1);
+        if ((pending_copies == 0) && !dma_shutdown)
+        {
+          // Go to sleep
+          PTHREAD_SAFE_CALL(pthread_cond_wait(&dma_cond, &dma_lock));
+        }
+        __sync_fetch_and_sub(&sleeping_threads, 1);
+        // See if we are done
+        const bool done = dma_shutdown && (pending_copies == 0);
+        PTHREAD_SAFE_CALL(pthread_mutex_unlock(&dma_lock));
+        if (done)
+          break;
       }
     }
 
@@ -4792,10 +5116,21 @@ namespace LegionRuntime {
     {
       if (num_dma_threads > 0)
       {
-        PTHREAD_SAFE_CALL(pthread_mutex_lock(&dma_lock));
-        ready_copies.push_back(copy);
-        PTHREAD_SAFE_CALL(pthread_cond_signal(&dma_cond));
-        PTHREAD_SAFE_CALL(pthread_mutex_unlock(&dma_lock));
+        // Count the copy before it is visible so the count
+        // never drops below the number of queued copies
+        __sync_fetch_and_add(&pending_copies, 1);
+        unsigned target = __sync_fetch_and_add(&next_worker, 1) % num_dma_threads;
+        DMAWorker &worker = workers[target];
+        PTHREAD_SAFE_CALL(pthread_mutex_lock(&worker.lock));
+        worker.copies.push_back(copy);
+        PTHREAD_SAFE_CALL(pthread_mutex_unlock(&worker.lock));
+        // Only take the lock to wake someone up if a thread is asleep
+        if (sleeping_threads > 0)
+        {
+          PTHREAD_SAFE_CALL(pthread_mutex_lock(&dma_lock));
+          PTHREAD_SAFE_CALL(pthread_cond_signal(&dma_cond));
+          PTHREAD_SAFE_CALL(pthread_mutex_unlock(&dma_lock));
+        }
       }
       else
       {
@@ -4807,8 +5142,8 @@ namespace LegionRuntime {
 
     /*static*/ void* DMAQueue::start_dma_thread(void *args)
     {
-      DMAQueue *dma_queue = (DMAQueue*)args;
-      dma_queue->run_dma_loop();
+      DMAWorker *worker = (DMAWorker*)args;
+      worker->queue->run_dma_loop(worker->index);
       pthread_exit(NULL);
     }
 
@@ -5634,6 +5969,14 @@ namespace LegionRuntime {
 	return result;
     }
 
+    IndexSpace::Impl* Runtime::Impl::get_structured_metadata_impl(void)
+    {
+        PTHREAD_SAFE_CALL(pthread_rwlock_rdlock(&metadata_lock));
+        IndexSpace::Impl *result = metadatas[0];
+        PTHREAD_SAFE_CALL(pthread_rwlock_unlock(&metadata_lock));
+	return result;
+    }
+
     void Runtime::Impl::free_metadata(IndexSpace::Impl *impl)
     {
         PTHREAD_SAFE_CALL(pthread_mutex_lock(&free_metas_lock));
@@ -0,0 +1,416 @@
+/* Copyright 2015 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __LEGION_SPATIAL_INDEX_H__
+#define __LEGION_SPATIAL_INDEX_H__
+
+#include <cassert>
+#include <vector>
+#include <algorithm>
+
+#include "arrays.h"
+
+// Number of rectangles stored in each leaf of a spatial index
+#ifndef SPATIAL_INDEX_LEAF_SIZE
+#define SPATIAL_INDEX_LEAF_SIZE         4
+#endif
+// Smallest number of pairwise rectangle tests for which it is
+// worth building a spatial index instead of just doing them
+#ifndef SPATIAL_INDEX_THRESHOLD
+#define SPATIAL_INDEX_THRESHOLD         256
+#endif
+
+namespace LegionRuntime {
+  namespace HighLevel {
+
+    /**
+     * \class SpatialIndex
+     * A bounding volume hierarchy over a set of discrete
+     * N-dimensional rectangles each with a tag.  Rectangles
+     * are all added first and the hierarchy is built by the
+     * first query, splitting at the median along the longest
+     * axis so queries are O(log n) plus the number of results.
+     * This is what we use to avoid pairwise tests between sets
+     * of domains for intersection, dominance and disjointness.
+     */
+    template<unsigned DIM>
+    class SpatialIndex {
+    public:
+      typedef Arrays::Rect<DIM> IndexRect;
+    public:
+      struct Entry {
+      public:
+        Entry(void) { }
+        Entry(const IndexRect &r, unsigned t) : rect(r), tag(t) { }
+      public:
+        IndexRect rect;
+        unsigned tag;
+      };
+      struct Node {
+      public:
+        IndexRect bounds;
+        // Leaves own entries [begin,end), other nodes have children
+        unsigned begin, end;
+        int left, right;
+      };
+    public:
+      SpatialIndex(void);
+    public:
+      void add_rect(const IndexRect &rect, unsigned tag = 0);
+      inline size_t size(void) const { return entries.size(); }
+      inline bool empty(void) const { return entries.empty(); }
+    public:
+      // Does the rectangle overlap any entry with a tag other than skip
+      bool intersects(const IndexRect &rect, int skip_tag = -1);
+      // Return the first entry overlapping the rectangle or NULL
+      const Entry* find_intersection(const IndexRect &rect);
+      // Append the indexes of all the entries overlapping the rectangle
+      void find_intersections(const IndexRect &rect,
+                              std::vector<unsigned> &results);
+      // Does the union of the entries contain every point of the rect
+      bool covers(const IndexRect &rect);
+      // Does any pair of entries with different tags overlap
+      bool has_overlaps(unsigned &first_tag, unsigned &second_tag);
+      inline const Entry& get_entry(unsigned idx) const
+        { return entries[idx]; }
+    protected:
+      void build(void);
+      int build_node(unsigned begin, unsigned end);
+      static inline bool is_empty(const IndexRect &rect);
+      static inline bool overlaps(const IndexRect &one, const IndexRect &two);
+      static inline bool contains(const IndexRect &one, const IndexRect &two);
+    protected:
+      struct CenterOrder {
+      public:
+        CenterOrder(unsigned d) : dim(d) { }
+        inline bool operator()(const Entry &one, const Entry &two) const
+        {
+          return ((long long)one.rect.lo.x[dim] + one.rect.hi.x[dim]) <
+                 ((long long)two.rect.lo.x[dim] + two.rect.hi.x[dim]);
+        }
+      public:
+        const unsigned dim;
+      };
+    protected:
+      std::vector<Entry> entries;
+      std::vector<Node> nodes;
+      bool built;
+    };
+
+    /////////////////////////////////////////////////////////////
+    // Spatial Index
+    /////////////////////////////////////////////////////////////
+
+    //--------------------------------------------------------------------------
+    template<unsigned DIM>
+    SpatialIndex<DIM>::SpatialIndex(void)
+      : built(false)
+    //--------------------------------------------------------------------------
+    {
+    }
+
+    //--------------------------------------------------------------------------
+    template<unsigned DIM>
+    /*static*/ inline bool SpatialIndex<DIM>::is_empty(const IndexRect &rect)
+    //--------------------------------------------------------------------------
+    {
+      for (unsigned idx = 0; idx < DIM; idx++)
+        if (rect.lo.x[idx] > rect.hi.x[idx])
+          return true;
+      return false;
+    }
+
+    //--------------------------------------------------------------------------
+    template<unsigned DIM>
+    /*static*/ inline bool SpatialIndex<DIM>::overlaps(const IndexRect &one,
+                                                       const IndexRect &two)
+    //--------------------------------------------------------------------------
+    {
+      for (unsigned idx = 0; idx < DIM; idx++)
+        if ((one.hi.x[idx] < two.lo.x[idx]) || (one.lo.x[idx] > two.hi.x[idx]))
+          return false;
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    template<unsigned DIM>
+    /*static*/ inline bool SpatialIndex<DIM>::contains(const IndexRect &one,
+                                                       const IndexRect &two)
+    //--------------------------------------------------------------------------
+    {
+      for (unsigned idx = 0; idx < DIM; idx++)
+        if ((one.lo.x[idx] > two.lo.x[idx]) || (one.hi.x[idx] < two.hi.x[idx]))
+          return false;
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    template<unsigned DIM>
+    void SpatialIndex<DIM>::add_rect(const IndexRect &rect, unsigned tag)
+    //--------------------------------------------------------------------------
+    {
+      // Empty rectangles can never overlap or cover anything
+      if (is_empty(rect))
+        return;
+      entries.push_back(Entry(rect, tag));
+      built = false;
+    }
+
+    //--------------------------------------------------------------------------
+    template<unsigned DIM>
+    void SpatialIndex<DIM>::build(void)
+    //--------------------------------------------------------------------------
+    {
+      nodes.clear();
+      if (!entries.empty())
+      {
+        // A balanced tree over n entries has fewer than 2n/leaf nodes
+        nodes.reserve(2*(entries.size()/SPATIAL_INDEX_LEAF_SIZE + 1));
+        build_node(0, entries.size());
+      }
+      built = true;
+    }
+
+    //--------------------------------------------------------------------------
+    template<unsigned DIM>
+    int SpatialIndex<DIM>::build_node(unsigned begin, unsigned end)
+    //--------------------------------------------------------------------------
+    {
+      const int index = nodes.size();
+      nodes.push_back(Node());
+      IndexRect bounds = entries[begin].rect;
+      for (unsigned idx = begin+1; idx < end; idx++)
+        bounds = bounds.convex_hull(entries[idx].rect);
+      if ((end - begin) <= SPATIAL_INDEX_LEAF_SIZE)
+      {
+        Node &leaf = nodes[index];
+        leaf.bounds = bounds;
+        leaf.begin = begin;
+        leaf.end = end;
+        leaf.left = -1;
+        leaf.right = -1;
+        return index;
+      }
+      // Split at the median along the longest axis of the bounds
+      unsigned split_dim = 0;
+      long long longest = -1;
+      for (unsigned idx = 0; idx < DIM; idx++)
+      {
+        const long long extent =
+          (long long)bounds.hi.x[idx] - (long long)bounds.lo.x[idx];
+        if (extent > longest)
+        {
+          longest = extent;
+          split_dim = idx;
+        }
+      }
+      const unsigned middle = begin + (end - begin)/2;
+      std::nth_element(entries.begin()+begin, entries.begin()+middle,
+                       entries.begin()+end, CenterOrder(split_dim));
+      // Recursion can reallocate nodes so don't hold references
+      const int left = build_node(begin, middle);
+      const int right = build_node(middle, end);
+      Node &node = nodes[index];
+      node.bounds = bounds;
+      node.begin = begin;
+      node.end = end;
+      node.left = left;
+      node.right = right;
+      return index;
+    }
+
+    //--------------------------------------------------------------------------
+    template<unsigned DIM>
+    bool SpatialIndex<DIM>::intersects(const IndexRect &rect, int skip_tag)
+    //--------------------------------------------------------------------------
+    {
+      if (entries.empty() || is_empty(rect))
+        return false;
+      if (!built)
+        build();
+      std::vector<int> stack;
+      stack.push_back(0);
+      while (!stack.empty())
+      {
+        const Node &node = nodes[stack.back()];
+        stack.pop_back();
+        if (!overlaps(node.bounds, rect))
+          continue;
+        if (node.left < 0)
+        {
+          for (unsigned idx = node.begin; idx < node.end; idx++)
+          {
+            if ((skip_tag >= 0) && (entries[idx].tag == unsigned(skip_tag)))
+              continue;
+            if (overlaps(entries[idx].rect, rect))
+              return true;
+          }
+        }
+        else
+        {
+          stack.push_back(node.right);
+          stack.push_back(node.left);
+        }
+      }
+      return false;
+    }
+
+    //--------------------------------------------------------------------------
+    template<unsigned DIM>
+    const typename SpatialIndex<DIM>::Entry*
+                 SpatialIndex<DIM>::find_intersection(const IndexRect &rect)
+    //--------------------------------------------------------------------------
+    {
+      if (entries.empty() || is_empty(rect))
+        return NULL;
+      if (!built)
+        build();
+      std::vector<int> stack;
+      stack.push_back(0);
+      while (!stack.empty())
+      {
+        const Node &node = nodes[stack.back()];
+        stack.pop_back();
+        if (!overlaps(node.bounds, rect))
+          continue;
+        if (node.left < 0)
+        {
+          for (unsigned idx = node.begin; idx < node.end; idx++)
+            if (overlaps(entries[idx].rect, rect))
+              return &entries[idx];
+        }
+        else
+        {
+          stack.push_back(node.right);
+          stack.push_back(node.left);
+        }
+      }
+      return NULL;
+    }
+
+    //--------------------------------------------------------------------------
+    template<unsigned DIM>
+    void SpatialIndex<DIM>::find_intersections(const IndexRect &rect,
+                                               std::vector<unsigned> &results)
+    //--------------------------------------------------------------------------
+    {
+      if (entries.empty() || is_empty(rect))
+        return;
+      if (!built)
+        build();
+      std::vector<int> stack;
+      stack.push_back(0);
+      while (!stack.empty())
+      {
+        const Node &node = nodes[stack.back()];
+        stack.pop_back();
+        if (!overlaps(node.bounds, rect))
+          continue;
+        if (contains(rect, node.bounds))
+        {
+          // Everything underneath overlaps so skip the tests
+          for (unsigned idx = node.begin; idx < node.end; idx++)
+            results.push_back(idx);
+        }
+        else if (node.left < 0)
+        {
+          for (unsigned idx = node.begin; idx < node.end; idx++)
+            if (overlaps(entries[idx].rect, rect))
+              results.push_back(idx);
+        }
+        else
+        {
+          stack.push_back(node.right);
+          stack.push_back(node.left);
+        }
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    template<unsigned DIM>
+    bool SpatialIndex<DIM>::covers(const IndexRect &rect)
+    //--------------------------------------------------------------------------
+    {
+      if (is_empty(rect))
+        return true;
+      // Keep a list of the pieces of the rectangle that we haven't
+      // shown to be covered yet.  For each piece find an entry that
+      // overlaps it and replace the piece with what is left after
+      // cutting that entry out, which is at most 2*DIM smaller pieces.
+      std::vector<IndexRect> pieces;
+      pieces.push_back(rect);
+      while (!pieces.empty())
+      {
+        IndexRect piece = pieces.back();
+        pieces.pop_back();
+        const Entry *entry = find_intersection(piece);
+        if (entry == NULL)
+          return false;
+        const IndexRect &cut = entry->rect;
+        for (unsigned idx = 0; idx < DIM; idx++)
+        {
+          if (piece.lo.x[idx] < cut.lo.x[idx])
+          {
+            IndexRect below = piece;
+            below.hi.x[idx] = cut.lo.x[idx] - 1;
+            pieces.push_back(below);
+            piece.lo.x[idx] = cut.lo.x[idx];
+          }
+          if (piece.hi.x[idx] > cut.hi.x[idx])
+          {
+            IndexRect above = piece;
+            above.lo.x[idx] = cut.hi.x[idx] + 1;
+            pieces.push_back(above);
+            piece.hi.x[idx] = cut.hi.x[idx];
+          }
+        }
+        // What is left of the piece is inside the entry
+      }
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    template<unsigned DIM>
+    bool SpatialIndex<DIM>::has_overlaps(unsigned &first_tag,
+                                         unsigned &second_tag)
+    //--------------------------------------------------------------------------
+    {
+      if (!built)
+        build();
+      std::vector<unsigned> overlapping;
+      for (unsigned idx = 0; idx < entries.size(); idx++)
+      {
+        overlapping.clear();
+        find_intersections(entries[idx].rect, overlapping);
+        for (unsigned idx2 = 0; idx2 < overlapping.size(); idx2++)
+        {
+          const Entry &other = entries[overlapping[idx2]];
+          if (other.tag == entries[idx].tag)
+            continue;
+          first_tag = entries[idx].tag;
+          second_tag = other.tag;
+          return true;
+        }
+      }
+      return false;
+    }
+
+  }; // namespace HighLevel
+}; // namespace LegionRuntime
+
+#endif // __LEGION_SPATIAL_INDEX_H__
+
+// EOF
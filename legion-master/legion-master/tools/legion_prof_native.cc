@@ -0,0 +1,956 @@
+/* Copyright 2015 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Native analyzer for the binary profiles written by a LEGION_PROF
+ * build run with -hl:prof_file <prefix>.  It computes the same
+ * processor, memory and task statistics as legion_prof.py does for
+ * text logs but without the cost of parsing and matching text, and
+ * can write a timeline in the Chrome trace event format which can
+ * be loaded by chrome://tracing or any of its successors.
+ *
+ * Build:
+ *   g++ -O2 -o legion_prof_native legion_prof_native.cc
+ *
+ * Usage:
+ *   legion_prof_native [-c] [-v] [-t <trace.json>] <prefix>.<node> ...
+ *     -c : sort tasks by cummulative instead of non-cummulative time
+ *     -v : print verbose per-task statistics
+ *     -t : write a Chrome trace of all processors and memories
+ *
+ * The record layout is described with BinaryRecordKind in
+ * runtime/legion_profiling.h and the two must be kept in sync.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <map>
+#include <set>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+typedef unsigned long long u64;
+
+// Record kinds from legion_profiling.h
+enum BinaryRecordKind {
+  PROF_REC_PROCESSOR = 1,
+  PROF_REC_MEMORY = 2,
+  PROF_REC_TASK_VARIANT = 3,
+  PROF_REC_CURRENT_PROC = 4,
+  PROF_REC_UNIQUE_TASK = 5,
+  PROF_REC_UNIQUE_MAP = 6,
+  PROF_REC_UNIQUE_CLOSE = 7,
+  PROF_REC_UNIQUE_COPY = 8,
+  PROF_REC_EVENT = 9,
+  PROF_REC_CREATE_INSTANCE = 10,
+  PROF_REC_INSTANCE_FIELD = 11,
+  PROF_REC_DESTROY_INSTANCE = 12,
+};
+
+struct BinaryHeader {
+  char magic[8];
+  unsigned version;
+  unsigned node;
+  u64 init_time;
+};
+
+// Range kinds, named after the ones in legion_prof.py
+enum RangeKind {
+  DEPENDENCE_RANGE,
+  PREMAP_RANGE,
+  MAPPING_RANGE,
+  EXECUTION_RANGE,
+  POST_RANGE,
+  SCHEDULE_RANGE,
+  TRIGGER_RANGE,
+  GC_RANGE,
+  MESSAGE_RANGE,
+  COPY_RANGE,
+  BASE_RANGE,
+};
+
+static const char *range_names[] = {
+  "Dependence Analysis", "Premap Analysis", "Mapping Analysis",
+  "Execution", "Post Execution", "Scheduler", "Trigger Execution",
+  "Garbage Collection", "Message Handler", "Low-Level Copy", "Processor",
+};
+
+enum OpKind {
+  TASK_OP,
+  MAP_OP,
+  CLOSE_OP,
+  COPY_OP,
+  SCHEDULER_OP,
+};
+
+struct TaskVariant {
+  unsigned task_id;
+  std::string name;
+};
+
+struct UniqueOp {
+  OpKind kind;
+  u64 uid;
+  u64 parent;
+  unsigned task_id;
+  // Open begin events for each (category,processor)
+  std::map<std::pair<unsigned,u64>,std::vector<u64> > open;
+};
+
+struct TimeRange {
+  TimeRange(u64 b, u64 e, RangeKind k, UniqueOp *o)
+    : start(b), stop(e), kind(k), op(o) { }
+  u64 start, stop;
+  RangeKind kind;
+  UniqueOp *op;
+  std::vector<TimeRange*> subranges;
+public:
+  inline u64 cummulative_time(void) const { return (stop - start); }
+  u64 non_cummulative_time(void) const
+  {
+    u64 result = cummulative_time();
+    for (unsigned idx = 0; idx < subranges.size(); idx++)
+      result -= subranges[idx]->cummulative_time();
+    return result;
+  }
+  // Execution ranges count as application time and everything else
+  // that a processor does counts as meta time, the base range that
+  // covers the whole run is only the sum of what is under it
+  u64 active_time(void) const
+  {
+    if ((kind != EXECUTION_RANGE) && (kind != BASE_RANGE))
+      return cummulative_time();
+    u64 result = (kind == EXECUTION_RANGE) ? cummulative_time() : 0;
+    for (unsigned idx = 0; idx < subranges.size(); idx++)
+      result += subranges[idx]->active_time();
+    return result;
+  }
+  u64 application_time(void) const
+  {
+    if ((kind != EXECUTION_RANGE) && (kind != BASE_RANGE))
+      return 0;
+    u64 result = (kind == EXECUTION_RANGE) ? cummulative_time() : 0;
+    for (unsigned idx = 0; idx < subranges.size(); idx++)
+      result += subranges[idx]->application_time();
+    return result;
+  }
+  u64 meta_time(void) const
+  {
+    if ((kind != EXECUTION_RANGE) && (kind != BASE_RANGE))
+      return cummulative_time();
+    u64 result = 0;
+    for (unsigned idx = 0; idx < subranges.size(); idx++)
+      result += subranges[idx]->meta_time();
+    return result;
+  }
+};
+
+// Ranges precede all the ranges that they contain
+static bool range_order(const TimeRange *a, const TimeRange *b)
+{
+  if (a->start != b->start)
+    return (a->start < b->start);
+  return (a->stop > b->stop);
+}
+
+struct ProcessorState {
+  u64 proc_id;
+  unsigned node;
+  bool utility;
+  unsigned kind;
+  UniqueOp scheduler;
+  std::vector<TimeRange*> ranges;
+  TimeRange *full_range;
+public:
+  std::string get_name(void) const
+  {
+    char buffer[128];
+    if (kind == 3)
+      snprintf(buffer, sizeof(buffer), "Low-Level Copies (Node %u)", node);
+    else
+      snprintf(buffer, sizeof(buffer), "%s Processor 0x%llx%s",
+               (kind == 0) ? "GPU" : ((kind <= 2) ? "CPU" : "OTHER PROC KIND"),
+               proc_id, utility ? " (Utility)" : "");
+    return std::string(buffer);
+  }
+  // Nest every range inside the smallest range containing it
+  void build_tree(u64 last_time)
+  {
+    full_range = new TimeRange(0, last_time, BASE_RANGE, &scheduler);
+    std::sort(ranges.begin(), ranges.end(), range_order);
+    std::vector<TimeRange*> stack;
+    stack.push_back(full_range);
+    for (unsigned idx = 0; idx < ranges.size(); idx++)
+    {
+      TimeRange *range = ranges[idx];
+      while ((stack.size() > 1) &&
+             ((stack.back()->start > range->start) ||
+              (stack.back()->stop < range->stop)))
+        stack.pop_back();
+      stack.back()->subranges.push_back(range);
+      stack.push_back(range);
+    }
+  }
+};
+
+struct InstanceState {
+  u64 mem;
+  u64 create_time, destroy_time;
+  bool destroyed;
+  std::map<unsigned,u64> fields;
+};
+
+struct MemoryState {
+  u64 mem_id;
+  unsigned kind;
+  unsigned instances;
+};
+
+struct CallTracker {
+public:
+  CallTracker(void) : invocations(0), cum_time(0), non_cum_time(0) { }
+public:
+  inline void increment(u64 cum, u64 non_cum)
+  {
+    invocations++;
+    cum_time += cum;
+    non_cum_time += non_cum;
+  }
+  void print_stats(u64 total_time) const
+  {
+    printf("                Total Invocations: %llu\n", invocations);
+    if (invocations == 0)
+      return;
+    printf("                Cummulative Time: %llu us (%.3f%%)\n",
+           cum_time, 100.0*double(cum_time)/double(total_time));
+    printf("                Non-Cummulative Time: %llu us (%.3f%%)\n",
+           non_cum_time, 100.0*double(non_cum_time)/double(total_time));
+    printf("                Average Cum Time: %.3f us\n",
+           double(cum_time)/double(invocations));
+    printf("                Average Non-Cum Time: %.3f us\n",
+           double(non_cum_time)/double(invocations));
+  }
+public:
+  u64 invocations, cum_time, non_cum_time;
+};
+
+enum StatKind {
+  STAT_INVOCATIONS,
+  STAT_DEPENDENCE_ANALYSIS,
+  STAT_PREMAPPINGS,
+  STAT_MAPPING_ANALYSIS,
+  STAT_INLINE_DEP_ANALYSIS,
+  STAT_INLINE_MAPPINGS,
+  STAT_CLOSE_DEP_ANALYSIS,
+  STAT_CLOSE_OPERATIONS,
+  STAT_COPY_DEP_ANALYSIS,
+  STAT_COPY_OPERATIONS,
+  STAT_TRIGGERS,
+  STAT_POST_OPERATIONS,
+  LAST_STAT_KIND,
+};
+
+static const char *stat_names[LAST_STAT_KIND] = {
+  "Executions (APP):",
+  "Dependence Analysis (META):",
+  "Premapping Analysis (META):",
+  "Mapping Analysis (META):",
+  "Inline Mapping Dependence (META):",
+  "Inline Mapping Analysis (META):",
+  "Close Dependence Analysis (META):",
+  "Close Mapping Analysis (META):",
+  "Copy Dependence Analysis (META):",
+  "Copy Mapping Analysis (META):",
+  "Trigger Calls (META):",
+  "Post Operations (META):",
+};
+
+struct VariantStats {
+  CallTracker calls[LAST_STAT_KIND];
+public:
+  u64 cummulative_time(void) const
+  {
+    u64 result = 0;
+    for (unsigned idx = 0; idx < LAST_STAT_KIND; idx++)
+      result += calls[idx].cum_time;
+    return result;
+  }
+  u64 non_cummulative_time(void) const
+  {
+    u64 result = 0;
+    for (unsigned idx = 0; idx < LAST_STAT_KIND; idx++)
+      result += calls[idx].non_cum_time;
+    return result;
+  }
+};
+
+class ProfileState {
+public:
+  ProfileState(void) : last_time(0) { }
+public:
+  bool parse_file(const char *file_name);
+  void build_time_ranges(void);
+  void print_processor_stats(void);
+  void print_memory_stats(void);
+  void print_task_stats(bool cummulative, bool verbose);
+  bool write_trace(const char *file_name);
+protected:
+  void add_event(unsigned node, u64 proc_id, unsigned kind,
+                 u64 uid, u64 time);
+  unsigned find_variant(UniqueOp *op);
+  void update_task_stats(TimeRange *range);
+public:
+  u64 last_time;
+  std::map<u64,ProcessorState> processors;
+  std::map<u64,MemoryState> memories;
+  std::map<unsigned,TaskVariant> variants;
+  std::map<u64,UniqueOp> ops;
+  std::vector<InstanceState> instances;
+  // Only instances that are still live can be destroyed
+  std::map<std::pair<unsigned,unsigned>,unsigned> live_instances;
+protected:
+  std::map<unsigned,VariantStats> variant_stats;
+  CallTracker scheduler, gcs, dependence_analysis, mapping_analysis;
+};
+
+// A simple cursor over the contents of one file
+class RecordReader {
+public:
+  RecordReader(const std::vector<char> &d)
+    : data(d), offset(0), truncated(false) { }
+public:
+  template<typename T>
+  inline T read(void)
+  {
+    T result;
+    if ((offset + sizeof(T)) > data.size())
+    {
+      truncated = true;
+      memset(&result, 0, sizeof(T));
+      offset = data.size();
+      return result;
+    }
+    memcpy(&result, &data[offset], sizeof(T));
+    offset += sizeof(T);
+    return result;
+  }
+  inline std::string read_string(size_t length)
+  {
+    if ((offset + length) > data.size())
+    {
+      truncated = true;
+      offset = data.size();
+      return std::string();
+    }
+    std::string result(&data[offset], length);
+    offset += length;
+    return result;
+  }
+  inline bool done(void) const { return (offset >= data.size()); }
+public:
+  const std::vector<char> &data;
+  size_t offset;
+  bool truncated;
+};
+
+struct PendingEvent {
+  u64 proc_id;
+  unsigned kind;
+  u64 uid;
+  u64 time;
+};
+
+bool ProfileState::parse_file(const char *file_name)
+{
+  FILE *f = fopen(file_name, "rb");
+  if (f == NULL)
+  {
+    fprintf(stderr,"ERROR: Unable to open %s\n", file_name);
+    return false;
+  }
+  std::vector<char> data;
+  char chunk[1 << 16];
+  size_t bytes;
+  while ((bytes = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    data.insert(data.end(), chunk, chunk+bytes);
+  fclose(f);
+  BinaryHeader header;
+  if ((data.size() < sizeof(header)) ||
+      (memcmp(&data[0], "LEGPROF", 8) != 0))
+  {
+    fprintf(stderr,"ERROR: %s is not a binary Legion profile\n", file_name);
+    return false;
+  }
+  memcpy(&header, &data[0], sizeof(header));
+  if (header.version != 1)
+  {
+    fprintf(stderr,"ERROR: Unsupported profile version %u in %s\n",
+            header.version, file_name);
+    return false;
+  }
+  const unsigned node = header.node;
+  RecordReader reader(data);
+  reader.offset = sizeof(header);
+  // Events can be seen before the ops they are for when the ops
+  // were recorded by a different thread so we do them after the
+  // whole file has been read, in the order that they were recorded
+  std::vector<PendingEvent> events;
+  u64 current_proc = 0;
+  unsigned num_records = 0;
+  while (!reader.done() && !reader.truncated)
+  {
+    const unsigned char rec = reader.read<unsigned char>();
+    num_records++;
+    switch (rec)
+    {
+      case PROF_REC_PROCESSOR:
+        {
+          ProcessorState proc;
+          proc.proc_id = reader.read<u64>();
+          proc.node = node;
+          proc.utility = (reader.read<unsigned char>() != 0);
+          proc.kind = reader.read<unsigned char>();
+          proc.scheduler.kind = SCHEDULER_OP;
+          proc.scheduler.uid = 0;
+          proc.scheduler.parent = 0;
+          proc.scheduler.task_id = 0;
+          proc.full_range = NULL;
+          // Copy processors are made up per node so keep them apart
+          u64 key = proc.proc_id;
+          if (proc.kind == 3)
+            key |= (u64(node) << 48);
+          if (processors.find(key) == processors.end())
+            processors[key] = proc;
+          break;
+        }
+      case PROF_REC_MEMORY:
+        {
+          MemoryState mem;
+          mem.mem_id = reader.read<u64>();
+          mem.kind = reader.read<unsigned char>();
+          mem.instances = 0;
+          if (memories.find(mem.mem_id) == memories.end())
+            memories[mem.mem_id] = mem;
+          break;
+        }
+      case PROF_REC_TASK_VARIANT:
+        {
+          TaskVariant variant;
+          variant.task_id = reader.read<unsigned>();
+          unsigned short length = reader.read<unsigned short>();
+          variant.name = reader.read_string(length);
+          variants[variant.task_id] = variant;
+          break;
+        }
+      case PROF_REC_CURRENT_PROC:
+        {
+          current_proc = reader.read<u64>();
+          break;
+        }
+      case PROF_REC_UNIQUE_TASK:
+        {
+          UniqueOp op;
+          op.kind = TASK_OP;
+          op.uid = reader.read<u64>();
+          op.parent = 0;
+          op.task_id = reader.read<unsigned>();
+          // The point is not needed for any of the statistics
+          reader.read<unsigned>();
+          for (int idx = 0; idx < 3; idx++)
+            reader.read<int>();
+          if (ops.find(op.uid) == ops.end())
+            ops[op.uid] = op;
+          break;
+        }
+      case PROF_REC_UNIQUE_MAP:
+      case PROF_REC_UNIQUE_CLOSE:
+      case PROF_REC_UNIQUE_COPY:
+        {
+          UniqueOp op;
+          op.kind = (rec == PROF_REC_UNIQUE_MAP) ? MAP_OP :
+                    (rec == PROF_REC_UNIQUE_CLOSE) ? CLOSE_OP : COPY_OP;
+          op.uid = reader.read<u64>();
+          op.parent = reader.read<u64>();
+          op.task_id = 0;
+          ops[op.uid] = op;
+          break;
+        }
+      case PROF_REC_EVENT:
+        {
+          PendingEvent event;
+          event.proc_id = current_proc;
+          event.kind = reader.read<unsigned char>();
+          event.uid = reader.read<u64>();
+          event.time = reader.read<u64>();
+          events.push_back(event);
+          if (event.time > last_time)
+            last_time = event.time;
+          break;
+        }
+      case PROF_REC_CREATE_INSTANCE:
+        {
+          const unsigned inst_id = reader.read<unsigned>();
+          InstanceState inst;
+          inst.mem = reader.read<unsigned>();
+          reader.read<unsigned>(); // redop
+          reader.read<u64>(); // blocking factor
+          inst.create_time = reader.read<u64>();
+          inst.destroy_time = 0;
+          inst.destroyed = false;
+          live_instances[std::make_pair(node,inst_id)] = instances.size();
+          instances.push_back(inst);
+          if (memories.find(inst.mem) != memories.end())
+            memories[inst.mem].instances++;
+          break;
+        }
+      case PROF_REC_INSTANCE_FIELD:
+        {
+          const unsigned inst_id = reader.read<unsigned>();
+          const unsigned fid = reader.read<unsigned>();
+          const u64 size = reader.read<u64>();
+          std::map<std::pair<unsigned,unsigned>,unsigned>::const_iterator
+            finder = live_instances.find(std::make_pair(node,inst_id));
+          if (finder != live_instances.end())
+            instances[finder->second].fields[fid] = size;
+          break;
+        }
+      case PROF_REC_DESTROY_INSTANCE:
+        {
+          const unsigned inst_id = reader.read<unsigned>();
+          const u64 time = reader.read<u64>();
+          std::map<std::pair<unsigned,unsigned>,unsigned>::iterator
+            finder = live_instances.find(std::make_pair(node,inst_id));
+          if (finder != live_instances.end())
+          {
+            instances[finder->second].destroy_time = time;
+            instances[finder->second].destroyed = true;
+            live_instances.erase(finder);
+          }
+          break;
+        }
+      default:
+        {
+          fprintf(stderr,"ERROR: Unknown record kind %d at offset %zd "
+                  "of %s\n", rec, reader.offset-1, file_name);
+          return false;
+        }
+    }
+  }
+  if (reader.truncated)
+    fprintf(stderr,"WARNING: %s ends with a partial record\n", file_name);
+  for (unsigned idx = 0; idx < events.size(); idx++)
+    add_event(node, events[idx].proc_id, events[idx].kind,
+              events[idx].uid, events[idx].time);
+  printf("Loaded %u records from %s\n", num_records, file_name);
+  return true;
+}
+
+void ProfileState::add_event(unsigned node, u64 proc_id, unsigned kind,
+                             u64 uid, u64 time)
+{
+  std::map<u64,ProcessorState>::iterator proc_finder =
+    processors.find(proc_id);
+  if (proc_finder == processors.end())
+    proc_finder = processors.find(proc_id | (u64(node) << 48));
+  if (proc_finder == processors.end())
+    return;
+  ProcessorState &proc = proc_finder->second;
+  UniqueOp *op = &proc.scheduler;
+  if (uid != 0)
+  {
+    std::map<u64,UniqueOp>::iterator finder = ops.find(uid);
+    if (finder == ops.end())
+      return;
+    op = &finder->second;
+  }
+  // Completion, launch and wait events only show up in pictures
+  if ((kind == 8) || (kind == 9) || (kind == 12) || (kind == 13))
+    return;
+  std::pair<unsigned,u64> key(kind/2, proc_id);
+  if ((kind % 2) == 0)
+  {
+    op->open[key].push_back(time);
+    return;
+  }
+  std::map<std::pair<unsigned,u64>,std::vector<u64> >::iterator finder =
+    op->open.find(key);
+  if ((finder == op->open.end()) || finder->second.empty())
+    return;
+  const u64 start = finder->second.back();
+  finder->second.pop_back();
+  RangeKind range_kind;
+  switch (kind)
+  {
+    case 1: range_kind = DEPENDENCE_RANGE; break;
+    case 3: range_kind = PREMAP_RANGE; break;
+    case 5: range_kind = MAPPING_RANGE; break;
+    case 7: range_kind = EXECUTION_RANGE; break;
+    case 11: range_kind = SCHEDULE_RANGE; break;
+    case 15: range_kind = POST_RANGE; break;
+    case 17: range_kind = TRIGGER_RANGE; break;
+    case 19: range_kind = GC_RANGE; break;
+    case 21: range_kind = MESSAGE_RANGE; break;
+    case 23: range_kind = COPY_RANGE; break;
+    default:
+      fprintf(stderr,"WARNING: Unknown event kind %u\n", kind);
+      return;
+  }
+  if (start > time)
+    return;
+  proc.ranges.push_back(new TimeRange(start, time, range_kind, op));
+}
+
+void ProfileState::build_time_ranges(void)
+{
+  for (std::map<u64,ProcessorState>::iterator it = processors.begin();
+        it != processors.end(); it++)
+    it->second.build_tree(last_time);
+}
+
+void ProfileState::print_processor_stats(void)
+{
+  printf("****************************************************\n");
+  printf("   PROCESSOR STATS\n");
+  printf("****************************************************\n");
+  for (std::map<u64,ProcessorState>::const_iterator it =
+        processors.begin(); it != processors.end(); it++)
+  {
+    const TimeRange *full = it->second.full_range;
+    const u64 total_time = full->cummulative_time();
+    const u64 active_time = full->active_time();
+    const u64 application_time = full->application_time();
+    const u64 meta_time = full->meta_time();
+    const double scale = (total_time > 0) ? (100.0/double(total_time)) : 0.0;
+    printf("%s\n", it->second.get_name().c_str());
+    printf("    Total time: %llu us\n", total_time);
+    printf("    Active time: %llu us (%.3f%%)\n",
+           active_time, double(active_time)*scale);
+    printf("    Application time: %llu us (%.3f%%)\n",
+           application_time, double(application_time)*scale);
+    printf("    Meta time: %llu us (%.3f%%)\n",
+           meta_time, double(meta_time)*scale);
+    printf("\n");
+  }
+  printf("\n");
+}
+
+void ProfileState::print_memory_stats(void)
+{
+  printf("****************************************************\n");
+  printf("   MEMORY STATS\n");
+  printf("****************************************************\n");
+  for (std::map<u64,MemoryState>::const_iterator it =
+        memories.begin(); it != memories.end(); it++)
+  {
+    printf("Memory 0x%llx\n", it->first);
+    printf("    Total Instances: %u\n", it->second.instances);
+  }
+  printf("\n");
+}
+
+unsigned ProfileState::find_variant(UniqueOp *op)
+{
+  // Follow parents up to the task that launched the operation
+  for (unsigned depth = 0; (op->kind != TASK_OP) && (depth < 64); depth++)
+  {
+    std::map<u64,UniqueOp>::iterator finder = ops.find(op->parent);
+    if (finder == ops.end())
+      break;
+    op = &finder->second;
+  }
+  return op->task_id;
+}
+
+void ProfileState::update_task_stats(TimeRange *range)
+{
+  const u64 cum = range->cummulative_time();
+  const u64 non_cum = range->non_cummulative_time();
+  switch (range->kind)
+  {
+    case SCHEDULE_RANGE:
+      scheduler.increment(cum, non_cum);
+      break;
+    case GC_RANGE:
+      gcs.increment(cum, non_cum);
+      break;
+    case DEPENDENCE_RANGE:
+    case PREMAP_RANGE:
+    case MAPPING_RANGE:
+    case EXECUTION_RANGE:
+    case POST_RANGE:
+    case TRIGGER_RANGE:
+      {
+        if (range->op->kind == SCHEDULER_OP)
+          break;
+        VariantStats &stats = variant_stats[find_variant(range->op)];
+        const OpKind op_kind = range->op->kind;
+        StatKind stat = STAT_INVOCATIONS;
+        if (range->kind == DEPENDENCE_RANGE)
+        {
+          stat = (op_kind == MAP_OP) ? STAT_INLINE_DEP_ANALYSIS :
+                 (op_kind == CLOSE_OP) ? STAT_CLOSE_DEP_ANALYSIS :
+                 (op_kind == COPY_OP) ? STAT_COPY_DEP_ANALYSIS :
+                                        STAT_DEPENDENCE_ANALYSIS;
+          dependence_analysis.increment(cum, non_cum);
+        }
+        else if (range->kind == PREMAP_RANGE)
+        {
+          stat = STAT_PREMAPPINGS;
+          mapping_analysis.increment(cum, non_cum);
+        }
+        else if (range->kind == MAPPING_RANGE)
+        {
+          stat = (op_kind == MAP_OP) ? STAT_INLINE_MAPPINGS :
+                 (op_kind == CLOSE_OP) ? STAT_CLOSE_OPERATIONS :
+                 (op_kind == COPY_OP) ? STAT_COPY_OPERATIONS :
+                                        STAT_MAPPING_ANALYSIS;
+          mapping_analysis.increment(cum, non_cum);
+        }
+        else if (range->kind == POST_RANGE)
+          stat = STAT_POST_OPERATIONS;
+        else if (range->kind == TRIGGER_RANGE)
+          stat = STAT_TRIGGERS;
+        stats.calls[stat].increment(cum, non_cum);
+        break;
+      }
+    default:
+      break;
+  }
+  for (unsigned idx = 0; idx < range->subranges.size(); idx++)
+    update_task_stats(range->subranges[idx]);
+}
+
+struct VariantOrder {
+public:
+  VariantOrder(const std::map<unsigned,VariantStats> &s, bool c)
+    : stats(s), cummulative(c) { }
+  bool operator()(unsigned a, unsigned b) const
+  {
+    const VariantStats &sa = stats.find(a)->second;
+    const VariantStats &sb = stats.find(b)->second;
+    if (cummulative)
+      return (sa.cummulative_time() > sb.cummulative_time());
+    return (sa.non_cummulative_time() > sb.non_cummulative_time());
+  }
+public:
+  const std::map<unsigned,VariantStats> &stats;
+  const bool cummulative;
+};
+
+void ProfileState::print_task_stats(bool cummulative, bool verbose)
+{
+  printf("****************************************************\n");
+  printf("   TASK STATS\n");
+  printf("****************************************************\n");
+  std::vector<unsigned> order;
+  for (std::map<unsigned,TaskVariant>::const_iterator it =
+        variants.begin(); it != variants.end(); it++)
+  {
+    variant_stats[it->first];
+    order.push_back(it->first);
+  }
+  for (std::map<u64,ProcessorState>::const_iterator it =
+        processors.begin(); it != processors.end(); it++)
+    update_task_stats(it->second.full_range);
+  // Total time is the overall execution time times the processors
+  u64 total_time = last_time * processors.size();
+  if (total_time == 0)
+    total_time = 1;
+  std::stable_sort(order.begin(), order.end(),
+                   VariantOrder(variant_stats, cummulative));
+  printf("  -------------------------\n");
+  printf("  Task Statistics\n");
+  printf("  -------------------------\n");
+  for (unsigned idx = 0; idx < order.size(); idx++)
+  {
+    const TaskVariant &variant = variants[order[idx]];
+    const VariantStats &stats = variant_stats[order[idx]];
+    const u64 cum_time = stats.cummulative_time();
+    const u64 non_cum_time = stats.non_cummulative_time();
+    const u64 time = cummulative ? cum_time : non_cum_time;
+    char title[64];
+    snprintf(title, sizeof(title), "Task ID %u %s",
+             variant.task_id, variant.name.c_str());
+    printf("    %-50s%llu us (%.3f%%)\n", title, time,
+           100.0*double(time)/double(total_time));
+    if (!verbose)
+    {
+      const CallTracker &app = stats.calls[STAT_INVOCATIONS];
+      const u64 meta_cum_time = cum_time - app.cum_time;
+      const u64 meta_non_cum_time = non_cum_time - app.non_cum_time;
+      printf("          Executions (APP):\n");
+      app.print_stats(total_time);
+      printf("          Meta Execution Time (META):\n");
+      printf("                Cummulative Time: %llu us (%.3f%%)\n",
+             meta_cum_time, 100.0*double(meta_cum_time)/double(total_time));
+      printf("                Non-Cummulative Time: %llu us (%.3f%%)\n",
+             meta_non_cum_time,
+             100.0*double(meta_non_cum_time)/double(total_time));
+    }
+    else
+    {
+      for (unsigned stat = 0; stat < LAST_STAT_KIND; stat++)
+      {
+        if (stats.calls[stat].invocations == 0)
+          continue;
+        printf("         %s\n", stat_names[stat]);
+        stats.calls[stat].print_stats(total_time);
+      }
+    }
+  }
+  printf("  -------------------------\n");
+  printf("  Meta-Task Statistics\n");
+  printf("  -------------------------\n");
+  if (scheduler.invocations > 0)
+  {
+    printf("  Scheduler (META):\n");
+    scheduler.print_stats(total_time);
+  }
+  if (gcs.invocations > 0)
+  {
+    printf("  Garbage Collection (META):\n");
+    gcs.print_stats(total_time);
+  }
+  if (dependence_analysis.invocations > 0)
+  {
+    printf("  Total Dependence Analyses (META):\n");
+    dependence_analysis.print_stats(total_time);
+  }
+  if (mapping_analysis.invocations > 0)
+  {
+    printf("  Total Mapping Analyses (META):\n");
+    mapping_analysis.print_stats(total_time);
+  }
+  printf("\n");
+}
+
+static void emit_trace_range(FILE *f, bool &first, const ProcessorState &proc,
+                             const TimeRange *range,
+                             const std::map<unsigned,TaskVariant> &variants,
+                             unsigned task_id)
+{
+  if (range->kind != BASE_RANGE)
+  {
+    std::string name = range_names[range->kind];
+    if (range->op->kind != SCHEDULER_OP)
+    {
+      std::map<unsigned,TaskVariant>::const_iterator finder =
+        variants.find(task_id);
+      char suffix[128];
+      snprintf(suffix, sizeof(suffix), " of %s (UID %llu)",
+               (finder != variants.end()) ? finder->second.name.c_str() : "?",
+               range->op->uid);
+      name += suffix;
+    }
+    fprintf(f, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+            "\"pid\":%u,\"tid\":\"0x%llx\",\"ts\":%llu,\"dur\":%llu}",
+            first ? "" : ",", name.c_str(), range_names[range->kind],
+            proc.node, proc.proc_id, range->start, range->cummulative_time());
+    first = false;
+  }
+}
+
+bool ProfileState::write_trace(const char *file_name)
+{
+  FILE *f = fopen(file_name, "w");
+  if (f == NULL)
+  {
+    fprintf(stderr,"ERROR: Unable to open %s\n", file_name);
+    return false;
+  }
+  bool first = true;
+  fprintf(f, "{\"traceEvents\":[");
+  for (std::map<u64,ProcessorState>::const_iterator it =
+        processors.begin(); it != processors.end(); it++)
+  {
+    const ProcessorState &proc = it->second;
+    fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,"
+            "\"tid\":\"0x%llx\",\"args\":{\"name\":\"%s\"}}",
+            first ? "" : ",", proc.node, proc.proc_id,
+            proc.get_name().c_str());
+    first = false;
+    for (unsigned idx = 0; idx < proc.ranges.size(); idx++)
+      emit_trace_range(f, first, proc, proc.ranges[idx], variants,
+                       find_variant(proc.ranges[idx]->op));
+  }
+  // Instances show up as ranges on a row for their memory
+  for (unsigned idx = 0; idx < instances.size(); idx++)
+  {
+    const InstanceState &inst = instances[idx];
+    const u64 stop = inst.destroyed ? inst.destroy_time : last_time;
+    u64 bytes = 0;
+    for (std::map<unsigned,u64>::const_iterator it =
+          inst.fields.begin(); it != inst.fields.end(); it++)
+      bytes += it->second;
+    fprintf(f, ",\n{\"name\":\"Instance (%zd fields, %llu bytes per element)"
+            "\",\"cat\":\"Instance\",\"ph\":\"X\",\"pid\":\"Memories\","
+            "\"tid\":\"0x%llx\",\"ts\":%llu,\"dur\":%llu}",
+            inst.fields.size(), bytes, inst.mem, inst.create_time,
+            (stop > inst.create_time) ? (stop - inst.create_time) : 0);
+  }
+  fprintf(f, "\n]}\n");
+  fclose(f);
+  return true;
+}
+
+static void usage(const char *name)
+{
+  fprintf(stderr,"Usage: %s [-c] [-v] [-t <trace.json>] <file> ...\n", name);
+  fprintf(stderr,"  -c : perform cummulative analysis\n");
+  fprintf(stderr,"  -v : print verbose profiling information\n");
+  fprintf(stderr,"  -t <file> : write a Chrome trace of the timeline\n");
+  exit(1);
+}
+
+int main(int argc, char **argv)
+{
+  bool cummulative = false, verbose = false;
+  const char *trace_file = NULL;
+  std::vector<const char*> files;
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i],"-c"))
+      cummulative = true;
+    else if (!strcmp(argv[i],"-v"))
+      verbose = true;
+    else if (!strcmp(argv[i],"-t") && ((i+1) < argc))
+      trace_file = argv[++i];
+    else if (argv[i][0] == '-')
+      usage(argv[0]);
+    else
+      files.push_back(argv[i]);
+  }
+  if (files.empty())
+    usage(argv[0]);
+  ProfileState state;
+  for (unsigned idx = 0; idx < files.size(); idx++)
+    if (!state.parse_file(files[idx]))
+      return 1;
+  state.build_time_ranges();
+  state.print_processor_stats();
+  state.print_memory_stats();
+  state.print_task_stats(cummulative, verbose);
+  if (trace_file != NULL)
+  {
+    printf("Generating Chrome trace in %s...\n", trace_file);
+    if (!state.write_trace(trace_file))
+      return 1;
+    printf("Done!\n");
+  }
+  return 0;
+}
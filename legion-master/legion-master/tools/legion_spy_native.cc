@@ -0,0 +1,1645 @@
+/* Copyright 2015 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Native verifier for the logs written by a LEGION_SPY build run
+ * with -cat legion_spy -level 2.  It performs the same logical
+ * dependence check as legion_spy.py -l, checks that the event graph
+ * is acyclic, computes its critical path and can write its transitive
+ * reduction as a dot file.
+ *
+ * The log is streamed a line at a time.  Only a window of the most
+ * recent operations of each context is kept: an operation is checked
+ * against the operations before it in the window once a window's
+ * worth of later operations have been seen (or at the end of the log)
+ * and is retired once no remaining check can refer to it.  Checks for
+ * different contexts run in parallel.
+ *
+ * Memory: the operations kept for the logical checks are bounded by
+ * the window.  What is kept for every task in the log is small: a
+ * record per task context, the name of every task and index launch
+ * for the reports, the slice to index launch map and the region tree.
+ * The ids of the last RETIRED_HISTORY retired operations are kept so
+ * that lines which arrive after their operation was retired can be
+ * dropped, a line that arrives even later is reported as unmatched
+ * at the end.  The event graph is not streamed.  Every event, operation and copy in the log
+ * stays in memory as a compact adjacency list until the end, so the
+ * event checks need memory proportional to the number of nodes and
+ * edges in the graph.  Its connected components are analyzed in
+ * parallel, and the reachability sets used for the transitive
+ * reduction are quadratic in the size of a component.  Those sets
+ * come out of one budget shared by all threads (-m): a component
+ * waits until enough of the budget is free, and a component that
+ * would need more than the whole budget is not reduced at all.
+ *
+ * Build:
+ *   g++ -O2 -o legion_spy_native legion_spy_native.cc -lpthread
+ *
+ * Usage:
+ *   legion_spy_native [-l] [-e] [-v] [-w <ops>] [-j <threads>]
+ *                     [-m <MB>] [-d <graph.dot>] <file>
+ *     -l : perform logical dependence checks
+ *     -e : perform event graph checks
+ *     -v : print every context that is checked
+ *     -w : operations in the window of each context (default 4096,
+ *          0 keeps every operation like legion_spy.py does)
+ *     -j : number of threads to use (default all cores)
+ *     -m : memory for the transitive reduction shared by all
+ *          threads in MB (default 1024)
+ *     -d : write the transitive reduction of the event graph (implies -e)
+ * With neither -l nor -e both kinds of checks are performed.
+ *
+ * The line formats are the ones written by runtime/legion_spy.h and
+ * parsed by spy_parser.py and all three must be kept in sync.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <map>
+#include <set>
+#include <deque>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <pthread.h>
+#include <unistd.h>
+
+typedef unsigned long long u64;
+
+// Number of retired operations whose ids are remembered
+#define RETIRED_HISTORY (1 << 20)
+
+// Default memory in MB for the reachability sets of the
+// transitive reduction, shared by all the threads
+#define DEFAULT_REDUCTION_MB 1024
+
+// From legion_types.h
+enum DependenceType {
+  NO_DEPENDENCE = 0,
+  TRUE_DEPENDENCE = 1,
+  ANTI_DEPENDENCE = 2,
+  ATOMIC_DEPENDENCE = 3,
+  SIMULTANEOUS_DEPENDENCE = 4,
+};
+
+enum PrivilegeMode {
+  NO_ACCESS = 0x00000000,
+  READ_ONLY = 0x00000001,
+  READ_WRITE = 0x00000007,
+  WRITE_ONLY = 0x00000002,
+  REDUCE = 0x00000004,
+};
+
+enum CoherenceProperty {
+  EXCLUSIVE = 0,
+  ATOMIC = 1,
+  SIMULTANEOUS = 2,
+  RELAXED = 3,
+};
+
+// Operation kinds, named after the ones in spy_analysis.py
+enum OpKind {
+  SINGLE_OP,
+  INDEX_OP,
+  MAPPING_OP,
+  CLOSE_OP,
+  DELETION_OP,
+  COPY_OP,
+  FENCE_OP,
+  ACQUIRE_OP,
+  RELEASE_OP,
+};
+
+static const char *op_kind_names[] = {
+  "Task",
+  "Index Task",
+  "Mapping",
+  "Close",
+  "Deletion",
+  "Copy Op",
+  "Fence",
+  "Acquire",
+  "Release",
+};
+
+class LineParser {
+public:
+  LineParser(const char *line) : cur(line), valid(true) { }
+public:
+  // Consume the keyword if the rest of the line starts with it
+  bool keyword(const char *word)
+  {
+    const size_t len = strlen(word);
+    if (strncmp(cur, word, len) != 0)
+      return false;
+    if ((cur[len] != ' ') && (cur[len] != '\n') && (cur[len] != '\0'))
+      return false;
+    cur += len;
+    return true;
+  }
+  u64 hex(void) { return number(16); }
+  u64 dec(void) { return number(10); }
+  std::string word(void)
+  {
+    while (*cur == ' ')
+      cur++;
+    const char *start = cur;
+    while ((*cur != '\0') && (*cur != ' ') && (*cur != '\n'))
+      cur++;
+    if (start == cur)
+      valid = false;
+    return std::string(start, cur - start);
+  }
+protected:
+  u64 number(int base)
+  {
+    char *end;
+    const u64 result = strtoull(cur, &end, base);
+    if (end == cur)
+      valid = false;
+    cur = end;
+    return result;
+  }
+public:
+  const char *cur;
+  bool valid;
+};
+
+struct IndexNode {
+public:
+  IndexNode(u64 i, bool reg, IndexNode *p, bool dis)
+    : id(i), is_region(reg), parent(p),
+      depth((p == NULL) ? 0 : p->depth + 1), disjoint(dis) { }
+public:
+  const u64 id;
+  const bool is_region;
+  IndexNode *const parent;
+  const unsigned depth;
+  const bool disjoint;
+};
+
+struct Requirement {
+public:
+  bool is_read_only(void) const
+    { return (priv == NO_ACCESS) || (priv == READ_ONLY); }
+  bool has_write(void) const
+    { return (priv == READ_WRITE) || (priv == REDUCE) || (priv == WRITE_ONLY); }
+  bool is_write_only(void) const { return (priv == WRITE_ONLY); }
+  bool is_reduce(void) const { return (priv == REDUCE); }
+  bool is_exclusive(void) const { return (coher == EXCLUSIVE); }
+  bool is_atomic(void) const { return (coher == ATOMIC); }
+  bool is_simult(void) const { return (coher == SIMULTANEOUS); }
+  bool is_relaxed(void) const { return (coher == RELAXED); }
+  void print(std::string &out) const;
+public:
+  unsigned index;
+  bool valid;
+  bool is_reg;
+  u64 ispace;
+  unsigned fspace, tid, priv, coher, redop;
+  IndexNode *node;
+  std::vector<unsigned> fields; // sorted
+};
+
+struct Context;
+
+struct MappingDep {
+public:
+  MappingDep(u64 p, unsigned pi, unsigned ni, unsigned d)
+    : prev_seq(p), prev_idx(pi), next_idx(ni), dtype(d) { }
+public:
+  // Operations in the same context are named by their position
+  // so the dependence stays valid after the operation is retired
+  u64 prev_seq;
+  unsigned prev_idx, next_idx, dtype;
+};
+
+struct Operation {
+public:
+  Operation(u64 u, OpKind k, const std::string &n)
+    : uid(u), kind(k), name(n), ctx(NULL), seq(0), mark(0) { }
+public:
+  std::string get_name(void) const
+  {
+    if ((kind == SINGLE_OP) || (kind == INDEX_OP))
+      return name;
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%s %llu", op_kind_names[kind], uid);
+    return std::string(buffer);
+  }
+  const Requirement* find_requirement(unsigned idx) const
+  {
+    if ((idx < reqs.size()) && reqs[idx].valid)
+      return &(reqs[idx]);
+    return NULL;
+  }
+public:
+  const u64 uid;
+  const OpKind kind;
+  const std::string name;
+  Context *ctx;
+  u64 seq;
+  unsigned mark;
+  std::vector<Requirement> reqs;
+  std::vector<MappingDep> mdeps; // where we are the next operation
+};
+
+struct Context {
+public:
+  Context(u64 u, const std::string &n)
+    : uid(u), name(n), base_seq(0), next_seq(0), checked_seq(0),
+      epoch(0), ops_checked(0), actual_deps(0), errors(0), warnings(0),
+      unverified(0), reported(false) { }
+public:
+  Operation* find_op(u64 seq) const
+  {
+    if ((seq < base_seq) || (seq >= next_seq))
+      return NULL;
+    return ops[seq - base_seq];
+  }
+public:
+  const u64 uid;
+  const std::string name;
+  // Resident operations with sequence numbers [base_seq,next_seq)
+  std::deque<Operation*> ops;
+  u64 base_seq, next_seq;
+  // Operations before checked_seq have been checked
+  u64 checked_seq;
+  unsigned epoch;
+  // Statistics and output from the checks
+  u64 ops_checked, actual_deps, errors, warnings, unverified;
+  bool reported;
+  std::string output;
+};
+
+enum GraphNodeKind {
+  EVENT_NODE,
+  OP_NODE,
+  COPY_NODE,
+};
+
+struct GraphNode {
+public:
+  GraphNode(GraphNodeKind k, u64 i, unsigned g)
+    : kind(k), id(i), gen(g) { }
+public:
+  GraphNodeKind kind;
+  u64 id; // event id, operation uid or copy number
+  unsigned gen;
+  std::vector<unsigned> out;
+};
+
+struct Component {
+public:
+  Component(void)
+    : cycle(false), skipped(false), redundant(0), critical_length(0) { }
+public:
+  std::vector<unsigned> nodes;
+  bool cycle;
+  // Too large to compute the transitive reduction
+  bool skipped;
+  u64 redundant;
+  // The longest chain of operations and copies in the component
+  unsigned critical_length;
+  std::vector<unsigned> critical_path;
+  // Edges of the transitive reduction if it was requested
+  std::vector<std::pair<unsigned,unsigned> > reduced;
+};
+
+class SpyState {
+public:
+  SpyState(bool logical, bool events, bool verbose,
+           unsigned window, unsigned threads, u64 reduction_bytes);
+  ~SpyState(void);
+public:
+  bool parse_file(const char *file_name);
+  void finish_logical(void);
+  void analyze_event_graph(const char *dot_file);
+public:
+  void check_context(Context *ctx, u64 limit);
+  void analyze_component(Component &comp, bool reduce);
+protected:
+  bool parse_line(const char *line);
+  bool add_operation(u64 ctx, u64 uid, OpKind kind, const std::string &name);
+  Context* find_or_create_context(u64 uid, const std::string &name);
+  IndexNode* find_index_node(bool is_reg, u64 id) const;
+  unsigned compute_dependence(const Requirement &req1,
+                              const Requirement &req2) const;
+  bool is_aliased(const IndexNode *one, const IndexNode *two) const;
+  bool has_logical_path(Context *ctx, Operation *from, Operation *to);
+  unsigned find_event_node(u64 id, unsigned gen);
+  void replay_pending(bool final);
+  void run_check_pass(bool final);
+  void retire_operations(Context *ctx);
+  void print_context(Context *ctx);
+protected:
+  const bool logical_checks, event_checks, verbose;
+  const unsigned window, num_threads;
+  // Memory budget for the reachability sets of all the components
+  // being reduced at the same time
+  const u64 reduction_budget;
+  u64 reduction_in_use;
+  pthread_mutex_t reduction_lock;
+  pthread_cond_t reduction_cond;
+  // Region tree shape
+  std::map<u64,IndexNode*> index_spaces, index_parts;
+  // Resident operations and the contexts of all tasks
+  std::map<u64,Operation*> ops;
+  std::map<u64,Context*> contexts;
+  // The ids of the most recently retired operations, oldest first
+  std::set<u64> retired;
+  std::deque<u64> retired_order;
+  std::map<u64,u64> slice_index;
+  std::map<u64,std::string> slice_names;
+  // Lines that referred to things that have not been seen yet
+  std::vector<std::string> pending;
+  u64 ops_since_pass;
+  u64 top_level_uid;
+  bool has_top_level;
+  u64 lines, matched, dropped;
+  // Event graph
+  std::vector<GraphNode> nodes;
+  std::map<std::pair<u64,unsigned>,unsigned> event_nodes;
+  std::map<u64,unsigned> op_nodes;
+  std::map<u64,std::string> op_names;
+  u64 event_edges, implicit_edges, copies;
+public:
+  u64 total_errors, total_warnings;
+};
+
+SpyState::SpyState(bool logical, bool events, bool verb,
+                   unsigned w, unsigned t, u64 reduction_bytes)
+  : logical_checks(logical), event_checks(events), verbose(verb),
+    window(w), num_threads(t), reduction_budget(reduction_bytes),
+    reduction_in_use(0), ops_since_pass(0), top_level_uid(0),
+    has_top_level(false), lines(0), matched(0), dropped(0),
+    event_edges(0), implicit_edges(0), copies(0),
+    total_errors(0), total_warnings(0)
+{
+  pthread_mutex_init(&reduction_lock, NULL);
+  pthread_cond_init(&reduction_cond, NULL);
+}
+
+SpyState::~SpyState(void)
+{
+  pthread_cond_destroy(&reduction_cond);
+  pthread_mutex_destroy(&reduction_lock);
+  for (std::map<u64,IndexNode*>::const_iterator it = index_spaces.begin();
+        it != index_spaces.end(); it++)
+    delete it->second;
+  for (std::map<u64,IndexNode*>::const_iterator it = index_parts.begin();
+        it != index_parts.end(); it++)
+    delete it->second;
+  std::set<Context*> deleted;
+  for (std::map<u64,Context*>::const_iterator it = contexts.begin();
+        it != contexts.end(); it++)
+  {
+    // Point tasks that were merged share a context
+    if (!deleted.insert(it->second).second)
+      continue;
+    for (unsigned idx = 0; idx < it->second->ops.size(); idx++)
+      delete it->second->ops[idx];
+    delete it->second;
+  }
+}
+
+bool SpyState::parse_file(const char *file_name)
+{
+  FILE *f = fopen(file_name, "r");
+  if (f == NULL)
+  {
+    fprintf(stderr,"ERROR: Unable to open %s\n", file_name);
+    return false;
+  }
+  static const char *prefix = "{legion_spy}: ";
+  const size_t prefix_len = strlen(prefix);
+  std::vector<char> buffer(1 << 16);
+  while (fgets(&buffer[0], buffer.size(), f) != NULL)
+  {
+    size_t len = strlen(&buffer[0]);
+    // Grow the buffer for really long lines
+    while ((len == (buffer.size() - 1)) && (buffer[len-1] != '\n'))
+    {
+      buffer.resize(2 * buffer.size());
+      if (fgets(&buffer[len], buffer.size() - len, f) == NULL)
+        break;
+      len += strlen(&buffer[len]);
+    }
+    const char *line = strstr(&buffer[0], prefix);
+    if (line == NULL)
+      continue;
+    line += prefix_len;
+    lines++;
+    if (parse_line(line))
+      matched++;
+    else
+      pending.push_back(std::string(line));
+    if (logical_checks && (window > 0) && (ops_since_pass >= window))
+    {
+      replay_pending(false/*final*/);
+      run_check_pass(false/*final*/);
+      ops_since_pass = 0;
+    }
+  }
+  fclose(f);
+  replay_pending(true/*final*/);
+  return true;
+}
+
+void SpyState::replay_pending(bool final)
+{
+  // Keep going until we stop making progress like spy_parser.py
+  while (!pending.empty())
+  {
+    std::vector<std::string> remaining;
+    for (unsigned idx = 0; idx < pending.size(); idx++)
+    {
+      if (parse_line(pending[idx].c_str()))
+        matched++;
+      else
+        remaining.push_back(pending[idx]);
+    }
+    const bool progress = (remaining.size() < pending.size());
+    pending.swap(remaining);
+    if (!progress)
+      break;
+  }
+  if (final && !pending.empty())
+  {
+    fprintf(stderr,"WARNING: Unable to match %zd lines, the first is: %s",
+            pending.size(), pending[0].c_str());
+    pending.clear();
+  }
+}
+
+bool SpyState::parse_line(const char *line)
+{
+  LineParser p(line);
+  // Names and the shape of the machine don't matter to the checks
+  if (p.keyword("Index Space Name") || p.keyword("Index Partition Name") ||
+      p.keyword("Logical Region Name") || p.keyword("Logical Partition Name") ||
+      p.keyword("Field Space Name") || p.keyword("Field Space") ||
+      p.keyword("Field Creation") || p.keyword("Field Name") ||
+      p.keyword("Region") || p.keyword("Utility") ||
+      p.keyword("Processor Memory") || p.keyword("Processor") ||
+      p.keyword("Memory Memory") || p.keyword("Memory") ||
+      p.keyword("Task Instance Requirement") || p.keyword("Copy Field") ||
+      p.keyword("Physical Instance") || p.keyword("Reduction Instance") ||
+      p.keyword("Op Instance User") || p.keyword("Op Processor User") ||
+      p.keyword("Phase Barrier"))
+    return true;
+  // Region tree shapes
+  if (p.keyword("Index Space"))
+  {
+    const u64 uid = p.hex();
+    if (index_spaces.find(uid) == index_spaces.end())
+      index_spaces[uid] = new IndexNode(uid, true/*region*/, NULL, false);
+    return true;
+  }
+  if (p.keyword("Index Partition"))
+  {
+    const u64 pid = p.hex();
+    const u64 uid = p.hex();
+    const bool disjoint = (p.dec() == 1);
+    std::map<u64,IndexNode*>::const_iterator finder = index_spaces.find(pid);
+    if (finder == index_spaces.end())
+      return false;
+    if (index_parts.find(uid) == index_parts.end())
+      index_parts[uid] = new IndexNode(uid, false/*region*/,
+                                       finder->second, disjoint);
+    return true;
+  }
+  if (p.keyword("Index Subspace"))
+  {
+    const u64 pid = p.hex();
+    const u64 uid = p.hex();
+    std::map<u64,IndexNode*>::const_iterator finder = index_parts.find(pid);
+    if (finder == index_parts.end())
+      return false;
+    if (index_spaces.find(uid) == index_spaces.end())
+      index_spaces[uid] = new IndexNode(uid, true/*region*/,
+                                        finder->second, false);
+    return true;
+  }
+  // Operations
+  if (p.keyword("Top Task"))
+  {
+    p.dec(); // task id
+    const u64 uid = p.dec();
+    const std::string name = p.word();
+    top_level_uid = uid;
+    has_top_level = true;
+    find_or_create_context(uid, name);
+    op_names[uid] = name;
+    return true;
+  }
+  if (p.keyword("Individual Task") || p.keyword("Index Task"))
+  {
+    const bool index = (strncmp(line, "Index", 5) == 0);
+    const u64 ctx = p.dec();
+    p.dec(); // task id
+    const u64 uid = p.dec();
+    const std::string name = p.word();
+    if (has_top_level && (uid == top_level_uid))
+      return true;
+    if (!add_operation(ctx, uid, index ? INDEX_OP : SINGLE_OP, name))
+      return false;
+    if (!index)
+      find_or_create_context(uid, name);
+    return true;
+  }
+  {
+    static const char *op_lines[] = {
+      "Mapping Operation", "Close Operation", "Fence Operation",
+      "Copy Operation", "Acquire Operation", "Release Operation",
+      "Deletion Operation",
+    };
+    static const OpKind op_kinds[] = {
+      MAPPING_OP, CLOSE_OP, FENCE_OP, COPY_OP,
+      ACQUIRE_OP, RELEASE_OP, DELETION_OP,
+    };
+    for (unsigned idx = 0; idx < (sizeof(op_kinds)/sizeof(op_kinds[0])); idx++)
+    {
+      if (!p.keyword(op_lines[idx]))
+        continue;
+      const u64 ctx = p.dec();
+      const u64 uid = p.dec();
+      return add_operation(ctx, uid, op_kinds[idx], std::string());
+    }
+  }
+  if (p.keyword("Index Slice"))
+  {
+    const u64 index_id = p.dec();
+    const u64 slice_id = p.dec();
+    if (!has_top_level && (ops.find(index_id) == ops.end()) &&
+        (retired.find(index_id) == retired.end()))
+      return false;
+    slice_index[slice_id] = index_id;
+    return true;
+  }
+  if (p.keyword("Slice Slice"))
+  {
+    const u64 slice1 = p.dec();
+    const u64 slice2 = p.dec();
+    std::map<u64,u64>::const_iterator finder = slice_index.find(slice1);
+    if (finder == slice_index.end())
+      return false;
+    slice_index[slice2] = finder->second;
+    return true;
+  }
+  if (p.keyword("Slice Point"))
+  {
+    const u64 slice_id = p.dec();
+    const u64 point_id = p.dec();
+    std::map<u64,u64>::const_iterator finder = slice_index.find(slice_id);
+    if (finder == slice_index.end())
+      return false;
+    // Point tasks are contexts for the operations they launch
+    std::string name;
+    std::map<u64,Operation*>::const_iterator index_op =
+      ops.find(finder->second);
+    if (index_op != ops.end())
+      name = index_op->second->name;
+    else
+      name = op_names[finder->second];
+    find_or_create_context(point_id, name);
+    op_names[point_id] = name;
+    return true;
+  }
+  if (p.keyword("Point Point"))
+  {
+    const u64 point1 = p.dec();
+    const u64 point2 = p.dec();
+    std::map<u64,Context*>::const_iterator finder = contexts.find(point1);
+    if (finder == contexts.end())
+      return false;
+    contexts[point2] = finder->second;
+    return true;
+  }
+  // Mapping dependence analysis
+  if (p.keyword("Logical Requirement Field"))
+  {
+    if (!logical_checks)
+      return true;
+    const u64 uid = p.dec();
+    const unsigned index = p.dec();
+    const unsigned fid = p.dec();
+    std::map<u64,Operation*>::const_iterator finder = ops.find(uid);
+    if (finder == ops.end())
+    {
+      if (retired.find(uid) != retired.end())
+      {
+        dropped++;
+        return true;
+      }
+      return false;
+    }
+    Operation *op = finder->second;
+    if ((index >= op->reqs.size()) || !op->reqs[index].valid)
+      return false;
+    std::vector<unsigned> &fields = op->reqs[index].fields;
+    fields.insert(std::lower_bound(fields.begin(), fields.end(), fid), fid);
+    return true;
+  }
+  if (p.keyword("Logical Requirement"))
+  {
+    if (!logical_checks)
+      return true;
+    Requirement req;
+    const u64 uid = p.dec();
+    req.index = p.dec();
+    req.valid = true;
+    req.is_reg = (p.dec() == 1);
+    req.ispace = p.hex();
+    req.fspace = p.dec();
+    req.tid = p.dec();
+    req.priv = p.dec();
+    req.coher = p.dec();
+    req.redop = p.dec();
+    if (!p.valid)
+      return false;
+    std::map<u64,Operation*>::const_iterator finder = ops.find(uid);
+    if (finder == ops.end())
+    {
+      if (retired.find(uid) != retired.end())
+      {
+        dropped++;
+        return true;
+      }
+      return false;
+    }
+    req.node = find_index_node(req.is_reg, req.ispace);
+    if (req.node == NULL)
+      return false;
+    Operation *op = finder->second;
+    if (req.index >= op->reqs.size())
+    {
+      Requirement invalid;
+      invalid.valid = false;
+      op->reqs.resize(req.index+1, invalid);
+    }
+    op->reqs[req.index] = req;
+    return true;
+  }
+  if (p.keyword("Mapping Dependence"))
+  {
+    if (!logical_checks)
+      return true;
+    const u64 ctx = p.dec();
+    const u64 prev_id = p.dec();
+    const unsigned pidx = p.dec();
+    const u64 next_id = p.dec();
+    const unsigned nidx = p.dec();
+    const unsigned dtype = p.dec();
+    std::map<u64,Operation*>::const_iterator prev = ops.find(prev_id);
+    std::map<u64,Operation*>::const_iterator next = ops.find(next_id);
+    if ((prev == ops.end()) || (next == ops.end()))
+    {
+      if ((retired.find(prev_id) != retired.end()) ||
+          (retired.find(next_id) != retired.end()))
+      {
+        dropped++;
+        return true;
+      }
+      return false;
+    }
+    std::map<u64,Context*>::const_iterator context = contexts.find(ctx);
+    if (context == contexts.end())
+      return false;
+    // Dependences are always between operations in the same context
+    if ((prev->second->ctx != context->second) ||
+        (next->second->ctx != context->second))
+      return true;
+    next->second->mdeps.push_back(
+        MappingDep(prev->second->seq, pidx, nidx, dtype));
+    return true;
+  }
+  // Event graph
+  if (p.keyword("Event Event") || p.keyword("Implicit Event"))
+  {
+    if (!event_checks)
+      return true;
+    const bool implicit = (line[0] == 'I');
+    const u64 id1 = p.hex();
+    const unsigned gen1 = p.dec();
+    const u64 id2 = p.hex();
+    const unsigned gen2 = p.dec();
+    if (implicit)
+    {
+      // Implicit dependences are not part of the event graph
+      implicit_edges++;
+      return true;
+    }
+    if ((id1 == 0) || (id2 == 0))
+      return true;
+    const unsigned src = find_event_node(id1, gen1);
+    const unsigned dst = find_event_node(id2, gen2);
+    nodes[src].out.push_back(dst);
+    event_edges++;
+    return true;
+  }
+  if (p.keyword("Op Events"))
+  {
+    if (!event_checks)
+      return true;
+    const u64 uid = p.dec();
+    const u64 start_id = p.hex();
+    const unsigned start_gen = p.dec();
+    const u64 term_id = p.hex();
+    const unsigned term_gen = p.dec();
+    unsigned op_node;
+    std::map<u64,unsigned>::const_iterator finder = op_nodes.find(uid);
+    if (finder == op_nodes.end())
+    {
+      op_node = nodes.size();
+      nodes.push_back(GraphNode(OP_NODE, uid, 0));
+      op_nodes[uid] = op_node;
+      std::map<u64,Operation*>::const_iterator op = ops.find(uid);
+      if (op != ops.end())
+        op_names[uid] = op->second->get_name();
+    }
+    else
+      op_node = finder->second;
+    if (start_id != 0)
+      nodes[find_event_node(start_id, start_gen)].out.push_back(op_node);
+    if (term_id != 0)
+    {
+      const unsigned term = find_event_node(term_id, term_gen);
+      nodes[op_node].out.push_back(term);
+    }
+    return true;
+  }
+  if (p.keyword("Copy Events"))
+  {
+    if (!event_checks)
+      return true;
+    p.hex(); // source instance
+    p.hex(); // destination instance
+    p.hex(); // index space
+    p.dec(); // field space
+    p.dec(); // tree id
+    const u64 start_id = p.hex();
+    const unsigned start_gen = p.dec();
+    const u64 term_id = p.hex();
+    const unsigned term_gen = p.dec();
+    const unsigned copy_node = nodes.size();
+    nodes.push_back(GraphNode(COPY_NODE, ++copies, 0));
+    if (start_id != 0)
+      nodes[find_event_node(start_id, start_gen)].out.push_back(copy_node);
+    if (term_id != 0)
+    {
+      const unsigned term = find_event_node(term_id, term_gen);
+      nodes[copy_node].out.push_back(term);
+    }
+    return true;
+  }
+  // Not something that we know about, count it as matched so
+  // we don't keep trying to replay it
+  return true;
+}
+
+Context* SpyState::find_or_create_context(u64 uid, const std::string &name)
+{
+  std::map<u64,Context*>::const_iterator finder = contexts.find(uid);
+  if (finder != contexts.end())
+    return finder->second;
+  Context *result = new Context(uid, name);
+  contexts[uid] = result;
+  return result;
+}
+
+bool SpyState::add_operation(u64 ctx, u64 uid, OpKind kind,
+                             const std::string &name)
+{
+  std::map<u64,Context*>::const_iterator finder = contexts.find(ctx);
+  if (finder == contexts.end())
+    return false;
+  if (!logical_checks)
+  {
+    op_names[uid] = (kind <= INDEX_OP) ? name : std::string();
+    return true;
+  }
+  Context *context = finder->second;
+  Operation *op = new Operation(uid, kind, name);
+  op->ctx = context;
+  op->seq = context->next_seq++;
+  context->ops.push_back(op);
+  ops[uid] = op;
+  if ((kind == SINGLE_OP) || (kind == INDEX_OP))
+    op_names[uid] = name;
+  ops_since_pass++;
+  return true;
+}
+
+IndexNode* SpyState::find_index_node(bool is_reg, u64 id) const
+{
+  const std::map<u64,IndexNode*> &nodes = is_reg ? index_spaces : index_parts;
+  std::map<u64,IndexNode*>::const_iterator finder = nodes.find(id);
+  if (finder == nodes.end())
+    return NULL;
+  return finder->second;
+}
+
+static unsigned check_for_anti_dependence(const Requirement &req1,
+                                          const Requirement &req2,
+                                          unsigned actual)
+{
+  if (req1.is_read_only())
+  {
+    assert(req2.has_write());
+    return ANTI_DEPENDENCE;
+  }
+  if (req2.is_write_only())
+    return ANTI_DEPENDENCE;
+  return actual;
+}
+
+// Mirrors compute_dependence_type in spy_analysis.py
+static unsigned compute_dependence_type(const Requirement &req1,
+                                        const Requirement &req2)
+{
+  if (req1.is_read_only() && req2.is_read_only())
+    return NO_DEPENDENCE;
+  if (req1.is_reduce() && req2.is_reduce())
+    return (req1.redop == req2.redop) ? NO_DEPENDENCE : TRUE_DEPENDENCE;
+  assert(req1.has_write() || req2.has_write());
+  if (req1.is_exclusive() || req2.is_exclusive())
+    return check_for_anti_dependence(req1, req2, TRUE_DEPENDENCE);
+  if (req1.is_atomic() || req2.is_atomic())
+  {
+    if (req1.is_atomic() && req2.is_atomic())
+      return check_for_anti_dependence(req1, req2, ATOMIC_DEPENDENCE);
+    if ((!req1.is_atomic() && req1.is_read_only()) ||
+        (!req2.is_atomic() && req2.is_read_only()))
+      return NO_DEPENDENCE;
+    return check_for_anti_dependence(req1, req2, TRUE_DEPENDENCE);
+  }
+  if (req1.is_simult() || req2.is_simult())
+    return check_for_anti_dependence(req1, req2, SIMULTANEOUS_DEPENDENCE);
+  if (req1.is_relaxed() && req2.is_relaxed())
+    return check_for_anti_dependence(req1, req2, SIMULTANEOUS_DEPENDENCE);
+  // Should never get here
+  assert(false);
+  return NO_DEPENDENCE;
+}
+
+unsigned SpyState::compute_dependence(const Requirement &req1,
+                                      const Requirement &req2) const
+{
+  // Check for any overlap in the fields first since it is cheap
+  std::vector<unsigned>::const_iterator it1 = req1.fields.begin();
+  std::vector<unsigned>::const_iterator it2 = req2.fields.begin();
+  bool overlap = false;
+  while ((it1 != req1.fields.end()) && (it2 != req2.fields.end()))
+  {
+    if (*it1 == *it2)
+    {
+      overlap = true;
+      break;
+    }
+    if (*it1 < *it2)
+      it1++;
+    else
+      it2++;
+  }
+  if (!overlap)
+    return NO_DEPENDENCE;
+  // Different region trees can't alias
+  if (req1.tid != req2.tid)
+    return NO_DEPENDENCE;
+  if (!is_aliased(req1.node, req2.node))
+    return NO_DEPENDENCE;
+  return compute_dependence_type(req1, req2);
+}
+
+bool SpyState::is_aliased(const IndexNode *one, const IndexNode *two) const
+{
+  const IndexNode *orig_one = one;
+  const IndexNode *orig_two = two;
+  // Bring them to the same depth
+  while (one->depth > two->depth)
+    one = one->parent;
+  while (two->depth > one->depth)
+    two = two->parent;
+  // One is an ancestor of the other
+  if ((one == orig_two) || (two == orig_one))
+    return true;
+  // Walk up in sync until we find the least common ancestor
+  while (one != two)
+  {
+    if ((one->parent == NULL) || (two->parent == NULL))
+      return false;
+    one = one->parent;
+    two = two->parent;
+  }
+  // Different partitions of the same region are aliased
+  if (one->is_region)
+    return true;
+  return !one->disjoint;
+}
+
+bool SpyState::has_logical_path(Context *ctx, Operation *from, Operation *to)
+{
+  // Depth-first search back along the mapping dependences
+  // of the operations that are still resident
+  ctx->epoch++;
+  std::vector<Operation*> stack;
+  stack.push_back(from);
+  from->mark = ctx->epoch;
+  while (!stack.empty())
+  {
+    Operation *op = stack.back();
+    stack.pop_back();
+    if (op == to)
+      return true;
+    for (std::vector<MappingDep>::const_iterator it = op->mdeps.begin();
+          it != op->mdeps.end(); it++)
+    {
+      Operation *prev = ctx->find_op(it->prev_seq);
+      if ((prev == NULL) || (prev->mark == ctx->epoch))
+        continue;
+      prev->mark = ctx->epoch;
+      stack.push_back(prev);
+    }
+  }
+  return false;
+}
+
+void Requirement::print(std::string &out) const
+{
+  char buffer[256];
+  if (is_reg)
+    snprintf(buffer, sizeof(buffer),
+             "        Logical Region Requirement (0x%llx,%u,%u)\n",
+             ispace, fspace, tid);
+  else
+    snprintf(buffer, sizeof(buffer),
+             "        Logical Partition Requirement (%llu,%u,%u)\n",
+             ispace, fspace, tid);
+  out += buffer;
+  out += "          Fields: ";
+  for (unsigned idx = 0; idx < fields.size(); idx++)
+  {
+    snprintf(buffer, sizeof(buffer), (idx == 0) ? "%u" : ", %u", fields[idx]);
+    out += buffer;
+  }
+  out += "\n";
+  const char *privilege = "REDUCE";
+  switch (priv)
+  {
+    case NO_ACCESS: privilege = "NO ACCESS"; break;
+    case READ_ONLY: privilege = "READ-ONLY"; break;
+    case READ_WRITE: privilege = "READ-WRITE"; break;
+    case WRITE_ONLY: privilege = "WRITE-ONLY"; break;
+    default: break;
+  }
+  static const char *coherences[] =
+    { "EXCLUSIVE", "ATOMIC", "SIMULTANEOUS", "RELAXED" };
+  if (priv == REDUCE)
+    snprintf(buffer, sizeof(buffer),
+        "        Privilege: REDUCE with Reduction Op %u\n", redop);
+  else
+    snprintf(buffer, sizeof(buffer), "        Privilege: %s\n", privilege);
+  out += buffer;
+  snprintf(buffer, sizeof(buffer), "        Coherence: %s\n",
+           (coher <= RELAXED) ? coherences[coher] : "UNKNOWN");
+  out += buffer;
+}
+
+// Check all the operations in the context before the limit
+void SpyState::check_context(Context *ctx, u64 limit)
+{
+  char buffer[512];
+  for (u64 seq = ctx->checked_seq; seq < limit; seq++)
+  {
+    Operation *next = ctx->find_op(seq);
+    assert(next != NULL);
+    ctx->ops_checked++;
+    // Compute the actual dependences on the operations before us
+    // in the window and make sure there is a path for each of them
+    if ((next->kind != FENCE_OP) && (next->kind != DELETION_OP))
+    {
+      const u64 first = ((window > 0) && (seq > window)) ?
+                          std::max(seq - window, ctx->base_seq) : ctx->base_seq;
+      for (u64 prev_seq = first; prev_seq < seq; prev_seq++)
+      {
+        Operation *prev = ctx->find_op(prev_seq);
+        if ((prev->kind == FENCE_OP) || (prev->kind == DELETION_OP))
+          continue;
+        for (unsigned idx1 = 0; idx1 < prev->reqs.size(); idx1++)
+        {
+          const Requirement &req1 = prev->reqs[idx1];
+          if (!req1.valid)
+            continue;
+          for (unsigned idx2 = 0; idx2 < next->reqs.size(); idx2++)
+          {
+            const Requirement &req2 = next->reqs[idx2];
+            if (!req2.valid)
+              continue;
+            if (compute_dependence(req1, req2) == NO_DEPENDENCE)
+              continue;
+            ctx->actual_deps++;
+            if (has_logical_path(ctx, next, prev))
+              continue;
+            snprintf(buffer, sizeof(buffer),
+                "    ERROR: Failed to compute mapping dependence between "
+                "index %u of %s (ID %llu) and index %u of %s (ID %llu)\n",
+                req1.index, prev->get_name().c_str(), prev->uid,
+                req2.index, next->get_name().c_str(), next->uid);
+            ctx->output += buffer;
+            ctx->output += "      First Requirement:\n";
+            req1.print(ctx->output);
+            ctx->output += "      Second Requirement:\n";
+            req2.print(ctx->output);
+            ctx->errors++;
+          }
+        }
+      }
+    }
+    // Now make sure every dependence that the runtime computed
+    // corresponds to an actual dependence
+    if (next->kind == DELETION_OP)
+      continue;
+    for (std::vector<MappingDep>::const_iterator it = next->mdeps.begin();
+          it != next->mdeps.end(); it++)
+    {
+      // Retired or still resident but further back than the window
+      // that we checked against so we can't tell
+      Operation *prev = ctx->find_op(it->prev_seq);
+      if ((prev == NULL) || ((window > 0) && (it->prev_seq < seq) &&
+                             ((seq - it->prev_seq) > window)))
+      {
+        ctx->unverified++;
+        continue;
+      }
+      bool found = false;
+      if ((it->prev_seq < seq) &&
+          (prev->kind != FENCE_OP) && (prev->kind != DELETION_OP) &&
+          (next->kind != FENCE_OP))
+      {
+        const Requirement *req1 = prev->find_requirement(it->prev_idx);
+        const Requirement *req2 = next->find_requirement(it->next_idx);
+        if ((req1 != NULL) && (req2 != NULL))
+          found = (compute_dependence(*req1, *req2) == it->dtype);
+      }
+      if (found)
+        continue;
+      snprintf(buffer, sizeof(buffer),
+          "    WARNING: Computed extra mapping dependence between index %u "
+          "of %s (ID %llu) and index %u of %s (ID %llu) in context of "
+          "task %s\n", it->prev_idx, prev->get_name().c_str(), prev->uid,
+          it->next_idx, next->get_name().c_str(), next->uid, ctx->name.c_str());
+      ctx->output += buffer;
+      ctx->warnings++;
+    }
+  }
+  ctx->checked_seq = limit;
+}
+
+void SpyState::retire_operations(Context *ctx)
+{
+  // Operations can be retired once no unchecked operation
+  // will look back far enough in the window to see them
+  if (window == 0)
+    return;
+  while (!ctx->ops.empty() && ((ctx->base_seq + window) < ctx->checked_seq))
+  {
+    Operation *op = ctx->ops.front();
+    ctx->ops.pop_front();
+    ctx->base_seq++;
+    ops.erase(op->uid);
+    retired.insert(op->uid);
+    retired_order.push_back(op->uid);
+    if (retired_order.size() > RETIRED_HISTORY)
+    {
+      retired.erase(retired_order.front());
+      retired_order.pop_front();
+    }
+    delete op;
+  }
+}
+
+struct CheckWork {
+public:
+  SpyState *state;
+  std::vector<std::pair<Context*,u64> > *contexts;
+  volatile unsigned next;
+};
+
+static void* check_thread(void *arg)
+{
+  CheckWork *work = (CheckWork*)arg;
+  while (true)
+  {
+    const unsigned index = __sync_fetch_and_add(&(work->next), 1);
+    if (index >= work->contexts->size())
+      break;
+    std::pair<Context*,u64> &item = (*work->contexts)[index];
+    work->state->check_context(item.first, item.second);
+  }
+  return NULL;
+}
+
+void SpyState::run_check_pass(bool final)
+{
+  // Find all the contexts with operations that are ready to be checked,
+  // operations are only checked once a window's worth of operations
+  // after them have been seen to give their dependences time to arrive
+  std::vector<std::pair<Context*,u64> > ready;
+  std::set<Context*> seen;
+  for (std::map<u64,Context*>::const_iterator it = contexts.begin();
+        it != contexts.end(); it++)
+  {
+    Context *ctx = it->second;
+    if (!seen.insert(ctx).second)
+      continue;
+    u64 limit = ctx->next_seq;
+    if (!final)
+      limit = (limit > window) ? (limit - window) : 0;
+    if (limit > ctx->checked_seq)
+      ready.push_back(std::pair<Context*,u64>(ctx, limit));
+  }
+  if (ready.empty())
+    return;
+  CheckWork work;
+  work.state = this;
+  work.contexts = &ready;
+  work.next = 0;
+  const unsigned threads =
+    std::min<unsigned>(num_threads, ready.size());
+  std::vector<pthread_t> workers(threads);
+  for (unsigned idx = 1; idx < threads; idx++)
+    pthread_create(&workers[idx], NULL, check_thread, &work);
+  check_thread(&work);
+  for (unsigned idx = 1; idx < threads; idx++)
+    pthread_join(workers[idx], NULL);
+  for (unsigned idx = 0; idx < ready.size(); idx++)
+  {
+    print_context(ready[idx].first);
+    retire_operations(ready[idx].first);
+  }
+}
+
+void SpyState::print_context(Context *ctx)
+{
+  if (!ctx->reported && (verbose || !ctx->output.empty()))
+  {
+    printf("Checking mapping dependences for task context %s (UID %llu)\n",
+           ctx->name.c_str(), ctx->uid);
+    ctx->reported = true;
+  }
+  if (!ctx->output.empty())
+  {
+    fputs(ctx->output.c_str(), stdout);
+    ctx->output.clear();
+  }
+  total_errors += ctx->errors;
+  total_warnings += ctx->warnings;
+  ctx->errors = 0;
+  ctx->warnings = 0;
+}
+
+void SpyState::finish_logical(void)
+{
+  if (!logical_checks)
+    return;
+  run_check_pass(true/*final*/);
+  u64 checked = 0, actual = 0, unverified = 0;
+  std::set<Context*> seen;
+  for (std::map<u64,Context*>::const_iterator it = contexts.begin();
+        it != contexts.end(); it++)
+  {
+    if (!seen.insert(it->second).second)
+      continue;
+    checked += it->second->ops_checked;
+    actual += it->second->actual_deps;
+    unverified += it->second->unverified;
+  }
+  printf("Checked %llu operations in %zd contexts with %llu actual dependences\n",
+         checked, seen.size(), actual);
+  if (unverified > 0)
+    printf("    %llu computed dependences fell outside the window of %u "
+           "operations and were not verified\n", unverified, window);
+  if (dropped > 0)
+    printf("    %llu lines arrived after their operations were retired\n",
+           dropped);
+  printf("    Mapping Dependence Errors: %llu\n", total_errors);
+  printf("    Mapping Dependence Warnings: %llu\n", total_warnings);
+}
+
+unsigned SpyState::find_event_node(u64 id, unsigned gen)
+{
+  const std::pair<u64,unsigned> key(id, gen);
+  std::map<std::pair<u64,unsigned>,unsigned>::const_iterator finder =
+    event_nodes.find(key);
+  if (finder != event_nodes.end())
+    return finder->second;
+  const unsigned result = nodes.size();
+  nodes.push_back(GraphNode(EVENT_NODE, id, gen));
+  event_nodes[key] = result;
+  return result;
+}
+
+// Find the transitive reduction, check for cycles and find
+// the critical path of the component
+void SpyState::analyze_component(Component &comp, bool reduce)
+{
+  const unsigned size = comp.nodes.size();
+  // Local numbering of the nodes in the component
+  std::map<unsigned,unsigned> local;
+  for (unsigned idx = 0; idx < size; idx++)
+    local[comp.nodes[idx]] = idx;
+  std::vector<std::vector<unsigned> > out(size);
+  std::vector<unsigned> in_degree(size, 0);
+  for (unsigned idx = 0; idx < size; idx++)
+  {
+    const std::vector<unsigned> &edges = nodes[comp.nodes[idx]].out;
+    for (unsigned e = 0; e < edges.size(); e++)
+      out[idx].push_back(local[edges[e]]);
+    std::sort(out[idx].begin(), out[idx].end());
+    out[idx].erase(std::unique(out[idx].begin(), out[idx].end()),
+                   out[idx].end());
+    for (unsigned e = 0; e < out[idx].size(); e++)
+      in_degree[out[idx][e]]++;
+  }
+  // Topological sort
+  std::vector<unsigned> order;
+  order.reserve(size);
+  for (unsigned idx = 0; idx < size; idx++)
+    if (in_degree[idx] == 0)
+      order.push_back(idx);
+  for (unsigned idx = 0; idx < order.size(); idx++)
+  {
+    const std::vector<unsigned> &edges = out[order[idx]];
+    for (unsigned e = 0; e < edges.size(); e++)
+      if (--in_degree[edges[e]] == 0)
+        order.push_back(edges[e]);
+  }
+  if (order.size() < size)
+  {
+    comp.cycle = true;
+    return;
+  }
+  std::vector<unsigned> position(size);
+  for (unsigned idx = 0; idx < size; idx++)
+    position[order[idx]] = idx;
+  // Longest chain of operations and copies
+  std::vector<unsigned> length(size, 0), pred(size, size);
+  for (unsigned idx = 0; idx < size; idx++)
+  {
+    const unsigned node = order[idx];
+    if (nodes[comp.nodes[node]].kind != EVENT_NODE)
+      length[node]++;
+    if (length[node] > comp.critical_length)
+    {
+      comp.critical_length = length[node];
+      comp.critical_path.clear();
+      comp.critical_path.push_back(node);
+    }
+    const std::vector<unsigned> &edges = out[node];
+    for (unsigned e = 0; e < edges.size(); e++)
+    {
+      if ((pred[edges[e]] == size) || (length[node] > length[edges[e]]))
+      {
+        length[edges[e]] = length[node];
+        pred[edges[e]] = node;
+      }
+    }
+  }
+  if (!comp.critical_path.empty())
+  {
+    unsigned node = comp.critical_path[0];
+    comp.critical_path.clear();
+    while (node != size)
+    {
+      if (nodes[comp.nodes[node]].kind != EVENT_NODE)
+        comp.critical_path.push_back(comp.nodes[node]);
+      node = pred[node];
+    }
+    std::reverse(comp.critical_path.begin(), comp.critical_path.end());
+  }
+  // The reachability sets are quadratic in the size of the component
+  const unsigned words = (size + 63) / 64;
+  const u64 needed = u64(size) * words * sizeof(u64);
+  if (needed > reduction_budget)
+  {
+    comp.skipped = true;
+    if (reduce)
+    {
+      for (unsigned idx = 0; idx < size; idx++)
+        for (unsigned e = 0; e < out[idx].size(); e++)
+          comp.reduced.push_back(std::pair<unsigned,unsigned>(
+                comp.nodes[idx], comp.nodes[out[idx][e]]));
+    }
+    return;
+  }
+  // Wait for our share of the budget, every thread holds at most one
+  // share and no share is larger than the budget so this always ends
+  pthread_mutex_lock(&reduction_lock);
+  while ((reduction_in_use + needed) > reduction_budget)
+    pthread_cond_wait(&reduction_cond, &reduction_lock);
+  reduction_in_use += needed;
+  pthread_mutex_unlock(&reduction_lock);
+  // Transitive reduction: walk the nodes in reverse topological order
+  // and visit the successors of each node from the closest one, any
+  // successor that is already reachable through a closer one is redundant
+  std::vector<std::vector<u64> > reach(size);
+  for (int idx = size - 1; idx >= 0; idx--)
+  {
+    const unsigned node = order[idx];
+    std::vector<u64> &mine = reach[node];
+    mine.resize(words, 0);
+    std::vector<unsigned> &edges = out[node];
+    std::vector<std::pair<unsigned,unsigned> > sorted;
+    for (unsigned e = 0; e < edges.size(); e++)
+      sorted.push_back(std::pair<unsigned,unsigned>(position[edges[e]], edges[e]));
+    std::sort(sorted.begin(), sorted.end());
+    for (unsigned e = 0; e < sorted.size(); e++)
+    {
+      const unsigned succ = sorted[e].second;
+      if (mine[succ/64] & (1ULL << (succ%64)))
+      {
+        comp.redundant++;
+        continue;
+      }
+      if (reduce)
+        comp.reduced.push_back(std::pair<unsigned,unsigned>(
+              comp.nodes[node], comp.nodes[succ]));
+      mine[succ/64] |= (1ULL << (succ%64));
+      const std::vector<u64> &theirs = reach[succ];
+      for (unsigned w = 0; w < words; w++)
+        mine[w] |= theirs[w];
+    }
+  }
+  // Give the memory back before giving back the share
+  std::vector<std::vector<u64> >().swap(reach);
+  pthread_mutex_lock(&reduction_lock);
+  reduction_in_use -= needed;
+  pthread_cond_broadcast(&reduction_cond);
+  pthread_mutex_unlock(&reduction_lock);
+}
+
+struct ComponentWork {
+public:
+  SpyState *state;
+  std::vector<Component> *components;
+  bool reduce;
+  volatile unsigned next;
+};
+
+static void* component_thread(void *arg)
+{
+  ComponentWork *work = (ComponentWork*)arg;
+  while (true)
+  {
+    const unsigned index = __sync_fetch_and_add(&(work->next), 1);
+    if (index >= work->components->size())
+      break;
+    work->state->analyze_component((*work->components)[index], work->reduce);
+  }
+  return NULL;
+}
+
+static unsigned find_root(std::vector<unsigned> &parents, unsigned node)
+{
+  while (parents[node] != node)
+  {
+    parents[node] = parents[parents[node]];
+    node = parents[node];
+  }
+  return node;
+}
+
+void SpyState::analyze_event_graph(const char *dot_file)
+{
+  if (!event_checks)
+    return;
+  u64 edges = 0;
+  for (unsigned idx = 0; idx < nodes.size(); idx++)
+    edges += nodes[idx].out.size();
+  printf("Event graph has %zd nodes (%zd operations, %llu copies) "
+         "and %llu edges (%llu implicit dependences ignored)\n",
+         nodes.size(), op_nodes.size(), copies, edges, implicit_edges);
+  // Find the connected components
+  std::vector<unsigned> parents(nodes.size());
+  for (unsigned idx = 0; idx < nodes.size(); idx++)
+    parents[idx] = idx;
+  for (unsigned idx = 0; idx < nodes.size(); idx++)
+  {
+    for (unsigned e = 0; e < nodes[idx].out.size(); e++)
+    {
+      const unsigned one = find_root(parents, idx);
+      const unsigned two = find_root(parents, nodes[idx].out[e]);
+      if (one != two)
+        parents[one] = two;
+    }
+  }
+  std::map<unsigned,unsigned> roots;
+  std::vector<Component> components;
+  for (unsigned idx = 0; idx < nodes.size(); idx++)
+  {
+    const unsigned root = find_root(parents, idx);
+    std::map<unsigned,unsigned>::const_iterator finder = roots.find(root);
+    unsigned index;
+    if (finder == roots.end())
+    {
+      index = components.size();
+      roots[root] = index;
+      components.push_back(Component());
+    }
+    else
+      index = finder->second;
+    components[index].nodes.push_back(idx);
+  }
+  // Analyze the largest components first to balance the threads
+  std::vector<std::pair<size_t,unsigned> > by_size;
+  for (unsigned idx = 0; idx < components.size(); idx++)
+    by_size.push_back(std::pair<size_t,unsigned>(
+          components[idx].nodes.size(), idx));
+  std::sort(by_size.rbegin(), by_size.rend());
+  std::vector<Component> sorted(components.size());
+  for (unsigned idx = 0; idx < by_size.size(); idx++)
+    sorted[idx].nodes.swap(components[by_size[idx].second].nodes);
+  components.swap(sorted);
+  ComponentWork work;
+  work.state = this;
+  work.components = &components;
+  work.reduce = (dot_file != NULL);
+  work.next = 0;
+  const unsigned threads =
+    std::max<unsigned>(1, std::min<unsigned>(num_threads, components.size()));
+  std::vector<pthread_t> workers(threads);
+  for (unsigned idx = 1; idx < threads; idx++)
+    pthread_create(&workers[idx], NULL, component_thread, &work);
+  component_thread(&work);
+  for (unsigned idx = 1; idx < threads; idx++)
+    pthread_join(workers[idx], NULL);
+  // Report the results
+  u64 redundant = 0, cycles = 0, skipped = 0;
+  unsigned critical = components.size();
+  for (unsigned idx = 0; idx < components.size(); idx++)
+  {
+    const Component &comp = components[idx];
+    redundant += comp.redundant;
+    if (comp.skipped)
+      skipped++;
+    if (comp.cycle)
+    {
+      cycles++;
+      printf("    ERROR: Cycle in event graph component %u with %zd nodes\n",
+             idx, comp.nodes.size());
+      continue;
+    }
+    if ((critical == components.size()) ||
+        (comp.critical_length > components[critical].critical_length))
+      critical = idx;
+  }
+  printf("    Connected components: %zd\n", components.size());
+  printf("    Redundant edges removed by transitive reduction: %llu\n", redundant);
+  if (skipped > 0)
+    printf("    %llu components needing more than %llu MB were not reduced\n",
+           skipped, reduction_budget >> 20);
+  printf("    Event Graph Cycles: %llu\n", cycles);
+  total_errors += cycles;
+  if (critical < components.size())
+  {
+    const Component &comp = components[critical];
+    printf("    Critical path has %u operations and copies:\n",
+           comp.critical_length);
+    for (unsigned idx = 0; idx < comp.critical_path.size(); idx++)
+    {
+      const GraphNode &node = nodes[comp.critical_path[idx]];
+      if (node.kind == COPY_NODE)
+        printf("      Copy %llu\n", node.id);
+      else
+        printf("      %s (UID %llu)\n", op_names[node.id].c_str(), node.id);
+    }
+  }
+  if (dot_file == NULL)
+    return;
+  printf("Writing transitive reduction of the event graph to %s...\n", dot_file);
+  FILE *f = fopen(dot_file, "w");
+  if (f == NULL)
+  {
+    fprintf(stderr,"ERROR: Unable to open %s\n", dot_file);
+    return;
+  }
+  fprintf(f, "digraph event_graph {\n");
+  for (unsigned idx = 0; idx < nodes.size(); idx++)
+  {
+    const GraphNode &node = nodes[idx];
+    switch (node.kind)
+    {
+      case EVENT_NODE:
+        fprintf(f, "  n%u [label=\"Event %llx %u\",shape=oval];\n",
+                idx, node.id, node.gen);
+        break;
+      case OP_NODE:
+        fprintf(f, "  n%u [label=\"%s (UID %llu)\",shape=record,"
+                "style=filled,fillcolor=lightskyblue];\n",
+                idx, op_names[node.id].c_str(), node.id);
+        break;
+      case COPY_NODE:
+        fprintf(f, "  n%u [label=\"Copy %llu\",shape=record,"
+                "style=filled,fillcolor=darkgoldenrod1];\n", idx, node.id);
+        break;
+    }
+  }
+  for (unsigned idx = 0; idx < components.size(); idx++)
+  {
+    const Component &comp = components[idx];
+    for (unsigned e = 0; e < comp.reduced.size(); e++)
+      fprintf(f, "  n%u -> n%u;\n", comp.reduced[e].first,
+              comp.reduced[e].second);
+  }
+  fprintf(f, "}\n");
+  fclose(f);
+  printf("Done!\n");
+}
+
+static void usage(const char *name)
+{
+  fprintf(stderr,"Usage: %s [-l] [-e] [-v] [-w <ops>] [-j <threads>] "
+                 "[-m <MB>] [-d <graph.dot>] <file>\n", name);
+  fprintf(stderr,"  -l : perform logical dependence checks\n");
+  fprintf(stderr,"  -e : perform event graph checks\n");
+  fprintf(stderr,"  -v : print every context that is checked\n");
+  fprintf(stderr,"  -w <ops> : operations in the window of each context "
+                 "(0 is unbounded)\n");
+  fprintf(stderr,"  -j <threads> : number of threads to use\n");
+  fprintf(stderr,"  -m <MB> : memory for the transitive reduction "
+                 "shared by all threads\n");
+  fprintf(stderr,"  -d <file> : write the transitive reduction of the "
+                 "event graph\n");
+  exit(1);
+}
+
+int main(int argc, char **argv)
+{
+  bool logical = false, events = false, verbose = false;
+  unsigned window = 4096;
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  unsigned threads = (cores > 0) ? cores : 1;
+  u64 reduction_mb = DEFAULT_REDUCTION_MB;
+  const char *dot_file = NULL;
+  const char *file_name = NULL;
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i],"-l"))
+      logical = true;
+    else if (!strcmp(argv[i],"-e"))
+      events = true;
+    else if (!strcmp(argv[i],"-v"))
+      verbose = true;
+    else if (!strcmp(argv[i],"-w") && ((i+1) < argc))
+      window = atoi(argv[++i]);
+    else if (!strcmp(argv[i],"-j") && ((i+1) < argc))
+      threads = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i],"-m") && ((i+1) < argc))
+      reduction_mb = strtoull(argv[++i], NULL, 10);
+    else if (!strcmp(argv[i],"-d") && ((i+1) < argc))
+      dot_file = argv[++i];
+    else if ((argv[i][0] == '-') || (file_name != NULL))
+      usage(argv[0]);
+    else
+      file_name = argv[i];
+  }
+  if (file_name == NULL)
+    usage(argv[0]);
+  if (!logical && !events)
+    logical = events = true;
+  if (dot_file != NULL)
+    events = true;
+  SpyState state(logical, events, verbose, window, threads,
+                 reduction_mb << 20);
+  printf("Loading log file %s...\n", file_name);
+  if (!state.parse_file(file_name))
+    return 1;
+  if (logical)
+  {
+    printf("Performing logical checks...\n");
+    state.finish_logical();
+  }
+  if (events)
+  {
+    printf("Performing event graph checks...\n");
+    state.analyze_event_graph(dot_file);
+  }
+  printf("Legion Spy analysis complete.  Exiting...\n");
+  return (state.total_errors > 0) ? 2 : 0;
+}
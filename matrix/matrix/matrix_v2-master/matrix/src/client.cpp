@@ -22,16 +22,13 @@ int main(int argc, char *argv[]) {
 	string 	configFileStr(argv[1]);
 	MatrixClient *mc = new MatrixClient(configFileStr);
 
-	/* generate task dag adjecent list (children) */
-	adjList dagAdjList;
-	gen_dag_adjlist(dagAdjList, mc->config->dagType,
-			mc->config->dagArg, mc->config->numTaskPerClient);
-
-	/* calculate indegrees (number of parents) for every tasks */
-	inDegree dagInDegree;
-	gen_dag_indegree(dagAdjList, dagInDegree);
-	//adjList dagParentList;
-	//gen_dag_parents(dagAdjList, dagParentList);
+	/* the task dag generator, it computes the children and the
+	 * indegree (number of parents) of each task on the fly, so
+	 * the whole dag is never held in memory
+	 * */
+	DagGenerator dagGen(mc->config->dagType, mc->config->dagArg,
+			mc->config->numTaskPerClient, mc->config->numMapTask,
+			mc->config->numReduceTask);
 
 	/* wait until all schedulers have registered to ZHT */
 #ifdef PRINT_OUT
@@ -69,11 +66,14 @@ int main(int argc, char *argv[]) {
 	}
 
 	/* insert the task information to ZHT */
-	mc->insert_taskinfo_to_zht(dagAdjList, dagInDegree);
+	mc->insert_taskinfo_to_zht(dagGen);
 
 	/* initalize tasks by assigning taskId information to each task */
 	mc->init_task();
 
+	/* the critical path of each task is its scheduling priority */
+	mc->prioritize_task(dagGen);
+
 	/* submit tasks to the schedulers */
 	mc->submit_task();
 
@@ -51,13 +51,11 @@ MatrixClient::MatrixClient(const string &configFile) :
 MatrixClient::~MatrixClient() {
 
 }
-/* insert task information to ZHT
- * the tasks have already been represented as DAGs
- * that are formed with adjecency list (dagAdjList)
- * and parent list (dagInDegree)
+/* insert task information to ZHT, the tasks are emitted one by one
+ * by the dag generator, so the client memory does not grow with the
+ * number of tasks in the dag
  * */
-void MatrixClient::insert_taskinfo_to_zht(adjList &dagAdjList,
-		inDegree &dagInDegree) {
+void MatrixClient::insert_taskinfo_to_zht(DagGenerator &dagGen) {
 #ifdef PRINT_OUT
 	cout << "------------------------------------------------------------" << endl;
 	cout << "Now, I am going to insert task information to ZHT" << endl;
@@ -73,152 +71,28 @@ void MatrixClient::insert_taskinfo_to_zht(adjList &dagAdjList,
 
 	clock_gettime(0, &start);
 
-	for (adjList::iterator it = dagAdjList.begin(); it != dagAdjList.end();
-			++it) {
-		stringstream ss;
-		ss << get_index() << it->first;
-		string taskId(ss.str());
+	string prefix = num_to_str<int>(get_index());
+	DagTask task;
+	long numTask = 0;
 
-		vector<long> existList = it->second;
-		long inDegree = dagInDegree[it->first];
+	dagGen.reset();
+	while (dagGen.next(task)) {
+		string taskId(prefix + num_to_str<long>(task.id));
 
 		Value value;
 		value.set_id(taskId);
-		value.set_indegree(inDegree);
-
-		for (long i = 0; i < existList.size(); i++) {
-			stringstream ssChild;
-			ssChild << get_index() << existList.at(i);
-			string sChild(ssChild.str());
+		value.set_indegree(task.indegree);
 
-			value.add_children(sChild);
+		for (long i = 0; i < task.children.size(); i++) {
+			value.add_children(prefix + num_to_str<long>(task.children.at(i)));
 		}
 
-		/*value.set_nummove(0);
-		 value.set_history("|" + get_id());
-		 value.set_submittime(0.0);
-		 value.set_arrivetime(0.0);
-		 value.set_rqueuedtime(0.0);
-		 value.set_exetime(0.0);
-		 value.set_fintime(0.0);*/
-
-		string seriValue;
-		seriValue = value_to_str(value);
+		string seriValue = value_to_str(value);
 		zc.insert(taskId, seriValue);
+		numTask++;
 	}
 
-//	map<string, int> fileMap; // storing file locations <filename, location>
-//
-//	/*string filePath("/users/kwangiit/sc14/matrix_v2/matrix/src/workload_dag/file_" + num_to_str<int>(schedulerVec.size()) + "_" +
-//	 num_to_str<double>(config->locality) + ".0_" + num_to_str<int>(
-//	 config->numFile) + "_" + num_to_str<int>(config->numTaskPerClient));
-//	 string taskPath("/users/kwangiit/sc14/matrix_v2/matrix/src/workload_dag/task_" + num_to_str<int>(schedulerVec.size()) + "_" +
-//	 num_to_str<double>(config->locality) + ".0_" + num_to_str<int>(
-//	 config->numFile) + "_" + num_to_str<int>(config->numTaskPerClient));*/
-//
-//	//cout << "file path is:" << filePath << ", and task path is:" << taskPath << endl;
-//	/* file that defines file locations */
-//	string filePath(
-//			"./workload_dag/file." + num_to_str<int>(schedulerVec.size()) + "."
-//					+ num_to_str<int>(config->numTaskPerClient));
-//
-//	/* task specifications: task input/out datasize,
-//	 * task input data files, task type: map/reduce, task length */
-//	string taskPath(
-//			"./workload_dag/task." + num_to_str<int>(schedulerVec.size()) + "."
-//					+ num_to_str<int>(config->numTaskPerClient));
-//	/*vector<string> fileStr = read_from_file(filePath);
-//	 for (int i = 0; i < fileStr.size(); i++)
-//	 {
-//	 vector<string> lineVec = tokenize(fileStr.at(i), " ");
-//	 fileMap.insert(make_pair(lineVec.at(0), str_to_num<int>(lineVec.at(1))));
-//	 }*/
-//
-//	/* This is to know which file is at which compute node */
-//	vector<string> fileStr = read_from_file(filePath);
-//	for (int i = 0; i < fileStr.size(); i++) {
-//		vector<string> lineVec = tokenize(fileStr.at(i), " ");
-//		fileMap.insert(
-//				make_pair(lineVec.at(0), str_to_num<int>(lineVec.at(1))));
-//	}
-//
-//	vector<string> taskStr = read_from_file(taskPath);
-//	//string lastTaskId(num_to_str<int>(get_index()) + num_to_str<int>(taskStr.size() + 1));
-//
-////	for (int i = 0; i < taskStr.size(); i++)
-////	{
-////		vector<string> lineVec = tokenize(taskStr.at(i), " ");
-////		string taskId(num_to_str<int>(get_index()) + lineVec.at(0));
-////		Value value;
-////		value.set_id(taskId);
-////		value.set_indegree(0);
-////		value.add_parents(schedulerVec.at(fileMap.find(lineVec.at(1))->second));
-////		value.add_datanamelist(lineVec.at(1));
-////		value.add_datasize(2097152);
-////		value.set_alldatasize(2097152);
-////		//value.add_children(lastTaskId);
-////		string seriValue = value_to_str(value);
-////		zc.insert(taskId, seriValue);
-////		//cout << "Task id is:" << taskId << ", and value is:" << seriValue << endl;
-////		//
-////		//		for (long i = 0; i < existList.size(); i++)
-////		//		{
-////		//			stringstream ssChild;
-////		//			ssChild << get_index() << existList.at(i);
-////		//			string sChild(ssChild.str());
-////		//
-////		//			value.add_children(sChild);
-////		//		}
-////	}
-//
-//	/* task has the format: taskid map/reduce filename inputfilesize outputfilesize executelength*/
-//	for (int i = 0; i < taskStr.size(); i++) {
-//		vector<string> lineVec = tokenize(taskStr.at(i), " ");
-//		string taskId(num_to_str<int>(get_index()) + lineVec.at(0));
-//		Value value;
-//		value.set_id(taskId);
-//		if (lineVec.at(1).compare("map") == 0) {
-//			value.set_indegree(0);
-//			value.add_datasize(str_to_num<long>(lineVec.at(2)));
-//			value.set_alldatasize(str_to_num<long>(lineVec.at(2)));
-//			value.set_outputsize(str_to_num<long>(lineVec.at(3)));
-//			value.set_tasklength(str_to_num<long>(lineVec.at(4)));
-//			value.add_parents(
-//					schedulerVec.at(fileMap.find(lineVec.at(5))->second));
-//			value.add_datanamelist(lineVec.at(5));
-//			for (int i = 0; i < config->numReduceTask; i++) {
-//				stringstream ssChild;
-//				ssChild << get_index() << (i + config->numMapTask);
-//				string sChild(ssChild.str());
-//				value.add_children(sChild);
-//			}
-//		} else {
-//			value.set_indegree(config->numMapTask);
-//			value.set_tasklength(str_to_num<long>(lineVec.at(2)));
-//		}
-//
-//		//value.add_children(lastTaskId);
-//		string seriValue = value_to_str(value);
-//		zc.insert(taskId, seriValue);
-//		//cout << "Task id is:" << taskId << ", and value is:" << seriValue << endl;
-//		//
-//		//		for (long i = 0; i < existList.size(); i++)
-//		//		{
-//		//			stringstream ssChild;
-//		//			ssChild << get_index() << existList.at(i);
-//		//			string sChild(ssChild.str());
-//		//
-//		//			value.add_children(sChild);
-//		//		}
-//	}
-
-//	Value value;
-//	value.set_id(lastTaskId);
-//	value.set_indegree(taskStr.size());
-//	string seriValue = value_to_str(value);
-//	zc.insert(lastTaskId, seriValue);
-
-	incre_ZHT_msg_count(config->numTaskPerClient);
+	incre_ZHT_msg_count(numTask);
 
 	clock_gettime(0, &end);
 	timespec diff = time_diff(start, end);
@@ -255,10 +129,43 @@ void MatrixClient::init_task() {
 		tm.set_dir(taskItemStr.at(2));
 		tm.set_cmd(taskItemStr.at(3));
 		tm.set_datalength(0);
+		tm.set_dagid(num_to_str<int>(get_index()));
+
+		/* an optional fourth column of the workload file is the
+		 * deadline relative to the submission in micro-second */
+		if (taskItemStr.size() > 4) {
+			tm.set_deadline(str_to_num<long>(taskItemStr.at(4)));
+		}
 		tasks.push_back(tm);
 	}
 }
 
+/* set the critical path of every task as its priority,
+ * so that the schedulers first run the tasks on the
+ * longest paths to the end of the DAG. The generator
+ * only emits children with a higher index, so a single
+ * backward sweep over the tasks computes the paths in
+ * place, without materializing the DAG
+ * */
+void MatrixClient::prioritize_task(DagGenerator &dagGen) {
+	DagTask task;
+	long numTask = tasks.size() < dagGen.num_task() ?
+			tasks.size() : dagGen.num_task();
+
+	for (long i = numTask - 1; i >= 0; i--) {
+		long length = 1;
+		dagGen.get_task(i, task);
+		for (long j = 0; j < task.children.size(); j++) {
+			long child = task.children.at(j);
+			if (child > i && child < numTask
+					&& tasks.at(child).priority() + 1 > length) {
+				length = tasks.at(child).priority() + 1;
+			}
+		}
+		tasks.at(i).set_priority(length);
+	}
+}
+
 /* submit tasks to the schedulers, either with
  * the best case scenario or worst case scenario
  * */
@@ -290,7 +197,11 @@ void MatrixClient::submit_task() {
 		string taskDetail;
 		zc.lookup(taskId, taskDetail);
 		Value value = str_to_value(taskDetail);
-		value.set_submittime(get_time_usec());
+		long submitTime = get_time_usec();
+		value.set_submittime(submitTime);
+		if (tasks.at(i).deadline() > 0) {
+			tasks.at(i).set_deadline(submitTime + tasks.at(i).deadline());
+		}
 
 		taskDetail = value_to_str(value);
 		zc.insert(taskId, taskDetail);
@@ -380,64 +291,60 @@ void MatrixClient::submit_task_wc(vector<TaskMsg> tmVec, int toScheIdx) {
 
 /* monitoring thread function, monitoring is conducted only by client 0.
  * It can monitor the execution progress of all the tasks, the system
- * status, and log all the task details
+ * status, and log all the task details. The status is pulled directly
+ * from the metrics endpoint of every scheduler, so monitoring puts no
+ * load on ZHT
  * */
 void *monitoring(void* args) {
 	MatrixClient *mc = (MatrixClient*) args;
-	string key("num tasks done");
+	ClusterMetrics clusterMetrics(mc->schedulerVec, mc->config->schedulerPortNo);
+	MetricsSnapshot cluster;
 	long numAllCore = mc->config->numCorePerExecutor * mc->schedulerVec.size();
-	long numIdleCore = 0;
-	long numTaskWait = 0, numTaskReady = 0;
 	long preNumTaskDone = 0, numTaskDone = 0;
-	long prevTimeUs = 0L, currentTimeUs = 0L;
+	long prevTimeUs = get_time_usec(), currentTimeUs = 0L;
 	double instantThr = 0.0;
 
-	string numTaskFinStr;
-
 	/* system status log head */
 	if (mc->systemLogOS.is_open()) {
 		mc->systemLogOS << "Time(us)\tNumAllCore\tNumIdleCore\tNumTaskWait\t"
-				"NumTaskReady\tNumTaskDone\tThroughput" << endl;
+				"NumTaskReady\tNumTaskDone\tThroughput\tNumWorkSteal\t"
+				"NumWorkStealFail\tQueueWaitP99(us)\tExecP99(us)\t"
+				"StealRttP99(us)\tZhtOpP99(us)" << endl;
 	}
 
-	long increment = 0;
-
 	while (1) {
-		mc->zc.lookup(key, numTaskFinStr);	// lookup how many tasks are done
-		numTaskDone = str_to_num<long>(numTaskFinStr);
+		if (clusterMetrics.pull(cluster) < mc->schedulerVec.size()) {
+			for (int i = 0; i < mc->schedulerVec.size(); i++) {
+				if (!clusterMetrics.answered.at(i)) {
+					cout << "scheduler " << mc->schedulerVec.at(i)
+							<< " did not answer, using its last known metrics"
+							<< endl;
+				}
+			}
+		}
+		numTaskDone = cluster.get("numtaskfin");
 		cout << "number of task done is:" << numTaskDone << endl;
-		increment++;
 
 		/* log the instant system status */
 		if (mc->systemLogOS.is_open()) {
 			currentTimeUs = get_time_usec();
-			for (int i = 0; i < mc->schedulerVec.size(); i++) {
-				string schedulerStat;
-				mc->zc.lookup(mc->schedulerVec.at(i), schedulerStat);
-				if (schedulerStat.empty())
-					continue;
-
-				Value value = str_to_value(schedulerStat);
-				numIdleCore += value.numcoreavilable();
-				numTaskWait += value.numtaskwait();
-				numTaskReady += value.numtaskready();
-			}
-
-			increment += mc->schedulerVec.size();
-
 			instantThr = (double) (numTaskDone - preNumTaskDone)
 					/ (currentTimeUs - prevTimeUs) * 1E6;
 
 			mc->systemLogOS << currentTimeUs << "\t" << numAllCore << "\t"
-					<< numIdleCore << "\t" << numTaskWait << "\t"
-					<< numTaskReady << "\t" << numTaskDone << "\t" << instantThr
-					<< endl;
+					<< cluster.get("numidlecore") << "\t"
+					<< cluster.get("numtaskwait") << "\t"
+					<< cluster.get("numtaskready") << "\t" << numTaskDone
+					<< "\t" << instantThr << "\t"
+					<< cluster.get("numworksteal") << "\t"
+					<< cluster.get("numworkstealfail") << "\t"
+					<< cluster.percentile("queuewait", 0.99) << "\t"
+					<< cluster.percentile("exec", 0.99) << "\t"
+					<< cluster.percentile("stealrtt", 0.99) << "\t"
+					<< cluster.percentile("zhtop", 0.99) << endl;
 
 			preNumTaskDone = numTaskDone;
 			prevTimeUs = currentTimeUs;
-			numIdleCore = 0;
-			numTaskWait = 0;
-			numTaskReady = 0;
 		}
 
 		if (numTaskDone == mc->config->numAllTask)	// all the tasks are done
@@ -469,8 +376,6 @@ void *monitoring(void* args) {
 		mc->systemLogOS.close();
 	}
 
-	mc->incre_ZHT_msg_count(increment);
-
 #ifdef PRINT_OUT
 	cout << "The number of ZHT message is:" << mc->numZHTMsg << endl;
 #endif
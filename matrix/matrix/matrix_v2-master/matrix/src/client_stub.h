@@ -14,19 +14,24 @@
 #include <error.h>
 
 #include "matrix_tcp_proxy_stub.h"
+#include "dag.h"
+#include "scheduler_metrics.h"
 
 class MatrixClient: public Peer {
 public:
 	MatrixClient(const string&);
 	virtual ~MatrixClient();
 
-	/* insert task information to ZHT */
-	void insert_taskinfo_to_zht(adjList&, inDegree&);
-	//void insert_taskinfo_to_zht(adjList&, adjList&);
+	/* insert task information to ZHT, streaming
+	 * the tasks one by one from a dag generator */
+	void insert_taskinfo_to_zht(DagGenerator&);
 
 	/* initialize tasks by adding taskId for each task */
 	void init_task(void);
 
+	/* set the critical path of each task as its priority */
+	void prioritize_task(DagGenerator&);
+
 	/* submit all the tasks to schedulers */
 	void submit_task(void);
 
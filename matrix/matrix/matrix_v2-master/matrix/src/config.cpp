@@ -72,6 +72,12 @@ void Configuration::parse_config(const string &configFile) {
 
 	estTimeThreadshold = str_to_num<long>(configMap.find("EstimatedTimeThreshold")->second);
 
+	/* optional, older configuration files do not have it */
+	if (configMap.find("AgingInterval") != configMap.end())
+		agingInterval = str_to_num<long>(configMap.find("AgingInterval")->second);
+	else
+		agingInterval = 1000000;
+
 	schedulerMemFile = configMap.find("SchedulerMemlistFile")->second;
 
 	netProtoc = configMap.find("NetworkProtocol")->second;
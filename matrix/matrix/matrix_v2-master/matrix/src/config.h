@@ -37,6 +37,7 @@ public:
 	string policy;
 	long dataSizeThreshold;
 	long estTimeThreadshold;
+	long agingInterval;	// ready task aging interval in microsecond
 
 	string schedulerMemFile;	// the memberlist file of all the schedulers
 	string netProtoc;	// network protocol type: TCP, UDP, UDT, etc
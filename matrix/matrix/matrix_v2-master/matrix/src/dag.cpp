@@ -0,0 +1,420 @@
+/*
+ * dag.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "dag.h"
+#include <sstream>
+
+/* the band radius of random layered DAGs, a task can only have
+ * parents within this distance of its position in the layer above
+ * */
+static const long RANDOM_LAYERED_BAND = 2;
+
+DagShape dag_shape_from_str(const string &dagType) {
+	if (dagType.compare("BOT") == 0)
+		return DAG_BOT;
+	else if (dagType.compare("FanOut") == 0)
+		return DAG_FANOUT;
+	else if (dagType.compare("FanIn") == 0)
+		return DAG_FANIN;
+	else if (dagType.compare("Pipeline") == 0)
+		return DAG_PIPELINE;
+	else if (dagType.compare("Diamond") == 0)
+		return DAG_DIAMOND;
+	else if (dagType.compare("RandomLayered") == 0)
+		return DAG_RANDOM_LAYERED;
+	else if (dagType.compare("WordCount") == 0)
+		return DAG_WORDCOUNT;
+	return DAG_UNKNOWN;
+}
+
+DagGenerator::DagGenerator(const string &dagType, long dagArg, long numTask,
+		long numMapTask, long numReduceTask, unsigned long seed) {
+	this->shape = dag_shape_from_str(dagType);
+	this->dagArg = dagArg < 1 ? 1 : dagArg;
+	this->numTask = numTask;
+	this->numMapTask = numMapTask;
+	this->numReduceTask = numReduceTask;
+	this->seed = seed;
+	this->cur = 0;
+
+	/* the dag always has exactly "numTask" tasks, as that is the number
+	 * the client submits and the monitor waits for. A word count dag
+	 * keeps the configured number of reduce tasks and the map tasks
+	 * make up the rest */
+	if (shape == DAG_WORDCOUNT) {
+		if (this->numReduceTask < 0) {
+			this->numReduceTask = 0;
+		} else if (this->numReduceTask > numTask) {
+			this->numReduceTask = numTask;
+		}
+		this->numMapTask = numTask - this->numReduceTask;
+	}
+}
+
+DagGenerator::~DagGenerator() {
+
+}
+
+bool DagGenerator::next(DagTask &task) {
+	if (cur >= numTask) {
+		return false;
+	}
+	get_task(cur++, task);
+	return true;
+}
+
+void DagGenerator::get_task(long idx, DagTask &task) const {
+	task.id = idx;
+	task.indegree = 0;
+	task.children.clear();
+
+	switch (shape) {
+	case DAG_FANOUT:
+		fanout_task(idx, task);
+		break;
+	case DAG_FANIN:
+		fanin_task(idx, task);
+		break;
+	case DAG_PIPELINE:
+		pipeline_task(idx, task);
+		break;
+	case DAG_DIAMOND:
+		diamond_task(idx, task);
+		break;
+	case DAG_RANDOM_LAYERED:
+		random_layered_task(idx, task);
+		break;
+	case DAG_WORDCOUNT:
+		wordcount_task(idx, task);
+		break;
+	default:
+		bot_task(idx, task);
+		break;
+	}
+}
+
+void DagGenerator::reset() {
+	cur = 0;
+}
+
+long DagGenerator::num_task() const {
+	return numTask;
+}
+
+DagShape DagGenerator::get_shape() const {
+	return shape;
+}
+
+void DagGenerator::bot_task(long idx, DagTask &task) const {
+
+}
+
+/* task i has children i * dagArg + 1 .. i * dagArg + dagArg */
+void DagGenerator::fanout_task(long idx, DagTask &task) const {
+	for (long j = 1; j <= dagArg; j++) {
+		long next = idx * dagArg + j;
+		if (next >= numTask) {
+			break;
+		}
+		task.children.push_back(next);
+	}
+	task.indegree = idx == 0 ? 0 : 1;
+}
+
+/* the fan in DAG is the fan out DAG flipped over with every task i
+ * renamed to numTask - 1 - i, so the single child of a task is the
+ * renamed fan out parent, and its parents are the renamed fan out
+ * children
+ * */
+void DagGenerator::fanin_task(long idx, DagTask &task) const {
+	long flipIdx = numTask - 1 - idx;
+
+	if (flipIdx > 0) {
+		task.children.push_back(numTask - 1 - (flipIdx - 1) / dagArg);
+	}
+
+	for (long j = 1; j <= dagArg; j++) {
+		if (flipIdx * dagArg + j >= numTask) {
+			break;
+		}
+		task.indegree++;
+	}
+}
+
+void DagGenerator::pipeline_task(long idx, DagTask &task) const {
+	long next = idx + 1;
+
+	if (next % dagArg != 0 && next < numTask) {
+		task.children.push_back(next);
+	}
+	task.indegree = idx % dagArg == 0 ? 0 : 1;
+}
+
+/* diamonds are chained through their top tasks: top task t has
+ * children t + 1 .. t + dagArg, all of which have the single child
+ * t + dagArg + 1, which is the top task of the next diamond
+ * */
+void DagGenerator::diamond_task(long idx, DagTask &task) const {
+	long pos = idx % (dagArg + 1);
+
+	if (pos == 0) {
+		for (long j = 1; j <= dagArg && idx + j < numTask; j++) {
+			task.children.push_back(idx + j);
+		}
+		task.indegree = idx == 0 ? 0 : dagArg;
+	} else {
+		long next = idx - pos + dagArg + 1;
+		if (next < numTask) {
+			task.children.push_back(next);
+		}
+		task.indegree = 1;
+	}
+}
+
+/* splitmix64 finalizer over (seed, parent, child) */
+bool DagGenerator::random_edge(long parent, long child) const {
+	unsigned long long x = seed + (unsigned long long) parent
+			* 0x9E3779B97F4A7C15ULL + (unsigned long long) child;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	x = x ^ (x >> 31);
+	return (x & 1) == 1;
+}
+
+/* layers are dagArg tasks wide. A task is always connected to the
+ * task at the same position in the next layer, and randomly to the
+ * tasks at most RANDOM_LAYERED_BAND positions away, so both the
+ * children and the indegree are computed in O(band)
+ * */
+void DagGenerator::random_layered_task(long idx, DagTask &task) const {
+	long layer = idx / dagArg, pos = idx % dagArg;
+
+	for (long p = pos - RANDOM_LAYERED_BAND; p <= pos + RANDOM_LAYERED_BAND;
+			p++) {
+		if (p < 0 || p >= dagArg) {
+			continue;
+		}
+
+		long child = (layer + 1) * dagArg + p;
+		if (child < numTask && (p == pos || random_edge(idx, child))) {
+			task.children.push_back(child);
+		}
+
+		if (layer > 0) {
+			long parent = (layer - 1) * dagArg + p;
+			if (p == pos || random_edge(parent, idx)) {
+				task.indegree++;
+			}
+		}
+	}
+}
+
+/* map tasks are 0 .. numMapTask - 1, and every one of them is a
+ * parent of all the reduce tasks that follow
+ * */
+void DagGenerator::wordcount_task(long idx, DagTask &task) const {
+	if (idx < numMapTask) {
+		task.children.reserve(numReduceTask);
+		for (long j = 0; j < numReduceTask; j++) {
+			task.children.push_back(numMapTask + j);
+		}
+	} else {
+		task.indegree = numMapTask;
+	}
+}
+
+DagReader::DagReader(const string &fileName) :
+		fileStream(fileName.c_str()) {
+
+}
+
+DagReader::~DagReader() {
+
+}
+
+bool DagReader::good() {
+	return fileStream.good();
+}
+
+bool DagReader::next(DagTask &task) {
+	string line;
+
+	while (getline(fileStream, line)) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+
+		stringstream ss(line);
+		long child;
+
+		task.children.clear();
+		if (!(ss >> task.id >> task.indegree)) {
+			continue;
+		}
+		while (ss >> child) {
+			task.children.push_back(child);
+		}
+		return true;
+	}
+
+	return false;
+}
+
+long write_dag_file(DagGenerator &dagGen, const string &fileName) {
+	ofstream fileStream(fileName.c_str());
+	DagTask task;
+	long numTask = 0;
+
+	if (!fileStream.good()) {
+		return -1;
+	}
+
+	dagGen.reset();
+	while (dagGen.next(task)) {
+		fileStream << task.id << " " << task.indegree;
+		for (long i = 0; i < task.children.size(); i++) {
+			fileStream << " " << task.children[i];
+		}
+		fileStream << "\n";
+		numTask++;
+	}
+	dagGen.reset();
+
+	return numTask;
+}
+
+CompactDag::CompactDag() {
+	childOffset.push_back(0);
+}
+
+CompactDag::~CompactDag() {
+
+}
+
+/* tasks must be added in index order, which both
+ * the generator and write_dag_file guarantee */
+void CompactDag::add_task(const DagTask &task) {
+	children.insert(children.end(), task.children.begin(),
+			task.children.end());
+	childOffset.push_back(children.size());
+	indegree.push_back(task.indegree);
+}
+
+void CompactDag::build(DagGenerator &dagGen) {
+	DagTask task;
+
+	childOffset.reserve(dagGen.num_task() + 1);
+	indegree.reserve(dagGen.num_task());
+
+	dagGen.reset();
+	while (dagGen.next(task)) {
+		add_task(task);
+	}
+	dagGen.reset();
+}
+
+void CompactDag::build(DagReader &dagReader) {
+	DagTask task;
+
+	while (dagReader.next(task)) {
+		add_task(task);
+	}
+}
+
+/* counting sort of the edges by child */
+void CompactDag::build_parents() {
+	long numTask = num_task();
+
+	parentOffset.assign(numTask + 1, 0);
+	parents.assign(children.size(), 0);
+
+	for (long i = 0; i < children.size(); i++) {
+		parentOffset[children[i] + 1]++;
+	}
+	for (long i = 0; i < numTask; i++) {
+		parentOffset[i + 1] += parentOffset[i];
+	}
+
+	vector<long> fill(parentOffset.begin(), parentOffset.end() - 1);
+	for (long i = 0; i < numTask; i++) {
+		for (long j = childOffset[i]; j < childOffset[i + 1]; j++) {
+			parents[fill[children[j]]++] = i;
+		}
+	}
+}
+
+long CompactDag::num_task() const {
+	return childOffset.size() - 1;
+}
+
+long CompactDag::num_edge() const {
+	return children.size();
+}
+
+long CompactDag::num_children(long idx) const {
+	return childOffset[idx + 1] - childOffset[idx];
+}
+
+const long* CompactDag::children_of(long idx) const {
+	return children.empty() ? NULL : &children[childOffset[idx]];
+}
+
+long CompactDag::num_parents(long idx) const {
+	if (parentOffset.empty()) {
+		return 0;
+	}
+	return parentOffset[idx + 1] - parentOffset[idx];
+}
+
+const long* CompactDag::parents_of(long idx) const {
+	return parents.empty() ? NULL : &parents[parentOffset[idx]];
+}
+
+long CompactDag::get_indegree(long idx) const {
+	return indegree[idx];
+}
+
+void CompactDag::get_task(long idx, DagTask &task) const {
+	task.id = idx;
+	task.indegree = indegree[idx];
+	task.children.assign(children.begin() + childOffset[idx],
+			children.begin() + childOffset[idx + 1]);
+}
+
+/* topological order by Kahn's algorithm, then the longest path
+ * to a sink of every task in reverse order. Tasks on a cycle, if
+ * any, keep a critical path of 1.
+ * */
+void CompactDag::critical_path(vector<long> &length) const {
+	long numTask = num_task();
+	vector<long> numParent(indegree.begin(), indegree.end());
+	vector<long> order;
+
+	order.reserve(numTask);
+	for (long i = 0; i < numTask; i++) {
+		if (numParent[i] == 0) {
+			order.push_back(i);
+		}
+	}
+	for (long k = 0; k < order.size(); k++) {
+		long idx = order[k];
+		for (long j = childOffset[idx]; j < childOffset[idx + 1]; j++) {
+			if (--numParent[children[j]] == 0) {
+				order.push_back(children[j]);
+			}
+		}
+	}
+
+	length.assign(numTask, 1);
+	for (long k = (long) order.size() - 1; k >= 0; k--) {
+		long idx = order[k];
+		for (long j = childOffset[idx]; j < childOffset[idx + 1]; j++) {
+			if (length[children[j]] + 1 > length[idx]) {
+				length[idx] = length[children[j]] + 1;
+			}
+		}
+	}
+}
@@ -0,0 +1,159 @@
+/*
+ * dag.h
+ *
+ * compact (CSR) representation of workload DAGs, and a
+ * streaming generator/reader that emits the tasks of a
+ * DAG one at a time without materializing the whole DAG
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef DAG_H_
+#define DAG_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+using namespace std;
+
+/* one task of a DAG as emitted by a generator or a reader */
+struct DagTask
+{
+	long id;	// task index within the DAG (0 .. numTask - 1)
+	long indegree;	// number of parents
+	vector<long> children;	// indices of the children
+};
+
+/* the DAG shapes that can be generated */
+enum DagShape
+{
+	DAG_BOT,	// bag of independent tasks
+	DAG_FANOUT,	// tree, every task has "dagArg" children
+	DAG_FANIN,	// flipped fan out tree
+	DAG_PIPELINE,	// independent chains of "dagArg" tasks
+	DAG_DIAMOND,	// chained diamonds, each "dagArg" tasks wide
+	DAG_RANDOM_LAYERED,	// layers of "dagArg" tasks, random banded edges
+	DAG_WORDCOUNT,	// map tasks all feeding every reduce task
+	DAG_UNKNOWN
+};
+
+/* map a DagType string in the configuration file to a shape */
+extern DagShape dag_shape_from_str(const string&);
+
+/* Streaming DAG generator. The children and the indegree of every
+ * task are computed in closed form from the task index, so the
+ * memory used is independent of the number of tasks. Random layered
+ * DAGs hash (seed, parent, child) to decide edges, so every client
+ * generating the same DAG gets the same edges. Children always have
+ * a higher index than their parents, so the index order of the
+ * tasks is a topological order.
+ * */
+class DagGenerator
+{
+	public:
+		DagGenerator(const string &dagType, long dagArg, long numTask,
+				long numMapTask = 0, long numReduceTask = 0,
+				unsigned long seed = 0);
+		virtual ~DagGenerator();
+
+		/* fill in the next task, returns false when all tasks are done */
+		bool next(DagTask&);
+
+		/* compute an arbitrary task without advancing the stream */
+		void get_task(long, DagTask&) const;
+
+		void reset();
+
+		long num_task() const;
+
+		DagShape get_shape() const;
+
+	private:
+		void bot_task(long, DagTask&) const;
+		void fanout_task(long, DagTask&) const;
+		void fanin_task(long, DagTask&) const;
+		void pipeline_task(long, DagTask&) const;
+		void diamond_task(long, DagTask&) const;
+		void random_layered_task(long, DagTask&) const;
+		void wordcount_task(long, DagTask&) const;
+
+		bool random_edge(long, long) const;
+
+		DagShape shape;
+		long dagArg;
+		long numTask;
+		long numMapTask;
+		long numReduceTask;
+		unsigned long seed;
+		long cur;
+};
+
+/* Streaming reader of a DAG file written by write_dag_file. Each
+ * line has the format: taskIdx indegree child1 child2 ... so a
+ * task can be emitted as soon as its line is read.
+ * */
+class DagReader
+{
+	public:
+		DagReader(const string&);
+		virtual ~DagReader();
+
+		bool good();
+
+		bool next(DagTask&);
+
+	private:
+		ifstream fileStream;
+};
+
+/* write all the tasks of a generator to a DAG file */
+extern long write_dag_file(DagGenerator&, const string&);
+
+/* DAG in compressed sparse row form: the children of task i are
+ * children[childOffset[i] .. childOffset[i + 1]), which costs two
+ * longs per task and one long per edge instead of a map node and
+ * a vector per task. Parents are only built on demand.
+ * */
+class CompactDag
+{
+	public:
+		CompactDag();
+		virtual ~CompactDag();
+
+		/* build from a generator or a reader */
+		void build(DagGenerator&);
+		void build(DagReader&);
+
+		/* build the parents in CSR form from the children */
+		void build_parents();
+
+		long num_task() const;
+		long num_edge() const;
+
+		long num_children(long) const;
+		const long* children_of(long) const;
+
+		long num_parents(long) const;
+		const long* parents_of(long) const;
+
+		long get_indegree(long) const;
+
+		/* the number of tasks on the longest path from
+		 * every task to the end of the DAG, itself included */
+		void critical_path(vector<long>&) const;
+
+		/* the task with the given index in the generator format */
+		void get_task(long, DagTask&) const;
+
+	private:
+		void add_task(const DagTask&);
+
+		vector<long> childOffset;
+		vector<long> children;
+		vector<long> parentOffset;
+		vector<long> parents;
+		vector<long> indegree;
+};
+
+#endif /* DAG_H_ */
@@ -32,12 +32,15 @@ void protobuf_AssignDesc_metatask_2eproto() {
       "metatask.proto");
   GOOGLE_CHECK(file != NULL);
   TaskMsg_descriptor_ = file->message_type(0);
-  static const int TaskMsg_offsets_[5] = {
+  static const int TaskMsg_offsets_[8] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TaskMsg, taskid_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TaskMsg, user_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TaskMsg, dir_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TaskMsg, cmd_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TaskMsg, datalength_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TaskMsg, priority_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TaskMsg, deadline_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TaskMsg, dagid_),
   };
   TaskMsg_reflection_ =
     ::google::protobuf::internal::GeneratedMessageReflection::NewGeneratedMessageReflection(
@@ -80,9 +83,10 @@ void protobuf_AddDesc_metatask_2eproto() {
   GOOGLE_PROTOBUF_VERIFY_VERSION;
 
   ::google::protobuf::DescriptorPool::InternalAddGeneratedFile(
-    "\n\016metatask.proto\"U\n\007TaskMsg\022\016\n\006taskId\030\001 "
-    "\002(\t\022\014\n\004user\030\002 \002(\t\022\013\n\003dir\030\003 \002(\t\022\013\n\003cmd\030\004 "
-    "\002(\t\022\022\n\ndataLength\030\005 \002(\003", 103);
+    "\n\016metatask.proto\"\210\001\n\007TaskMsg\022\016\n\006taskId\030\001"
+    " \002(\t\022\014\n\004user\030\002 \002(\t\022\013\n\003dir\030\003 \002(\t\022\013\n\003cmd\030\004"
+    " \002(\t\022\022\n\ndataLength\030\005 \002(\003\022\020\n\010priority\030\006 \001"
+    "(\003\022\020\n\010deadline\030\007 \001(\003\022\r\n\005dagId\030\010 \001(\t", 155);
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedFile(
     "metatask.proto", &protobuf_RegisterTypes);
   TaskMsg::default_instance_ = new TaskMsg();
@@ -115,6 +119,9 @@ const int TaskMsg::kUserFieldNumber;
 const int TaskMsg::kDirFieldNumber;
 const int TaskMsg::kCmdFieldNumber;
 const int TaskMsg::kDataLengthFieldNumber;
+const int TaskMsg::kPriorityFieldNumber;
+const int TaskMsg::kDeadlineFieldNumber;
+const int TaskMsg::kDagIdFieldNumber;
 #endif  // !_MSC_VER
 
 TaskMsg::TaskMsg()
@@ -142,6 +149,9 @@ void TaskMsg::SharedCtor() {
   dir_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
   cmd_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
   datalength_ = GOOGLE_LONGLONG(0);
+  priority_ = GOOGLE_LONGLONG(0);
+  deadline_ = GOOGLE_LONGLONG(0);
+  dagid_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
@@ -155,6 +165,7 @@ void TaskMsg::SharedDtor() {
   user_.DestroyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
   dir_.DestroyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
   cmd_.DestroyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+  dagid_.DestroyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
   if (this != default_instance_) {
   }
 }
@@ -185,7 +196,16 @@ TaskMsg* TaskMsg::New(::google::protobuf::Arena* arena) const {
 }
 
 void TaskMsg::Clear() {
-  if (_has_bits_[0 / 32] & 31) {
+#define ZR_HELPER_(f) reinterpret_cast<char*>(\
+  &reinterpret_cast<TaskMsg*>(16)->f)
+
+#define ZR_(first, last) do {\
+  ::memset(&first, 0,\
+           ZR_HELPER_(last) - ZR_HELPER_(first) + sizeof(last));\
+} while (0)
+
+  if (_has_bits_[0 / 32] & 255) {
+    ZR_(datalength_, deadline_);
     if (has_taskid()) {
       taskid_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
     }
@@ -198,8 +218,14 @@ void TaskMsg::Clear() {
     if (has_cmd()) {
       cmd_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
     }
-    datalength_ = GOOGLE_LONGLONG(0);
+    if (has_dagid()) {
+      dagid_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+    }
   }
+
+#undef ZR_HELPER_
+#undef ZR_
+
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
   if (_internal_metadata_.have_unknown_fields()) {
     mutable_unknown_fields()->Clear();
@@ -294,6 +320,53 @@ bool TaskMsg::MergePartialFromCodedStream(
         } else {
           goto handle_unusual;
         }
+        if (input->ExpectTag(48)) goto parse_priority;
+        break;
+      }
+
+      // optional int64 priority = 6;
+      case 6: {
+        if (tag == 48) {
+         parse_priority:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::int64, ::google::protobuf::internal::WireFormatLite::TYPE_INT64>(
+                 input, &priority_)));
+          set_has_priority();
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(56)) goto parse_deadline;
+        break;
+      }
+
+      // optional int64 deadline = 7;
+      case 7: {
+        if (tag == 56) {
+         parse_deadline:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::int64, ::google::protobuf::internal::WireFormatLite::TYPE_INT64>(
+                 input, &deadline_)));
+          set_has_deadline();
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(66)) goto parse_dagId;
+        break;
+      }
+
+      // optional string dagId = 8;
+      case 8: {
+        if (tag == 66) {
+         parse_dagId:
+          DO_(::google::protobuf::internal::WireFormatLite::ReadString(
+                input, this->mutable_dagid()));
+          ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(
+            this->dagid().data(), this->dagid().length(),
+            ::google::protobuf::internal::WireFormat::PARSE,
+            "TaskMsg.dagId");
+        } else {
+          goto handle_unusual;
+        }
         if (input->ExpectAtEnd()) goto success;
         break;
       }
@@ -368,6 +441,26 @@ void TaskMsg::SerializeWithCachedSizes(
     ::google::protobuf::internal::WireFormatLite::WriteInt64(5, this->datalength(), output);
   }
 
+  // optional int64 priority = 6;
+  if (has_priority()) {
+    ::google::protobuf::internal::WireFormatLite::WriteInt64(6, this->priority(), output);
+  }
+
+  // optional int64 deadline = 7;
+  if (has_deadline()) {
+    ::google::protobuf::internal::WireFormatLite::WriteInt64(7, this->deadline(), output);
+  }
+
+  // optional string dagId = 8;
+  if (has_dagid()) {
+    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->dagid().data(), this->dagid().length(),
+      ::google::protobuf::internal::WireFormat::SERIALIZE,
+      "TaskMsg.dagId");
+    ::google::protobuf::internal::WireFormatLite::WriteStringMaybeAliased(
+      8, this->dagid(), output);
+  }
+
   if (_internal_metadata_.have_unknown_fields()) {
     ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
         unknown_fields(), output);
@@ -427,6 +520,27 @@ void TaskMsg::SerializeWithCachedSizes(
     target = ::google::protobuf::internal::WireFormatLite::WriteInt64ToArray(5, this->datalength(), target);
   }
 
+  // optional int64 priority = 6;
+  if (has_priority()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteInt64ToArray(6, this->priority(), target);
+  }
+
+  // optional int64 deadline = 7;
+  if (has_deadline()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteInt64ToArray(7, this->deadline(), target);
+  }
+
+  // optional string dagId = 8;
+  if (has_dagid()) {
+    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->dagid().data(), this->dagid().length(),
+      ::google::protobuf::internal::WireFormat::SERIALIZE,
+      "TaskMsg.dagId");
+    target =
+      ::google::protobuf::internal::WireFormatLite::WriteStringToArray(
+        8, this->dagid(), target);
+  }
+
   if (_internal_metadata_.have_unknown_fields()) {
     target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
         unknown_fields(), target);
@@ -507,6 +621,29 @@ int TaskMsg::ByteSize() const {
   } else {
     total_size += RequiredFieldsByteSizeFallback();
   }
+  if (_has_bits_[5 / 32] & 224) {
+    // optional int64 priority = 6;
+    if (has_priority()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int64Size(
+          this->priority());
+    }
+
+    // optional int64 deadline = 7;
+    if (has_deadline()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int64Size(
+          this->deadline());
+    }
+
+    // optional string dagId = 8;
+    if (has_dagid()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::StringSize(
+          this->dagid());
+    }
+
+  }
   if (_internal_metadata_.have_unknown_fields()) {
     total_size +=
       ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
@@ -552,6 +689,16 @@ void TaskMsg::MergeFrom(const TaskMsg& from) {
     if (from.has_datalength()) {
       set_datalength(from.datalength());
     }
+    if (from.has_priority()) {
+      set_priority(from.priority());
+    }
+    if (from.has_deadline()) {
+      set_deadline(from.deadline());
+    }
+    if (from.has_dagid()) {
+      set_has_dagid();
+      dagid_.AssignWithDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), from.dagid_);
+    }
   }
   if (from._internal_metadata_.have_unknown_fields()) {
     mutable_unknown_fields()->MergeFrom(from.unknown_fields());
@@ -586,6 +733,9 @@ void TaskMsg::InternalSwap(TaskMsg* other) {
   dir_.Swap(&other->dir_);
   cmd_.Swap(&other->cmd_);
   std::swap(datalength_, other->datalength_);
+  std::swap(priority_, other->priority_);
+  std::swap(deadline_, other->deadline_);
+  dagid_.Swap(&other->dagid_);
   std::swap(_has_bits_[0], other->_has_bits_[0]);
   _internal_metadata_.Swap(&other->_internal_metadata_);
   std::swap(_cached_size_, other->_cached_size_);
@@ -838,6 +988,107 @@ void TaskMsg::InternalSwap(TaskMsg* other) {
   // @@protoc_insertion_point(field_set:TaskMsg.dataLength)
 }
 
+// optional int64 priority = 6;
+ bool TaskMsg::has_priority() const {
+  return (_has_bits_[0] & 0x00000020u) != 0;
+}
+ void TaskMsg::set_has_priority() {
+  _has_bits_[0] |= 0x00000020u;
+}
+ void TaskMsg::clear_has_priority() {
+  _has_bits_[0] &= ~0x00000020u;
+}
+ void TaskMsg::clear_priority() {
+  priority_ = GOOGLE_LONGLONG(0);
+  clear_has_priority();
+}
+ ::google::protobuf::int64 TaskMsg::priority() const {
+  // @@protoc_insertion_point(field_get:TaskMsg.priority)
+  return priority_;
+}
+ void TaskMsg::set_priority(::google::protobuf::int64 value) {
+  set_has_priority();
+  priority_ = value;
+  // @@protoc_insertion_point(field_set:TaskMsg.priority)
+}
+
+// optional int64 deadline = 7;
+ bool TaskMsg::has_deadline() const {
+  return (_has_bits_[0] & 0x00000040u) != 0;
+}
+ void TaskMsg::set_has_deadline() {
+  _has_bits_[0] |= 0x00000040u;
+}
+ void TaskMsg::clear_has_deadline() {
+  _has_bits_[0] &= ~0x00000040u;
+}
+ void TaskMsg::clear_deadline() {
+  deadline_ = GOOGLE_LONGLONG(0);
+  clear_has_deadline();
+}
+ ::google::protobuf::int64 TaskMsg::deadline() const {
+  // @@protoc_insertion_point(field_get:TaskMsg.deadline)
+  return deadline_;
+}
+ void TaskMsg::set_deadline(::google::protobuf::int64 value) {
+  set_has_deadline();
+  deadline_ = value;
+  // @@protoc_insertion_point(field_set:TaskMsg.deadline)
+}
+
+// optional string dagId = 8;
+ bool TaskMsg::has_dagid() const {
+  return (_has_bits_[0] & 0x00000080u) != 0;
+}
+ void TaskMsg::set_has_dagid() {
+  _has_bits_[0] |= 0x00000080u;
+}
+ void TaskMsg::clear_has_dagid() {
+  _has_bits_[0] &= ~0x00000080u;
+}
+ void TaskMsg::clear_dagid() {
+  dagid_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+  clear_has_dagid();
+}
+ const ::std::string& TaskMsg::dagid() const {
+  // @@protoc_insertion_point(field_get:TaskMsg.dagId)
+  return dagid_.GetNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+}
+ void TaskMsg::set_dagid(const ::std::string& value) {
+  set_has_dagid();
+  dagid_.SetNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), value);
+  // @@protoc_insertion_point(field_set:TaskMsg.dagId)
+}
+ void TaskMsg::set_dagid(const char* value) {
+  set_has_dagid();
+  dagid_.SetNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), ::std::string(value));
+  // @@protoc_insertion_point(field_set_char:TaskMsg.dagId)
+}
+ void TaskMsg::set_dagid(const char* value, size_t size) {
+  set_has_dagid();
+  dagid_.SetNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited(),
+      ::std::string(reinterpret_cast<const char*>(value), size));
+  // @@protoc_insertion_point(field_set_pointer:TaskMsg.dagId)
+}
+ ::std::string* TaskMsg::mutable_dagid() {
+  set_has_dagid();
+  // @@protoc_insertion_point(field_mutable:TaskMsg.dagId)
+  return dagid_.MutableNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+}
+ ::std::string* TaskMsg::release_dagid() {
+  clear_has_dagid();
+  return dagid_.ReleaseNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+}
+ void TaskMsg::set_allocated_dagid(::std::string* dagid) {
+  if (dagid != NULL) {
+    set_has_dagid();
+  } else {
+    clear_has_dagid();
+  }
+  dagid_.SetAllocatedNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), dagid);
+  // @@protoc_insertion_point(field_set_allocated:TaskMsg.dagId)
+}
+
 #endif  // PROTOBUF_INLINE_NOT_IN_HEADERS
 
 // @@protoc_insertion_point(namespace_scope)
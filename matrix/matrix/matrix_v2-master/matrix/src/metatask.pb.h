@@ -157,6 +157,32 @@ class TaskMsg : public ::google::protobuf::Message {
   ::google::protobuf::int64 datalength() const;
   void set_datalength(::google::protobuf::int64 value);
 
+  // optional int64 priority = 6;
+  bool has_priority() const;
+  void clear_priority();
+  static const int kPriorityFieldNumber = 6;
+  ::google::protobuf::int64 priority() const;
+  void set_priority(::google::protobuf::int64 value);
+
+  // optional int64 deadline = 7;
+  bool has_deadline() const;
+  void clear_deadline();
+  static const int kDeadlineFieldNumber = 7;
+  ::google::protobuf::int64 deadline() const;
+  void set_deadline(::google::protobuf::int64 value);
+
+  // optional string dagId = 8;
+  bool has_dagid() const;
+  void clear_dagid();
+  static const int kDagIdFieldNumber = 8;
+  const ::std::string& dagid() const;
+  void set_dagid(const ::std::string& value);
+  void set_dagid(const char* value);
+  void set_dagid(const char* value, size_t size);
+  ::std::string* mutable_dagid();
+  ::std::string* release_dagid();
+  void set_allocated_dagid(::std::string* dagid);
+
   // @@protoc_insertion_point(class_scope:TaskMsg)
  private:
   inline void set_has_taskid();
@@ -169,6 +195,12 @@ class TaskMsg : public ::google::protobuf::Message {
   inline void clear_has_cmd();
   inline void set_has_datalength();
   inline void clear_has_datalength();
+  inline void set_has_priority();
+  inline void clear_has_priority();
+  inline void set_has_deadline();
+  inline void clear_has_deadline();
+  inline void set_has_dagid();
+  inline void clear_has_dagid();
 
   // helper for ByteSize()
   int RequiredFieldsByteSizeFallback() const;
@@ -181,6 +213,9 @@ class TaskMsg : public ::google::protobuf::Message {
   ::google::protobuf::internal::ArenaStringPtr dir_;
   ::google::protobuf::internal::ArenaStringPtr cmd_;
   ::google::protobuf::int64 datalength_;
+  ::google::protobuf::int64 priority_;
+  ::google::protobuf::int64 deadline_;
+  ::google::protobuf::internal::ArenaStringPtr dagid_;
   friend void  protobuf_AddDesc_metatask_2eproto();
   friend void protobuf_AssignDesc_metatask_2eproto();
   friend void protobuf_ShutdownFile_metatask_2eproto();
@@ -432,6 +467,107 @@ inline void TaskMsg::set_datalength(::google::protobuf::int64 value) {
   // @@protoc_insertion_point(field_set:TaskMsg.dataLength)
 }
 
+// optional int64 priority = 6;
+inline bool TaskMsg::has_priority() const {
+  return (_has_bits_[0] & 0x00000020u) != 0;
+}
+inline void TaskMsg::set_has_priority() {
+  _has_bits_[0] |= 0x00000020u;
+}
+inline void TaskMsg::clear_has_priority() {
+  _has_bits_[0] &= ~0x00000020u;
+}
+inline void TaskMsg::clear_priority() {
+  priority_ = GOOGLE_LONGLONG(0);
+  clear_has_priority();
+}
+inline ::google::protobuf::int64 TaskMsg::priority() const {
+  // @@protoc_insertion_point(field_get:TaskMsg.priority)
+  return priority_;
+}
+inline void TaskMsg::set_priority(::google::protobuf::int64 value) {
+  set_has_priority();
+  priority_ = value;
+  // @@protoc_insertion_point(field_set:TaskMsg.priority)
+}
+
+// optional int64 deadline = 7;
+inline bool TaskMsg::has_deadline() const {
+  return (_has_bits_[0] & 0x00000040u) != 0;
+}
+inline void TaskMsg::set_has_deadline() {
+  _has_bits_[0] |= 0x00000040u;
+}
+inline void TaskMsg::clear_has_deadline() {
+  _has_bits_[0] &= ~0x00000040u;
+}
+inline void TaskMsg::clear_deadline() {
+  deadline_ = GOOGLE_LONGLONG(0);
+  clear_has_deadline();
+}
+inline ::google::protobuf::int64 TaskMsg::deadline() const {
+  // @@protoc_insertion_point(field_get:TaskMsg.deadline)
+  return deadline_;
+}
+inline void TaskMsg::set_deadline(::google::protobuf::int64 value) {
+  set_has_deadline();
+  deadline_ = value;
+  // @@protoc_insertion_point(field_set:TaskMsg.deadline)
+}
+
+// optional string dagId = 8;
+inline bool TaskMsg::has_dagid() const {
+  return (_has_bits_[0] & 0x00000080u) != 0;
+}
+inline void TaskMsg::set_has_dagid() {
+  _has_bits_[0] |= 0x00000080u;
+}
+inline void TaskMsg::clear_has_dagid() {
+  _has_bits_[0] &= ~0x00000080u;
+}
+inline void TaskMsg::clear_dagid() {
+  dagid_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+  clear_has_dagid();
+}
+inline const ::std::string& TaskMsg::dagid() const {
+  // @@protoc_insertion_point(field_get:TaskMsg.dagId)
+  return dagid_.GetNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+}
+inline void TaskMsg::set_dagid(const ::std::string& value) {
+  set_has_dagid();
+  dagid_.SetNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), value);
+  // @@protoc_insertion_point(field_set:TaskMsg.dagId)
+}
+inline void TaskMsg::set_dagid(const char* value) {
+  set_has_dagid();
+  dagid_.SetNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), ::std::string(value));
+  // @@protoc_insertion_point(field_set_char:TaskMsg.dagId)
+}
+inline void TaskMsg::set_dagid(const char* value, size_t size) {
+  set_has_dagid();
+  dagid_.SetNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited(),
+      ::std::string(reinterpret_cast<const char*>(value), size));
+  // @@protoc_insertion_point(field_set_pointer:TaskMsg.dagId)
+}
+inline ::std::string* TaskMsg::mutable_dagid() {
+  set_has_dagid();
+  // @@protoc_insertion_point(field_mutable:TaskMsg.dagId)
+  return dagid_.MutableNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+}
+inline ::std::string* TaskMsg::release_dagid() {
+  clear_has_dagid();
+  return dagid_.ReleaseNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+}
+inline void TaskMsg::set_allocated_dagid(::std::string* dagid) {
+  if (dagid != NULL) {
+    set_has_dagid();
+  } else {
+    clear_has_dagid();
+  }
+  dagid_.SetAllocatedNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), dagid);
+  // @@protoc_insertion_point(field_set_allocated:TaskMsg.dagId)
+}
+
 #endif  // !PROTOBUF_INLINE_NOT_IN_HEADERS
 
 // @@protoc_insertion_point(namespace_scope)
@@ -0,0 +1,239 @@
+/*
+ * ready_queue.h
+ *
+ * multi-level ready queue with per-user and per-DAG fair share.
+ * Tasks are grouped into flows, one per DAG of a user. Users take
+ * turns round robin, and so do the DAGs of a user, so that a huge
+ * bag of tasks can not starve the latency sensitive workflows of
+ * others. Within a DAG, tasks are kept in FIFO levels: tasks with
+ * a deadline are leveled by their slack, the others by their
+ * critical path (the longest path of tasks left to the end of the
+ * DAG). A task waiting longer than the aging interval counts as one
+ * level higher per interval, so low levels are never starved. A flow
+ * is dropped as soon as it runs out of tasks, so the queue only holds
+ * the users and DAGs that have ready tasks. Picking the next task is
+ * O(1), while a push and the removal of an empty flow look the flow
+ * up by name in a map, O(log) in the number of queued users and DAGs.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef READY_QUEUE_H_
+#define READY_QUEUE_H_
+
+#include <string>
+#include <deque>
+#include <map>
+
+using namespace std;
+
+#define READY_QUEUE_NUM_LEVEL 32	// levels of a flow, 31 is the highest
+#define READY_QUEUE_CP_LEVEL 24	// critical path levels 0 - 23, deadlines 24 - 31
+#define READY_QUEUE_AGING_INTERVAL 1000000	// default aging interval in micro-second
+
+/* the scheduling attributes of a ready task */
+struct ReadyAttr
+{
+	string user;	// fair share among users
+	string dag;	// then among the DAGs of a user
+	long priority;	// critical path length, longer goes first
+	long deadline;	// absolute deadline in micro-second, 0 if none
+	long time;	// when the task became ready, for aging
+};
+
+/* floor(log2(num)) for num > 0, 0 otherwise */
+inline int ready_log2(long num)
+{
+	return num <= 0 ? 0 : 63 - __builtin_clzl((unsigned long) num);
+}
+
+/* the level of a task at a given time. The tighter the slack to its
+ * deadline (in mili-second) the higher, missed deadlines go to the top */
+inline int ready_level(const ReadyAttr &attr, long now)
+{
+	if (attr.deadline > 0) {
+		long slack = (attr.deadline - now) / 1000;
+		if (slack <= 0) {
+			return READY_QUEUE_NUM_LEVEL - 1;
+		}
+		int level = READY_QUEUE_NUM_LEVEL - 2 - ready_log2(slack);
+		return level < READY_QUEUE_CP_LEVEL ? READY_QUEUE_CP_LEVEL : level;
+	}
+
+	int level = ready_log2(attr.priority + 1);
+	return level >= READY_QUEUE_CP_LEVEL ? READY_QUEUE_CP_LEVEL - 1 : level;
+}
+
+template<typename Item> class ReadyQueue
+{
+	public:
+		ReadyQueue(long agingInterval = READY_QUEUE_AGING_INTERVAL)
+		{
+			this->agingInterval = agingInterval > 0 ? agingInterval : 1;
+			numItem = 0;
+		}
+
+		~ReadyQueue()
+		{
+			for (typename map<string, UserFlow*>::iterator it = users.begin();
+					it != users.end(); ++it) {
+				for (typename map<string, DagFlow*>::iterator dit =
+						it->second->dags.begin(); dit != it->second->dags.end();
+						++dit) {
+					delete dit->second;
+				}
+				delete it->second;
+			}
+		}
+
+		void set_aging_interval(long agingInterval)
+		{
+			this->agingInterval = agingInterval > 0 ? agingInterval : 1;
+		}
+
+		long size() const
+		{
+			return numItem;
+		}
+
+		bool empty() const
+		{
+			return numItem == 0;
+		}
+
+		void push(const Item &item, const ReadyAttr &attr)
+		{
+			UserFlow *uf = users[attr.user];
+			if (uf == NULL) {
+				uf = new UserFlow();
+				uf->name = attr.user;
+				uf->active = false;
+				users[attr.user] = uf;
+			}
+
+			DagFlow *df = uf->dags[attr.dag];
+			if (df == NULL) {
+				df = new DagFlow();
+				df->name = attr.dag;
+				df->mask = 0;
+				df->size = 0;
+				df->active = false;
+				uf->dags[attr.dag] = df;
+			}
+
+			int level = ready_level(attr, attr.time);
+			df->levels[level].push_back(Entry(item, attr));
+			df->mask |= 1U << level;
+			df->size++;
+			numItem++;
+
+			if (!df->active) {
+				df->active = true;
+				uf->activeDags.push_back(df);
+			}
+			if (!uf->active) {
+				uf->active = true;
+				activeUsers.push_back(uf);
+			}
+		}
+
+		/* take the next task of the next DAG of the next user,
+		 * the queue must not be empty */
+		void pop(long now, Item &item, ReadyAttr &attr)
+		{
+			UserFlow *uf = activeUsers.front();
+			activeUsers.pop_front();
+			DagFlow *df = uf->activeDags.front();
+			uf->activeDags.pop_front();
+
+			int level = pick_level(df, now);
+			Entry &entry = df->levels[level].front();
+			item = entry.item;
+			attr = entry.attr;
+			df->levels[level].pop_front();
+			if (df->levels[level].empty()) {
+				df->mask &= ~(1U << level);
+			}
+			df->size--;
+			numItem--;
+
+			if (df->size > 0) {
+				uf->activeDags.push_back(df);
+			} else {
+				uf->dags.erase(df->name);
+				delete df;
+			}
+			if (!uf->activeDags.empty()) {
+				activeUsers.push_back(uf);
+			} else {
+				users.erase(uf->name);
+				delete uf;
+			}
+		}
+
+		Item pop(long now)
+		{
+			Item item;
+			ReadyAttr attr;
+			pop(now, item, attr);
+			return item;
+		}
+
+	private:
+		struct Entry
+		{
+			Entry(const Item &item, const ReadyAttr &attr) :
+					item(item), attr(attr)
+			{
+			}
+
+			Item item;
+			ReadyAttr attr;
+		};
+
+		struct DagFlow
+		{
+			string name;	// key in the dags of its user
+			deque<Entry> levels[READY_QUEUE_NUM_LEVEL];
+			unsigned int mask;	// bit k is set if level k is not empty
+			long size;
+			bool active;	// in the round robin of its user
+		};
+
+		struct UserFlow
+		{
+			string name;	// key in the users
+			map<string, DagFlow*> dags;
+			deque<DagFlow*> activeDags;
+			bool active;	// in the round robin of users
+		};
+
+		/* the level whose oldest task has the highest aged level,
+		 * the higher level wins a tie */
+		int pick_level(DagFlow *df, long now)
+		{
+			int best = -1;
+			long bestAged = -1;
+			unsigned int mask = df->mask;
+
+			while (mask != 0) {
+				int level = 31 - __builtin_clz(mask);
+				mask &= ~(1U << level);
+				long aged = level + (now - df->levels[level].front().attr.time)
+						/ agingInterval;
+				if (aged > bestAged) {
+					bestAged = aged;
+					best = level;
+				}
+			}
+
+			return best;
+		}
+
+		map<string, UserFlow*> users;
+		deque<UserFlow*> activeUsers;
+		long numItem;
+		long agingInterval;
+};
+
+#endif /* READY_QUEUE_H_ */
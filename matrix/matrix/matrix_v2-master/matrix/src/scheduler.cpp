@@ -27,6 +27,8 @@ int main(int argc, char *argv[]) {
 
 	ms->fork_es_thread();	// forks the epoll event driven server
 
+	ms->fork_record_task_thread();	// forks task trace writer thread
+
 //	ms->load_data();
 
 //	ms->get_task_from_file();
@@ -0,0 +1,223 @@
+/*
+ * scheduler_metrics.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "scheduler_metrics.h"
+#include "matrix_tcp_proxy_stub.h"
+#include <string.h>
+
+LatencyHistogram::LatencyHistogram() {
+	count = 0;
+	sum = 0;
+	max = 0;
+	memset(bucket, 0, sizeof(bucket));
+}
+
+LatencyHistogram::~LatencyHistogram() {
+
+}
+
+void LatencyHistogram::add(long value) {
+	int idx = 0;
+
+	if (value < 0) {
+		value = 0;
+	}
+	while (idx < METRICS_NUM_BUCKET - 1 && (value >> idx) > 0) {
+		idx++;
+	}
+
+	__atomic_fetch_add(&count, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&sum, value, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&bucket[idx], 1, __ATOMIC_RELAXED);
+
+	long curMax = __atomic_load_n(&max, __ATOMIC_RELAXED);
+	while (value > curMax && !__atomic_compare_exchange_n(&max, &curMax,
+			value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+	}
+}
+
+void LatencyHistogram::dump(const string &name,
+		map<string, long> &values) const {
+	values[name + ".count"] = __atomic_load_n(&count, __ATOMIC_RELAXED);
+	values[name + ".sum"] = __atomic_load_n(&sum, __ATOMIC_RELAXED);
+	values[name + ".max"] = __atomic_load_n(&max, __ATOMIC_RELAXED);
+
+	for (int i = 0; i < METRICS_NUM_BUCKET; i++) {
+		long num = __atomic_load_n(&bucket[i], __ATOMIC_RELAXED);
+		if (num > 0) {
+			values[name + ".b" + num_to_str<int>(i)] = num;
+		}
+	}
+}
+
+MetricsSnapshot::MetricsSnapshot() {
+
+}
+
+MetricsSnapshot::~MetricsSnapshot() {
+
+}
+
+long MetricsSnapshot::get(const string &key) const {
+	map<string, long>::const_iterator it = values.find(key);
+	return it == values.end() ? 0 : it->second;
+}
+
+void MetricsSnapshot::set(const string &key, long value) {
+	values[key] = value;
+}
+
+void MetricsSnapshot::merge(const MetricsSnapshot &other) {
+	for (map<string, long>::const_iterator it = other.values.begin();
+			it != other.values.end(); ++it) {
+		const string &key = it->first;
+		if ((key.size() > 4 && key.compare(key.size() - 4, 4, ".max") == 0)
+				|| key.compare("time") == 0 || key.compare("uptime") == 0) {
+			if (values[key] < it->second) {
+				values[key] = it->second;
+			}
+		} else {
+			values[key] += it->second;
+		}
+	}
+}
+
+long MetricsSnapshot::percentile(const string &name, double pct) const {
+	long count = get(name + ".count");
+	long seen = 0;
+
+	if (count == 0) {
+		return 0;
+	}
+
+	for (int i = 0; i < METRICS_NUM_BUCKET; i++) {
+		seen += get(name + ".b" + num_to_str<int>(i));
+		if (seen >= pct * count) {
+			long upper = i == 0 ? 0 : (1L << i) - 1;
+			long max = get(name + ".max");
+			return upper < max ? upper : max;
+		}
+	}
+
+	return get(name + ".max");
+}
+
+string MetricsSnapshot::to_str() const {
+	string str("");
+
+	for (map<string, long>::const_iterator it = values.begin();
+			it != values.end(); ++it) {
+		str.append(it->first);
+		str.append("=");
+		str.append(num_to_str<long>(it->second));
+		str.append(";");
+	}
+
+	return str;
+}
+
+MetricsSnapshot MetricsSnapshot::from_str(const string &str) {
+	MetricsSnapshot snapshot;
+	vector<string> pairVec = tokenize(str, ";");
+
+	for (int i = 0; i < pairVec.size(); i++) {
+		size_t pos = pairVec.at(i).find('=');
+		if (pos == string::npos) {
+			continue;
+		}
+		snapshot.values[pairVec.at(i).substr(0, pos)] = str_to_num<long>(
+				pairVec.at(i).substr(pos + 1));
+	}
+
+	return snapshot;
+}
+
+SchedulerMetrics::SchedulerMetrics() {
+	numTaskRecv = 0;
+	numTaskFin = 0;
+	numTaskPushed = 0;
+	numTaskSteal = 0;
+	numTaskStolen = 0;
+	numWS = 0;
+	numWSFail = 0;
+	numZHTOp = 0;
+	startTime = get_time_usec();
+}
+
+SchedulerMetrics::~SchedulerMetrics() {
+
+}
+
+void SchedulerMetrics::incre(long &counter, long increment) {
+	__atomic_fetch_add(&counter, increment, __ATOMIC_RELAXED);
+}
+
+MetricsSnapshot SchedulerMetrics::snapshot() const {
+	MetricsSnapshot snapshot;
+
+	snapshot.set("time", get_time_usec());
+	snapshot.set("uptime", get_time_usec() - startTime);
+	snapshot.set("numtaskrecv", __atomic_load_n(&numTaskRecv, __ATOMIC_RELAXED));
+	snapshot.set("numtaskfin", __atomic_load_n(&numTaskFin, __ATOMIC_RELAXED));
+	snapshot.set("numtaskpushed",
+			__atomic_load_n(&numTaskPushed, __ATOMIC_RELAXED));
+	snapshot.set("numtasksteal",
+			__atomic_load_n(&numTaskSteal, __ATOMIC_RELAXED));
+	snapshot.set("numtaskstolen",
+			__atomic_load_n(&numTaskStolen, __ATOMIC_RELAXED));
+	snapshot.set("numworksteal", __atomic_load_n(&numWS, __ATOMIC_RELAXED));
+	snapshot.set("numworkstealfail",
+			__atomic_load_n(&numWSFail, __ATOMIC_RELAXED));
+	snapshot.set("numzhtop", __atomic_load_n(&numZHTOp, __ATOMIC_RELAXED));
+
+	queueWait.dump("queuewait", snapshot.values);
+	exec.dump("exec", snapshot.values);
+	stealRtt.dump("stealrtt", snapshot.values);
+	zhtOp.dump("zhtop", snapshot.values);
+
+	return snapshot;
+}
+
+ClusterMetrics::ClusterMetrics(const vector<string> &schedulerVec, long port) {
+	this->schedulerVec = schedulerVec;
+	this->port = port;
+	perScheduler.resize(schedulerVec.size());
+	answered.resize(schedulerVec.size(), false);
+}
+
+ClusterMetrics::~ClusterMetrics() {
+
+}
+
+int ClusterMetrics::pull(MetricsSnapshot &cluster) {
+	MatrixMsg mm;
+	mm.set_msgtype("query metrics");
+	string strQuery = mm_to_str(mm);
+	int numAnswer = 0;
+
+	cluster = MetricsSnapshot();
+
+	for (int i = 0; i < schedulerVec.size(); i++) {
+		string result;
+		answered.at(i) = false;
+		int sockfd = send_first(schedulerVec.at(i), port, strQuery);
+		if (sockfd != -1) {
+			recv_big(sockfd, result);
+			close(sockfd);
+		}
+
+		if (!result.empty()) {
+			MatrixMsg mmMetrics = str_to_mm(result);
+			perScheduler.at(i) = MetricsSnapshot::from_str(
+					mmMetrics.extrainfo());
+			answered.at(i) = true;
+			numAnswer++;
+		}
+		cluster.merge(perScheduler.at(i));
+	}
+
+	return numAnswer;
+}
@@ -0,0 +1,124 @@
+/*
+ * scheduler_metrics.h
+ *
+ * live counters and latency histograms kept by every scheduler,
+ * served to clients through the scheduler's epoll server with the
+ * "query metrics" message, and aggregated over the whole cluster
+ * by ClusterMetrics without touching ZHT
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SCHEDULER_METRICS_H_
+#define SCHEDULER_METRICS_H_
+
+#include <string>
+#include <vector>
+#include <map>
+
+using namespace std;
+
+#define METRICS_NUM_BUCKET 40	// bucket k counts values in [2^(k-1), 2^k)
+
+/* lock-free histogram of latencies in micro-second, with power of
+ * two buckets, so that percentiles can be estimated after summing
+ * the histograms of many schedulers
+ * */
+class LatencyHistogram
+{
+	public:
+		LatencyHistogram();
+		~LatencyHistogram();
+
+		void add(long value);
+
+		/* dump as <name>.count, <name>.sum, <name>.max, <name>.b<k> */
+		void dump(const string &name, map<string, long>&) const;
+
+	private:
+		long count;
+		long sum;
+		long max;
+		long bucket[METRICS_NUM_BUCKET];
+};
+
+/* a point in time view of the metrics of one or more schedulers */
+class MetricsSnapshot
+{
+	public:
+		MetricsSnapshot();
+		~MetricsSnapshot();
+
+		long get(const string&) const;
+		void set(const string&, long);
+
+		/* add the metrics of another scheduler, maxima are maxed */
+		void merge(const MetricsSnapshot&);
+
+		/* estimate a percentile (0 - 1) of a histogram, the
+		 * upper bound of the bucket holding it is returned */
+		long percentile(const string &name, double pct) const;
+
+		/* "key=value;key=value;..." so that it survives mm_to_str */
+		string to_str() const;
+		static MetricsSnapshot from_str(const string&);
+
+		map<string, long> values;
+};
+
+/* counters of one scheduler, updated with atomic operations
+ * so that the hot paths never take a lock
+ * */
+class SchedulerMetrics
+{
+	public:
+		SchedulerMetrics();
+		~SchedulerMetrics();
+
+		void incre(long &counter, long increment = 1);
+
+		/* snapshot of the counters and histograms, the queue
+		 * lengths and core counts are gauges given by the caller */
+		MetricsSnapshot snapshot() const;
+
+		long numTaskRecv;	// tasks received from clients
+		long numTaskFin;	// tasks done
+		long numTaskPushed;	// tasks received because of data locality
+		long numTaskSteal;	// tasks stolen from other schedulers
+		long numTaskStolen;	// tasks stolen by other schedulers
+		long numWS;	// work stealing attempts
+		long numWSFail;	// failed work stealing attempts
+		long numZHTOp;	// ZHT operations on the scheduling path
+
+		LatencyHistogram queueWait;	// ready queued to start
+		LatencyHistogram exec;	// start to finish
+		LatencyHistogram stealRtt;	// one whole work stealing attempt
+		LatencyHistogram zhtOp;	// one ZHT lookup or compare and swap
+
+		long startTime;	// when the metrics were created
+};
+
+/* pulls the metrics of every scheduler and sums them up */
+class ClusterMetrics
+{
+	public:
+		ClusterMetrics(const vector<string> &schedulerVec, long port);
+		~ClusterMetrics();
+
+		/* query all the schedulers, returns how many answered. A
+		 * scheduler that does not answer counts with the metrics
+		 * it answered last, so that the sums never go backwards */
+		int pull(MetricsSnapshot &cluster);
+
+		/* the last known metrics of every scheduler */
+		vector<MetricsSnapshot> perScheduler;
+
+		/* whether every scheduler answered the last pull */
+		vector<bool> answered;
+
+	private:
+		vector<string> schedulerVec;
+		long port;
+};
+
+#endif /* SCHEDULER_METRICS_H_ */
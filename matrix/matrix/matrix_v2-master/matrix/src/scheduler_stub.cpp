@@ -10,23 +10,17 @@
 #include <math.h>
 #include <algorithm>
 
-MatrixScheduler::MatrixScheduler(const string &configFile) : Peer(configFile) {
+MatrixScheduler::MatrixScheduler(const string &configFile) :
+		Peer(configFile), stealPolicy(schedulerVec.size(), get_index(),
+				config->wsPollIntervalStart, config->wsPollIntervalUb,
+				time(NULL)) {
 	timespec start, end;
 	clock_gettime(0, &start);
 
-	/* number of neighbors is equal to the
-	 * squared root of all number of schedulers
-	 * */
+	/* no work stealing with one scheduler */
 	if (schedulerVec.size() == 1)
 		config->workStealingOn = 0;
 
-	numNeigh = (int) (sqrt(schedulerVec.size()) + 0.5);
-	neighIdx = new int[numNeigh];
-	maxLoadedIdx = -1;
-	maxLoad = -1000000;
-	pollInterval = config->wsPollIntervalStart;
-	chooseBitMap = new bool[schedulerVec.size()];
-	reset_choosebm();
 	startWS = false;
 
 	ZHTMsgCountMutex = Mutex();
@@ -39,7 +33,6 @@ MatrixScheduler::MatrixScheduler(const string &configFile) : Peer(configFile) {
 	lqMutex = Mutex();
 	wsqMutex = Mutex();
 	ldMutex = Mutex();
-	tteMutex = Mutex();
 
 	clock_gettime(0, &end);
 
@@ -63,10 +56,8 @@ MatrixScheduler::MatrixScheduler(const string &configFile) : Peer(configFile) {
 	numWSFail = 0;
 
 	waitQueue = deque<TaskMsg>();
-	localQueue = priority_queue<TaskMsg,
-			vector<TaskMsg>, HighPriorityByDataSize>();
-	wsQueue = priority_queue<TaskMsg,
-			vector<TaskMsg>, HighPriorityByDataSize>();
+	localQueue.set_aging_interval(config->agingInterval);
+	wsQueue.set_aging_interval(config->agingInterval);
 	completeQueue = deque<CmpQueueItem>();
 
 	localData = map<string, string>();
@@ -75,14 +66,28 @@ MatrixScheduler::MatrixScheduler(const string &configFile) : Peer(configFile) {
 	cache = true;
 #endif
 
-	string taskLogFile("./task." + (num_to_str<int>(schedulerVec.size())) + "."
-					+ num_to_str<long>(config->numTaskPerClient) + "."
-					+ num_to_str<int>(get_index()));
-	taskLogOS.open(taskLogFile.c_str());
+	taskTracer = NULL;
+	if (config->taskLog == 1) {
+		string taskLogFile("./task." + (num_to_str<int>(schedulerVec.size()))
+				+ "." + num_to_str<long>(config->numTaskPerClient) + "."
+				+ num_to_str<int>(get_index()) + ".trace");
+		taskTracer = new TaskTracer(taskLogFile, config->sleepLength);
+	}
 
 	srand(time(NULL));
 }
 
+/* the scheduling attributes of a task that becomes ready now */
+static ReadyAttr ready_attr(const TaskMsg &tm, long time) {
+	ReadyAttr attr;
+	attr.user = tm.user();
+	attr.dag = tm.dagid();
+	attr.priority = tm.priority();
+	attr.deadline = tm.deadline();
+	attr.time = time;
+	return attr;
+}
+
 MatrixScheduler::~MatrixScheduler(void) {
 
 }
@@ -171,8 +176,9 @@ void MatrixScheduler::get_task_from_file() {
 			tm.set_dir(taskItemStr.at(2));
 			tm.set_cmd(taskItemStr.at(3));
 			tm.set_datalength(0);
-			long time = get_time_usec();
-			taskTimeEntry.push_back(tm.taskid() + "\tWaitQueueTime\t" + num_to_str<long>(time));
+			if (taskTracer != NULL) {
+				taskTracer->record(tm.taskid(), TE_WAIT_QUEUED, get_time_usec());
+			}
 			waitQueue.push_back(tm);
 		}
 
@@ -208,12 +214,13 @@ void MatrixScheduler::send_task(int sockfd) {
 	/* number of tasks to send equals to half of the current load,
 	 * which is calculated as the number of tasks in the ready queue
 	 * minus number of idle cores */
-	numTaskToSend = wsQueue.size() / 2;
+	numTaskToSend = StealPolicy::num_task_to_send(wsQueue.size());
 	for (int i = 0; i < numTaskToSend; i++) {
-		taskVec.push_back(wsQueue.top());
-		wsQueue.pop();
+		taskVec.push_back(wsQueue.pop(get_time_usec()));
 	}
 	wsqMutex.unlock();
+
+	metrics.incre(metrics.numTaskStolen, taskVec.size());
 	send_batch_tasks(taskVec, sockfd, "scheduler");
 }
 
@@ -238,24 +245,23 @@ void MatrixScheduler::recv_task_from_client(string &str, int sockfd) {
 	for (int i = 1; i < stealVec.size(); i++) {
 		MatrixMsg mm = str_to_mm(stealVec.at(i));
 		vector<TaskMsg> tmVec;
-		string time = num_to_str<long>(get_time_usec());
+		long time = get_time_usec();
 		for (long j = 0; j < mm.count(); j++) {
 			tmVec.push_back(str_to_taskmsg(mm.tasks(j)));
 		}
 		//cout << "OK, before the time record!" << endl;
-		tteMutex.lock();
 		for (long j = 0; j < mm.count(); j++) {
 			string taskMD;
 			//cout << "Now, I am doing a zht lookup:" << tmVec.at(j).taskid() << endl;
-			zc.lookup(tmVec.at(j).taskid(), taskMD);
+			zht_lookup(tmVec.at(j).taskid(), taskMD);
 			//cout << "I got the task metadata:" << taskMD << endl;
 			Value value = str_to_value(taskMD);
-			taskTimeEntry.push_back(tmVec.at(j).taskid() + "\tSubmissionTime\t"
-					+ num_to_str<long>(value.submittime()));
-			taskTimeEntry.push_back(tmVec.at(j).taskid()
-					+ "\tWaitQueueTime\t" + time);
+			if (taskTracer != NULL) {
+				taskTracer->record(tmVec.at(j).taskid(), TE_SUBMISSION,
+						value.submittime());
+				taskTracer->record(tmVec.at(j).taskid(), TE_WAIT_QUEUED, time);
+			}
 		}
-		tteMutex.unlock();
 		//cout << "OK, I did the time record!" << endl;
 		increment += mm.count();
 
@@ -264,6 +270,7 @@ void MatrixScheduler::recv_task_from_client(string &str, int sockfd) {
 			waitQueue.push_back(tmVec.at(j));
 		}
 		wqMutex.unlock();
+		metrics.incre(metrics.numTaskRecv, mm.count());
 	}
 	//cout << "OK, now I have put the tasks in the wait queue, let's update the ZHT record!" << endl;
 	string numTaskRecvStr, numTaskRecvMoreStr, queryValue;
@@ -308,14 +315,14 @@ void MatrixScheduler::recv_pushing_task(MatrixMsg &mm, int sockfd) {
 	 taskDetail = value_to_str(value);
 	 insert_wrap(tm.taskid(), taskDetail);*/
 
-	tteMutex.lock();
-	taskTimeEntry.push_back(
-			tm.taskid() + "\tPushQueuedTime\t"
-					+ num_to_str<long>(get_time_usec()));
-	tteMutex.unlock();
+	long time = get_time_usec();
+	if (taskTracer != NULL) {
+		taskTracer->record(tm.taskid(), TE_PUSH_QUEUED, time);
+	}
+	metrics.incre(metrics.numTaskPushed);
 
 	lqMutex.lock();
-	localQueue.push(tm);
+	localQueue.push(tm, ready_attr(tm, time));
 	lqMutex.unlock();
 	//increment += 2;
 
@@ -358,6 +365,12 @@ int MatrixScheduler::proc_req(int sockfd, char *buf) {
 			send_bf(sockfd, strLoad);
 		} else if (msg.compare("steal task") == 0) {	// thief steals tasks
 			send_task(sockfd);
+		} else if (msg.compare("query metrics") == 0) {	// monitoring pull
+			MatrixMsg mmMetrics;
+			mmMetrics.set_msgtype("send metrics");
+			mmMetrics.set_extrainfo(get_metrics().to_str());
+			string strMetrics = mm_to_str(mmMetrics);
+			send_big(sockfd, strMetrics);
 		} else if (msg.compare("scheduler push task") == 0) {
 			recv_pushing_task(mm, sockfd);
 		} else if (msg.compare("scheduler require data") == 0) {
@@ -406,32 +419,6 @@ void MatrixScheduler::fork_es_thread() {
 	}
 }
 
-/* reset the bitmap of neighbors chosen, "false"
- * means hasn't been chosen */
-void MatrixScheduler::reset_choosebm() {
-	for (int i = 0; i < schedulerVec.size(); i++) {
-		chooseBitMap[i] = false;
-	}
-}
-
-/* choose candidate neighbors to steal tasks,
- * for simplicity, we randomly choose neighbors
- * */
-void MatrixScheduler::choose_neigh() {
-	int idx = -1;
-	for (int i = 0; i < numNeigh; i++) {
-		idx = rand() % schedulerVec.size();
-		while (idx == get_index() || chooseBitMap[idx]) {
-			idx = rand() % schedulerVec.size();
-		}
-		neighIdx[i] = idx;
-		chooseBitMap[idx] = true;
-		//cout << "The neighbor to choose is:" << idx << endl;
-	}
-
-	reset_choosebm();
-}
-
 /* find the neighbor with the maximum load by quering
  * the load information of each scheduler one by one
  * */
@@ -442,8 +429,9 @@ void MatrixScheduler::find_most_loaded_neigh() {
 	string strLoadQuery = mm_to_str(mm);
 
 	long load = -1;
+	const vector<int> &neighIdx = stealPolicy.choose_neigh();
 
-	for (int i = 0; i < numNeigh; i++) {
+	for (int i = 0; i < neighIdx.size(); i++) {
 		string result;
 		sockMutex.lock();
 		int sockfd = send_first(schedulerVec.at(neighIdx[i]),
@@ -458,10 +446,7 @@ void MatrixScheduler::find_most_loaded_neigh() {
 		MatrixMsg mmLoad = str_to_mm(result);
 
 		load = mmLoad.count();
-		if (maxLoad < load) {
-			maxLoad = load;
-			maxLoadedIdx = neighIdx[i];
-		}
+		stealPolicy.offer_load(neighIdx[i], load);
 	}
 }
 
@@ -484,22 +469,22 @@ bool MatrixScheduler::recv_task_from_scheduler(int sockfd) {
 		MatrixMsg mm = str_to_mm(stealVec.at(i));
 
 		vector<TaskMsg> tmVec;
-		string time = num_to_str<long>(get_time_usec());
+		long time = get_time_usec();
 
 		for (long j = 0; j < mm.count(); j++) {
 			tmVec.push_back(str_to_taskmsg(mm.tasks(j)));
 		}
 
-		tteMutex.lock();
 		for (long j = 0; j < mm.count(); j++) {
-			taskTimeEntry.push_back(
-					tmVec.at(j).taskid() + "\tWorkStealQueuedTime\t" + time);
+			if (taskTracer != NULL) {
+				taskTracer->record(tmVec.at(j).taskid(), TE_WS_QUEUED, time);
+			}
 		}
-		tteMutex.unlock();
+		metrics.incre(metrics.numTaskSteal, mm.count());
 
 		wsqMutex.lock();
 		for (long j = 0; j < mm.count(); j++) {
-			wsQueue.push(tmVec.at(j));
+			wsQueue.push(tmVec.at(j), ready_attr(tmVec.at(j), time));
 		}
 		wsqMutex.unlock();
 	}
@@ -515,7 +500,8 @@ bool MatrixScheduler::recv_task_from_scheduler(int sockfd) {
  * */
 bool MatrixScheduler::steal_task() {
 	/* if no neighbors have ready tasks */
-	if (maxLoad <= 0) {
+	int victim = stealPolicy.victim();
+	if (victim < 0) {
 		return false;
 	}
 
@@ -528,7 +514,7 @@ bool MatrixScheduler::steal_task() {
 	//cout << "OK, before sending stealing task message!" << endl;
 	sockMutex.lock();
 	//cout << "OK, I am sending stealing task message!" << endl;
-	int sockfd = send_first(schedulerVec.at(maxLoadedIdx),
+	int sockfd = send_first(schedulerVec.at(victim),
 			config->schedulerPortNo, strStealTask);
 
 	bool ret = recv_task_from_scheduler(sockfd);
@@ -548,13 +534,13 @@ void *workstealing(void* args) {
 
 	while (ms->running) {
 		while (ms->localQueue.size() + ms->wsQueue.size() == 0
-				&& ms->pollInterval < ms->config->wsPollIntervalUb) {
-			ms->choose_neigh();
+				&& !ms->stealPolicy.stopped()) {
+			long stealStart = get_time_usec();
 			ms->find_most_loaded_neigh();
 			bool success = ms->steal_task();
+			ms->metrics.stealRtt.add(get_time_usec() - stealStart);
+			ms->metrics.incre(ms->metrics.numWS);
 			ms->numWS++;
-			ms->maxLoadedIdx = -1;
-			ms->maxLoad = -1000000;
 
 			/* if successfully steals some tasks, then the poll
 			 * interval is set back to the initial value, otherwise
@@ -562,20 +548,20 @@ void *workstealing(void* args) {
 			 * interval, and tries to do work stealing again
 			 * */
 			if (success) {
-				ms->pollInterval = ms->config->wsPollIntervalStart;
+				ms->stealPolicy.reset();
 			} else {
 				ms->numWSFail++;
-				usleep(ms->pollInterval);
-				ms->pollInterval *= 2;
+				ms->metrics.incre(ms->metrics.numWSFail);
+				usleep(ms->stealPolicy.fail());
 			}
 		}
 
-		if (ms->pollInterval >= ms->config->wsPollIntervalUb) {
+		if (ms->stealPolicy.stopped()) {
 			break;
 		}
 
-		ms->pollInterval = ms->config->wsPollIntervalStart;
-		usleep(ms->pollInterval);
+		ms->stealPolicy.reset();
+		usleep(ms->stealPolicy.poll_interval());
 	}
 
 	ms->ZHTMsgCountMutex.lock();
@@ -601,15 +587,16 @@ void MatrixScheduler::fork_ws_thread() {
  * delimited with space. After a task is done, move it to the
  * complete queue.
  * */
-void MatrixScheduler::exec_a_task(TaskMsg &tm) {
+void MatrixScheduler::exec_a_task(TaskMsg &tm, long readyTime) {
 	string taskDetail;
 	//cout << "Now, I am executing a task" << tm.taskid() << endl;
 	sockMutex.lock();
-	zc.lookup(tm.taskid(), taskDetail);
+	zht_lookup(tm.taskid(), taskDetail);
 	sockMutex.unlock();
 	Value value = str_to_value(taskDetail);
 
 	long startTime = get_time_usec();
+	metrics.queueWait.add(startTime - readyTime);
 
 	string data("");
 
@@ -705,18 +692,19 @@ void MatrixScheduler::exec_a_task(TaskMsg &tm) {
 #endif
 
 	long finTime = get_time_usec();
-	tteMutex.lock();
-	taskTimeEntry.push_back(
-			tm.taskid() + "\tStartTime\t" + num_to_str<long>(startTime));
-	taskTimeEntry.push_back(
-			tm.taskid() + "\tFinTime\t" + num_to_str<long>(finTime));
-	tteMutex.unlock();
+	if (taskTracer != NULL) {
+		taskTracer->record(tm.taskid(), TE_START, startTime);
+		taskTracer->record(tm.taskid(), TE_FIN, finTime);
+	}
 
 	cqMutex.lock();
 	//completeQueue.push_back(CmpQueueItem(tm.taskid(), key, result.length()));
 	completeQueue.push_back(CmpQueueItem(tm.taskid(), key, value.outputsize()));
 	cqMutex.unlock();
 
+	metrics.exec.add(finTime - startTime);
+	metrics.incre(metrics.numTaskFin);
+
 	numTaskFinMutex.lock();
 	numTaskFin++;
 	//cout << tm.taskid() << "\tNumber of task fin is:" << numTaskFin << endl;
@@ -734,14 +722,14 @@ void MatrixScheduler::exec_a_task(TaskMsg &tm) {
 void *executing_task(void *args) {
 	MatrixScheduler *ms = (MatrixScheduler*) args;
 	TaskMsg tm;
+	ReadyAttr attr;
 
 	while (ms->running) {
 		while (ms->localQueue.size() > 0 || ms->wsQueue.size() > 0) {
 			if (ms->localQueue.size() > 0) {
 				ms->lqMutex.lock();
 				if (ms->localQueue.size() > 0) {
-					tm = ms->localQueue.top();
-					ms->localQueue.pop();
+					ms->localQueue.pop(get_time_usec(), tm, attr);
 					ms->lqMutex.unlock();
 				} else {
 					ms->lqMutex.unlock();
@@ -751,8 +739,7 @@ void *executing_task(void *args) {
 				ms->wsqMutex.lock();
 				if (ms->wsQueue.size() > 0) {
 					//cout << "The ready queue length is:" << ms->wsQueue.size() << endl;
-					tm = ms->wsQueue.top();
-					ms->wsQueue.pop();
+					ms->wsQueue.pop(get_time_usec(), tm, attr);
 					ms->wsqMutex.unlock();
 				} else {
 					ms->wsqMutex.unlock();
@@ -767,7 +754,7 @@ void *executing_task(void *args) {
 			ms->numIdleCoreMutex.unlock();
 
 			//cout << "The task to execute is:" << tm.taskid() << endl;
-			ms->exec_a_task(tm);
+			ms->exec_a_task(tm, attr.time);
 
 			ms->numIdleCoreMutex.lock();
 			ms->numIdleCore++;
@@ -863,7 +850,7 @@ bool MatrixScheduler::check_a_ready_task(TaskMsg &tm) {
 	string taskDetail;
 	bool ready = false;
 	sockMutex.lock();
-	zc.lookup(tm.taskid(), taskDetail);
+	zht_lookup(tm.taskid(), taskDetail);
 	sockMutex.unlock();
 	Value value = str_to_value(taskDetail);
 	//cout << "task indegree:" << tm.taskid() << "\t" << value.indegree() << endl;
@@ -871,21 +858,17 @@ bool MatrixScheduler::check_a_ready_task(TaskMsg &tm) {
 	if (value.indegree() == 0) {
 		ready = true;
 		int flag = task_ready_process(value, tm);
-		if (flag != 2) {
-			tteMutex.lock();
-			taskTimeEntry.push_back(
-					tm.taskid() + "\tReadyQueuedTime\t"
-							+ num_to_str<long>(get_time_usec()));
-			tteMutex.unlock();
-
+		long time = get_time_usec();
+		if (flag != 2 && taskTracer != NULL) {
+			taskTracer->record(tm.taskid(), TE_READY_QUEUED, time);
 		}
 		if (flag == 0) {
 			wsqMutex.lock();
-			wsQueue.push(tm);
+			wsQueue.push(tm, ready_attr(tm, time));
 			wsqMutex.unlock();
 		} else if (flag == 1) {
 			lqMutex.lock();
-			localQueue.push(tm);
+			localQueue.push(tm, ready_attr(tm, time));
 			lqMutex.unlock();
 		}
 	}
@@ -946,7 +929,7 @@ long MatrixScheduler::notify_children(const CmpQueueItem &cqItem) {
 	long increment = 0;
 	sockMutex.lock();
 	//cout << "I got the lock, and I am notifying children!" << endl;
-	zc.lookup(cqItem.taskId, taskDetail);
+	zht_lookup(cqItem.taskId, taskDetail);
 	//cout << "OK, the task id is:" << cqItem.taskId << ", and task detail is:" << taskDetail << endl;
 	sockMutex.unlock();
 	if (taskDetail.empty()) {
@@ -963,7 +946,7 @@ long MatrixScheduler::notify_children(const CmpQueueItem &cqItem) {
 	for (int i = 0; i < value.children_size(); i++) {
 		childTaskId = value.children(i);
 		sockMutex.lock();
-		zc.lookup(childTaskId, childTaskDetail);
+		zht_lookup(childTaskId, childTaskDetail);
 		//cout << "The child task id is:" << childTaskId << "\t" << childTaskDetail << endl;
 		//cout << "The size is:" << childTaskDetail.length() << endl;
 		sockMutex.unlock();
@@ -983,10 +966,10 @@ long MatrixScheduler::notify_children(const CmpQueueItem &cqItem) {
 		//cout << cqItem.taskId << "\t" << childTaskId << "\t" << childTaskDetail << "\t" << childTaskDetailAttempt << endl;
 		increment++;
 		sockMutex.lock();
-		while (zc.compare_swap(childTaskId, childTaskDetail,
+		while (zht_cas(childTaskId, childTaskDetail,
 				childTaskDetailAttempt, query_value) != 0) {
 			if (query_value.empty()) {
-				zc.lookup(childTaskId, childTaskDetail);
+				zht_lookup(childTaskId, childTaskDetail);
 				increment++;
 			} else {
 				//cout << "The query_value is:" << query_value << endl;
@@ -1051,9 +1034,10 @@ void MatrixScheduler::fork_cct_thread() {
 }
 
 /* recording status thread function. The recording thread would periodically
- * dump the scheduler status information (number of tasks done, waiting,
+ * log the scheduler status information (number of tasks done, waiting,
  * and ready; number of idle/all cores, and number of (failed) working
- * stealing operations) to ZHT.
+ * stealing operations), and add the tasks done to the global counter in
+ * ZHT. The status itself is served live with the "query metrics" message.
  * */
 void *recording_stat(void *args) {
 	MatrixScheduler *ms = (MatrixScheduler*) args;
@@ -1067,20 +1051,6 @@ void *recording_stat(void *args) {
 	}
 
 	while (1) {
-		Value recordVal;
-		recordVal.set_id(ms->get_id());
-		recordVal.set_numtaskfin(ms->numTaskFin);
-		recordVal.set_numtaskwait(ms->waitQueue.size());
-		recordVal.set_numtaskready(ms->localQueue.size() + ms->wsQueue.size());
-		recordVal.set_numcoreavilable(ms->numIdleCore);
-		recordVal.set_numallcore(ms->config->numCorePerExecutor);
-		recordVal.set_numworksteal(ms->numWS);
-		recordVal.set_numworkstealfail(ms->numWSFail);
-		string recordValStr = value_to_str(recordVal);
-		sockMutex.lock();
-		ms->zc.insert(ms->get_id(), recordValStr);
-		sockMutex.unlock();
-
 		if (ms->schedulerLogOS.is_open()) {
 			ms->schedulerLogOS << get_time_usec() << "\t" << ms->numTaskFin
 					<< "\t" << ms->waitQueue.size() << "\t"
@@ -1154,17 +1124,19 @@ void *recording_stat(void *args) {
 
 	ms->schedulerLogOS << "The number of ZHT message is:" << ms->numZHTMsg
 			<< endl;
-	ms->schedulerLogOS.flush();
-	ms->schedulerLogOS.close();
 
-	if (ms->taskTimeEntry.size() > 0) {
-		//ms->tteMutex.lock();
-		for (int i = 0; i < ms->taskTimeEntry.size(); i++) {
-			ms->taskLogOS << ms->taskTimeEntry.at(i) << endl;
+	/* stop the trace writer, and drain what is left */
+	if (ms->taskTracer != NULL) {
+		ms->taskTracer->stop();
+		if (ms->schedulerLogOS.is_open()) {
+			ms->schedulerLogOS << "The number of dropped task events is:"
+					<< ms->taskTracer->num_dropped() << endl;
 		}
-		//ms->tteMutex.unlock();
 	}
 
+	ms->schedulerLogOS.flush();
+	ms->schedulerLogOS.close();
+
 	pthread_exit(NULL);
 	return NULL;
 }
@@ -1178,34 +1150,12 @@ void MatrixScheduler::fork_record_stat_thread() {
 	}
 }
 
-void *record_task_time(void *args) {
-	MatrixScheduler *ms = (MatrixScheduler*) args;
-
-	while (ms->running) {
-		if (ms->taskTimeEntry.size() > 0) {
-			ms->tteMutex.lock();
-			while (ms->taskTimeEntry.size() > 0) {
-				ms->taskLogOS << ms->taskTimeEntry.back() << endl;
-				ms->taskTimeEntry.pop_back();
-			}
-			ms->tteMutex.unlock();
-		}
-
-		usleep(ms->config->sleepLength);
-	}
-
-	ms->taskLogOS.flush();
-	ms->taskLogOS.close();
-	pthread_exit(NULL);
-
-	return NULL;
-}
-
+/* fork the task trace writer thread, which drains the
+ * per-thread event rings to the trace file periodically
+ * */
 void MatrixScheduler::fork_record_task_thread() {
-	pthread_t trThread;
-
-	while (pthread_create(&trThread, NULL, record_task_time, this) != 0) {
-		sleep(1);
+	if (taskTracer != NULL) {
+		taskTracer->fork_writer_thread();
 	}
 }
 
@@ -1221,8 +1171,9 @@ void *localQueue_monitor(void *args) {
 		time = (double) diff.tv_sec + (double) diff.tv_nsec / 1E9;
 		aveThroughput = (double) (ms->numTaskFin) / time;
 		maxSize = (long) (aveThroughput * ms->config->estTimeThreadshold);
-		vector<TaskMsg> vecRemain;
-		vector<TaskMsg> vecMigrated;
+		vector<pair<TaskMsg, ReadyAttr> > vecRemain;
+		vector<pair<TaskMsg, ReadyAttr> > vecMigrated;
+		long now = get_time_usec();
 		if (maxSize == 0) {
 			usleep(ms->config->sleepLength);
 			continue;
@@ -1230,24 +1181,28 @@ void *localQueue_monitor(void *args) {
 		ms->lqMutex.lock();
 		if (ms->localQueue.size() > maxSize) {
 			int numTaskToMove = ms->localQueue.size() - maxSize;
+			pair<TaskMsg, ReadyAttr> task;
 			for (int i = 0; i < maxSize; i++) {
-				vecRemain.push_back(ms->localQueue.top());
-				ms->localQueue.pop();
+				ms->localQueue.pop(now, task.first, task.second);
+				vecRemain.push_back(task);
 			}
 
 			for (int i = 0; i < numTaskToMove; i++) {
-				vecMigrated.push_back(ms->localQueue.top());
-				ms->localQueue.pop();
+				ms->localQueue.pop(now, task.first, task.second);
+				vecMigrated.push_back(task);
 			}
 
+			/* the ready times are kept, so that the aging goes on */
 			for (int i = 0; i < maxSize; i++) {
-				ms->localQueue.push(vecRemain.at(i));
+				ms->localQueue.push(vecRemain.at(i).first,
+						vecRemain.at(i).second);
 			}
 			ms->lqMutex.unlock();
 
 			ms->wsqMutex.lock();
 			for (int i = 0; i < numTaskToMove; i++) {
-				ms->wsQueue.push(vecMigrated.at(i));
+				ms->wsQueue.push(vecMigrated.at(i).first,
+						vecMigrated.at(i).second);
 			}
 			ms->wsqMutex.unlock();
 		} else {
@@ -1268,6 +1223,51 @@ void MatrixScheduler::fork_localQueue_monitor_thread() {
 	}
 }
 
+int MatrixScheduler::zht_lookup(const string &key, string &result) {
+	long time = get_time_usec();
+	int ret = zc.lookup(key, result);
+	metrics.zhtOp.add(get_time_usec() - time);
+	metrics.incre(metrics.numZHTOp);
+	return ret;
+}
+
+int MatrixScheduler::zht_cas(const string &key, const string &seenVal,
+		const string &newVal, string &queryVal) {
+	long time = get_time_usec();
+	int ret = zc.compare_swap(key, seenVal, newVal, queryVal);
+	metrics.zhtOp.add(get_time_usec() - time);
+	metrics.incre(metrics.numZHTOp);
+	return ret;
+}
+
+MetricsSnapshot MatrixScheduler::get_metrics() {
+	MetricsSnapshot snapshot = metrics.snapshot();
+
+	/* the queues are changed by the other threads, take one lock
+	 * at a time so that this never orders the locks */
+	wqMutex.lock();
+	long numWait = waitQueue.size();
+	wqMutex.unlock();
+	lqMutex.lock();
+	long numLocal = localQueue.size();
+	lqMutex.unlock();
+	wsqMutex.lock();
+	long numWs = wsQueue.size();
+	wsqMutex.unlock();
+	numIdleCoreMutex.lock();
+	int numIdle = numIdleCore;
+	numIdleCoreMutex.unlock();
+
+	snapshot.set("numtaskwait", numWait);
+	snapshot.set("numtaskready", numLocal + numWs);
+	snapshot.set("numlocalqueue", numLocal);
+	snapshot.set("numwsqueue", numWs);
+	snapshot.set("numidlecore", numIdle);
+	snapshot.set("numallcore", config->numCorePerExecutor);
+
+	return snapshot;
+}
+
 CmpQueueItem::CmpQueueItem(const string &taskId, const string &key,
 		long dataSize) {
 	this->taskId = taskId;
@@ -9,6 +9,10 @@
 #define SCHEDULER_STUB_H_
 
 #include "matrix_tcp_proxy_stub.h"
+#include "task_trace.h"
+#include "scheduler_metrics.h"
+#include "ready_queue.h"
+#include "steal_policy.h"
 #include <queue>
 
 class CmpQueueItem
@@ -55,11 +59,8 @@ class MatrixScheduler: public Peer
 
 		void fork_es_thread();	// fork epoll server thread
 
-		void reset_choosebm();	// reset the bitmap of neighbors chosen
-
-		void choose_neigh();	// choose candidate neighbors to steal tasks
-
-		/* find the neighbor with the maximum load */
+		/* query the load of the neighbors chosen
+		 * for this attempt by the steal policy */
 		void find_most_loaded_neigh();
 
 		/* try to steal tasks from the most-loaded neighbor */
@@ -75,7 +76,7 @@ class MatrixScheduler: public Peer
 
 		void fork_crt_thread();	// fork check ready task thread
 
-		void exec_a_task(TaskMsg&);	// execute a task
+		void exec_a_task(TaskMsg&, long);	// execute a task ready since a time
 
 		void fork_exec_task_thread();	// fork execute task threads
 
@@ -88,10 +89,20 @@ class MatrixScheduler: public Peer
 		/* fork recording status thread */
 		void fork_record_stat_thread();
 
-		void fork_record_task_thread();
+		void fork_record_task_thread();	// fork the task trace writer thread
 
 		void fork_localQueue_monitor_thread();
 
+		/* ZHT lookup and compare and swap on the scheduling
+		 * path, timed into the zhtOp latency histogram */
+		int zht_lookup(const string &key, string &result);
+		int zht_cas(const string &key, const string &seenVal,
+				const string &newVal, string &queryVal);
+
+		/* the live metrics of this scheduler, including the
+		 * current queue lengths and number of idle cores */
+		MetricsSnapshot get_metrics();
+
 		Mutex ZHTMsgCountMutex;	// Mutex of ZHT message count
 		Mutex numIdleCoreMutex;	// Mutex of number of idle cores
 		Mutex numTaskFinMutex;	// Mutex of number of tasks done
@@ -104,12 +115,7 @@ class MatrixScheduler: public Peer
 		long numWS;	// number of work stealing operations
 		long numWSFail;	// number of failed work stealing operations
 
-		bool *chooseBitMap;	// bitmap of neighbors chosen
-		int numNeigh;	// number of neighbors
-		int *neighIdx;	// the indeces of all chosen neighbors
-		int maxLoadedIdx;	// the neighbor index with the maximum load
-		long maxLoad;	// the maximum load of all the neighbors
-		long pollInterval;	// the work stealing polling interval
+		StealPolicy stealPolicy;	// same policy as the simulator
 		bool startWS;
 
 		Mutex wqMutex;	// Mutex of waiting queue
@@ -118,11 +124,10 @@ class MatrixScheduler: public Peer
 		Mutex lqMutex;
 		Mutex wsqMutex;
 		Mutex ldMutex;
-		Mutex tteMutex;
 
-		priority_queue<TaskMsg, vector<TaskMsg>, HighPriorityByDataSize> localQueue;
+		ReadyQueue<TaskMsg> localQueue;	// tasks to run here for data locality
 
-		priority_queue<TaskMsg, vector<TaskMsg>, HighPriorityByDataSize> wsQueue;
+		ReadyQueue<TaskMsg> wsQueue;	// tasks that can be stolen
 
 		deque<TaskMsg> waitQueue;	// waiting queue
 		//deque<string> readyQueue;	// ready queue
@@ -133,8 +138,9 @@ class MatrixScheduler: public Peer
 
 		ofstream schedulerLogOS;	// scheduler log output stream
 
-		ofstream taskLogOS;
-		vector<string> taskTimeEntry;
+		TaskTracer *taskTracer;	// binary per-task event trace
+
+		SchedulerMetrics metrics;	// served with "query metrics"
 
 		timespec start, end;
 };
@@ -0,0 +1,41 @@
+/*
+ * simulator.cpp
+ *
+ * runs a whole MATRIX deployment (schedulers and ZHT servers) as a
+ * discrete event simulation in one process, see simulator_stub.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "simulator_stub.h"
+
+using namespace std;
+
+int main(int argc, char *argv[]) {
+	/* the MATRIX configuration file gives the workload and the
+	 * scheduling parameters, the simulation configuration file
+	 * gives the number of schedulers and the simulated costs */
+	if (argc != 3) {
+		fprintf(stderr, "The usage is: simulator\tconfiguration_file"
+				"\tsimulation_configuration_file!\n");
+		exit(-1);
+	}
+
+	string configFileStr(argv[1]);
+	string simConfigFileStr(argv[2]);
+	MatrixSimulator *msim = new MatrixSimulator(configFileStr,
+			simConfigFileStr);
+
+	bool done = msim->run();
+
+	msim->report();
+
+	if (!done) {
+		fprintf(stderr, "The simulation stalled before all "
+				"the tasks were done!\n");
+	}
+
+	delete msim;
+
+	return done ? 0 : 1;
+}
@@ -0,0 +1,663 @@
+/*
+ * simulator_stub.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "simulator_stub.h"
+#include "util.h"
+#include <math.h>
+#include <algorithm>
+
+/* the value of a key in a configuration map, or the default */
+static string sim_config_value(map<string, string> &configMap,
+		const string &key, const string &defaultValue) {
+	map<string, string>::iterator it = configMap.find(key);
+	return it == configMap.end() ? defaultValue : it->second;
+}
+
+SimConfiguration::SimConfiguration(const string &configFile) {
+	parse_config(configFile);
+}
+
+SimConfiguration::~SimConfiguration() {
+
+}
+
+void SimConfiguration::parse_config(const string &configFile) {
+	map<string, string> configMap;
+	fstream fileStream(configFile.c_str());
+
+	if (fileStream.good()) {
+		string line, key, value;
+
+		while (getline(fileStream, line)) {
+			stringstream ss(line);
+			ss >> key >> value;
+			if (!key.empty() && key[0] != '#')
+				configMap.insert(make_pair(key, value));
+			key.clear();
+			value.clear();
+		}
+
+		fileStream.close();
+	}
+
+	numScheduler = str_to_num<int>(
+			sim_config_value(configMap, "NumScheduler", "64"));
+
+	taskLength = str_to_num<long>(
+			sim_config_value(configMap, "TaskLength", "10000"));
+
+	taskLengthDist = sim_config_value(configMap, "TaskLengthDist", "constant");
+
+	zhtLatency = str_to_num<long>(
+			sim_config_value(configMap, "ZhtLatency", "200"));
+
+	netLatency = str_to_num<long>(
+			sim_config_value(configMap, "NetLatency", "100"));
+
+	netBandwidth = str_to_num<long>(
+			sim_config_value(configMap, "NetBandwidth", "100"));
+
+	taskOutputSize = str_to_num<long>(
+			sim_config_value(configMap, "TaskOutputSize", "0"));
+
+	seed = str_to_num<unsigned long>(
+			sim_config_value(configMap, "RandomSeed", "0"));
+}
+
+SimZHT::SimZHT(int numServer) {
+	numMsg.assign(numServer, 0);
+	numCasRetry = 0;
+}
+
+SimZHT::~SimZHT() {
+
+}
+
+/* spread the task indices over the servers as
+ * the hashing of the task ids by ZHT would */
+int SimZHT::server_of(long key) {
+	unsigned long h = (unsigned long) key + 0x9e3779b97f4a7c15UL;
+	h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9UL;
+	h = (h ^ (h >> 27)) * 0x94d049bb133111ebUL;
+	h ^= h >> 31;
+	return (int) (h % numMsg.size());
+}
+
+void SimZHT::count(long key, long numMsg) {
+	this->numMsg[server_of(key)] += numMsg;
+}
+
+long SimZHT::num_msg() {
+	long num = 0;
+	for (int i = 0; i < numMsg.size(); i++) {
+		num += numMsg.at(i);
+	}
+	return num;
+}
+
+SimScheduler::SimScheduler(int index, int numCore, int numSche,
+		long pollStart, long pollUb, unsigned long seed, long agingInterval) :
+		stealPolicy(numSche, index, pollStart, pollUb, seed),
+		localQueue(agingInterval), wsQueue(agingInterval) {
+	this->index = index;
+	this->numIdleCore = numCore;
+	wsPending = false;
+	wsDone = false;
+	esFreeAt = 0;
+	crtFreeAt = 0;
+	cctFreeAt = 0;
+	wsStart = 0;
+}
+
+SimScheduler::~SimScheduler() {
+
+}
+
+long SimScheduler::num_ready() {
+	return localQueue.size() + wsQueue.size();
+}
+
+MatrixSimulator::MatrixSimulator(const string &configFile,
+		const string &simConfigFile) {
+	config = new Configuration(configFile);
+	simConfig = new SimConfiguration(simConfigFile);
+
+	int numSche = simConfig->numScheduler;
+
+	/* same as the real scheduler, no work stealing with one scheduler */
+	if (numSche == 1) {
+		config->workStealingOn = 0;
+	}
+
+	cache = false;
+#ifdef DATA_CACHE
+	cache = true;
+#endif
+
+	randState = simConfig->seed;
+	seq = 0;
+	now = 0;
+	numBatch = 0;
+	numTaskFin = 0;
+	numEvent = 0;
+	sumTaskLength = 0;
+	makespan = 0;
+
+	zht = new SimZHT(numSche);
+	for (int i = 0; i < numSche; i++) {
+		schedulers.push_back(new SimScheduler(i, config->numCorePerExecutor,
+				numSche, config->wsPollIntervalStart, config->wsPollIntervalUb,
+				simConfig->seed, config->agingInterval));
+	}
+
+	dagGen = new DagGenerator(config->dagType, config->dagArg,
+			config->numTaskPerClient, config->numMapTask,
+			config->numReduceTask, simConfig->seed);
+	numTask = dagGen->num_task();
+
+	CompactDag dag;
+	dag.build(*dagGen);
+	dag.critical_path(criticalPath);
+
+	tasks.resize(numTask);
+	DagTask dagTask;
+	for (long i = 0; i < numTask; i++) {
+		dagGen->get_task(i, dagTask);
+		SimTask &task = tasks.at(i);
+		task.indegree = dagTask.indegree;
+		task.length = gen_task_length();
+		task.allDataSize = 0;
+		task.maxDataSize = -1000000;
+		task.maxDataSche = -1;
+		task.maxDataTask = -1;
+		task.sche = -1;
+		task.state = ST_UNSUBMITTED;
+		task.readyTime = 0;
+		task.lastWrite = 0;
+	}
+}
+
+MatrixSimulator::~MatrixSimulator() {
+	for (int i = 0; i < schedulers.size(); i++) {
+		delete schedulers.at(i);
+	}
+	delete dagGen;
+	delete zht;
+	delete simConfig;
+	delete config;
+}
+
+/* splitmix64, so that runs are reproducible given the seed */
+unsigned long MatrixSimulator::next_rand() {
+	unsigned long z = (randState += 0x9e3779b97f4a7c15UL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9UL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebUL;
+	return z ^ (z >> 31);
+}
+
+long MatrixSimulator::gen_task_length() {
+	long mean = simConfig->taskLength;
+
+	if (simConfig->taskLengthDist.compare("uniform") == 0) {
+		return (long) (next_rand() % (unsigned long) (2 * mean + 1));
+	} else if (simConfig->taskLengthDist.compare("exponential") == 0) {
+		double u = (double) (next_rand() >> 11) / (double) (1UL << 53);
+		return (long) (-log(1.0 - u) * mean);
+	}
+
+	return mean;
+}
+
+void MatrixSimulator::post(long time, int type, int sche, long task, long arg) {
+	SimEvent event;
+	event.time = time;
+	event.seq = seq++;
+	event.type = type;
+	event.sche = sche;
+	event.task = task;
+	event.arg = arg;
+	events.push(event);
+}
+
+/* the client inserts the metadata of all the tasks to ZHT and
+ * then submits them package by package, either interleaved over
+ * all the schedulers (best case) or all to one (worst case)
+ * */
+void MatrixSimulator::submit_task() {
+	int numSche = schedulers.size();
+	vector<vector<long> > taskVec(numSche);
+
+	for (long i = 0; i < numTask; i++) {
+		zht->count(i);
+	}
+
+	if (config->submitMode.compare("worstcase") == 0) {
+		int scheIdx = next_rand() % numSche;
+		for (long i = 0; i < numTask; i++) {
+			taskVec[scheIdx].push_back(i);
+		}
+	} else {
+		for (long i = 0; i < numTask; i++) {
+			taskVec[i % numSche].push_back(i);
+		}
+	}
+
+	long clientTime = 0;
+	for (int i = 0; i < numSche; i++) {
+		for (long j = 0; j < taskVec[i].size(); j += config->maxTaskPerPkg) {
+			long end = j + config->maxTaskPerPkg;
+			if (end > taskVec[i].size()) {
+				end = taskVec[i].size();
+			}
+			batches[numBatch] = vector<long>(taskVec[i].begin() + j,
+					taskVec[i].begin() + end);
+			clientTime += simConfig->netLatency;
+			post(clientTime, SE_SUBMIT, i, numBatch++);
+		}
+	}
+}
+
+/* recv_task_from_client: the epoll server thread looks up every task
+ * of the package, puts them in the wait queue, and updates the "num
+ * tasks recv" counter with a lookup and a compare and swap
+ * */
+void MatrixSimulator::submit(const SimEvent &event) {
+	SimScheduler &ms = *schedulers.at(event.sche);
+	vector<long> &batch = batches[event.task];
+	long zl = simConfig->zhtLatency;
+
+	long done = max(event.time, ms.esFreeAt);
+	for (long i = 0; i < batch.size(); i++) {
+		zht->count(batch.at(i));
+		done += zl;
+	}
+	ms.esFreeAt = done + 2 * zl;
+	zht->count(-1, 2);
+	ms.metrics.incre(ms.metrics.numTaskRecv, batch.size());
+
+	for (long i = 0; i < batch.size(); i++) {
+		SimTask &task = tasks.at(batch.at(i));
+		task.sche = ms.index;
+		task.state = ST_CHECKING;
+		post(done, SE_READY_CHECK, ms.index, batch.at(i));
+	}
+
+	batches.erase(event.task);
+}
+
+/* the checking ready task thread looks up the indegree of a task;
+ * the real thread keeps polling the tasks that are not ready, here
+ * they are only checked again when their indegree drops to 0, so
+ * the ZHT message count of DAG workloads is a lower bound
+ * */
+void MatrixSimulator::ready_check(const SimEvent &event) {
+	SimScheduler &ms = *schedulers.at(event.sche);
+
+	ms.crtFreeAt = max(event.time, ms.crtFreeAt) + simConfig->zhtLatency;
+	zht->count(event.task);
+	post(ms.crtFreeAt, SE_READY_DONE, ms.index, event.task);
+}
+
+void MatrixSimulator::ready_done(const SimEvent &event) {
+	SimScheduler &ms = *schedulers.at(event.sche);
+	SimTask &task = tasks.at(event.task);
+
+	if (task.indegree == 0) {
+		task_ready_process(ms, event.task, event.time);
+		exec_task(ms, event.time);
+	} else {
+		task.state = ST_WAITING;
+	}
+}
+
+/* same decisions as MatrixScheduler::task_ready_process: tasks with
+ * little input data go to the work stealing queue, the others run
+ * where their biggest piece of input data is, being pushed there
+ * if that is another scheduler
+ * */
+void MatrixSimulator::task_ready_process(SimScheduler &ms, long taskIdx,
+		long time) {
+	SimTask &task = tasks.at(taskIdx);
+
+	if (task.allDataSize <= config->dataSizeThreshold) {
+		enqueue_ready(ms, taskIdx, false, time);
+	} else if (task.maxDataSche == ms.index || (cache && ms.cache.count(
+			task.maxDataTask) > 0)) {
+		enqueue_ready(ms, taskIdx, true, time);
+	} else {
+		ms.crtFreeAt = max(time, ms.crtFreeAt) + 2 * simConfig->netLatency;
+		post(time + simConfig->netLatency, SE_PUSH_RECV, task.maxDataSche,
+				taskIdx);
+	}
+}
+
+void MatrixSimulator::enqueue_ready(SimScheduler &ms, long taskIdx,
+		bool local, long time) {
+	SimTask &task = tasks.at(taskIdx);
+
+	task.sche = ms.index;
+	task.state = ST_READY;
+	task.readyTime = time;
+
+	ReadyAttr attr;
+	attr.user = "sim";
+	attr.dag = "0";
+	attr.priority = criticalPath.at(taskIdx);
+	attr.deadline = 0;
+	attr.time = time;
+
+	if (local) {
+		ms.localQueue.push(taskIdx, attr);
+	} else {
+		ms.wsQueue.push(taskIdx, attr);
+	}
+}
+
+/* the executing threads: run ready tasks on the idle cores, local
+ * queue first. A task looks up its metadata, fetches the input data
+ * it has neither produced nor cached, and runs for its length.
+ * */
+void MatrixSimulator::exec_task(SimScheduler &ms, long time) {
+	while (ms.numIdleCore > 0 && ms.num_ready() > 0) {
+		long taskIdx;
+		if (!ms.localQueue.empty()) {
+			taskIdx = ms.localQueue.pop(time);
+		} else {
+			taskIdx = ms.wsQueue.pop(time);
+		}
+
+		SimTask &task = tasks.at(taskIdx);
+		ms.numIdleCore--;
+		task.state = ST_RUNNING;
+		ms.metrics.queueWait.add(time - task.readyTime);
+
+		long startTime = time + simConfig->zhtLatency;
+		zht->count(taskIdx);
+
+		long length = 0;
+		for (int i = 0; i < task.parents.size(); i++) {
+			if (task.parents.at(i).first == ms.index || (cache
+					&& ms.cache.count(task.parents.at(i).second) > 0)) {
+				continue;
+			}
+			length += 2 * simConfig->netLatency + simConfig->taskOutputSize
+					/ max(simConfig->netBandwidth, 1L);
+			if (cache) {
+				ms.cache.insert(task.parents.at(i).second);
+			}
+		}
+		length += task.length;
+
+		ms.metrics.exec.add(length);
+		post(startTime + length, SE_FIN, ms.index, taskIdx);
+	}
+
+	if (ms.num_ready() == 0) {
+		start_ws(ms, time);
+	}
+}
+
+/* a task is done: free the core, and let the checking complete task
+ * thread notify the children, a lookup and a compare and swap per
+ * child, the compare and swap is retried if another scheduler has
+ * updated the child since the lookup
+ * */
+void MatrixSimulator::fin_task(const SimEvent &event) {
+	SimScheduler &ms = *schedulers.at(event.sche);
+	SimTask &task = tasks.at(event.task);
+	long zl = simConfig->zhtLatency;
+
+	ms.numIdleCore++;
+	task.state = ST_DONE;
+	ms.metrics.incre(ms.metrics.numTaskFin);
+	numTaskFin++;
+	sumTaskLength += task.length;
+	makespan = event.time;
+
+	long time = max(event.time, ms.cctFreeAt) + zl;
+	zht->count(event.task);
+
+	DagTask dagTask;
+	dagGen->get_task(event.task, dagTask);
+	for (long i = 0; i < dagTask.children.size(); i++) {
+		long child = dagTask.children.at(i);
+		SimTask &childTask = tasks.at(child);
+		long lookupTime = time + zl;
+		long casTime = lookupTime + zl;
+		zht->count(child, 2);
+		while (childTask.lastWrite > lookupTime) {
+			lookupTime = casTime;
+			casTime += zl;
+			zht->count(child);
+			zht->numCasRetry++;
+		}
+		childTask.lastWrite = casTime;
+		post(casTime, SE_CHILD_NOTIFY, ms.index, child, event.task);
+		time = casTime;
+	}
+	ms.cctFreeAt = time;
+
+	exec_task(ms, event.time);
+}
+
+void MatrixSimulator::child_notify(const SimEvent &event) {
+	SimTask &task = tasks.at(event.task);
+
+	task.indegree--;
+	if (simConfig->taskOutputSize > 0) {
+		task.allDataSize += simConfig->taskOutputSize;
+		task.parents.push_back(make_pair(event.sche, event.arg));
+		if (simConfig->taskOutputSize > task.maxDataSize) {
+			task.maxDataSize = simConfig->taskOutputSize;
+			task.maxDataSche = event.sche;
+			task.maxDataTask = event.arg;
+		}
+	}
+
+	if (task.indegree == 0 && task.state == ST_WAITING) {
+		task.state = ST_CHECKING;
+		post(event.time, SE_READY_CHECK, task.sche, event.task);
+	}
+}
+
+/* the work stealing thread notices an empty ready queue
+ * within one initial poll interval */
+void MatrixSimulator::start_ws(SimScheduler &ms, long time) {
+	if (config->workStealingOn != 1 || ms.wsDone || ms.wsPending) {
+		return;
+	}
+
+	ms.wsPending = true;
+	post(time + config->wsPollIntervalStart, SE_STEAL, ms.index, -1);
+}
+
+/* one attempt: query the load of sqrt(N) random neighbors one by
+ * one, and ask the most loaded one for half of its ready tasks
+ * */
+void MatrixSimulator::steal(const SimEvent &event) {
+	SimScheduler &ms = *schedulers.at(event.sche);
+
+	if (ms.num_ready() > 0) {
+		ms.wsPending = false;
+		ms.stealPolicy.reset();
+		return;
+	}
+
+	ms.metrics.incre(ms.metrics.numWS);
+	ms.wsStart = event.time;
+
+	const vector<int> &neighIdx = ms.stealPolicy.choose_neigh();
+	for (int i = 0; i < neighIdx.size(); i++) {
+		ms.stealPolicy.offer_load(neighIdx[i],
+				schedulers.at(neighIdx[i])->wsQueue.size());
+	}
+
+	long time = event.time + neighIdx.size() * 2 * simConfig->netLatency;
+	int victim = ms.stealPolicy.victim();
+	if (victim < 0) {
+		ws_fail(ms, time);
+	} else {
+		post(time + simConfig->netLatency, SE_STEAL_TAKE, ms.index, -1,
+				victim);
+	}
+}
+
+/* sleep the poll interval and double it, the work stealing thread
+ * quits once the poll interval reaches the upper bound */
+void MatrixSimulator::ws_fail(SimScheduler &ms, long time) {
+	ms.metrics.incre(ms.metrics.numWSFail);
+	ms.metrics.stealRtt.add(time - ms.wsStart);
+
+	long next = time + ms.stealPolicy.fail();
+	if (ms.stealPolicy.stopped()) {
+		ms.wsPending = false;
+		ms.wsDone = true;
+	} else {
+		post(next, SE_STEAL, ms.index, -1);
+	}
+}
+
+/* send_task: the victim sends half of its work stealing queue */
+void MatrixSimulator::steal_take(const SimEvent &event) {
+	SimScheduler &ms = *schedulers.at(event.sche);
+	SimScheduler &victim = *schedulers.at(event.arg);
+	long numTaskToSend = StealPolicy::num_task_to_send(victim.wsQueue.size());
+
+	if (numTaskToSend == 0) {
+		ws_fail(ms, event.time + simConfig->netLatency);
+		return;
+	}
+
+	vector<long> &batch = batches[numBatch];
+	for (long i = 0; i < numTaskToSend; i++) {
+		batch.push_back(victim.wsQueue.pop(event.time));
+	}
+	victim.metrics.incre(victim.metrics.numTaskStolen, numTaskToSend);
+
+	post(event.time + simConfig->netLatency, SE_STEAL_RECV, ms.index,
+			numBatch++);
+}
+
+void MatrixSimulator::steal_recv(const SimEvent &event) {
+	SimScheduler &ms = *schedulers.at(event.sche);
+	vector<long> &batch = batches[event.task];
+
+	for (long i = 0; i < batch.size(); i++) {
+		enqueue_ready(ms, batch.at(i), false, event.time);
+	}
+	ms.metrics.incre(ms.metrics.numTaskSteal, batch.size());
+	ms.metrics.stealRtt.add(event.time - ms.wsStart);
+	batches.erase(event.task);
+
+	ms.wsPending = false;
+	ms.stealPolicy.reset();
+	exec_task(ms, event.time);
+}
+
+bool MatrixSimulator::run() {
+	submit_task();
+
+	for (int i = 0; i < schedulers.size(); i++) {
+		start_ws(*schedulers.at(i), 0);
+	}
+
+	while (numTaskFin < numTask && !events.empty()) {
+		SimEvent event = events.top();
+		events.pop();
+		now = event.time;
+		numEvent++;
+
+		switch (event.type) {
+		case SE_SUBMIT:
+			submit(event);
+			break;
+		case SE_READY_CHECK:
+			ready_check(event);
+			break;
+		case SE_READY_DONE:
+			ready_done(event);
+			break;
+		case SE_PUSH_RECV:
+			schedulers.at(event.sche)->metrics.incre(
+					schedulers.at(event.sche)->metrics.numTaskPushed);
+			enqueue_ready(*schedulers.at(event.sche), event.task, true,
+					event.time);
+			exec_task(*schedulers.at(event.sche), event.time);
+			break;
+		case SE_FIN:
+			fin_task(event);
+			break;
+		case SE_CHILD_NOTIFY:
+			child_notify(event);
+			break;
+		case SE_STEAL:
+			steal(event);
+			break;
+		case SE_STEAL_TAKE:
+			steal_take(event);
+			break;
+		case SE_STEAL_RECV:
+			steal_recv(event);
+			break;
+		}
+	}
+
+	return numTaskFin == numTask;
+}
+
+void MatrixSimulator::report() {
+	int numSche = schedulers.size();
+	long numAllCore = (long) numSche * config->numCorePerExecutor;
+	MetricsSnapshot cluster;
+	long minTaskFin = numTask, maxTaskFin = 0;
+
+	for (int i = 0; i < numSche; i++) {
+		MetricsSnapshot snapshot = schedulers.at(i)->metrics.snapshot();
+		cluster.merge(snapshot);
+		minTaskFin = min(minTaskFin, snapshot.get("numtaskfin"));
+		maxTaskFin = max(maxTaskFin, snapshot.get("numtaskfin"));
+	}
+
+	long maxZHTMsg = 0;
+	for (int i = 0; i < numSche; i++) {
+		maxZHTMsg = max(maxZHTMsg, zht->numMsg.at(i));
+	}
+
+	long numWS = cluster.get("numworksteal");
+	long numWSFail = cluster.get("numworkstealfail");
+	double sec = makespan / 1E6;
+
+	cout << "NumScheduler\t" << numSche << endl;
+	cout << "NumAllCore\t" << numAllCore << endl;
+	cout << "DagType\t" << config->dagType << endl;
+	cout << "NumTask\t" << numTask << endl;
+	cout << "NumTaskFin\t" << numTaskFin << endl;
+	cout << "NumEvent\t" << numEvent << endl;
+	cout << "Makespan(us)\t" << makespan << endl;
+	cout << "Throughput(task/sec)\t" << (sec > 0 ? numTaskFin / sec : 0.0)
+			<< endl;
+	cout << "Utilization\t" << (makespan > 0 ? (double) sumTaskLength
+			/ ((double) makespan * numAllCore) : 0.0) << endl;
+	cout << "MinTaskFinPerScheduler\t" << minTaskFin << endl;
+	cout << "MaxTaskFinPerScheduler\t" << maxTaskFin << endl;
+	cout << "NumWorkSteal\t" << numWS << endl;
+	cout << "NumWorkStealFail\t" << numWSFail << endl;
+	cout << "StealEfficiency\t" << (numWS > 0 ? (double) (numWS - numWSFail)
+			/ numWS : 0.0) << endl;
+	cout << "NumTaskSteal\t" << cluster.get("numtasksteal") << endl;
+	cout << "NumTaskPushed\t" << cluster.get("numtaskpushed") << endl;
+	cout << "NumZHTMsg\t" << zht->num_msg() << endl;
+	cout << "NumZHTMsgPerTask\t" << (numTask > 0 ? (double) zht->num_msg()
+			/ numTask : 0.0) << endl;
+	cout << "MaxZHTMsgPerServer\t" << maxZHTMsg << endl;
+	cout << "NumZHTCasRetry\t" << zht->numCasRetry << endl;
+	cout << "QueueWaitP50(us)\t" << cluster.percentile("queuewait", 0.5)
+			<< endl;
+	cout << "QueueWaitP99(us)\t" << cluster.percentile("queuewait", 0.99)
+			<< endl;
+	cout << "StealRttP99(us)\t" << cluster.percentile("stealrtt", 0.99)
+			<< endl;
+}
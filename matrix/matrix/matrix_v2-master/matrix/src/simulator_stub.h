@@ -0,0 +1,207 @@
+/*
+ * simulator_stub.h
+ *
+ * discrete event simulation of a whole MATRIX deployment in one
+ * process: N schedulers and N ZHT servers, with the scheduling
+ * policies of MatrixScheduler (ready checking, data aware task
+ * placement, random neighbor work stealing with exponential back
+ * off) replayed on a virtual clock. The ready queues and the work
+ * stealing policy are the same classes the scheduler runs, only the
+ * threads and messages around them are simulated. Task executions
+ * and network and ZHT operations take simulated time, so scaling
+ * studies with thousands of schedulers run on a single machine in
+ * seconds.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SIMULATOR_STUB_H_
+#define SIMULATOR_STUB_H_
+
+#include "config.h"
+#include "dag.h"
+#include "scheduler_metrics.h"
+#include "ready_queue.h"
+#include "steal_policy.h"
+#include <queue>
+#include <deque>
+#include <set>
+
+/* the simulation parameters, every key is optional */
+class SimConfiguration
+{
+	public:
+		SimConfiguration(const string&);
+		virtual ~SimConfiguration();
+
+		void parse_config(const string&);
+
+		int numScheduler;	// number of simulated schedulers and ZHT servers
+		long taskLength;	// mean task length in micro-second
+		string taskLengthDist;	// constant, uniform or exponential
+		long zhtLatency;	// one ZHT operation in micro-second
+		long netLatency;	// one way scheduler to scheduler message
+		long netBandwidth;	// bytes per micro-second for data transfers
+		long taskOutputSize;	// bytes of output data of every task
+		unsigned long seed;	// seed of the random number generator
+};
+
+/* the events of the simulation */
+enum SimEventType
+{
+	SE_SUBMIT = 0,	// a package of tasks arrives from the client
+	SE_READY_CHECK,	// a task is put in the wait queue
+	SE_READY_DONE,	// the ZHT lookup of a ready check is back
+	SE_PUSH_RECV,	// a task pushed for data locality arrives
+	SE_FIN,	// a task is done
+	SE_CHILD_NOTIFY,	// the indegree of a child is decreased in ZHT
+	SE_STEAL,	// a work stealing attempt starts
+	SE_STEAL_TAKE,	// the victim hands over half of its tasks
+	SE_STEAL_RECV	// the stolen tasks arrive at the thief
+};
+
+struct SimEvent
+{
+	long time;	// virtual time in micro-second
+	long seq;	// keeps events of the same time in FIFO order
+	int type;	// SimEventType
+	int sche;	// the scheduler the event happens at
+	long task;	// task index, or batch index for package events
+	long arg;	// event dependent argument
+
+	bool operator>(const SimEvent &other) const
+	{
+		return time > other.time || (time == other.time && seq > other.seq);
+	}
+};
+
+/* task states in the simulation */
+enum SimTaskState
+{
+	ST_UNSUBMITTED = 0, ST_CHECKING, ST_WAITING, ST_READY, ST_RUNNING, ST_DONE
+};
+
+/* the ZHT metadata and the simulation state of a task */
+struct SimTask
+{
+	long indegree;	// number of parents not done yet
+	long length;	// simulated execution time
+	long allDataSize;	// bytes of data produced by all parents
+	long maxDataSize;	// the biggest piece of data of one parent
+	int maxDataSche;	// the scheduler holding the biggest piece
+	long maxDataTask;	// the parent that produced the biggest piece
+	int sche;	// the scheduler the task is queued at or ran at
+	int state;	// SimTaskState
+	long readyTime;	// when the task was put in a ready queue
+	long lastWrite;	// the last time the ZHT record was updated
+	vector<pair<int, long> > parents;	// (scheduler, parent) with data
+};
+
+/* the ZHT servers, only the message counts are kept, the
+ * metadata lives in the SimTask records */
+class SimZHT
+{
+	public:
+		SimZHT(int numServer);
+		virtual ~SimZHT();
+
+		int server_of(long key);	// the server a key is hashed to
+
+		void count(long key, long numMsg = 1);
+
+		long num_msg();
+
+		vector<long> numMsg;	// messages handled by every server
+		long numCasRetry;	// failed compare and swaps
+};
+
+/* the state of one simulated scheduler, every thread of the real
+ * scheduler that serializes work is a "free at" time stamp */
+class SimScheduler
+{
+	public:
+		SimScheduler(int index, int numCore, int numSche, long pollStart,
+				long pollUb, unsigned long seed, long agingInterval);
+		virtual ~SimScheduler();
+
+		long num_ready();
+
+		int index;
+		int numIdleCore;
+		bool wsPending;	// a work stealing attempt is scheduled
+		bool wsDone;	// the poll interval reached the upper bound
+
+		long esFreeAt;	// epoll server thread
+		long crtFreeAt;	// checking ready task thread
+		long cctFreeAt;	// checking complete task thread
+		long wsStart;	// start of the current stealing attempt
+
+		StealPolicy stealPolicy;	// same policies as the real scheduler
+		ReadyQueue<long> localQueue;
+		ReadyQueue<long> wsQueue;
+		set<long> cache;	// parents whose data is cached
+
+		SchedulerMetrics metrics;
+};
+
+class MatrixSimulator
+{
+	public:
+		MatrixSimulator(const string &configFile, const string &simConfigFile);
+		virtual ~MatrixSimulator();
+
+		/* run until all the tasks are done, false if the
+		 * simulation stalls before all the tasks are done */
+		bool run();
+
+		void report();	// print the results of a run
+
+		Configuration *config;
+		SimConfiguration *simConfig;
+
+	private:
+		void submit_task();	// client submission of all the tasks
+
+		void post(long time, int type, int sche, long task, long arg = 0);
+
+		unsigned long next_rand();
+		long gen_task_length();
+
+		void ready_check(const SimEvent&);
+		void ready_done(const SimEvent&);
+		void task_ready_process(SimScheduler&, long task, long time);
+		void enqueue_ready(SimScheduler&, long task, bool local, long time);
+		void exec_task(SimScheduler&, long time);
+		void ws_fail(SimScheduler&, long time);
+		void fin_task(const SimEvent&);
+		void child_notify(const SimEvent&);
+		void start_ws(SimScheduler&, long time);
+		void submit(const SimEvent&);
+		void steal(const SimEvent&);
+		void steal_take(const SimEvent&);
+		void steal_recv(const SimEvent&);
+
+		DagGenerator *dagGen;
+		SimZHT *zht;
+		vector<SimScheduler*> schedulers;
+		vector<SimTask> tasks;
+		vector<long> criticalPath;	// priority of every task
+
+		priority_queue<SimEvent, vector<SimEvent>, greater<SimEvent> > events;
+		long seq;
+		long now;
+
+		map<long, vector<long> > batches;	// tasks of package events
+		long numBatch;
+
+		bool cache;
+		unsigned long randState;
+
+		long numTask;
+		long numTaskFin;
+		long numEvent;
+		long sumTaskLength;
+		long makespan;
+};
+
+#endif /* SIMULATOR_STUB_H_ */
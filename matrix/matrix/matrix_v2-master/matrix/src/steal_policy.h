@@ -0,0 +1,147 @@
+/*
+ * steal_policy.h
+ *
+ * the work stealing policy of a scheduler, shared by MatrixScheduler
+ * and the simulator so that both make the same decisions: an attempt
+ * queries sqrt(N) distinct random neighbors, steals from the most
+ * loaded one, and the victim hands over half of its work stealing
+ * queue. A failed attempt sleeps the poll interval and doubles it,
+ * stealing stops once the interval reaches the upper bound.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef STEAL_POLICY_H_
+#define STEAL_POLICY_H_
+
+#include <vector>
+#include <math.h>
+
+using namespace std;
+
+class StealPolicy
+{
+	public:
+		StealPolicy(int numSche, int self, long pollStart, long pollUb,
+				unsigned long seed)
+		{
+			this->numSche = numSche;
+			this->self = self;
+			this->pollStart = pollStart;
+			this->pollUb = pollUb;
+			pollInterval = pollStart;
+			randState = seed * 0x9E3779B97F4A7C15ULL + self + 1;
+			if (randState == 0) {
+				randState = 1;
+			}
+
+			/* number of neighbors is equal to the
+			 * squared root of all number of schedulers */
+			numNeigh = (int) (sqrt(numSche) + 0.5);
+			if (numNeigh > numSche - 1) {
+				numNeigh = numSche - 1;
+			}
+			chosen.assign(numSche, false);
+			maxLoadedIdx = -1;
+			maxLoad = -1000000;
+		}
+
+		int num_neigh() const
+		{
+			return numNeigh;
+		}
+
+		/* randomly choose the distinct neighbors of a new attempt */
+		const vector<int>& choose_neigh()
+		{
+			neighIdx.clear();
+			for (int i = 0; i < numNeigh; i++) {
+				int idx = next_rand() % numSche;
+				while (idx == self || chosen[idx]) {
+					idx = next_rand() % numSche;
+				}
+				neighIdx.push_back(idx);
+				chosen[idx] = true;
+			}
+			for (int i = 0; i < neighIdx.size(); i++) {
+				chosen[neighIdx[i]] = false;
+			}
+
+			maxLoadedIdx = -1;
+			maxLoad = -1000000;
+			return neighIdx;
+		}
+
+		/* the load a neighbor answered, the most loaded one is kept */
+		void offer_load(int idx, long load)
+		{
+			if (maxLoad < load) {
+				maxLoad = load;
+				maxLoadedIdx = idx;
+			}
+		}
+
+		/* the neighbor to steal from, -1 if none has ready tasks */
+		int victim() const
+		{
+			return maxLoad > 0 ? maxLoadedIdx : -1;
+		}
+
+		/* number of tasks a victim sends, half of its load */
+		static long num_task_to_send(long load)
+		{
+			return load / 2;
+		}
+
+		long poll_interval() const
+		{
+			return pollInterval;
+		}
+
+		/* back to the initial poll interval, after a successful
+		 * attempt or when the scheduler has work again */
+		void reset()
+		{
+			pollInterval = pollStart;
+		}
+
+		/* a failed attempt, returns how long to sleep
+		 * before the next one and doubles the interval */
+		long fail()
+		{
+			long sleepLength = pollInterval;
+			pollInterval *= 2;
+			return sleepLength;
+		}
+
+		/* the poll interval reached the upper bound */
+		bool stopped() const
+		{
+			return pollInterval >= pollUb;
+		}
+
+	private:
+		/* xorshift64*, so that every scheduler has its own stream */
+		unsigned long next_rand()
+		{
+			randState ^= randState >> 12;
+			randState ^= randState << 25;
+			randState ^= randState >> 27;
+			return (unsigned long) ((randState * 2685821657736338717ULL) >> 33);
+		}
+
+		int numSche;
+		int self;
+		int numNeigh;
+		long pollStart;
+		long pollUb;
+		long pollInterval;
+		unsigned long long randState;
+
+		vector<int> neighIdx;	// the neighbors of the current attempt
+		vector<bool> chosen;	// neighbors chosen in the current attempt
+		int maxLoadedIdx;	// the neighbor index with the maximum load
+		long maxLoad;	// the maximum load of all the neighbors
+};
+
+#endif /* STEAL_POLICY_H_ */
@@ -0,0 +1,238 @@
+/*
+ * task_trace.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "task_trace.h"
+#include <string.h>
+#include <unistd.h>
+
+const char *task_event_name[TE_NUM_TYPE] = { "SubmissionTime",
+		"WaitQueueTime", "ReadyQueuedTime", "PushQueuedTime",
+		"WorkStealQueuedTime", "StartTime", "FinTime" };
+
+TaskEventRing::TaskEventRing(unsigned long size, unsigned short thread) {
+	buf = new TaskEvent[size];
+	mask = size - 1;
+	head = 0;
+	tail = 0;
+	numDrop = 0;
+	this->thread = thread;
+}
+
+TaskEventRing::~TaskEventRing() {
+	delete[] buf;
+}
+
+/* only the owning thread pushes, so head can be read plainly;
+ * the release store publishes the record to the writer
+ * */
+bool TaskEventRing::push(const char *taskId, TaskEventType type, long time) {
+	unsigned long curTail = __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+
+	if (head - curTail > mask) {
+		numDrop++;
+		return false;
+	}
+
+	TaskEvent &event = buf[head & mask];
+	event.time = time;
+	event.type = (unsigned short) type;
+	event.thread = thread;
+	size_t len = strnlen(taskId, TASK_TRACE_ID_LEN);
+	memcpy(event.taskId, taskId, len);
+	if (len < TASK_TRACE_ID_LEN) {
+		event.taskId[len] = '\0';
+	}
+
+	__atomic_store_n(&head, head + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+/* write the pending records in at most two contiguous chunks */
+long TaskEventRing::drain(FILE *file) {
+	unsigned long curHead = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+	unsigned long num = curHead - tail;
+
+	if (num == 0) {
+		return 0;
+	}
+
+	unsigned long start = tail & mask;
+	unsigned long first = mask + 1 - start;
+	if (first > num) {
+		first = num;
+	}
+
+	fwrite(buf + start, sizeof(TaskEvent), first, file);
+	if (num > first) {
+		fwrite(buf, sizeof(TaskEvent), num - first, file);
+	}
+
+	__atomic_store_n(&tail, curHead, __ATOMIC_RELEASE);
+	return num;
+}
+
+TaskTracer::TaskTracer(const string &fileName, long flushInterval,
+		unsigned long ringSize) {
+	this->flushInterval = flushInterval;
+	this->ringSize = 1;
+	while (this->ringSize < ringSize) {
+		this->ringSize <<= 1;
+	}
+
+	running = true;
+	writerForked = false;
+	pthread_key_create(&ringKey, NULL);
+	pthread_mutex_init(&ringMutex, NULL);
+
+	traceFile = fopen(fileName.c_str(), "wb");
+	if (traceFile != NULL) {
+		TaskTraceHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, TASK_TRACE_MAGIC, sizeof(header.magic));
+		header.version = TASK_TRACE_VERSION;
+		header.recordSize = sizeof(TaskEvent);
+		fwrite(&header, sizeof(header), 1, traceFile);
+	}
+	traceOpen = traceFile != NULL;
+}
+
+TaskTracer::~TaskTracer() {
+	stop();
+	for (int i = 0; i < rings.size(); i++) {
+		delete rings.at(i);
+	}
+	pthread_key_delete(ringKey);
+	pthread_mutex_destroy(&ringMutex);
+}
+
+bool TaskTracer::is_open() {
+	return traceOpen.load(memory_order_acquire);
+}
+
+/* the ring of the calling thread, created on the first event */
+TaskEventRing* TaskTracer::local_ring() {
+	TaskEventRing *ring = (TaskEventRing*) pthread_getspecific(ringKey);
+
+	if (ring == NULL) {
+		pthread_mutex_lock(&ringMutex);
+		ring = new TaskEventRing(ringSize, (unsigned short) rings.size());
+		rings.push_back(ring);
+		pthread_mutex_unlock(&ringMutex);
+		pthread_setspecific(ringKey, ring);
+	}
+
+	return ring;
+}
+
+/* lock free unless this is the first event of the thread, an event
+ * that races with stop stays in its ring and is never written */
+void TaskTracer::record(const string &taskId, TaskEventType type, long time) {
+	if (!is_open()) {
+		return;
+	}
+	local_ring()->push(taskId.c_str(), type, time);
+}
+
+long TaskTracer::flush() {
+	long num = 0;
+
+	pthread_mutex_lock(&ringMutex);
+	if (traceFile != NULL) {
+		for (int i = 0; i < rings.size(); i++) {
+			num += rings.at(i)->drain(traceFile);
+		}
+		if (num > 0) {
+			fflush(traceFile);
+		}
+	}
+	pthread_mutex_unlock(&ringMutex);
+
+	return num;
+}
+
+long TaskTracer::num_dropped() {
+	long num = 0;
+
+	pthread_mutex_lock(&ringMutex);
+	for (int i = 0; i < rings.size(); i++) {
+		num += rings.at(i)->numDrop;
+	}
+	pthread_mutex_unlock(&ringMutex);
+
+	return num;
+}
+
+/* writer thread function, drains all the rings
+ * every flush interval until the tracer stops
+ * */
+void *writing_trace(void *args) {
+	TaskTracer *tt = (TaskTracer*) args;
+
+	while (tt->running) {
+		tt->flush();
+		usleep(tt->flushInterval);
+	}
+
+	pthread_exit(NULL);
+	return NULL;
+}
+
+void TaskTracer::fork_writer_thread() {
+	if (traceFile == NULL || writerForked) {
+		return;
+	}
+
+	while (pthread_create(&writerThread, NULL, writing_trace, this) != 0) {
+		sleep(1);
+	}
+	writerForked = true;
+}
+
+void TaskTracer::stop() {
+	running = false;
+
+	if (writerForked) {
+		pthread_join(writerThread, NULL);
+		writerForked = false;
+	}
+
+	flush();
+
+	pthread_mutex_lock(&ringMutex);
+	traceOpen.store(false, memory_order_release);
+	if (traceFile != NULL) {
+		fclose(traceFile);
+		traceFile = NULL;
+	}
+	pthread_mutex_unlock(&ringMutex);
+}
+
+FILE* open_trace_file(const string &fileName) {
+	FILE *file = fopen(fileName.c_str(), "rb");
+
+	if (file == NULL) {
+		return NULL;
+	}
+
+	TaskTraceHeader header;
+	if (fread(&header, sizeof(header), 1, file) != 1
+			|| memcmp(header.magic, TASK_TRACE_MAGIC, sizeof(header.magic)) != 0
+			|| header.version != TASK_TRACE_VERSION
+			|| header.recordSize != sizeof(TaskEvent)) {
+		fclose(file);
+		return NULL;
+	}
+
+	return file;
+}
+
+bool read_task_event(FILE *file, TaskEvent &event) {
+	return fread(&event, sizeof(TaskEvent), 1, file) == 1;
+}
+
+string task_event_id(const TaskEvent &event) {
+	return string(event.taskId, strnlen(event.taskId, TASK_TRACE_ID_LEN));
+}
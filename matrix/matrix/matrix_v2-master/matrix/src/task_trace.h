@@ -0,0 +1,137 @@
+/*
+ * task_trace.h
+ *
+ * low overhead binary tracing of task lifecycle events. Every
+ * thread that records events owns a single-producer ring buffer
+ * of fixed-size records, and a background writer thread drains
+ * all the rings into a binary trace file. Use trace_proc to
+ * convert a trace file to the text task log or to Chrome trace
+ * JSON.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef TASK_TRACE_H_
+#define TASK_TRACE_H_
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <pthread.h>
+#include <atomic>
+
+using namespace std;
+
+/* the lifecycle events of a task, the names are
+ * the ones used in the text task log */
+enum TaskEventType
+{
+	TE_SUBMISSION = 0,	// SubmissionTime
+	TE_WAIT_QUEUED,	// WaitQueueTime
+	TE_READY_QUEUED,	// ReadyQueuedTime
+	TE_PUSH_QUEUED,	// PushQueuedTime
+	TE_WS_QUEUED,	// WorkStealQueuedTime
+	TE_START,	// StartTime
+	TE_FIN,	// FinTime
+	TE_NUM_TYPE
+};
+
+extern const char *task_event_name[TE_NUM_TYPE];
+
+#define TASK_TRACE_ID_LEN 20	// longer task ids are truncated
+#define TASK_TRACE_MAGIC "MTXTRACE"
+#define TASK_TRACE_VERSION 1
+
+/* one event as it is stored in memory and in the trace file */
+struct TaskEvent
+{
+	long time;	// time stamp in micro-second
+	unsigned short type;	// TaskEventType
+	unsigned short thread;	// index of the recording thread
+	char taskId[TASK_TRACE_ID_LEN];	// not null terminated if full
+};
+
+/* trace file header, followed by TaskEvent records until the end */
+struct TaskTraceHeader
+{
+	char magic[8];
+	int version;
+	int recordSize;
+};
+
+/* ring buffer written by exactly one thread and read by the
+ * writer thread. Indices only grow, the slot is index & mask.
+ * If the writer falls behind, events are dropped and counted
+ * rather than blocking the recording thread.
+ * */
+class TaskEventRing
+{
+	public:
+		TaskEventRing(unsigned long size, unsigned short thread);
+		virtual ~TaskEventRing();
+
+		bool push(const char *taskId, TaskEventType type, long time);
+
+		/* write all pending events to a file, returns the number */
+		long drain(FILE*);
+
+		long numDrop;
+
+	private:
+		TaskEvent *buf;
+		unsigned long mask;
+		unsigned long head;	// written by the producer
+		unsigned long tail;	// written by the writer
+		unsigned short thread;
+};
+
+class TaskTracer
+{
+	public:
+		/* ringSize is rounded up to a power of two */
+		TaskTracer(const string &fileName, long flushInterval,
+				unsigned long ringSize = 131072);
+		virtual ~TaskTracer();
+
+		bool is_open();
+
+		/* record an event, safe to call from any thread */
+		void record(const string &taskId, TaskEventType type, long time);
+
+		void fork_writer_thread();	// fork the background writer thread
+
+		/* stop the writer thread, drain and close the trace file */
+		void stop();
+
+		long flush();	// drain all the rings once
+
+		long num_dropped();
+
+		atomic<bool> running;	// cleared by stop, polled by the writer
+		long flushInterval;	// writer sleep length in micro-second
+
+	private:
+		TaskEventRing* local_ring();
+
+		FILE *traceFile;
+		atomic<bool> traceOpen;	// traceFile is open, read without the lock
+		unsigned long ringSize;
+		pthread_key_t ringKey;
+		pthread_mutex_t ringMutex;	// protects rings and the trace file,
+						// never taken per event
+		vector<TaskEventRing*> rings;
+		pthread_t writerThread;
+		bool writerForked;
+};
+
+/* read the next event from a trace file opened with
+ * open_trace_file, returns false at the end of the file */
+extern bool read_task_event(FILE*, TaskEvent&);
+
+/* open a trace file and check its header, NULL on failure */
+extern FILE* open_trace_file(const string&);
+
+/* the task id of an event as a string */
+extern string task_event_id(const TaskEvent&);
+
+#endif /* TASK_TRACE_H_ */
@@ -0,0 +1,190 @@
+/*
+ * trace_proc.cpp
+ *
+ * offline processing of the binary task trace files written by
+ * the schedulers, and a native replacement of the java tools in
+ * dataproc/ (SchedulingLatency and TaskSplit)
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "task_trace.h"
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <stdlib.h>
+#include <time.h>
+
+using namespace std;
+
+void usage() {
+	fprintf(stderr, "The usage is: trace_proc\ttsv\ttrace_file...\n"
+			"\t\t\ttrace_proc\tchrome\ttrace_file...\n"
+			"\t\t\ttrace_proc\tlatency\ttrace_file...\n"
+			"\t\t\ttrace_proc\tsplit\tnum_task\tnum_node\n");
+	exit(-1);
+}
+
+/* convert to the text task log: taskId\tEventName\ttime */
+int to_tsv(int numFile, char *files[]) {
+	TaskEvent event;
+
+	for (int i = 0; i < numFile; i++) {
+		FILE *file = open_trace_file(files[i]);
+		if (file == NULL) {
+			fprintf(stderr, "%s is not a task trace file!\n", files[i]);
+			return -1;
+		}
+
+		while (read_task_event(file, event)) {
+			if (event.type >= TE_NUM_TYPE) {
+				continue;
+			}
+			cout << task_event_id(event) << "\t"
+					<< task_event_name[event.type] << "\t" << event.time
+					<< "\n";
+		}
+		fclose(file);
+	}
+
+	return 0;
+}
+
+/* convert to the Chrome trace event format. Each trace file is a
+ * process (scheduler), each recording thread is a thread. A task
+ * executes between its StartTime and FinTime on one executing
+ * thread, which records both back to back, so they are emitted as
+ * a begin/end pair; the queueing events become instant events.
+ * */
+int to_chrome(int numFile, char *files[]) {
+	TaskEvent event;
+	bool first = true;
+
+	cout << "{\"traceEvents\":[\n";
+	for (int i = 0; i < numFile; i++) {
+		FILE *file = open_trace_file(files[i]);
+		if (file == NULL) {
+			fprintf(stderr, "%s is not a task trace file!\n", files[i]);
+			return -1;
+		}
+
+		while (read_task_event(file, event)) {
+			const char *phase = "i";
+			if (event.type >= TE_NUM_TYPE) {
+				continue;
+			} else if (event.type == TE_START) {
+				phase = "B";
+			} else if (event.type == TE_FIN) {
+				phase = "E";
+			}
+
+			if (!first) {
+				cout << ",\n";
+			}
+			first = false;
+
+			cout << "{\"name\":\"" << task_event_id(event) << "\",\"cat\":\""
+					<< task_event_name[event.type] << "\",\"ph\":\"" << phase
+					<< "\",\"ts\":" << event.time << ",\"pid\":" << i
+					<< ",\"tid\":" << event.thread;
+			if (phase[0] == 'i') {
+				cout << ",\"s\":\"t\"";
+			}
+			cout << "}";
+		}
+		fclose(file);
+	}
+	cout << "\n]}\n";
+
+	return 0;
+}
+
+/* the average scheduling latency: the time between a task being
+ * queued in the wait queue and being queued in a ready queue
+ * */
+int latency(int numFile, char *files[]) {
+	map<string, pair<long, long> > taskTime;
+	TaskEvent event;
+
+	for (int i = 0; i < numFile; i++) {
+		FILE *file = open_trace_file(files[i]);
+		if (file == NULL) {
+			fprintf(stderr, "%s is not a task trace file!\n", files[i]);
+			return -1;
+		}
+
+		while (read_task_event(file, event)) {
+			if (event.type == TE_WAIT_QUEUED) {
+				taskTime[task_event_id(event)].first = event.time;
+			} else if (event.type == TE_READY_QUEUED) {
+				taskTime[task_event_id(event)].second = event.time;
+			}
+		}
+		fclose(file);
+	}
+
+	if (taskTime.empty()) {
+		cout << 0 << endl;
+		return 0;
+	}
+
+	long sum = 0L;
+	for (map<string, pair<long, long> >::iterator it = taskTime.begin();
+			it != taskTime.end(); ++it) {
+		sum += it->second.second - it->second.first;
+	}
+	cout << (double) sum / (double) taskTime.size() << endl;
+
+	return 0;
+}
+
+/* split numTask tasks randomly but evenly into
+ * one workload file per scheduler (workload.i)
+ * */
+int split(long numTask, int numNode) {
+	vector<vector<long> > nodeTask(numNode);
+	long ave = (numTask + numNode - 1) / numNode;
+	int toNode = -1;
+
+	srand(time(NULL));
+
+	for (long i = 0; i < numTask; i++) {
+		toNode = rand() % numNode;
+		while (nodeTask[toNode].size() >= ave) {
+			toNode = rand() % numNode;
+		}
+		nodeTask[toNode].push_back(i);
+	}
+
+	for (int i = 0; i < numNode; i++) {
+		char fileName[64];
+		snprintf(fileName, sizeof(fileName), "./workload.%d", i);
+		ofstream fileStream(fileName);
+		for (long j = 0; j < nodeTask[i].size(); j++) {
+			fileStream << "0" << nodeTask[i][j] << " kwang /home/ hostname\n";
+		}
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 3) {
+		usage();
+	}
+
+	string mode(argv[1]);
+
+	if (mode.compare("tsv") == 0) {
+		return to_tsv(argc - 2, argv + 2);
+	} else if (mode.compare("chrome") == 0) {
+		return to_chrome(argc - 2, argv + 2);
+	} else if (mode.compare("latency") == 0) {
+		return latency(argc - 2, argv + 2);
+	} else if (mode.compare("split") == 0 && argc == 4) {
+		return split(atol(argv[2]), atoi(argv[3]));
+	}
+
+	usage();
+	return -1;
+}
@@ -137,156 +137,6 @@ int get_self_idx(const string &str, vector<string> strVec) {
 	return idx;
 }
 
-/* generate adjecency list for BOT independent tasks */
-void gen_bot_adjlist(adjList &dagAdjList, long numTask) {
-	for (long i = 0; i < numTask; i++) {
-		vector<long> newList;
-		dagAdjList.insert(make_pair(i, newList));
-	}
-}
-
-/*
- * generate adjacency list for fanout dags,
- * the argument is the fan out degree
- * */
-void gen_fanout_adjlist(adjList &dagAdjList, long dagArg, long numTask) {
-	long next = -1;
-
-	for (long i = 0; i < numTask; i++) {
-		vector<long> newList;
-
-		for (long j = 1; j <= dagArg; j++) {
-			next = i * dagArg + j;
-
-			if (next >= numTask) {
-				break;
-			} else {
-				newList.push_back(next);
-			}
-		}
-
-		dagAdjList.insert(make_pair(i, newList));
-	}
-}
-
-/*
- * generate adjacency list for fan in dags,
- * the argument is the fan in degree
- * */
-void gen_fanin_adjlist(adjList &dagAdjList, long dagArg, long numTask) {
-	adjList tmpAdjList;
-
-	/* first generate an adjacency list for fan out dag,
-	 * and then flip it over, and switch the left with the
-	 * right to get the adjacency list for fan in dags */
-	gen_fanout_adjlist(tmpAdjList, dagArg, numTask);
-
-	for (long i = 0; i < numTask; i++) {
-		long reverseId = numTask - 1 - i;
-
-		vector<long> newList;
-		newList.push_back(reverseId);
-
-		vector<long> tmpList = tmpAdjList.find(i)->second;
-
-		for (long j = 0; j < tmpList.size(); j++) {
-			dagAdjList.insert(
-					make_pair(numTask - 1 - tmpList.at(tmpList.size() - 1 - j),
-							newList));
-		}
-	}
-
-	vector<long> lastVec;
-	dagAdjList.insert(make_pair(numTask - 1, lastVec));
-}
-
-void gen_pipeline_adjlist(adjList &dagAdjList, long dagArg, long numTask) {
-	long numPipe = numTask / dagArg, index = -1, next = -1;
-
-	for (long i = 0; i < numPipe; i++) {
-		for (long j = 0; j < dagArg; j++) {
-			index = i * dagArg + j;
-			next = index + 1;
-			vector<long> newList;
-
-			if (next % dagArg != 0 && next < numTask) {
-				newList.push_back(next);
-			}
-
-			dagAdjList.insert(make_pair(index, newList));
-		}
-	}
-
-	for (index = numPipe * dagArg; index < numTask; index++) {
-		next = index + 1;
-		vector<long> newList;
-
-		if (next % dagArg != 0 && next < numTask) {
-			newList.push_back(next);
-		}
-
-		dagAdjList.insert(make_pair(index, newList));
-	}
-}
-
-void print_adjlist(adjList &dagAdjList) {
-	for (adjList::iterator it = dagAdjList.begin(); it != dagAdjList.end();
-			++it) {
-		vector<long> existList = it->second;
-		cout << " " << it->first << " -> ";
-
-		for (long i = 0; i < existList.size(); i++) {
-			cout << " " << existList[i] << ",";
-		}
-
-		cout << endl;
-	}
-}
-
-void gen_dag_adjlist(adjList &dagAdjList, string &dagType, long dagArg, long numTask) {
-	if (dagType.compare("BOT") == 0)
-		gen_bot_adjlist(dagAdjList, numTask);
-	else if (dagType.compare("FanOut") == 0)
-		gen_fanout_adjlist(dagAdjList, dagArg, numTask);
-	else if (dagType.compare("FanIn") == 0)
-		gen_fanin_adjlist(dagAdjList, dagArg, numTask);
-	else if (dagType.compare("Pipeline") == 0)
-		gen_pipeline_adjlist(dagAdjList, dagArg, numTask);
-	//print_adjlist(dagAdjList);
-}
-
-void gen_dag_indegree(adjList &dagAdjList, inDegree &dagInDegree) {
-	for (long i = 0; i < dagAdjList.size(); i++) {
-		dagInDegree[i] = 0;
-	}
-	for (adjList::iterator it = dagAdjList.begin(); it != dagAdjList.end();
-			++it) {
-		long index = it->first;
-		vector<long> existList = it->second;
-
-		for (long j = 0; j < existList.size(); j++) {
-			dagInDegree[existList.at(j)]++;
-		}
-	}
-}
-
-void gen_dag_parents(adjList &dagAdjList, adjList &dagParentList) {
-	for (long i = 0; i < dagAdjList.size(); i++) {
-		vector<long> parents;
-		dagParentList.insert(make_pair(i, parents));
-	}
-
-	for (adjList::iterator it = dagAdjList.begin(); it != dagAdjList.end();
-			++it) {
-		long index = it->first;
-		vector<long> existList = it->second;
-
-		for (long i = 0; i < existList.size(); i++) {
-			dagParentList.find(existList.at(i))->second.push_back(index);
-		}
-	}
-}
-
 long get_time_usec() {
 	struct timeval currentTime;
 
@@ -338,6 +188,16 @@ extern string taskmsg_to_str(const TaskMsg &taskMsg) {
 	str.append("@@");
 	str.append(num_to_str<long>(taskMsg.datalength()));
 	str.append("@@");
+	str.append(num_to_str<long>(taskMsg.priority()));
+	str.append("@@");
+	str.append(num_to_str<long>(taskMsg.deadline()));
+	str.append("@@");
+	if (taskMsg.has_dagid() && !taskMsg.dagid().empty()) {
+		str.append(taskMsg.dagid());
+	} else {
+		str.append("nodagid");
+	}
+	str.append("@@");
 
 	return str;
 }
@@ -375,6 +235,14 @@ extern TaskMsg str_to_taskmsg(const string &str) {
 		cout << "has problem, the vector size is:4" << endl;
 		tm.set_datalength(0);
 	}
+	/* the scheduling attributes are optional */
+	if (vecStr.size() > 6) {
+		tm.set_priority(str_to_num<long>(vecStr.at(5)));
+		tm.set_deadline(str_to_num<long>(vecStr.at(6)));
+	}
+	if (vecStr.size() > 7 && vecStr.at(7).compare("nodagid") != 0) {
+		tm.set_dagid(vecStr.at(7));
+	}
 	return tm;
 }
 
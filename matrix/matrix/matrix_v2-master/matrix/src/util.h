@@ -41,9 +41,6 @@
 
 using namespace std;
 
-typedef map<long, vector<long> > adjList;	// task DAG represented as adjacency list
-typedef map<long, long> inDegree;	// number of parents of each task
-
 /* template of converting a number
  * to a string using stringstream */
 template<typename T> string num_to_str(T num)
@@ -82,15 +79,6 @@ extern vector<string> read_from_file(const string&);
 /* find the index of a string in a vector of strings */
 extern int get_self_idx(const string&, vector<string>);
 
-/* generate the adjacency list of a DAG */
-extern void gen_dag_adjlist(adjList&, string&, long, long);
-
-/* generate the infomation of
- * number of parents for each task */
-extern void gen_dag_indegree(adjList&, inDegree&);
-
-extern void gen_dag_parents(adjList&, adjList&);
-
 /* get the current time of day in micro-second */
 extern long get_time_usec();
 
@@ -169,15 +157,6 @@ class Peer
 		int index;
 };
 
-struct HighPriorityByDataSize
-{
-	bool operator()(const TaskMsg &hpTaskMsg,
-			const TaskMsg &lpTaskMsg) const
-	{
-		return hpTaskMsg.datalength() > lpTaskMsg.datalength();
-	}
-};
-
 extern Mutex tokenMutex;
 extern Mutex sockMutex;
 #endif /* UTIL_H_ */